@@ -0,0 +1,69 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CODEBLOCKDATA_HPP
+#define CODEBLOCKDATA_HPP
+
+#include <QTextBlockUserData>
+#include <QVector>
+
+#include "token.hpp"
+
+namespace Developer {
+
+/*!
+ * \brief The CodeBlockData struct holds the lexer state attached to a single
+ *  QTextBlock in a CodeEditor
+ *
+ * Each block records the lexer state it was entered with and the state it
+ * leaves behind (e.g. "inside a comment"), along with the lexemes found within
+ * it. Positions stored in the lexemes are relative to the start of the block,
+ * so a block only has to be re-lexed when its own text changes or when the
+ * state it is entered with changes - edits elsewhere in the document merely
+ * shift its absolute position.
+ *
+ * The document takes ownership of instances of this struct once they are
+ * attached with QTextBlock::setUserData().
+ */
+struct CodeBlockData : public QTextBlockUserData
+{
+    CodeBlockData()
+        : startState(-1)
+        , endState(0)
+        , dirty(true)
+        , formatHash(0)
+    {
+    }
+
+    //! The lexer state this block was last lexed with, -1 if never lexed
+    int startState;
+    //! The lexer state at the end of this block
+    int endState;
+    //! Whether the text of this block has changed since it was last lexed
+    bool dirty;
+    //! A hash of the block-relative token spans last used to highlight it
+    uint formatHash;
+    //! The lexemes contained in this block, positions relative to the block
+    QVector<Token> lexemes;
+};
+
+}
+
+#endif // CODEBLOCKDATA_HPP
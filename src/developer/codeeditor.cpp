@@ -47,17 +47,112 @@ void CodeEditorGutter::paintEvent(QPaintEvent *event)
 
 CodeEditor::CodeEditor(QWidget *parent)
     : QPlainTextEdit(parent)
+    , _tokens(new TokenBuffer)
+    , _rehighlighting(false)
+    , _spare(new TokenBuffer)
+    , _latestRevision(new QAtomicInt(0))
+    , _revision(0)
+    , _parseRunning(false)
+    , _parsePending(false)
 {
     _gutter = new CodeEditorGutter(this);
+    _watcher = new QFutureWatcher<ParseJob>(this);
 
     connect(this, SIGNAL(blockCountChanged(int)),
             this, SLOT(updateGutterWidth(int)));
     connect(this, SIGNAL(updateRequest(QRect,int)),
             this, SLOT(updateGutter(QRect,int)));
+    connect(document(), SIGNAL(contentsChange(int,int,int)),
+            this, SLOT(documentChanged(int,int,int)));
+    connect(_watcher, SIGNAL(finished()), this, SLOT(parseFinished()));
 
     updateGutterWidth(0);
 }
 
+CodeEditor::~CodeEditor()
+{
+    if(_parseRunning)
+    {
+        // No revision is negative, so this makes sure the running job gives
+        // up, then clean up after it
+        _latestRevision->fetchAndStoreRelaxed(-1);
+        _watcher->waitForFinished();
+        delete _watcher->result().tokens;
+    }
+
+    delete _tokens;
+    delete _spare;
+}
+
+void CodeEditor::parse()
+{
+    // Only one job runs at a time, if the document has changed since the
+    // running job started it will give up and the latest text is parsed once
+    // it has finished
+    if(_parseRunning)
+    {
+        _parsePending = true;
+        return;
+    }
+
+    startParse();
+}
+
+void CodeEditor::documentChanged(int position, int charsRemoved,
+                                 int charsAdded)
+{
+    Q_UNUSED(position)
+    Q_UNUSED(charsRemoved)
+    Q_UNUSED(charsAdded)
+
+    if(_rehighlighting)
+        return;
+
+    _latestRevision->fetchAndStoreRelaxed(++_revision);
+}
+
+void CodeEditor::parseFinished()
+{
+    _parseRunning = false;
+
+    ParseJob job = _watcher->result();
+    if(!job.cancelled && job.revision == _revision)
+    {
+        // The buffer which was being displayed becomes the spare
+        qSwap(_tokens, job.tokens);
+        applyJob(job);
+    }
+    else if(job.revision == _revision && retryJob(job))
+        _parsePending = true;
+    _spare = job.tokens;
+
+    if(_parsePending)
+        startParse();
+}
+
+bool CodeEditor::retryJob(const ParseJob &job)
+{
+    Q_UNUSED(job)
+    return false;
+}
+
+void CodeEditor::startParse()
+{
+    _parsePending = false;
+
+    ParseJob job;
+    job.revision = _revision;
+    job.latestRevision = _latestRevision;
+    if(!prepareJob(&job))
+        return;
+
+    job.tokens = _spare;
+    _spare = 0;
+
+    _parseRunning = true;
+    _watcher->setFuture(startJob(job));
+}
+
 int CodeEditor::gutterWidth() const
 {
     int characters = 1;
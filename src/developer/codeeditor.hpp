@@ -22,7 +22,10 @@
 #define CODEEDITOR_HPP
 
 #include <QPlainTextEdit>
+#include <QFutureWatcher>
+#include <QSharedPointer>
 #include "token.hpp"
+#include "parsejob.hpp"
 #include "global.hpp"
 
 namespace Developer {
@@ -56,6 +59,16 @@ private:
  * \brief The CodeEditor class provides an abstract base class for code editors
  *
  * In GP this is used for the ProgramEditor and the ConditionEditor.
+ *
+ * Parsing happens in the background so that a slow parse never holds up
+ * typing. When parse() is called the subclass takes a snapshot of the document
+ * in prepareJob(), which is tagged with the document's current revision and
+ * handed to a worker thread through startJob(). Every change to the document
+ * bumps the revision, which a running job notices and gives up. When a job
+ * finishes its tokens are only handed over to applyJob() (and so to the
+ * highlighter) if the revision still matches the document, otherwise they are
+ * thrown away and the latest text is parsed instead. The GUI thread only takes
+ * snapshots and applies highlighting.
  */
 class CodeEditor : public QPlainTextEdit
 {
@@ -63,32 +76,94 @@ class CodeEditor : public QPlainTextEdit
 
 public:
     explicit CodeEditor(QWidget *parent);
-
-    /*!
-     * \brief Gets the regular expression associated with the provided type
-     * \param type  The type of the token whose regexp we are retrieving. This
-     *  will be a value from the Lexemes enum
-     * \return A QRegExp object containing a pattern which will match this type
-     *  of lexeme
-     */
-    virtual QRegExp pattern(int type) const = 0;
+    ~CodeEditor();
 
     int gutterWidth() const;
     void drawGutter(QPaintEvent *event);
 
 public slots:
-    virtual void parse() = 0;
+    /*!
+     * \brief Parse the document in the background
+     *
+     * If a parse is already running then a new one is started for the latest
+     * text once it has finished.
+     */
+    void parse();
 
 protected slots:
     void updateGutterWidth(int blockCount);
     void updateGutter(const QRect &rect, int scrollDistance);
 
+    /*!
+     * \brief Record a change to the document, cancelling any running parse
+     *
+     * The parameters match QTextDocument::contentsChange()
+     */
+    virtual void documentChanged(int position, int charsRemoved,
+                                 int charsAdded);
+    /*!
+     * \brief Collect the result of a background parse
+     */
+    void parseFinished();
+
 protected:
     void resizeEvent(QResizeEvent *event);
 
-    QVector<Token *> _tokens;
-    QStringList _keywords;
+    /*!
+     * \brief Take a snapshot of the document for a new parse job
+     *
+     * This is called on the GUI thread and should be cheap.
+     *
+     * \param job   The job to fill in, its revision has already been set
+     * \return true if the job should be run, false if nothing has changed
+     *  since the last parse
+     */
+    virtual bool prepareJob(ParseJob *job) = 0;
+    /*!
+     * \brief Start running a parse job on a worker thread
+     * \param job   The job to run
+     * \return A future which will hold the finished job
+     */
+    virtual QFuture<ParseJob> startJob(const ParseJob &job) = 0;
+    /*!
+     * \brief Install the tokens from a finished parse job and highlight them
+     *
+     * This is only called for jobs taken from the document as it currently
+     * stands, by the time it is called _tokens holds the job's tokens.
+     *
+     * \param job   The finished job
+     */
+    virtual void applyJob(const ParseJob &job) = 0;
+    /*!
+     * \brief Decide whether to run another job after one gave up on the
+     *  document as it currently stands
+     *
+     * The default never does, subclasses which leave part of the document out
+     * of their snapshots can use this to ask for a fuller snapshot.
+     *
+     * \param job   The cancelled job
+     * \return true if the document should be parsed again
+     */
+    virtual bool retryJob(const ParseJob &job);
+
+    //! The tokens from the last parse applied, never null
+    TokenBuffer *_tokens;
     CodeEditorGutter *_gutter;
+    //! Set while highlighting is applied, which the document reports as a
+    //! change even though the text is unaltered
+    bool _rehighlighting;
+
+private:
+    void startParse();
+
+    QFutureWatcher<ParseJob> *_watcher;
+    //! The buffer the next job writes to, the two buffers swap whenever a
+    //! job's tokens are applied so neither is reallocated
+    TokenBuffer *_spare;
+    QSharedPointer<QAtomicInt> _latestRevision;
+    int _revision;
+    bool _parseRunning;
+    bool _parsePending;
 };
 
 }
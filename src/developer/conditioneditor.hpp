@@ -28,6 +28,14 @@ namespace Developer {
 
 class ConditionHighlighter;
 
+/*!
+ * \brief The ConditionEditor class displays and edits a rule condition
+ *
+ * The condition is handed to a ConditionParser running in the background and
+ * the resulting tokens are passed along to a ConditionHighlighter. Once they
+ * have been applied conditionParsed() is emitted, so that others can read the
+ * tokens through tokens() without parsing the condition again.
+ */
 class ConditionEditor : public CodeEditor
 {
     Q_OBJECT
@@ -35,37 +43,16 @@ class ConditionEditor : public CodeEditor
 public:
     explicit ConditionEditor(QWidget *parent = 0);
 
-    QRegExp pattern(int type) const;
-
     ConditionHighlighter *highlighter() const;
+    const TokenBuffer *tokens() const;
 
-public slots:
-    void parse();
+signals:
+    void conditionParsed();
 
 protected:
-    bool findMatch(ConditionLexemes *lexeme, int *matchLength,
-                   ConditionLexemes hint = ConditionLexeme_Default);
-    void handleLexeme(ConditionLexemes lexeme, int matchLength);
-
-    void parseEdgeTest();
-
-    bool consumeWhitespace();
-    bool consumeComments();
-    void consumeError(const QString &expecting = QString());
-
-    /*!
-     * \brief Produce a simple formatted text string when an invalid token is
-     *  found
-     *
-     * This is just to keep the error messages looking consistent.
-     *
-     * \todo Convert position into line:column
-     *
-     * \param tokenFound    The unexpected token which was found
-     * \param position      The position of the token
-     * \return A formatted QString with the provided details
-     */
-    QString errorString(const QString &tokenFound, int position);
+    bool prepareJob(ParseJob *job);
+    QFuture<ParseJob> startJob(const ParseJob &job);
+    void applyJob(const ParseJob &job);
 
     /*!
      * \brief Catch mouse movement over the editor in order to overlay error
@@ -76,11 +63,8 @@ protected:
 
 private:
     ConditionHighlighter *_highlighter;
-    QString _condition;
+    //! The text of the condition as of the last parse applied
     QString _cache;
-    int _pos;
-    QVector<Token *> _openParens;
-    bool _wantsValue;
 };
 
 }
@@ -23,6 +23,7 @@
 
 #include <QSyntaxHighlighter>
 #include "token.hpp"
+#include "tokenindex.hpp"
 
 namespace Developer {
 
@@ -43,9 +44,9 @@ public:
 public slots:
     /*!
      * \brief Set the sequence of tokens which correspond with this program
-     * \param tokens    The sequence of tokens
+     * \param tokens    The sequence of tokens, these are owned by the editor
      */
-    void setTokens(QVector<Token *> tokens);
+    void setTokens(const TokenBuffer *tokens);
     /*!
      * \brief A wrapper function which complies with the standard
      *  QSyntaxHighlighter interface
@@ -54,7 +55,7 @@ public slots:
     void highlightBlock(const QString &text);
 
 private:
-    QVector<Token *> _tokens;
+    TokenIndex _index;
 };
 
 }
@@ -0,0 +1,456 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "conditionparser.hpp"
+
+#include <QDebug>
+#include <QVariant>
+
+namespace Developer {
+
+ConditionParser::ConditionParser()
+    : _lexer(ConditionLanguage)
+    , _pos(0)
+    , _tokens(0)
+    , _wantsValue(true)
+{
+}
+
+ParseJob ConditionParser::run(ParseJob job)
+{
+    ConditionParser parser;
+    parser.parse(&job);
+    return job;
+}
+
+void ConditionParser::parse(ParseJob *job)
+{
+    _condition = job->text;
+    _tokens = job->tokens;
+    _tokens->clear();
+    _pos = 0;
+    _openParens.clear();
+    _wantsValue = true;
+
+    // Do the actual parse
+    while(_pos < _condition.length())
+    {
+        if(job->isStale())
+        {
+            job->cancelled = true;
+            return;
+        }
+
+        ConditionLexemes lexeme = ConditionLexeme_Error;
+        int matchLength = 0;
+        if(!findMatch(&lexeme, &matchLength))
+        {
+            lexeme = ConditionLexeme_Error;
+            matchLength = 1;
+        }
+
+        handleLexeme(lexeme, matchLength);
+    }
+
+    for(int i = 0; i < _openParens.size(); ++i)
+    {
+        Token &paren = (*_tokens)[_openParens.at(i)];
+        paren.lexeme = ConditionLexeme_Error;
+        paren.description = tr("Unmatched opening parenthesis");
+    }
+
+    _tokens = 0;
+}
+
+void ConditionParser::parseCondition(const QString &condition,
+                                     TokenBuffer *tokens)
+{
+    // Nothing else knows about this job, so it can never become stale
+    ParseJob job;
+    job.latestRevision = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    job.text = condition;
+    job.tokens = tokens;
+
+    parse(&job);
+}
+
+bool ConditionParser::findMatch(ConditionLexemes *lexeme,
+                                int *matchLength, ConditionLexemes hint)
+{
+    if(_pos == _condition.length())
+    {
+        qDebug() << "findMatch() asked to find match beyond end of string";
+        return false;
+    }
+
+    while(consumeWhitespace());
+
+    // The lexer tables find the longest match, preferring the hint on ties
+    int matched = ConditionLexeme_Error;
+    *matchLength = _lexer.match(_condition, _pos, &matched, hint);
+    *lexeme = (*matchLength > 0) ? static_cast<ConditionLexemes>(matched)
+                                 : ConditionLexeme_Error;
+
+    return (*matchLength > 0);
+}
+
+void ConditionParser::handleLexeme(ConditionLexemes lexeme, int matchLength)
+{
+    QString text = _condition.mid(_pos, matchLength);
+    Token token;
+    token.startPos = _pos;
+    token.lexeme = lexeme;
+    token.endPos = (_pos += matchLength);
+    token.text = text;
+
+    switch(lexeme)
+    {
+    case Not:
+        // Accept it
+        _tokens->append(token);
+        return;
+    case Empty:
+        // Accept it
+        _tokens->append(token);
+        return;
+    case And:
+    case Or:
+        // Accept it
+        _tokens->append(token);
+        return;
+    case Variable:
+        // Accept it
+        _tokens->append(token);
+        return;
+    case GraphLexeme:
+        // Reject it, we handle these in areas which accept them
+        token.lexeme = ConditionLexeme_Error;
+        token.description = tr("Unexpected identifier");
+        _tokens->append(token);
+        return;
+    case ListSeparator:
+            // Accept it
+            _tokens->append(token);
+            _wantsValue = true;
+        return;
+    case Comma:
+            // Accept it
+            _tokens->append(token);
+            return;
+    case QuotedString:
+        // Accept it
+        _tokens->append(token);
+        return;
+    case OpeningParen:
+        // Accept it
+        _openParens.push_back(_tokens->size());
+        _tokens->append(token);
+        return;
+    case ClosingParen:
+        if(_openParens.size() > 0)
+        {
+            _openParens.pop_back();
+            _tokens->append(token);
+        }
+        else
+        {
+            token.lexeme = ConditionLexeme_Error;
+            token.description = tr("Umatched closing parenthesis");
+            _tokens->append(token);
+        }
+        return;
+    case DegreeTest:
+        // Accept it
+        _tokens->append(token);
+        return;
+    case Integer:
+        // Accept it
+        _tokens->append(token);
+        return;
+        // Reject it, we handle these in areas which accept them
+        token.lexeme = ConditionLexeme_Error;
+        token.description = tr("Unexpected integer");
+        _tokens->append(token);
+        return;
+    case Negation:
+        // Accept it
+        _tokens->append(token);
+        return;
+    case Plus:
+    case Minus:
+    case Divide:
+    case Times:
+            // Accept it
+            _tokens->append(token);
+            return;
+    case LessThan:
+    case LessThanEqualTo:
+    case GreaterThan:
+    case GreaterThanEqualTo:
+            // Accept it
+            _tokens->append(token);
+            return;
+    case Equals:
+    case NotEquals:
+            // Accept it
+            _tokens->append(token);
+            return;
+    case EdgeTest:
+        // Accept it
+        _tokens->append(token);
+        parseEdgeTest();
+        return;
+    case ConditionLexeme_CommentOpen:
+        _pos -= matchLength;
+        consumeComments();
+        return;
+    case ConditionLexeme_CommentClose:
+        // Reject it
+        token.lexeme = ConditionLexeme_Error;
+        token.description = tr("Unexpected comment close");
+        _tokens->append(token);
+        return;
+    case ConditionLexeme_Error:
+        // Accept it
+        token.description = tr("No matches found at this position");
+        _tokens->append(token);
+        return;
+    case ConditionLexeme_Default:
+    case ConditionLexeme_Comment:
+    default:
+        // Shouldn't happen
+        qDebug() << "Unhandled type entered: " << lexeme;
+    }
+}
+
+void ConditionParser::parseEdgeTest()
+{
+    ConditionLexemes lexeme;
+    int matchLength = 0;
+    int stage = 0;
+    Token token;
+    while(_pos < _condition.length())
+    {
+        if(!findMatch(&lexeme, &matchLength, GraphLexeme))
+        {
+            if(stage > 0)
+            {
+                token = Token();
+                token.startPos = _pos;
+                token.endPos = ++_pos;
+                token.lexeme = ConditionLexeme_Error;
+                token.description = tr("Unexpected character in edge test");
+                _tokens->append(token);
+                continue;
+            }
+            else
+            {
+                // Bail at stage 0, but not afterwards
+                return;
+            }
+        }
+        else
+        {
+            token = Token();
+            token.startPos = _pos;
+            token.endPos = _pos += matchLength;
+            token.lexeme = lexeme;
+            token.text = _condition.mid(_pos, matchLength);
+        }
+
+        switch(stage)
+        {
+        case 0:
+            if(lexeme == OpeningParen)
+            {
+                _tokens->append(token);
+                ++stage;
+            }
+            else
+            {
+                // If we don't find an opening paren next, then we'll just move
+                // on for now. Someone may be typing that at the moment and it
+                // probably doesn't help to make everything afterwards an error
+                _pos -= matchLength;
+                return;
+            }
+            break;
+        case 1:
+        case 3:
+            if(lexeme == GraphLexeme)
+            {
+                _tokens->append(token);
+                ++stage;
+                continue;
+            }
+            else
+            {
+                token.lexeme = ConditionLexeme_Error;
+                _tokens->append(token);
+                continue;
+            }
+            break;
+        case 2:
+            if(lexeme == Comma)
+            {
+                _tokens->append(token);
+                ++stage;
+                continue;
+            }
+            else
+            {
+                token.lexeme = ConditionLexeme_Error;
+                _tokens->append(token);
+                continue;
+            }
+            break;
+        case 4:
+            if(lexeme == ClosingParen)
+            {
+                _tokens->append(token);
+                return;
+            }
+            else if(lexeme == Comma)
+            {
+                _tokens->append(token);
+                ++stage;
+                continue;
+            }
+            else
+            {
+                token.lexeme = ConditionLexeme_Error;
+                _tokens->append(token);
+                continue;
+            }
+            break;
+        case 5:
+            // This accepts a list, which is more complicated than I would like
+            _pos -= matchLength;
+            ++stage;
+            break;
+        case 6:
+            if(lexeme == ClosingParen)
+            {
+                _tokens->append(token);
+                return;
+            }
+            else
+            {
+                token.lexeme = ConditionLexeme_Error;
+                _tokens->append(token);
+                continue;
+            }
+            break;
+        default:
+            _pos -= matchLength;
+            return;
+        }
+    }
+}
+
+bool ConditionParser::consumeWhitespace()
+{
+    if(_pos >= _condition.length())
+        return false;
+
+    int end = _lexer.skipWhitespace(_condition, _pos);
+    if(end == _pos)
+        return false;
+
+    _pos = end;
+    return true;
+}
+
+bool ConditionParser::consumeComments()
+{
+    if(_pos >= _condition.length())
+        return false;
+
+    // Check for a comment
+    int lexeme = ConditionLexeme_Error;
+    int matchLength = _lexer.match(_condition, _pos, &lexeme);
+    if(matchLength > 0 && lexeme == ConditionLexeme_CommentOpen)
+    {
+        // Comment found, now we need to check for an ending and if we can't
+        // find one then we just mark a comment to the end of the condition
+        // and finish
+        Token token;
+        token.startPos = _pos;
+        token.lexeme = ConditionLexeme_Comment;
+        _pos += matchLength;
+
+        int end = _lexer.findCommentClose(_condition, _pos);
+        if(end < 0)
+        {
+            // There was no closing token, match to the end of the string
+            end = _condition.length();
+        }
+
+        token.text = _condition.mid(_pos, end - _pos);
+        token.endPos = end;
+        _pos = end;
+        _tokens->append(token);
+        return true;
+    }
+
+    // No comment found
+    return false;
+}
+
+void ConditionParser::consumeError(const QString &expecting)
+{
+    if(_pos >= _condition.length())
+        return;
+
+    Token error;
+    error.lexeme = ConditionLexeme_Error;
+    error.startPos = _pos;
+
+    // Identifiers are the only contiguous segments
+    int matchLength = _lexer.matchIdentifier(_condition, _pos);
+    if(matchLength == 0)
+    {
+        // This isn't a block, move along one char
+        error.text = QString(_condition.at(_pos));
+        error.description = errorString(error.text, _pos) +
+                expecting;
+        error.endPos = ++_pos;
+        _tokens->append(error);
+        return;
+    }
+
+    error.text = _condition.mid(_pos, matchLength);
+    error.endPos = _pos + matchLength;
+    error.description = errorString(error.text, _pos) +
+            expecting;
+    _tokens->append(error);
+    _pos += matchLength;
+}
+
+QString ConditionParser::errorString(const QString &tokenFound, int position)
+{
+    QString ret =  tr("Unexpected token %1 at position %2. ").arg(
+                tokenFound,
+                QVariant(position).toString());
+    //qDebug() << ret;
+    return ret;
+}
+
+}
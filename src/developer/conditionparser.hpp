@@ -0,0 +1,111 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CONDITIONPARSER_HPP
+#define CONDITIONPARSER_HPP
+
+#include <QCoreApplication>
+
+#include "conditiontokens.hpp"
+#include "lexer.hpp"
+#include "parsejob.hpp"
+
+namespace Developer {
+
+/*!
+ * \brief The ConditionParser class turns the text of a rule condition into a
+ *  sequence of tokens, marking any errors found
+ *
+ * The parser holds no references to the editor or its document and can run on
+ * any thread, ConditionEditor runs it in the background through run().
+ */
+class ConditionParser
+{
+    Q_DECLARE_TR_FUNCTIONS(ConditionParser)
+
+public:
+    ConditionParser();
+
+    /*!
+     * \brief Run a parse job, this is the entry point used for background jobs
+     * \param job   The job to run
+     * \return The job with its tokens filled in
+     */
+    static ParseJob run(ParseJob job);
+
+    /*!
+     * \brief Parse the text of the job into tokens
+     *
+     * This gives up early, marking the job as cancelled, if the job becomes
+     * stale while it is running.
+     *
+     * \param job   The job to process
+     */
+    void parse(ParseJob *job);
+
+    /*!
+     * \brief Parse a whole condition outside of an editor
+     *
+     * This is used to analyse the conditions of rules which are not open for
+     * editing.
+     *
+     * \param condition The text of the condition
+     * \param tokens    The buffer to write the tokens to
+     */
+    void parseCondition(const QString &condition, TokenBuffer *tokens);
+
+protected:
+    bool findMatch(ConditionLexemes *lexeme, int *matchLength,
+                   ConditionLexemes hint = ConditionLexeme_Default);
+    void handleLexeme(ConditionLexemes lexeme, int matchLength);
+
+    void parseEdgeTest();
+
+    bool consumeWhitespace();
+    bool consumeComments();
+    void consumeError(const QString &expecting = QString());
+
+    /*!
+     * \brief Produce a simple formatted text string when an invalid token is
+     *  found
+     *
+     * This is just to keep the error messages looking consistent.
+     *
+     * \todo Convert position into line:column
+     *
+     * \param tokenFound    The unexpected token which was found
+     * \param position      The position of the token
+     * \return A formatted QString with the provided details
+     */
+    QString errorString(const QString &tokenFound, int position);
+
+private:
+    Lexer _lexer;
+    QString _condition;
+    int _pos;
+    //! Indices of the unmatched opening parentheses in the token buffer
+    QVector<int> _openParens;
+    TokenBuffer *_tokens;
+    bool _wantsValue;
+};
+
+}
+
+#endif // CONDITIONPARSER_HPP
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT += core gui xml widgets svg
+QT += core gui xml widgets svg concurrent
 
 TARGET = GPDeveloper
 TEMPLATE = app
@@ -56,10 +56,34 @@ HEADERS += \
     programtokens.hpp \
     programeditor.hpp \
     token.hpp \
+    tokenindex.hpp \
+    tokenbuffer.hpp \
+    symbolindex.hpp \
+    findreplace.hpp \
+    findreplacedialog.hpp \
+    thumbnailcache.hpp \
+    projectvalidator.hpp \
+    typeinference.hpp \
+    lexer.hpp \
+    parsejob.hpp \
+    programparser.hpp \
+    conditionparser.hpp \
+    codeblockdata.hpp \
     preferences/appearancepreferences.hpp \
     preferences/toolchainpreferences.hpp \
     graphview/graphscene.hpp \
     graphview/graphitem.hpp \
+    graphview/graphviewstyle.hpp \
+    graphview/spatialgrid.hpp \
+    graphview/layoutjob.hpp \
+    graphview/layoutmirror.hpp \
+    graphview/forcelayout.hpp \
+    graphview/layoutanimator.hpp \
+    graphview/tilecache.hpp \
+    graphview/hitindex.hpp \
+    graphview/graphrenderer.hpp \
+    graphview/edgebundler.hpp \
+    graphview/densityraster.hpp \
     graphview/editnodedialog.hpp \
     graphview/editedgedialog.hpp \
     dotparser.hpp \
@@ -105,6 +129,7 @@ FORMS += \
     importruledialog.ui \
     importgraphdialog.ui \
     openprojectprogressdialog.ui \
+    findreplacedialog.ui \
     firstrundialog.ui
 
 RESOURCES += \
@@ -161,6 +186,16 @@ SOURCES += \
     preferences/toolchainpreferences.cpp \
     graphview/graphscene.cpp \
     graphview/graphitem.cpp \
+    graphview/graphviewstyle.cpp \
+    graphview/layoutjob.cpp \
+    graphview/layoutmirror.cpp \
+    graphview/forcelayout.cpp \
+    graphview/layoutanimator.cpp \
+    graphview/tilecache.cpp \
+    graphview/hitindex.cpp \
+    graphview/graphrenderer.cpp \
+    graphview/edgebundler.cpp \
+    graphview/densityraster.cpp \
     graphview/editnodedialog.cpp \
     graphview/editedgedialog.cpp \
     dotparser.cpp \
@@ -173,7 +208,18 @@ SOURCES += \
     list.cpp \
     firstrundialog.cpp \
     listvalidator.cpp \
-    runconfig.cpp
+    runconfig.cpp \
+    tokenindex.cpp \
+    tokenbuffer.cpp \
+    symbolindex.cpp \
+    findreplace.cpp \
+    findreplacedialog.cpp \
+    thumbnailcache.cpp \
+    projectvalidator.cpp \
+    typeinference.cpp \
+    lexer.cpp \
+    programparser.cpp \
+    conditionparser.cpp
 
 OTHER_FILES += \
     templates/newproject.gpp \
@@ -187,6 +233,14 @@ OTHER_FILES += \
     documentation/namespace_developer.dox \
     documentation/developer_main.dox \
     tests/CMakeLists.txt \
+    tests/benchgraphpan.cxx \
+    tests/benchgraphview.cxx \
+    tests/benchhighlighter.cxx \
+    tests/testedgebundler.cxx \
+    tests/testforcelayout.cxx \
+    tests/testlexer.cxx \
+    tests/testparsememory.cxx \
+    tests/testtypeinference.cxx \
     templates/newrule_alternative.gpr \
     templates/newgraph_alternative.gpg \
     templates/example_program.gpx \
@@ -23,6 +23,7 @@
 
 #include "helpdialog.hpp"
 #include "project.hpp"
+#include "thumbnailcache.hpp"
 
 namespace Developer {
 
@@ -31,6 +32,7 @@ Edit::Edit(QWidget *parent)
     , _ui(new Ui::Edit)
     , _project(0)
     , _currentFile(0)
+    , _thumbnails(new ThumbnailCache(this))
 {
     _ui->setupUi(this);
 
@@ -44,6 +46,8 @@ Edit::Edit(QWidget *parent)
             this, SLOT(handleGraphHasFocus(GraphWidget*)));
     connect(_ui->graphEdit, SIGNAL(graphLostFocus(GraphWidget*)),
             this, SLOT(handleGraphLostFocus(GraphWidget*)));
+    connect(_thumbnails, SIGNAL(thumbnailReady(QString)),
+            this, SLOT(thumbnailReady(QString)));
 }
 
 Edit::~Edit()
@@ -61,6 +65,7 @@ void Edit::setProject(Project *project)
 
     _project = project;
     _currentFile = 0;
+    _thumbnails->setDirectory(_project->dir().filePath(THUMBNAIL_DIRECTORY));
 
     // Set up rule edit
     if(_project->rules().count() > 0)
@@ -274,7 +279,7 @@ void Edit::fileListChanged()
         Graph *g = *iter;
         items.clear(); items << g->fileName();
         QTreeWidgetItem *item = new QTreeWidgetItem(items);
-        item->setToolTip(0, g->absolutePath());
+        item->setToolTip(0, graphToolTip(g->absolutePath()));
         switch(g->status())
         {
         case GPFile::Modified:
@@ -350,6 +355,36 @@ void Edit::fileStatusChanged(QString path, int status)
         // Do nothing
         break;
     }
+
+    // A saved graph needs a new thumbnail
+    if(dynamic_cast<Graph *>(file) != 0)
+        item->setToolTip(0, graphToolTip(file->absolutePath()));
+}
+
+void Edit::thumbnailReady(QString path)
+{
+    GPFile *file = _project == 0 ? 0 : _project->file(path);
+    if(file == 0 || !_treeMap.contains(file))
+        return;
+
+    _treeMap[file]->setToolTip(0, graphToolTip(path));
+}
+
+QString Edit::graphToolTip(const QString &path)
+{
+    QString imagePath = _thumbnails->thumbnail(path);
+    if(imagePath.isEmpty())
+        return path;
+
+    // Shown as rich text, so the paths must not be read as markup
+    QStringList escaped;
+    escaped << path << imagePath;
+    for(int i = 0; i < escaped.count(); ++i)
+        escaped[i].replace("&", "&amp;").replace("<", "&lt;")
+                .replace(">", "&gt;").replace("\"", "&quot;");
+
+    return QString("<p>%1</p><img src=\"%2\" />").arg(escaped.at(0),
+                                                      escaped.at(1));
 }
 
 void Edit::handleGraphHasFocus(GraphWidget *graphWidget)
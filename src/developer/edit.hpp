@@ -34,6 +34,7 @@ namespace Developer {
 class Project;
 class GPFile;
 class GraphWidget;
+class ThumbnailCache;
 
 /*!
  * \brief The Edit class provides a container for editing all three file types
@@ -99,15 +100,25 @@ public slots:
 
     void fileStatusChanged(QString path, int status);
 
+    /*!
+     * \brief Slot to show a graph's thumbnail in its tooltip once it has been
+     *  made
+     * \param path  The absolute path of the graph
+     */
+    void thumbnailReady(QString path);
+
 signals:
     void graphHasFocus(GraphWidget *graphWidget);
     void graphLostFocus(GraphWidget *graphWidget);
     
 private:
+    QString graphToolTip(const QString &path);
+
     Ui::Edit *_ui;
     Project *_project;
     QMap<GPFile *, QTreeWidgetItem *> _treeMap;
     GPFile *_currentFile;
+    ThumbnailCache *_thumbnails;
 };
 
 }
@@ -0,0 +1,437 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "findreplace.hpp"
+#include "gpfile.hpp"
+
+#include <QByteArrayMatcher>
+#include <QDebug>
+#include <QFile>
+#include <QRegExp>
+#include <QtConcurrentMap>
+
+#include <cstring>
+
+namespace Developer {
+
+namespace {
+
+/*!
+ * \brief Find the next match of a search within some text
+ * \param text      The text to search
+ * \param from      The position to start searching at
+ * \param options   What to search for
+ * \param rx        The compiled pattern, used for regular expression searches
+ * \param length    Set to the length of the match
+ * \return The position of the match, or -1 if there are no further matches
+ */
+int findNext(const QString &text, int from, const FindOptions &options,
+             QRegExp &rx, int *length)
+{
+    if(from > text.length())
+        return -1;
+
+    if(options.regularExpression)
+    {
+        int pos = rx.indexIn(text, from);
+        *length = rx.matchedLength();
+        return pos;
+    }
+
+    *length = options.pattern.length();
+    return text.indexOf(options.pattern, from, options.caseSensitive
+                        ? Qt::CaseSensitive : Qt::CaseInsensitive);
+}
+
+/*!
+ * \brief Substitute the captures of a regular expression match into a
+ *  replacement string
+ * \param replacement   The replacement text, containing \\0 to \\9
+ * \param rx            The regular expression which has just matched
+ * \return The replacement text for this match
+ */
+QString expandCaptures(const QString &replacement, const QRegExp &rx)
+{
+    QString result;
+    for(int i = 0; i < replacement.length(); ++i)
+    {
+        QChar c = replacement.at(i);
+        if(c == '\\' && i + 1 < replacement.length())
+        {
+            QChar next = replacement.at(i + 1);
+            if(next.isDigit())
+            {
+                result += rx.cap(next.digitValue());
+                ++i;
+                continue;
+            }
+            else if(next == '\\')
+            {
+                result += next;
+                ++i;
+                continue;
+            }
+        }
+        result += c;
+    }
+    return result;
+}
+
+/*!
+ * \brief Build a match record, working out the column and line text
+ * \param path      The path of the file
+ * \param data      The UTF-8 contents of the file
+ * \param size      The size of the contents in bytes
+ * \param line      The line number of the match
+ * \param lineStart The byte offset of the start of the line
+ * \param pos       The byte offset of the match
+ * \param length    The length of the match in characters
+ * \return The match
+ */
+FindMatch makeMatch(const QString &path, const char *data, int size, int line,
+                    int lineStart, int pos, int length)
+{
+    const char *lineEnd = static_cast<const char *>(
+                memchr(data + pos, '\n', size - pos));
+    int end = (lineEnd != 0) ? lineEnd - data : size;
+    if(end > lineStart && data[end-1] == '\r')
+        --end;
+
+    FindMatch match;
+    match.filePath = path;
+    match.line = line;
+    match.column = QString::fromUtf8(data + lineStart, pos - lineStart).length();
+    match.length = length;
+    match.lineText = QString::fromUtf8(data + lineStart, end - lineStart);
+    return match;
+}
+
+}
+
+FileSearch::FileSearch(const FindOptions &options,
+                       const QHash<QString, QString> &unsaved)
+    : _options(options)
+    , _unsaved(unsaved)
+{
+}
+
+QVector<FindMatch> FileSearch::operator()(const QString &path) const
+{
+    QHash<QString, QString>::const_iterator text = _unsaved.constFind(path);
+    if(text != _unsaved.constEnd())
+        return FindReplace::searchText(path, text.value(), _options);
+
+    return FindReplace::searchFile(path, _options);
+}
+
+FindReplace::FindReplace(QObject *parent)
+    : QObject(parent)
+    , _watcher(new QFutureWatcher< QVector<FindMatch> >(this))
+    , _error("")
+{
+    connect(_watcher, SIGNAL(resultReadyAt(int)), this, SLOT(resultReady(int)));
+    connect(_watcher, SIGNAL(finished()), this, SLOT(finished()));
+}
+
+FindReplace::~FindReplace()
+{
+    // The functors only hold copies of their input, but the watcher must not
+    // outlive its future being processed
+    _watcher->cancel();
+    _watcher->waitForFinished();
+}
+
+void FindReplace::find(const QStringList &paths, const FindOptions &options,
+                       const QHash<QString, QString> &unsaved)
+{
+    cancel();
+
+    if(options.pattern.isEmpty())
+    {
+        emit searchFinished();
+        return;
+    }
+
+    _watcher->setFuture(QtConcurrent::mapped(paths,
+                                             FileSearch(options, unsaved)));
+}
+
+void FindReplace::cancel()
+{
+    if(_watcher->isRunning())
+        _watcher->cancel();
+}
+
+bool FindReplace::isRunning() const
+{
+    return _watcher->isRunning();
+}
+
+bool FindReplace::replace(const QVector<GPFile *> &files,
+                          const FindOptions &options,
+                          const QString &replacement, int *replaced)
+{
+    _error = "";
+    if(replaced != 0)
+        *replaced = 0;
+
+    if(options.pattern.isEmpty())
+    {
+        _error = tr("Nothing to replace, the search text is empty.");
+        return false;
+    }
+
+    if(options.regularExpression && !QRegExp(options.pattern).isValid())
+    {
+        _error = tr("The regular expression is not valid.");
+        return false;
+    }
+
+    // Work out every change before touching the disk so that a failure part
+    // of the way through leaves nothing half-done
+    QVector<GPFile *> changedFiles;
+    QVector<QByteArray> originals;
+    QVector<QByteArray> updated;
+    int count = 0;
+    for(int i = 0; i < files.size(); ++i)
+    {
+        GPFile *file = files.at(i);
+        if(file->status() != GPFile::Normal)
+        {
+            _error = tr("The file %1 has unsaved changes or cannot be "
+                        "written, no files were changed.").arg(file->path());
+            return false;
+        }
+
+        QFile fp(file->path());
+        if(!fp.open(QFile::ReadOnly))
+        {
+            _error = tr("The file %1 could not be read, no files were "
+                        "changed.").arg(file->path());
+            return false;
+        }
+        QByteArray original = fp.readAll();
+        fp.close();
+
+        QString result;
+        int fileCount = replaceAll(QString::fromUtf8(original.constData(),
+                                                     original.size()),
+                                   options, replacement, &result);
+        if(fileCount == 0)
+            continue;
+
+        changedFiles.push_back(file);
+        originals.push_back(original);
+        updated.push_back(result.toUtf8());
+        count += fileCount;
+    }
+
+    for(int i = 0; i < changedFiles.size(); ++i)
+    {
+        if(changedFiles.at(i)->writeContents(updated.at(i)))
+            continue;
+
+        _error = tr("The file %1 could not be written, no files were "
+                    "changed.").arg(changedFiles.at(i)->path());
+
+        // Roll back the files already written, including the failed one in
+        // case it was truncated
+        for(int j = i; j >= 0; --j)
+        {
+            if(!changedFiles.at(j)->writeContents(originals.at(j)))
+                qDebug() << "Could not restore file: "
+                         << changedFiles.at(j)->path();
+        }
+        return false;
+    }
+
+    if(replaced != 0)
+        *replaced = count;
+    return true;
+}
+
+QString FindReplace::error() const
+{
+    return _error;
+}
+
+QVector<FindMatch> FindReplace::searchFile(const QString &path,
+                                           const FindOptions &options)
+{
+    QVector<FindMatch> matches;
+    if(options.pattern.isEmpty())
+        return matches;
+
+    QFile fp(path);
+    if(!fp.open(QFile::ReadOnly))
+    {
+        qDebug() << "Could not open file for searching: " << path;
+        return matches;
+    }
+
+    // Map the file rather than copying it where the platform allows, falling
+    // back to reading it in for files which cannot be mapped
+    QByteArray contents;
+    const char *data = 0;
+    int size = static_cast<int>(fp.size());
+    uchar *mapped = (size > 0) ? fp.map(0, size) : 0;
+    if(mapped != 0)
+        data = reinterpret_cast<const char *>(mapped);
+    else
+    {
+        contents = fp.readAll();
+        data = contents.constData();
+        size = contents.size();
+    }
+
+    if(!options.regularExpression && options.caseSensitive)
+    {
+        // Literal case-sensitive searches can be matched on the raw UTF-8
+        // bytes, which avoids decoding files with no matches at all
+        QByteArray pattern = options.pattern.toUtf8();
+        QByteArrayMatcher matcher(pattern);
+        int line = 1;
+        int lineStart = 0;
+        int scanned = 0;
+        int pos = matcher.indexIn(data, size, 0);
+        while(pos >= 0)
+        {
+            for(; scanned < pos; ++scanned)
+            {
+                if(data[scanned] == '\n')
+                {
+                    ++line;
+                    lineStart = scanned + 1;
+                }
+            }
+
+            matches.push_back(makeMatch(path, data, size, line, lineStart, pos,
+                                        options.pattern.length()));
+            pos = matcher.indexIn(data, size, pos + pattern.size());
+        }
+    }
+    else
+        matches = searchText(path, QString::fromUtf8(data, size), options);
+
+    if(mapped != 0)
+        fp.unmap(mapped);
+
+    return matches;
+}
+
+QVector<FindMatch> FindReplace::searchText(const QString &path,
+                                           const QString &text,
+                                           const FindOptions &options)
+{
+    QVector<FindMatch> matches;
+    QRegExp rx(options.pattern, options.caseSensitive ? Qt::CaseSensitive
+                                                      : Qt::CaseInsensitive,
+               QRegExp::RegExp2);
+    if(options.pattern.isEmpty()
+            || (options.regularExpression && !rx.isValid()))
+        return matches;
+
+    int line = 1;
+    int lineStart = 0;
+    int scanned = 0;
+    int length = 0;
+    int pos = findNext(text, 0, options, rx, &length);
+    while(pos >= 0)
+    {
+        for(; scanned < pos; ++scanned)
+        {
+            if(text.at(scanned) == '\n')
+            {
+                ++line;
+                lineStart = scanned + 1;
+            }
+        }
+
+        int lineEnd = text.indexOf('\n', pos);
+        if(lineEnd < 0)
+            lineEnd = text.length();
+        if(lineEnd > lineStart && text.at(lineEnd-1) == '\r')
+            --lineEnd;
+
+        FindMatch match;
+        match.filePath = path;
+        match.line = line;
+        match.column = pos - lineStart;
+        match.length = length;
+        match.lineText = text.mid(lineStart, lineEnd - lineStart);
+        matches.push_back(match);
+
+        // Step past empty matches so that they cannot repeat forever
+        pos = findNext(text, pos + qMax(length, 1), options, rx, &length);
+    }
+
+    return matches;
+}
+
+int FindReplace::replaceAll(const QString &text, const FindOptions &options,
+                            const QString &replacement, QString *result)
+{
+    QRegExp rx(options.pattern, options.caseSensitive ? Qt::CaseSensitive
+                                                      : Qt::CaseInsensitive,
+               QRegExp::RegExp2);
+    if(options.pattern.isEmpty()
+            || (options.regularExpression && !rx.isValid()))
+    {
+        *result = text;
+        return 0;
+    }
+
+    QString output;
+    output.reserve(text.length());
+    int count = 0;
+    int copied = 0;
+    int length = 0;
+    int pos = findNext(text, 0, options, rx, &length);
+    while(pos >= 0)
+    {
+        output += text.mid(copied, pos - copied);
+        if(options.regularExpression)
+            output += expandCaptures(replacement, rx);
+        else
+            output += replacement;
+        copied = pos + length;
+        ++count;
+
+        pos = findNext(text, pos + qMax(length, 1), options, rx, &length);
+    }
+    output += text.mid(copied);
+
+    *result = output;
+    return count;
+}
+
+void FindReplace::resultReady(int index)
+{
+    QVector<FindMatch> matches = _watcher->resultAt(index);
+    if(!matches.isEmpty())
+        emit matchesFound(matches);
+}
+
+void FindReplace::finished()
+{
+    emit searchFinished();
+}
+
+}
@@ -0,0 +1,222 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FINDREPLACE_HPP
+#define FINDREPLACE_HPP
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+namespace Developer {
+
+class GPFile;
+
+/*!
+ * \brief The FindOptions struct describes what a find or replace operation
+ *  should match
+ */
+struct FindOptions
+{
+    FindOptions()
+        : regularExpression(false)
+        , caseSensitive(true)
+    {
+    }
+
+    //! The text to search for, or a regular expression if regularExpression
+    //! is set
+    QString pattern;
+    //! Whether the pattern should be interpreted as a regular expression
+    bool regularExpression;
+    //! Whether matching is case sensitive
+    bool caseSensitive;
+};
+
+/*!
+ * \brief The FindMatch struct records a single match of a search within a
+ *  file
+ */
+struct FindMatch
+{
+    FindMatch()
+        : line(0)
+        , column(0)
+        , length(0)
+    {
+    }
+
+    //! The path of the file containing the match
+    QString filePath;
+    //! The line of the match, starting from 1
+    int line;
+    //! The column of the match within the line, starting from 0
+    int column;
+    //! The length of the match in characters
+    int length;
+    //! The full text of the line containing the match
+    QString lineText;
+};
+
+/*!
+ * \brief The FileSearch class searches a single file for matches, it is the
+ *  functor mapped across the files of a project by FindReplace
+ */
+class FileSearch
+{
+public:
+    typedef QVector<FindMatch> result_type;
+
+    FileSearch(const FindOptions &options,
+               const QHash<QString, QString> &unsaved);
+
+    QVector<FindMatch> operator()(const QString &path) const;
+
+private:
+    FindOptions _options;
+    //! The text of files with unsaved changes, searched in place of the disk
+    QHash<QString, QString> _unsaved;
+};
+
+/*!
+ * \brief The FindReplace class runs find and replace operations across the
+ *  files of a project
+ *
+ * Searches run on the global thread pool with one file per task, reading each
+ * file from disk as a memory mapping where possible. Files with unsaved
+ * changes are searched as they stand in memory instead, so that their matches
+ * line up with what the editors show. Matches are streamed back
+ * through matchesFound() as each file completes, so results for a large
+ * project are shown before the whole search has finished and a search can be
+ * cancelled part of the way through.
+ *
+ * Replacement is all-or-nothing: the new contents of every file are computed
+ * before anything is written, and if writing any file fails the files already
+ * written are restored to their previous contents.
+ */
+class FindReplace : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FindReplace(QObject *parent = 0);
+    ~FindReplace();
+
+    /*!
+     * \brief Start searching the provided files in the background
+     *
+     * Any search which is still running is cancelled first. Results are
+     * reported through matchesFound() and searchFinished().
+     *
+     * \param paths     The paths of the files to search
+     * \param options   What to search for
+     * \param unsaved   The text of any files with unsaved changes, by path,
+     *  which is searched instead of the file on disk
+     */
+    void find(const QStringList &paths, const FindOptions &options,
+              const QHash<QString, QString> &unsaved
+              = QHash<QString, QString>());
+
+    /*!
+     * \brief Cancel the running search, if there is one
+     *
+     * Files which are already being searched are finished but their results
+     * are discarded.
+     */
+    void cancel();
+
+    /*!
+     * \brief Check whether a search is running
+     * \return Boolean, true if a search has been started and not yet finished
+     */
+    bool isRunning() const;
+
+    /*!
+     * \brief Replace every match within the provided files
+     *
+     * Files with unsaved changes are refused rather than overwritten, callers
+     * should offer to save them first.
+     *
+     * \param files         The files to replace within
+     * \param options       What to replace
+     * \param replacement   The replacement text. For regular expressions the
+     *  captures \\1 to \\9 are substituted.
+     * \param replaced      If non-zero, set to the number of replacements made
+     * \return Boolean, true if every file was updated, false if nothing was
+     *  changed. error() describes the failure.
+     */
+    bool replace(const QVector<GPFile *> &files, const FindOptions &options,
+                 const QString &replacement, int *replaced = 0);
+
+    /*!
+     * \brief Get a description of the last replace failure
+     * \return The error message, or an empty string
+     */
+    QString error() const;
+
+    /*!
+     * \brief Search a single file from disk
+     * \param path      The path to the file
+     * \param options   What to search for
+     * \return The matches in the order they appear within the file
+     */
+    static QVector<FindMatch> searchFile(const QString &path,
+                                         const FindOptions &options);
+
+    /*!
+     * \brief Search the text of a single file
+     * \param path      The path to record in the matches
+     * \param text      The text to search
+     * \param options   What to search for
+     * \return The matches in the order they appear within the text
+     */
+    static QVector<FindMatch> searchText(const QString &path,
+                                         const QString &text,
+                                         const FindOptions &options);
+
+    /*!
+     * \brief Replace every non-overlapping match within the provided text
+     * \param text          The text to replace within
+     * \param options       What to replace
+     * \param replacement   The replacement text
+     * \param result        Set to the resulting text
+     * \return The number of replacements made
+     */
+    static int replaceAll(const QString &text, const FindOptions &options,
+                          const QString &replacement, QString *result);
+
+signals:
+    void matchesFound(QVector<FindMatch> matches);
+    void searchFinished();
+
+protected slots:
+    void resultReady(int index);
+    void finished();
+
+private:
+    QFutureWatcher< QVector<FindMatch> > *_watcher;
+    QString _error;
+};
+
+}
+
+#endif // FINDREPLACE_HPP
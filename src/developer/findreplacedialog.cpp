@@ -0,0 +1,256 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "findreplacedialog.hpp"
+#include "ui_findreplacedialog.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMessageBox>
+
+#include "project.hpp"
+#include "rule.hpp"
+#include "program.hpp"
+#include "graph.hpp"
+
+namespace Developer {
+
+namespace {
+
+/*!
+ * \brief Get the text a file would be saved with, to search in place of the
+ *  file on disk while it has unsaved changes
+ * \param file  The file to read
+ * \return The file's text, or a null string for files of other types
+ */
+QString unsavedText(GPFile *file)
+{
+    Rule *rule = qobject_cast<Rule *>(file);
+    if(rule != 0)
+        return rule->toString();
+
+    Program *program = qobject_cast<Program *>(file);
+    if(program != 0)
+        return program->toString();
+
+    Graph *graph = qobject_cast<Graph *>(file);
+    if(graph != 0)
+        return graph->toString(graph->fileFormat());
+
+    return QString();
+}
+
+}
+
+FindReplaceDialog::FindReplaceDialog(Project *proj, GPFile *file,
+                                     QWidget *parent)
+    : QDialog(parent)
+    , _ui(new Ui::FindReplaceDialog)
+    , _project(proj)
+    , _file(file)
+    , _findReplace(new FindReplace(this))
+    , _matchCount(0)
+{
+    _ui->setupUi(this);
+
+    // Load the help stylesheet and apply it to this widget
+    QFile fp(":/stylesheets/helpdialog.css");
+    fp.open(QIODevice::ReadOnly | QIODevice::Text);
+    QString style = fp.readAll();
+    setStyleSheet(style);
+
+    if(_file != 0)
+        _ui->title_2->setText(tr("Find and Replace in '%1'").arg(
+                                  _file->fileName()));
+    else
+        _ui->title_2->setText(tr("Find and Replace in Project"));
+
+    connect(_findReplace, SIGNAL(matchesFound(QVector<FindMatch>)),
+            this, SLOT(matchesFound(QVector<FindMatch>)));
+    connect(_findReplace, SIGNAL(searchFinished()),
+            this, SLOT(searchFinished()));
+}
+
+FindReplaceDialog::~FindReplaceDialog()
+{
+    delete _ui;
+}
+
+void FindReplaceDialog::find()
+{
+    _ui->resultsTree->clear();
+    _matchCount = 0;
+
+    FindOptions findOptions = options();
+    if(findOptions.pattern.isEmpty())
+    {
+        _ui->statusLabel->setText(QString());
+        return;
+    }
+
+    // Files with unsaved changes are searched as they are in memory, so that
+    // the matches line up with the editors
+    QStringList paths;
+    QHash<QString, QString> unsaved;
+    QVector<GPFile *> searchFiles = files();
+    for(int i = 0; i < searchFiles.size(); ++i)
+    {
+        GPFile *file = searchFiles.at(i);
+        paths << file->path();
+        if(file->status() != GPFile::Modified)
+            continue;
+
+        QString text = unsavedText(file);
+        if(!text.isNull())
+            unsaved.insert(file->path(), text);
+    }
+
+    _ui->statusLabel->setText(tr("Searching %1 files...").arg(paths.size()));
+    _timer.start();
+    _findReplace->find(paths, findOptions, unsaved);
+}
+
+void FindReplaceDialog::replaceAll()
+{
+    FindOptions findOptions = options();
+    if(findOptions.pattern.isEmpty())
+        return;
+
+    _findReplace->cancel();
+
+    // Replacement works on the files as they are on disk, so anything with
+    // unsaved changes needs saving first
+    QVector<GPFile *> replaceFiles = files();
+    bool unsaved = false;
+    for(int i = 0; i < replaceFiles.size(); ++i)
+    {
+        if(replaceFiles.at(i)->status() == GPFile::Modified)
+        {
+            unsaved = true;
+            break;
+        }
+    }
+
+    if(unsaved)
+    {
+        QMessageBox::StandardButton ret = QMessageBox::question(
+                    this,
+                    tr("Unsaved Changes"),
+                    tr("Some of the files to be changed have unsaved changes. "
+                       "Save them before replacing?"),
+                    QMessageBox::Save | QMessageBox::Cancel,
+                    QMessageBox::Save
+                    );
+        if(ret != QMessageBox::Save)
+            return;
+
+        for(int i = 0; i < replaceFiles.size(); ++i)
+        {
+            if(replaceFiles.at(i)->status() == GPFile::Modified)
+                replaceFiles.at(i)->save();
+        }
+    }
+
+    int replaced = 0;
+    if(!_findReplace->replace(replaceFiles, findOptions,
+                              _ui->replaceEdit->text(), &replaced))
+    {
+        QMessageBox::warning(this, tr("Replace Failed"),
+                             _findReplace->error());
+        return;
+    }
+
+    // The matches listed are now out of date
+    _ui->resultsTree->clear();
+    _timer.invalidate();
+    _ui->statusLabel->setText(tr("Replaced %1 matches.").arg(replaced));
+}
+
+void FindReplaceDialog::matchesFound(QVector<FindMatch> matches)
+{
+    QList<QTreeWidgetItem *> items;
+    for(int i = 0; i < matches.size(); ++i)
+    {
+        const FindMatch &match = matches.at(i);
+        QTreeWidgetItem *item = new QTreeWidgetItem();
+        item->setText(0, QFileInfo(match.filePath).fileName());
+        item->setToolTip(0, match.filePath);
+        item->setText(1, QVariant(match.line).toString());
+        item->setText(2, match.lineText.trimmed());
+        items << item;
+    }
+
+    // Adding a file's matches in one go avoids relaying out the tree for
+    // every row
+    _ui->resultsTree->addTopLevelItems(items);
+    _matchCount += matches.size();
+}
+
+void FindReplaceDialog::searchFinished()
+{
+    if(!_timer.isValid())
+        return;
+
+    _ui->statusLabel->setText(tr("Found %1 matches in %2 ms.").arg(
+                                  _matchCount).arg(_timer.elapsed()));
+    _timer.invalidate();
+}
+
+void FindReplaceDialog::reject()
+{
+    _findReplace->cancel();
+    QDialog::reject();
+}
+
+FindOptions FindReplaceDialog::options() const
+{
+    FindOptions findOptions;
+    findOptions.pattern = _ui->findEdit->text();
+    findOptions.regularExpression =
+            _ui->regularExpressionCheckBox->isChecked();
+    findOptions.caseSensitive = _ui->caseSensitiveCheckBox->isChecked();
+    return findOptions;
+}
+
+QVector<GPFile *> FindReplaceDialog::files() const
+{
+    QVector<GPFile *> result;
+    if(_file != 0)
+    {
+        result.push_back(_file);
+        return result;
+    }
+
+    if(_project == 0)
+        return result;
+
+    QVector<Rule *> rules = _project->rules();
+    for(int i = 0; i < rules.size(); ++i)
+        result.push_back(rules.at(i));
+    QVector<Program *> programs = _project->programs();
+    for(int i = 0; i < programs.size(); ++i)
+        result.push_back(programs.at(i));
+    QVector<Graph *> graphs = _project->graphs();
+    for(int i = 0; i < graphs.size(); ++i)
+        result.push_back(graphs.at(i));
+    return result;
+}
+
+}
@@ -0,0 +1,84 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FINDREPLACEDIALOG_HPP
+#define FINDREPLACEDIALOG_HPP
+
+#include <QDialog>
+#include <QElapsedTimer>
+
+#include "findreplace.hpp"
+
+namespace Ui {
+class FindReplaceDialog;
+}
+
+namespace Developer {
+
+class Project;
+class GPFile;
+
+/*!
+ * \brief The FindReplaceDialog class provides find and replace across either
+ *  a single file or every file in a project
+ *
+ * Results are added to the list as each file is searched, so the dialog stays
+ * responsive while a large project is being searched.
+ */
+class FindReplaceDialog : public QDialog
+{
+    Q_OBJECT
+    
+public:
+    /*!
+     * \brief Construct a new find and replace dialog
+     * \param proj      The project to search
+     * \param file      The file to restrict the search to, or 0 to search all
+     *  of the rules, programs and graphs in the project
+     * \param parent    The parent widget
+     */
+    explicit FindReplaceDialog(Project *proj, GPFile *file = 0,
+                               QWidget *parent = 0);
+    ~FindReplaceDialog();
+
+public slots:
+    void find();
+    void replaceAll();
+
+    void matchesFound(QVector<FindMatch> matches);
+    void searchFinished();
+
+    void reject();
+
+private:
+    FindOptions options() const;
+    QVector<GPFile *> files() const;
+
+    Ui::FindReplaceDialog *_ui;
+    Project *_project;
+    GPFile *_file;
+    FindReplace *_findReplace;
+    QElapsedTimer _timer;
+    int _matchCount;
+};
+
+}
+
+#endif // FINDREPLACEDIALOG_HPP
@@ -118,6 +118,61 @@ enum LayoutDirections
 //! The default orientation to use
 #define DEFAULT_LAYOUT_DIRECTION Layout_TopToBottom
 
+/*!
+ * \brief The OGDF layout algorithms which can be applied to a graph view
+ */
+enum LayoutAlgorithms
+{
+    LayoutAlgorithm_Tree,
+    LayoutAlgorithm_Sugiyama,
+    LayoutAlgorithm_RadialTree,
+    LayoutAlgorithm_FPP,
+    LayoutAlgorithm_PlanarDraw,
+    LayoutAlgorithm_PlanarStraight,
+    LayoutAlgorithm_Schnyder,
+    LayoutAlgorithm_PlanarizationGrid,
+    LayoutAlgorithm_Circular,
+    LayoutAlgorithm_Spring,
+    LayoutAlgorithm_DavidsonHarel,
+    LayoutAlgorithm_FMMM,
+    LayoutAlgorithm_GEM,
+    //! The built in force-directed layout, see ForceLayout
+    LayoutAlgorithm_BarnesHut
+};
+
+//! Time in milliseconds after which a running layout is abandoned
+#define LAYOUT_TIMEOUT 120000
+//! Time in milliseconds a layout must run for before its progress is shown
+#define LAYOUT_PROGRESS_DELAY 500
+//! Size given to nodes which have no item to measure when laying out
+#define LAYOUT_DEFAULT_NODE_SIZE 30.0
+//! Iterations run on each level of a full force-directed layout
+#define FORCE_LAYOUT_ITERATIONS 100
+//! Iterations run when refining a force-directed layout
+#define FORCE_LAYOUT_REFINE_ITERATIONS 50
+//! Gap left between neighbouring nodes by the force-directed layout, on top of
+//! the average node size
+#define FORCE_LAYOUT_SPACING 50.0
+//! Barnes-Hut opening criterion, larger values are faster and less accurate
+#define FORCE_LAYOUT_THETA 0.9
+//! Minimum time in milliseconds between the frames shown while a
+//! force-directed layout runs
+#define FORCE_LAYOUT_FRAME_INTERVAL 100
+//! Time in milliseconds taken to move nodes to the positions from a layout
+#define LAYOUT_ANIMATION_DURATION 400
+//! Time in milliseconds between the frames of a layout transition, about 60
+//! frames per second
+#define LAYOUT_ANIMATION_FRAME_INTERVAL 16
+//! Cycles of edge bundling, each doubles the number of points on every edge
+#define EDGE_BUNDLING_CYCLES 6
+//! Compatibility, from 0 to 1, two edges need to be bundled together
+#define EDGE_BUNDLING_COMPATIBILITY 0.6
+//! Time in milliseconds after the last change to a graph before its edges are
+//! bundled again
+#define EDGE_BUNDLING_DELAY 500
+//! Size of the grid cells bundled edges are merged into paths by
+#define EDGE_BUNDLING_CELL_SIZE 512.0
+
 //! The default graph type to use (before set in QSettings)
 #define DEFAULT_GRAPH_FORMAT DotGraph
 
@@ -164,6 +219,58 @@ enum LayoutDirections
 //! Default Z-index of edges in the visualisation
 #define EDGE_Z_VALUE 10
 
+//! Level of detail below which labels and IDs are not drawn in the
+//! visualisation, text at this scale is too small to read
+#define GRAPH_TEXT_DETAIL_THRESHOLD 0.5
+//! Level of detail below which nodes are drawn as filled dots and edges as
+//! plain lines without arrowheads
+#define GRAPH_SHAPE_DETAIL_THRESHOLD 0.25
+
+//! Number of nodes and edges above which a GraphWidget shows its graph in a
+//! virtualised scene
+#define VIRTUAL_GRAPH_THRESHOLD 20000
+//! Cell size of the spatial index over node positions in a virtualised graph
+//! view
+#define VIRTUAL_GRID_CELL_SIZE 256.0
+//! Distance beyond the visible area of a virtualised graph view within which
+//! items are kept, so that short scrolls do not create any
+#define VIRTUAL_VIEW_MARGIN 200.0
+//! The largest number of nodes a virtualised graph view creates items for,
+//! with more in view it draws a density overview instead
+#define VIRTUAL_MAX_NODE_ITEMS 5000
+//! The largest number of edges a virtualised graph view creates items for, the
+//! rest of the edges in view are drawn as plain lines
+#define VIRTUAL_MAX_EDGE_ITEMS 10000
+//! Spacing of the grid used to place nodes in a virtualised graph view when the
+//! graph has no layout
+#define VIRTUAL_NODE_SPACING 80.0
+//! Width and height in pixels of the cells of the density overview
+#define DENSITY_CELL_SIZE 4.0
+//! Density, as a multiple of the graph's average, drawn at full strength by
+//! the density overview
+#define DENSITY_SATURATION 8.0
+//! Distance in pixels the mouse must be dragged over the density overview to
+//! choose a region to zoom into, rather than a point
+#define DENSITY_DRAG_DISTANCE 8
+//! Width and height in pixels of the tiles cached by a tiled GraphWidget
+#define GRAPH_TILE_SIZE 256
+//! Memory in kilobytes each tiled GraphWidget may use for its cached tiles
+#define GRAPH_TILE_CACHE_SIZE 65536
+//! Cell size of the index used to find the items under the mouse in a graph
+//! view
+#define HIT_GRID_CELL_SIZE 128.0
+//! Default length in pixels of the longest side of a batch rendered graph
+#define RENDER_DEFAULT_SIZE 1024
+//! Largest length in pixels allowed for either side of a batch rendered graph,
+//! which bounds the memory each render job needs for its image
+#define RENDER_MAX_SIZE 8192
+//! Margin in scene units left around a batch rendered graph
+#define RENDER_MARGIN 20.0
+//! Length in pixels of the sides of a graph thumbnail
+#define THUMBNAIL_SIZE 160
+//! Directory, within a project's directory, in which graph thumbnails are kept
+#define THUMBNAIL_DIRECTORY ".thumbnails"
+
 //! Defines whether or not debug information is shown in the visualisation view
 #define SHOW_VISUALISATION_DEBUG false
 #define DEBUG_COLOUR QColor(Qt::lightGray)
@@ -193,6 +193,36 @@ bool GPFile::open()
     }
 }
 
+bool GPFile::writeContents(const QByteArray &contents)
+{
+    if(_path.isEmpty() || _path.startsWith(":") || _status == GPFile::ReadOnly)
+        return false;
+
+    if(_fp == 0)
+        _fp = new QFile(_path);
+    _fp->close();
+
+    if(!_fp->open(QFile::Truncate | QFile::WriteOnly))
+    {
+        qDebug() << "Could not open file for writing: " << _path;
+        return false;
+    }
+
+    // As with the derived save() functions, both the truncation and the write
+    // are picked up by the file watcher
+    _internalChanges += 2;
+
+    qint64 written = _fp->write(contents);
+    _fp->close();
+    if(written != contents.size())
+    {
+        qDebug() << "Write failed for file: " << _path;
+        return false;
+    }
+
+    return open();
+}
+
 void GPFile::fileChanged(const QString &filePath)
 {
     if(_internalChanges > 0)
@@ -165,6 +165,19 @@ public:
      */
     virtual bool open();
 
+    /*!
+     * \brief Replace the contents of this file on disk and read it back in
+     *
+     * This is used for edits made to the file as text rather than through the
+     * setters of the derived classes, such as a project-wide replace. The write
+     * is not reported as an external modification.
+     *
+     * \param contents  The new contents of the file
+     * \return Boolean, true if written and reopened successfully, false
+     *  otherwise
+     */
+    bool writeContents(const QByteArray &contents);
+
 signals:
     /*!
      * \brief This signal is emitted whenever it is detected that the file has
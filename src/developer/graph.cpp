@@ -31,6 +31,7 @@ namespace Developer {
 Graph::Graph(const QString &graphPath, bool autoInitialise, QObject *parent)
     : GPFile(graphPath, parent)
     , _idCounter(1)
+    , _edgeIndexValid(false)
 {
     if(autoInitialise && !graphPath.isEmpty())
         open();
@@ -39,6 +40,7 @@ Graph::Graph(const QString &graphPath, bool autoInitialise, QObject *parent)
 Graph::Graph(const graph_t &inputGraph, QObject *parent)
     : GPFile(QString(), parent)
     , _idCounter(1)
+    , _edgeIndexValid(false)
 {
     // We don't follow the normal open procedure here, since this is not coming
     // from a file. This is intended for create in-memory graph objects and
@@ -62,17 +64,8 @@ bool Graph::save()
     _fp->open(QFile::Truncate | QFile::WriteOnly);
     qDebug() << "Saving graph file: " << _fp->fileName();
 
-    // Determine how to save it
-    GraphTypes type = DEFAULT_GRAPH_FORMAT;
-    if(_path.endsWith(GP_GRAPH_ALTERNATIVE_EXTENSION))
-        type = AlternativeGraph;
-    if(_path.endsWith(GP_GRAPH_DOT_EXTENSION))
-        type = DotGraph;
-    if(_path.endsWith(GP_GRAPH_GXL_EXTENSION))
-        type = GxlGraph;
-
     QString saveText;
-    switch(type)
+    switch(fileFormat())
     {
     case AlternativeGraph:
         saveText = toAlternative();
@@ -107,6 +100,18 @@ bool Graph::save()
     return true;
 }
 
+GraphTypes Graph::fileFormat() const
+{
+    GraphTypes type = DEFAULT_GRAPH_FORMAT;
+    if(_path.endsWith(GP_GRAPH_ALTERNATIVE_EXTENSION))
+        type = AlternativeGraph;
+    if(_path.endsWith(GP_GRAPH_DOT_EXTENSION))
+        type = DotGraph;
+    if(_path.endsWith(GP_GRAPH_GXL_EXTENSION))
+        type = GxlGraph;
+    return type;
+}
+
 bool Graph::saveAs(const QString &filePath)
 {
     QString thePath = filePath;
@@ -240,6 +245,12 @@ bool Graph::open()
 
     qDebug() << "Opening graph file: " << _path;
 
+    // Reopening a graph (e.g. after its file has been rewritten) replaces the
+    // nodes and edges it already holds. This is not a modification, so the
+    // status set by GPFile::open() is kept
+    FileStatus status = _status;
+    clear();
+
     QString contents = _fp->readAll();
     std::string contentsString = contents.toStdString();
     graph_t graph;
@@ -278,6 +289,12 @@ bool Graph::open()
     if(!openGraphT(graph))
         return false;
 
+    if(_status != status)
+    {
+        _status = status;
+        emit statusChanged(_status);
+    }
+
     qDebug() << "    Finished parsing graph file: " << _path;
 
     emit openComplete();
@@ -481,6 +498,24 @@ bool Graph::containsEdge(const QString &id) const
     return (edge(id) != 0);
 }
 
+bool Graph::hasEdge(const Node *from, const Node *to) const
+{
+    if(!_edgeIndexValid)
+    {
+        _edgeIndex.clear();
+        _edgeIndex.reserve(_edges.size());
+        for(edgeConstIter iter = _edges.begin(); iter != _edges.end(); ++iter)
+        {
+            Edge *e = *iter;
+            _edgeIndex.insert(qMakePair<const Node *, const Node *>(e->from(),
+                                                                    e->to()));
+        }
+        _edgeIndexValid = true;
+    }
+
+    return _edgeIndex.contains(qMakePair(from, to));
+}
+
 QString Graph::toString(int outputType, bool keepLayout) const
 {
     QSettings settings;
@@ -783,7 +818,10 @@ Edge *Graph::addEdge(const QString &id, Node *from, Node *to, const List &label)
 
     Edge *e = new Edge(id, from, to, label, this);
     connect(e, SIGNAL(edgeChanged()), this, SLOT(trackChange()));
+    connect(e, SIGNAL(fromChanged(Node*)), this, SLOT(invalidateEdgeIndex()));
+    connect(e, SIGNAL(toChanged(Node*)), this, SLOT(invalidateEdgeIndex()));
     _edges.push_back(e);
+    _edgeIndexValid = false;
 
     _status = Modified;
     emit statusChanged(Modified);
@@ -801,7 +839,10 @@ Edge *Graph::addEdge(Node *from, Node *to, const List &label)
 
     Edge *e = new Edge(newId(), from, to, label, this);
     connect(e, SIGNAL(edgeChanged()), this, SLOT(trackChange()));
+    connect(e, SIGNAL(fromChanged(Node*)), this, SLOT(invalidateEdgeIndex()));
+    connect(e, SIGNAL(toChanged(Node*)), this, SLOT(invalidateEdgeIndex()));
     _edges.push_back(e);
+    _edgeIndexValid = false;
 
     _status = Modified;
     emit statusChanged(Modified);
@@ -873,6 +914,7 @@ bool Graph::removeEdge(const QString &id)
     }
 
     _edges.erase(iter);
+    _edgeIndexValid = false;
     delete e;
     _status = Modified;
     emit statusChanged(_status);
@@ -987,19 +1029,50 @@ bool Graph::openGraphT(const graph_t &inputGraph)
 
         Edge *e = new Edge(edge.id.c_str(), from, to, List(edge.label), this);
         connect(e, SIGNAL(edgeChanged()), this, SLOT(trackChange()));
+        connect(e, SIGNAL(fromChanged(Node*)),
+                this, SLOT(invalidateEdgeIndex()));
+        connect(e, SIGNAL(toChanged(Node*)),
+                this, SLOT(invalidateEdgeIndex()));
         emit edgeAdded(e);
         _edges.push_back(e);
+        _edgeIndexValid = false;
     }
 
     return true;
 }
 
+void Graph::clear()
+{
+    if(_nodes.empty() && _edges.empty())
+        return;
+
+    // Listeners drop anything referring to the nodes and edges while they
+    // still exist
+    emit aboutToClear();
+
+    for(edgeIter iter = _edges.begin(); iter != _edges.end(); ++iter)
+        delete *iter;
+    _edges.clear();
+    for(nodeIter iter = _nodes.begin(); iter != _nodes.end(); ++iter)
+        delete *iter;
+    _nodes.clear();
+
+    _edgeIndex.clear();
+    _edgeIndexValid = false;
+    emit graphChanged();
+}
+
 void Graph::trackChange()
 {
     _status = Modified;
     emit statusChanged(_status);
 }
 
+void Graph::invalidateEdgeIndex()
+{
+    _edgeIndexValid = false;
+}
+
 QString Graph::newId()
 {
     // Just find the first free integer, return as a string as the grammar
@@ -28,6 +28,8 @@
 #include "edge.hpp"
 #include <vector>
 #include <QRect>
+#include <QPair>
+#include <QSet>
 
 namespace Developer {
 
@@ -43,6 +45,11 @@ public:
 
     bool save();
     bool saveAs(const QString &filePath);
+    /*!
+     * \brief Get the format save() writes this graph in, from its extension
+     * \return A value from the GraphTypes enum
+     */
+    GraphTypes fileFormat() const;
     bool exportTo(const QString &filePath, GraphTypes outputType);
 
     bool open();
@@ -64,6 +71,19 @@ public:
     bool containsNode(const QString &id) const;
     bool containsEdge(const QString &id) const;
 
+    /*!
+     * \brief Check whether there is at least one edge from one node to another
+     *
+     * This answers from an index of node pairs which is rebuilt on the first
+     * query after edges are added, removed or re-attached, so repeated queries
+     * between edits are constant time.
+     *
+     * \param  from    The source node
+     * \param  to      The target node
+     * \return True if such an edge exists
+     */
+    bool hasEdge(const Node *from, const Node *to) const;
+
     QString toString(int outputType = DefaultGraph, bool keepLayout = true) const;
     QString toGxl(bool keepLayout = true) const;
     QString toDot(bool keepLayout = true) const;
@@ -77,6 +97,11 @@ signals:
     void edgeAdded(Edge *e);
     void nodeRemoved(QString id);
     void edgeRemoved(QString id);
+    /*!
+     * \brief Emitted once before every node and edge is deleted together, in
+     *  place of a nodeRemoved() or edgeRemoved() signal for each
+     */
+    void aboutToClear();
     void openComplete();
 
 public slots:
@@ -105,10 +130,12 @@ public slots:
 
 protected slots:
     void trackChange();
+    void invalidateEdgeIndex();
 
 protected:
     // Protected member functions
     bool openGraphT(const graph_t &inputGraph);
+    void clear();
     QString newId();
 
     // Protected member variables
@@ -116,6 +143,8 @@ protected:
     QRect _canvas;
     std::vector<Node *> _nodes;
     std::vector<Edge *> _edges;
+    mutable QSet<QPair<const Node *, const Node *> > _edgeIndex;
+    mutable bool _edgeIndexValid;
 
     // Some convenience typedefs (not going to tie in C++11 as a requirement)
     typedef std::vector<Node *>::iterator nodeIter;
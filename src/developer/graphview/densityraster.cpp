@@ -0,0 +1,332 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "densityraster.hpp"
+#include "global.hpp"
+
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Developer {
+
+namespace {
+
+//! Number of nodes whose cells are worked out at once, small enough for the
+//! cell indices to stay in the L1 cache
+const int BLOCK_SIZE = 256;
+//! Ranges are not split below this many nodes or edges, smaller ranges cost
+//! more to set up and sum than they save
+const int MIN_RANGE_SIZE = 16384;
+//! Most points an edge is sampled at, however long it is
+const int MAX_EDGE_SAMPLES = 64;
+//! Largest image a render will produce, in pixels
+const int MAX_CELLS = 4096 * 4096;
+//! Opacity of the densest areas of edges, so that nodes stand out above them
+const double EDGE_STRENGTH = 0.6;
+
+/*!
+ * \brief Find the cell a point falls in without branching
+ * \param column   The position of the point in cells from the left of the grid
+ * \param row      The position of the point in cells from the top of the grid
+ * \param columns  The number of columns in the grid
+ * \param rows     The number of rows in the grid
+ * \param outside  The cell to return for a point outside the grid
+ * \return The index of the cell, counted across then down
+ */
+inline int cellOf(float column, float row, int columns, int rows, int outside)
+{
+    // Shifted by one cell and clamped, so that a point outside the grid lands
+    // just outside it however far away it is, and then checked as unsigned so
+    // that both sides are tested at once
+    int x = static_cast<int>(std::min(std::max(column + 1.0f, 0.0f),
+                                      columns + 1.0f)) - 1;
+    int y = static_cast<int>(std::min(std::max(row + 1.0f, 0.0f),
+                                      rows + 1.0f)) - 1;
+    int inside = (static_cast<unsigned>(x) < static_cast<unsigned>(columns))
+            & (static_cast<unsigned>(y) < static_cast<unsigned>(rows));
+    return inside ? y * columns + x : outside;
+}
+
+}
+
+DensityRaster::DensityRaster()
+    : _edgeLength(0.0)
+{
+}
+
+void DensityRaster::clear()
+{
+    _x.clear();
+    _y.clear();
+    _edgeFrom.clear();
+    _edgeTo.clear();
+    _edgeLength = 0.0;
+    _bounds = QRectF();
+}
+
+void DensityRaster::setGraph(const QVector<QPointF> &positions,
+                             const QVector< QPair<int, int> > &edges)
+{
+    clear();
+
+    int nodeCount = positions.size();
+    _x.resize(nodeCount);
+    _y.resize(nodeCount);
+    double left = 0.0, top = 0.0, right = 0.0, bottom = 0.0;
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        const QPointF &pos = positions.at(i);
+        _x[i] = static_cast<float>(pos.x());
+        _y[i] = static_cast<float>(pos.y());
+        left = (i == 0) ? pos.x() : qMin(left, pos.x());
+        top = (i == 0) ? pos.y() : qMin(top, pos.y());
+        right = (i == 0) ? pos.x() : qMax(right, pos.x());
+        bottom = (i == 0) ? pos.y() : qMax(bottom, pos.y());
+    }
+    _bounds = QRectF(left, top, right - left, bottom - top);
+
+    _edgeFrom.reserve(edges.size());
+    _edgeTo.reserve(edges.size());
+    for(int i = 0; i < edges.size(); ++i)
+    {
+        int from = edges.at(i).first;
+        int to = edges.at(i).second;
+        if(from < 0 || from >= nodeCount || to < 0 || to >= nodeCount)
+            continue;
+
+        _edgeFrom.push_back(from);
+        _edgeTo.push_back(to);
+        double dx = _x.at(to) - _x.at(from);
+        double dy = _y.at(to) - _y.at(from);
+        _edgeLength += std::sqrt(dx * dx + dy * dy);
+    }
+}
+
+bool DensityRaster::isEmpty() const
+{
+    return _x.isEmpty();
+}
+
+QImage DensityRaster::render(const QRectF &rect, qreal cellSize,
+                             const QColor &nodeColour,
+                             const QColor &edgeColour,
+                             QRectF *imageRect) const
+{
+    QRectF area = rect.normalized();
+    if(isEmpty() || cellSize <= 0 || area.isEmpty())
+        return QImage();
+
+    Grid grid;
+    grid.cellSize = cellSize;
+    grid.left = std::floor(area.left() / cellSize) * cellSize;
+    grid.top = std::floor(area.top() / cellSize) * cellSize;
+    grid.columns = qMax(1, static_cast<int>(
+                            std::ceil((area.right() - grid.left) / cellSize)));
+    grid.rows = qMax(1, static_cast<int>(
+                         std::ceil((area.bottom() - grid.top) / cellSize)));
+    if(static_cast<qint64>(grid.columns) * grid.rows > MAX_CELLS)
+        return QImage();
+
+    if(imageRect != 0)
+        *imageRect = QRectF(grid.left, grid.top, grid.columns * cellSize,
+                            grid.rows * cellSize);
+
+    QVector<quint32> nodes = accumulate(grid, false);
+    QVector<quint32> edges = accumulate(grid, true);
+
+    // The counts are scaled against the average over the whole graph rather
+    // than the most in this image, so that any two images at one cell size
+    // agree where they meet
+    double cellArea = cellSize * cellSize;
+    double graphArea = qMax(_bounds.width(), cellSize)
+            * qMax(_bounds.height(), cellSize);
+    double nodeAverage = _x.size() * cellArea / graphArea;
+    double edgeAverage = (_edgeLength / cellSize + _edgeFrom.size())
+            * cellArea / graphArea;
+    double nodeScale = 1.0 / std::log(
+                1.0 + qMax(1.0, DENSITY_SATURATION * nodeAverage));
+    double edgeScale = 1.0 / std::log(
+                1.0 + qMax(1.0, DENSITY_SATURATION * edgeAverage));
+
+    QImage image(grid.columns, grid.rows,
+                 QImage::Format_ARGB32_Premultiplied);
+    if(image.isNull())
+        return image;
+
+    for(int row = 0; row < grid.rows; ++row)
+    {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(row));
+        const quint32 *nodeRow = nodes.constData() + row * grid.columns;
+        const quint32 *edgeRow = edges.constData() + row * grid.columns;
+        for(int column = 0; column < grid.columns; ++column)
+        {
+            if(nodeRow[column] == 0 && edgeRow[column] == 0)
+            {
+                line[column] = 0;
+                continue;
+            }
+
+            // Nodes are drawn over edges, premultiplied by their opacity
+            double node = qMin(1.0, std::log(1.0 + nodeRow[column])
+                               * nodeScale);
+            double edge = EDGE_STRENGTH
+                    * qMin(1.0, std::log(1.0 + edgeRow[column]) * edgeScale);
+            double under = edge * (1.0 - node);
+            line[column] = qRgba(
+                        qRound(255 * (nodeColour.redF() * node
+                                      + edgeColour.redF() * under)),
+                        qRound(255 * (nodeColour.greenF() * node
+                                      + edgeColour.greenF() * under)),
+                        qRound(255 * (nodeColour.blueF() * node
+                                      + edgeColour.blueF() * under)),
+                        qRound(255 * (node + under)));
+        }
+    }
+
+    return image;
+}
+
+void DensityRaster::count(CountRange &range)
+{
+    range.counts.fill(0, range.grid->columns * range.grid->rows + 1);
+    if(range.edges)
+        range.raster->countEdges(&range);
+    else
+        range.raster->countNodes(&range);
+}
+
+void DensityRaster::countNodes(CountRange *range) const
+{
+    const Grid &grid = *range->grid;
+    const float *x = _x.constData();
+    const float *y = _y.constData();
+    quint32 *counts = range->counts.data();
+
+    const float left = static_cast<float>(grid.left);
+    const float top = static_cast<float>(grid.top);
+    const float inverse = static_cast<float>(1.0 / grid.cellSize);
+    // Nodes outside the grid are counted in a spare cell at the end
+    const int outside = grid.columns * grid.rows;
+
+    int cells[BLOCK_SIZE];
+    for(int block = range->begin; block < range->end; block += BLOCK_SIZE)
+    {
+        int size = qMin(BLOCK_SIZE, range->end - block);
+        const float *blockX = x + block;
+        const float *blockY = y + block;
+
+        // Without branches, so that the compiler can vectorise this loop
+        for(int i = 0; i < size; ++i)
+            cells[i] = cellOf((blockX[i] - left) * inverse,
+                              (blockY[i] - top) * inverse,
+                              grid.columns, grid.rows, outside);
+
+        for(int i = 0; i < size; ++i)
+            ++counts[cells[i]];
+    }
+}
+
+void DensityRaster::countEdges(CountRange *range) const
+{
+    const Grid &grid = *range->grid;
+    const float *x = _x.constData();
+    const float *y = _y.constData();
+    quint32 *counts = range->counts.data();
+
+    const float left = static_cast<float>(grid.left);
+    const float top = static_cast<float>(grid.top);
+    const float inverse = static_cast<float>(1.0 / grid.cellSize);
+    const float columns = static_cast<float>(grid.columns);
+    const float rows = static_cast<float>(grid.rows);
+    const int outside = grid.columns * grid.rows;
+
+    int cells[MAX_EDGE_SAMPLES];
+    for(int e = range->begin; e < range->end; ++e)
+    {
+        // The ends of the edge in cells of the grid
+        float column1 = (x[_edgeFrom.at(e)] - left) * inverse;
+        float row1 = (y[_edgeFrom.at(e)] - top) * inverse;
+        float column2 = (x[_edgeTo.at(e)] - left) * inverse;
+        float row2 = (y[_edgeTo.at(e)] - top) * inverse;
+        if(std::max(column1, column2) < 0.0f
+                || std::min(column1, column2) >= columns
+                || std::max(row1, row2) < 0.0f
+                || std::min(row1, row2) >= rows)
+            continue;
+
+        // Roughly one sample for each cell the edge crosses
+        float dx = column2 - column1;
+        float dy = row2 - row1;
+        float cellsCrossed = std::sqrt(dx * dx + dy * dy);
+        int samples = (cellsCrossed < MAX_EDGE_SAMPLES - 1)
+                ? static_cast<int>(cellsCrossed) + 1
+                : MAX_EDGE_SAMPLES;
+        float step = 1.0f / samples;
+
+        // Without branches, as for the nodes
+        for(int k = 0; k < samples; ++k)
+        {
+            float t = (k + 0.5f) * step;
+            cells[k] = cellOf(column1 + t * dx, row1 + t * dy,
+                              grid.columns, grid.rows, outside);
+        }
+
+        for(int k = 0; k < samples; ++k)
+            ++counts[cells[k]];
+    }
+}
+
+QVector<quint32> DensityRaster::accumulate(const Grid &grid, bool edges) const
+{
+    int cellCount = grid.columns * grid.rows;
+    int itemCount = edges ? _edgeFrom.size() : _x.size();
+    if(itemCount == 0)
+        return QVector<quint32>(cellCount + 1, 0);
+
+    int rangeCount = qMin(itemCount / MIN_RANGE_SIZE + 1,
+                          qMax(1, QThread::idealThreadCount()));
+    QVector<CountRange> ranges(rangeCount);
+    for(int i = 0; i < rangeCount; ++i)
+    {
+        ranges[i].raster = this;
+        ranges[i].grid = &grid;
+        ranges[i].edges = edges;
+        ranges[i].begin = static_cast<int>(
+                    static_cast<qint64>(itemCount) * i / rangeCount);
+        ranges[i].end = static_cast<int>(
+                    static_cast<qint64>(itemCount) * (i + 1) / rangeCount);
+    }
+    QtConcurrent::blockingMap(ranges, &DensityRaster::count);
+
+    QVector<quint32> total = ranges.at(0).counts;
+    quint32 *sum = total.data();
+    for(int r = 1; r < rangeCount; ++r)
+    {
+        const quint32 *counts = ranges.at(r).counts.constData();
+        for(int i = 0; i < cellCount; ++i)
+            sum[i] += counts[i];
+    }
+    return total;
+}
+
+}
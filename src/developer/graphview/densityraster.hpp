@@ -0,0 +1,120 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DENSITYRASTER_HPP
+#define DENSITYRASTER_HPP
+
+#include <QColor>
+#include <QImage>
+#include <QPair>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+namespace Developer {
+
+/*!
+ * \brief The DensityRaster class draws how densely the nodes and edges of a
+ *  graph are packed as a heatmap, for graphs with too many nodes in view to
+ *  draw them one by one
+ *
+ * Node positions are kept as flat arrays of floats (structure of arrays). A
+ * render counts the nodes in each cell of a grid in blocks: the cell of every
+ * node in a block is worked out by a loop without branches, which the
+ * compiler can vectorise, before the counts are added up. Edges are counted
+ * at points sampled along their length. The nodes and edges are split into
+ * ranges which are counted in parallel with QtConcurrent, each range into its
+ * own grid, and the grids are summed at the end.
+ *
+ * The grid is aligned to multiples of the cell size in scene coordinates and
+ * the counts are scaled against the average density of the whole graph, so
+ * that neighbouring areas rendered separately, such as the tiles of a tiled
+ * GraphWidget, meet without seams. A render takes time in proportion to the
+ * size of the graph and of the image, whatever is in view.
+ */
+class DensityRaster
+{
+public:
+    DensityRaster();
+
+    void clear();
+    /*!
+     * \brief Set the graph to draw
+     * \param positions The position of each node
+     * \param edges     The edges as pairs of indices into positions
+     */
+    void setGraph(const QVector<QPointF> &positions,
+                  const QVector< QPair<int, int> > &edges);
+    bool isEmpty() const;
+
+    /*!
+     * \brief Draw the density of the graph within a rectangle
+     * \param rect          The area to draw, in scene coordinates
+     * \param cellSize      The size in scene coordinates of each pixel
+     * \param nodeColour    The colour of the densest areas of nodes
+     * \param edgeColour    The colour of the densest areas of edges
+     * \param imageRect     Set to the area the image covers, which is rect
+     *  widened to the cell grid
+     * \return An image with one pixel for each cell, transparent where the
+     *  graph is empty
+     */
+    QImage render(const QRectF &rect, qreal cellSize,
+                  const QColor &nodeColour, const QColor &edgeColour,
+                  QRectF *imageRect) const;
+
+private:
+    struct Grid
+    {
+        double left;
+        double top;
+        double cellSize;
+        int columns;
+        int rows;
+    };
+
+    struct CountRange
+    {
+        const DensityRaster *raster;
+        const Grid *grid;
+        bool edges;
+        int begin;
+        int end;
+        QVector<quint32> counts;
+    };
+
+    static void count(CountRange &range);
+
+    void countNodes(CountRange *range) const;
+    void countEdges(CountRange *range) const;
+    QVector<quint32> accumulate(const Grid &grid, bool edges) const;
+
+    QVector<float> _x;
+    QVector<float> _y;
+    QVector<int> _edgeFrom;
+    QVector<int> _edgeTo;
+    //! The total length of the edges, from which their average density is
+    //! worked out
+    double _edgeLength;
+    QRectF _bounds;
+};
+
+}
+
+#endif // DENSITYRASTER_HPP
@@ -0,0 +1,496 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "edgebundler.hpp"
+#include "spatialgrid.hpp"
+
+#include <QHash>
+#include <QPair>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Developer {
+
+namespace {
+
+//! Stiffness of the springs between neighbouring points of a polyline
+const double SPRING = 0.1;
+//! Distance a point moves per unit of force in the first cycle
+const double INITIAL_STEP = 0.1;
+//! Number of iterations run in the first cycle
+const int INITIAL_ITERATIONS = 90;
+//! Lengths and distances below this are treated as zero
+const double EPSILON = 1e-6;
+//! Number of ranges the edges are split into per thread, more than one
+//! balances the load when parts of the graph are denser than others
+const int RANGES_PER_THREAD = 4;
+
+/*!
+ * \brief Return the point on the infinite line through a line segment which
+ *  is closest to the provided point
+ */
+QPointF project(const QPointF &point, const QLineF &line)
+{
+    double length2 = line.dx() * line.dx() + line.dy() * line.dy();
+    double t = ((point.x() - line.x1()) * line.dx()
+                + (point.y() - line.y1()) * line.dy()) / length2;
+    return line.pointAt(t);
+}
+
+/*!
+ * \brief Return how much of one edge is in view of another, from 0 to 1
+ *
+ * The second edge is projected onto the line through the first. The closer
+ * the middle of the projection is to the middle of the first edge, relative
+ * to the length of the projection, the more visible the edges are.
+ */
+double visibility(const QLineF &p, const QLineF &q)
+{
+    QLineF projected(project(q.p1(), p), project(q.p2(), p));
+    if(projected.length() < EPSILON)
+        return 0.0;
+
+    QLineF middles(p.pointAt(0.5), projected.pointAt(0.5));
+    return qMax(0.0, 1.0 - 2.0 * middles.length() / projected.length());
+}
+
+}
+
+EdgeBundler::EdgeBundler()
+    : _pointCount(0)
+    , _threshold(0.6)
+    , _stepSize(INITIAL_STEP)
+    , _cycles(6)
+    , _cycle(0)
+    , _cycleIteration(0)
+    , _cycleIterations(INITIAL_ITERATIONS)
+    , _iteration(0)
+{
+}
+
+void EdgeBundler::setEdges(const QVector<QLineF> &edges)
+{
+    _edges = edges;
+    _lengths.resize(edges.size());
+    _bundled.resize(edges.size());
+    for(int i = 0; i < edges.size(); ++i)
+    {
+        _lengths[i] = edges.at(i).length();
+        _bundled[i] = (_lengths.at(i) > EPSILON);
+    }
+}
+
+double EdgeBundler::compatibility() const
+{
+    return _threshold;
+}
+
+void EdgeBundler::setCompatibility(double threshold)
+{
+    // The search for compatible edges is bounded by the threshold, with none
+    // at all it would compare every pair
+    _threshold = qBound(0.01, threshold, 1.0);
+}
+
+int EdgeBundler::cycles() const
+{
+    return _cycles;
+}
+
+void EdgeBundler::setCycles(int count)
+{
+    _cycles = qMax(0, count);
+}
+
+int EdgeBundler::totalIterations() const
+{
+    int total = 0;
+    int iterations = INITIAL_ITERATIONS;
+    for(int i = 0; i < _cycles; ++i)
+    {
+        total += iterations;
+        iterations = qMax(1, iterations * 2 / 3);
+    }
+    return total;
+}
+
+void EdgeBundler::start()
+{
+    _cycle = 0;
+    _cycleIteration = 0;
+    _cycleIterations = INITIAL_ITERATIONS;
+    _iteration = 0;
+    _stepSize = INITIAL_STEP;
+
+    // Each edge starts as a straight line with one point halfway along
+    int edgeCount = _edges.size();
+    _pointCount = 3;
+    _x.resize(edgeCount * _pointCount);
+    _y.resize(edgeCount * _pointCount);
+    for(int i = 0; i < edgeCount; ++i)
+    {
+        for(int j = 0; j < _pointCount; ++j)
+        {
+            QPointF point = _edges.at(i).pointAt(
+                        static_cast<double>(j) / (_pointCount - 1));
+            _x[i * _pointCount + j] = point.x();
+            _y[i * _pointCount + j] = point.y();
+        }
+    }
+    _nextX.resize(_x.size());
+    _nextY.resize(_y.size());
+
+    if(edgeCount == 0)
+    {
+        _cycle = _cycles;
+        return;
+    }
+
+    findCompatible();
+}
+
+bool EdgeBundler::step()
+{
+    if(finished())
+        return false;
+
+    int edgeCount = _edges.size();
+    int rangeCount = qMin(edgeCount,
+                          qMax(1, QThread::idealThreadCount())
+                          * RANGES_PER_THREAD);
+    QVector<ForceRange> ranges(rangeCount);
+    for(int i = 0; i < rangeCount; ++i)
+    {
+        ranges[i].bundler = this;
+        ranges[i].x = _nextX.data();
+        ranges[i].y = _nextY.data();
+        ranges[i].begin = static_cast<int>(
+                    static_cast<qint64>(edgeCount) * i / rangeCount);
+        ranges[i].end = static_cast<int>(
+                    static_cast<qint64>(edgeCount) * (i + 1) / rangeCount);
+    }
+    QtConcurrent::blockingMap(ranges, &EdgeBundler::computeForces);
+    _x.swap(_nextX);
+    _y.swap(_nextY);
+    ++_iteration;
+
+    if(++_cycleIteration < _cycleIterations)
+        return true;
+
+    if(++_cycle >= _cycles)
+        return false;
+
+    // The next cycle works in finer detail
+    _cycleIteration = 0;
+    _cycleIterations = qMax(1, _cycleIterations * 2 / 3);
+    _stepSize /= 2.0;
+    subdivide(2 * (_pointCount - 2) + 2);
+    return true;
+}
+
+int EdgeBundler::iteration() const
+{
+    return _iteration;
+}
+
+bool EdgeBundler::finished() const
+{
+    return _cycle >= _cycles;
+}
+
+bool EdgeBundler::bundled(int edge) const
+{
+    return _bundled.at(edge);
+}
+
+QVector<QPolygonF> EdgeBundler::polylines() const
+{
+    QVector<QPolygonF> result(_edges.size());
+    for(int i = 0; i < _edges.size(); ++i)
+    {
+        if(!_bundled.at(i) || _pointCount == 0)
+            continue;
+
+        QPolygonF &polyline = result[i];
+        polyline.reserve(_pointCount);
+        for(int j = 0; j < _pointCount; ++j)
+            polyline.append(QPointF(_x.at(i * _pointCount + j),
+                                    _y.at(i * _pointCount + j)));
+    }
+    return result;
+}
+
+void EdgeBundler::computeForces(ForceRange &range)
+{
+    const EdgeBundler *bundler = range.bundler;
+    int pointCount = bundler->_pointCount;
+    const double *x = bundler->_x.constData();
+    const double *y = bundler->_y.constData();
+    const int *compatible = bundler->_compatible.constData();
+    const double *weights = bundler->_weights.constData();
+    const char *reversed = bundler->_reversed.constData();
+    double stepSize = bundler->_stepSize;
+
+    for(int e = range.begin; e < range.end; ++e)
+    {
+        int base = e * pointCount;
+        // The end points never move
+        range.x[base] = x[base];
+        range.y[base] = y[base];
+        range.x[base + pointCount - 1] = x[base + pointCount - 1];
+        range.y[base + pointCount - 1] = y[base + pointCount - 1];
+
+        bool bundled = bundler->_bundled.at(e);
+        double spring = bundled
+                ? SPRING / (bundler->_lengths.at(e) * (pointCount - 1))
+                : 0.0;
+        int first = bundler->_compatibleStart.at(e);
+        int last = bundler->_compatibleStart.at(e + 1);
+
+        for(int i = 1; i < pointCount - 1; ++i)
+        {
+            int point = base + i;
+            double fx = spring * (x[point - 1] + x[point + 1] - 2 * x[point]);
+            double fy = spring * (y[point - 1] + y[point + 1] - 2 * y[point]);
+
+            // Each compatible edge pulls with a strength of its compatibility,
+            // whatever its distance
+            for(int k = first; k < last; ++k)
+            {
+                int other = compatible[k] * pointCount
+                        + (reversed[k] ? pointCount - 1 - i : i);
+                double dx = x[other] - x[point];
+                double dy = y[other] - y[point];
+                double distance = std::sqrt(dx * dx + dy * dy);
+                if(distance > EPSILON)
+                {
+                    fx += dx * weights[k] / distance;
+                    fy += dy * weights[k] / distance;
+                }
+            }
+
+            range.x[point] = x[point] + stepSize * fx;
+            range.y[point] = y[point] + stepSize * fy;
+        }
+    }
+}
+
+void EdgeBundler::findCompatible()
+{
+    int edgeCount = _edges.size();
+    double maxLength = 0.0;
+    for(int i = 0; i < edgeCount; ++i)
+        maxLength = qMax(maxLength, _lengths.at(i));
+
+    SpatialGrid<int> midpoints(qMax(maxLength, 1.0));
+    for(int i = 0; i < edgeCount; ++i)
+    {
+        if(_bundled.at(i))
+            midpoints.insert(i, QRectF(_edges.at(i).pointAt(0.5),
+                                       QSizeF(0, 0)));
+    }
+
+    QVector< QVector<int> > neighbours(edgeCount);
+    QVector< QVector<double> > weights(edgeCount);
+    for(int p = 0; p < edgeCount; ++p)
+    {
+        if(!_bundled.at(p))
+            continue;
+
+        // The position term alone falls below the threshold once the middles
+        // are further apart than this, so no edge beyond it can be compatible
+        double radius = (_lengths.at(p) + maxLength) / 2.0
+                * (1.0 / _threshold - 1.0);
+        QPointF middle = _edges.at(p).pointAt(0.5);
+        QList<int> candidates = midpoints.query(
+                    QRectF(middle.x() - radius, middle.y() - radius,
+                           2 * radius, 2 * radius));
+        for(int i = 0; i < candidates.size(); ++i)
+        {
+            int q = candidates.at(i);
+            if(q <= p)
+                continue;
+
+            double compatibility = pairCompatibility(p, q);
+            if(compatibility < _threshold)
+                continue;
+
+            neighbours[p].push_back(q);
+            weights[p].push_back(compatibility);
+            neighbours[q].push_back(p);
+            weights[q].push_back(compatibility);
+        }
+    }
+
+    _compatibleStart.resize(edgeCount + 1);
+    _compatible.clear();
+    _weights.clear();
+    _reversed.clear();
+    for(int p = 0; p < edgeCount; ++p)
+    {
+        _compatibleStart[p] = _compatible.size();
+        const QLineF &edge = _edges.at(p);
+        for(int i = 0; i < neighbours.at(p).size(); ++i)
+        {
+            const QLineF &other = _edges.at(neighbours.at(p).at(i));
+            _compatible.push_back(neighbours.at(p).at(i));
+            _weights.push_back(weights.at(p).at(i));
+            _reversed.push_back(edge.dx() * other.dx()
+                                + edge.dy() * other.dy() < 0.0);
+        }
+    }
+    _compatibleStart[edgeCount] = _compatible.size();
+}
+
+double EdgeBundler::pairCompatibility(int p, int q) const
+{
+    const QLineF &first = _edges.at(p);
+    const QLineF &second = _edges.at(q);
+    double firstLength = _lengths.at(p);
+    double secondLength = _lengths.at(q);
+
+    double angle = std::fabs(first.dx() * second.dx()
+                             + first.dy() * second.dy())
+            / (firstLength * secondLength);
+
+    double average = (firstLength + secondLength) / 2.0;
+    double scale = 2.0 / (average / qMin(firstLength, secondLength)
+                          + qMax(firstLength, secondLength) / average);
+
+    QLineF middles(first.pointAt(0.5), second.pointAt(0.5));
+    double position = average / (average + middles.length());
+
+    double visible = qMin(visibility(first, second),
+                          visibility(second, first));
+
+    return angle * scale * position * visible;
+}
+
+void EdgeBundler::subdivide(int pointCount)
+{
+    int edgeCount = _edges.size();
+    QVector<double> x(edgeCount * pointCount);
+    QVector<double> y(edgeCount * pointCount);
+    QVector<double> segments(_pointCount - 1);
+
+    for(int e = 0; e < edgeCount; ++e)
+    {
+        int oldBase = e * _pointCount;
+        int base = e * pointCount;
+
+        double length = 0.0;
+        for(int i = 0; i < _pointCount - 1; ++i)
+        {
+            double dx = _x.at(oldBase + i + 1) - _x.at(oldBase + i);
+            double dy = _y.at(oldBase + i + 1) - _y.at(oldBase + i);
+            segments[i] = std::sqrt(dx * dx + dy * dy);
+            length += segments.at(i);
+        }
+
+        x[base] = _x.at(oldBase);
+        y[base] = _y.at(oldBase);
+        x[base + pointCount - 1] = _x.at(oldBase + _pointCount - 1);
+        y[base + pointCount - 1] = _y.at(oldBase + _pointCount - 1);
+
+        // Place the new points at equal distances along the old polyline
+        double spacing = length / (pointCount - 1);
+        int segment = 0;
+        double walked = 0.0;
+        for(int i = 1; i < pointCount - 1; ++i)
+        {
+            double target = i * spacing;
+            while(segment < _pointCount - 2
+                  && walked + segments.at(segment) < target)
+            {
+                walked += segments.at(segment);
+                ++segment;
+            }
+
+            double t = (segments.at(segment) > EPSILON)
+                    ? (target - walked) / segments.at(segment)
+                    : 0.0;
+            int from = oldBase + segment;
+            x[base + i] = _x.at(from) + t * (_x.at(from + 1) - _x.at(from));
+            y[base + i] = _y.at(from) + t * (_y.at(from + 1) - _y.at(from));
+        }
+    }
+
+    _pointCount = pointCount;
+    _x = x;
+    _y = y;
+    _nextX.resize(_x.size());
+    _nextY.resize(_y.size());
+}
+
+BundleJob runEdgeBundling(BundleJob job)
+{
+    EdgeBundler bundler;
+    bundler.setEdges(job.lines);
+    bundler.setCompatibility(EDGE_BUNDLING_COMPATIBILITY);
+    bundler.setCycles(EDGE_BUNDLING_CYCLES);
+    bundler.start();
+    while(bundler.step())
+    {
+        if(job.isStale())
+        {
+            job.cancelled = true;
+            return job;
+        }
+    }
+
+    // Merge the polylines into one path for each grid cell their centres
+    // fall in
+    QVector<QPolygonF> polylines = bundler.polylines();
+    QVector<QString> bundledIds;
+    QHash<QPair<int, int>, int> cells;
+    for(int i = 0; i < polylines.size(); ++i)
+    {
+        if(polylines.at(i).isEmpty())
+            continue;
+        bundledIds.push_back(job.edgeIds.at(i));
+
+        QPointF centre = polylines.at(i).boundingRect().center();
+        QPair<int, int> cell(
+                    static_cast<int>(std::floor(centre.x()
+                                                / EDGE_BUNDLING_CELL_SIZE)),
+                    static_cast<int>(std::floor(centre.y()
+                                                / EDGE_BUNDLING_CELL_SIZE)));
+        int index = cells.value(cell, -1);
+        if(index < 0)
+        {
+            index = job.paths.size();
+            cells.insert(cell, index);
+            job.paths.push_back(QPainterPath());
+        }
+        job.paths[index].addPolygon(polylines.at(i));
+    }
+
+    job.edgeIds = bundledIds;
+    job.lines.clear();
+    for(int i = 0; i < job.paths.size(); ++i)
+        job.bounds.push_back(job.paths.at(i).controlPointRect());
+
+    return job;
+}
+
+}
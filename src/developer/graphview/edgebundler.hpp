@@ -0,0 +1,207 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDGEBUNDLER_HPP
+#define EDGEBUNDLER_HPP
+
+#include <QAtomicInt>
+#include <QLineF>
+#include <QPainterPath>
+#include <QPolygonF>
+#include <QRectF>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include "global.hpp"
+
+namespace Developer {
+
+/*!
+ * \brief The EdgeBundler class bends the edges of a dense graph into bundles
+ *  so that edges running the same way are drawn together
+ *
+ * This is force-directed edge bundling after Holten and van Wijk. Each edge is
+ * split into a polyline whose end points stay fixed. Every point is held in
+ * place by springs to its neighbours on the polyline and is pulled towards the
+ * matching point of every compatible edge. Two edges are compatible if they
+ * are of a similar length and angle, near each other and in view of each
+ * other along their lengths. The pairs are found once, through a SpatialGrid
+ * of edge midpoints, and edges below the compatibility threshold are never
+ * compared again.
+ *
+ * The simulation runs in cycles, each of which doubles the number of points
+ * on every polyline, halves the step size and runs two thirds as many
+ * iterations as the one before. The points of each polyline only depend on
+ * the previous iteration, so an iteration is computed in parallel over ranges
+ * of edges with QtConcurrent.
+ *
+ * Edges with no length, such as loops, cannot be bundled and are left out of
+ * the result. Like ForceLayout the bundler is driven one iteration at a time
+ * with step().
+ *
+ * \code
+ *  EdgeBundler bundler;
+ *  bundler.setEdges(lines);
+ *  bundler.start();
+ *  while(bundler.step())
+ *      ;
+ *  polylines = bundler.polylines();
+ * \endcode
+ */
+class EdgeBundler
+{
+public:
+    EdgeBundler();
+
+    /*!
+     * \brief Set the edges to bundle, each as a line between the centres of
+     *  its end points
+     */
+    void setEdges(const QVector<QLineF> &edges);
+
+    /*!
+     * \brief The compatibility, from 0 to 1, two edges need to be bundled
+     *  together
+     */
+    double compatibility() const;
+    void setCompatibility(double threshold);
+    int cycles() const;
+    void setCycles(int count);
+    int totalIterations() const;
+
+    /*!
+     * \brief Prepare to run the bundling, finding the compatible pairs of
+     *  edges
+     */
+    void start();
+    /*!
+     * \brief Run one iteration of the bundling
+     * \return true if there are iterations left to run
+     */
+    bool step();
+    int iteration() const;
+    bool finished() const;
+
+    /*!
+     * \brief Whether an edge can be bundled, edges with no length cannot
+     */
+    bool bundled(int edge) const;
+    /*!
+     * \brief The bundled edges
+     * \return A polyline from the start to the end of each edge, by index, or
+     *  an empty polygon for an edge which cannot be bundled
+     */
+    QVector<QPolygonF> polylines() const;
+
+private:
+    struct ForceRange
+    {
+        const EdgeBundler *bundler;
+        double *x;
+        double *y;
+        int begin;
+        int end;
+    };
+
+    static void computeForces(ForceRange &range);
+
+    void findCompatible();
+    double pairCompatibility(int p, int q) const;
+    void subdivide(int pointCount);
+
+    QVector<QLineF> _edges;
+    QVector<double> _lengths;
+    QVector<char> _bundled;
+
+    // The compatible edges of edge i are compatible[compatibleStart[i]] to
+    // compatible[compatibleStart[i+1] - 1], with their compatibility and
+    // whether they run the opposite way
+    QVector<int> _compatibleStart;
+    QVector<int> _compatible;
+    QVector<double> _weights;
+    QVector<char> _reversed;
+
+    // The points of every polyline, _pointCount to an edge
+    int _pointCount;
+    QVector<double> _x;
+    QVector<double> _y;
+    QVector<double> _nextX;
+    QVector<double> _nextY;
+
+    double _threshold;
+    double _stepSize;
+    int _cycles;
+    int _cycle;
+    int _cycleIteration;
+    int _cycleIterations;
+    int _iteration;
+};
+
+/*!
+ * \brief The BundleJob struct carries the edges of a scene to a background
+ *  EdgeBundler and the bundled paths back again
+ *
+ * Like LayoutJob the job holds no pointers into the scene and is tagged with a
+ * revision, so a superseded job gives up between iterations and its result is
+ * discarded.
+ */
+struct BundleJob
+{
+    BundleJob()
+        : revision(0)
+        , cancelled(false)
+    {
+    }
+
+    bool isStale() const
+    {
+        return latestRevision.isNull()
+                || latestRevision->fetchAndAddRelaxed(0) != revision;
+    }
+
+    //! The revision of the bundling request this job was started for
+    int revision;
+    //! The latest bundling request, shared with the scene
+    QSharedPointer<QAtomicInt> latestRevision;
+    //! The ID of each edge, replaced with the IDs of the edges which were
+    //! bundled
+    QVector<QString> edgeIds;
+    //! Each edge as a line between the centres of its end points
+    QVector<QLineF> lines;
+    //! The bundled edges, merged into one path for each cell of a grid so
+    //! that a few paths are drawn and those out of view can be skipped
+    QVector<QPainterPath> paths;
+    //! The bounding rectangle of each path
+    QVector<QRectF> bounds;
+    //! Set if the job gave up because it had become stale
+    bool cancelled;
+};
+
+/*!
+ * \brief Bundle the edges of a job, this is run on a worker thread
+ * \param job   The job to run
+ * \return The job with the bundled paths filled in
+ */
+BundleJob runEdgeBundling(BundleJob job);
+
+}
+
+#endif // EDGEBUNDLER_HPP
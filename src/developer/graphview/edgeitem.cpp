@@ -21,13 +21,13 @@
 #include "edgeitem.hpp"
 #include "edge.hpp"
 #include "editedgedialog.hpp"
+#include "graphviewstyle.hpp"
 
 #include "graph.hpp"
 
 #include <QApplication>
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
-#include <QSettings>
 #include <QGraphicsSceneMouseEvent>
 #include <QDebug>
 #include <QGraphicsScene>
@@ -38,6 +38,7 @@ EdgeItem::EdgeItem(Edge *edge, NodeItem *edgeFrom, NodeItem *edgeTo,
                    QGraphicsItem *parent)
     : GraphItem(edge->id(), edge->label().toString(), "edge", parent)
     , _edge(edge)
+    , _dirty(true)
     , _from(edgeFrom)
     , _to(edgeTo)
     , _hover(false)
@@ -47,6 +48,8 @@ EdgeItem::EdgeItem(Edge *edge, NodeItem *edgeFrom, NodeItem *edgeTo,
     setAcceptHoverEvents(true);
     setFlags(QGraphicsItem::ItemIsSelectable);
 
+    connect(edge, SIGNAL(edgeChanged()), this, SLOT(syncEdge()));
+
     setFrom(edgeFrom);
     setTo(edgeTo);
 
@@ -57,6 +60,7 @@ EdgeItem::EdgeItem(const QString &edgeId, NodeItem *edgeFrom, NodeItem *edgeTo,
                    const QString &edgeLabel, QGraphicsItem *parent)
     : GraphItem(edgeId, edgeLabel, "edge", parent)
     , _edge(0)
+    , _dirty(true)
     , _from(edgeFrom)
     , _to(edgeTo)
     , _hover(false)
@@ -87,8 +91,36 @@ NodeItem *EdgeItem::to() const
     return _to;
 }
 
+void EdgeItem::setId(const QString &itemId)
+{
+    if(itemId == id())
+        return;
+
+    GraphItem::setId(itemId);
+
+    if(_edge != 0)
+        _edge->setId(itemId);
+}
+
+void EdgeItem::setLabel(const QString &itemLabel)
+{
+    if(itemLabel == label())
+        return;
+
+    GraphItem::setLabel(itemLabel);
+    prepareGeometryChange();
+    nodeMoved();
+
+    if(_edge != 0)
+        _edge->setLabel(List(itemLabel));
+}
+
 void EdgeItem::setFrom(NodeItem *edgeFrom)
 {
+    // Stop following the previous end point unless it is also the other end
+    if(_from != 0 && _from != edgeFrom && _from != _to)
+        disconnect(_from, 0, this, 0);
+
     // Assign the node this edge is from and ensure that it sends a signal to
     // existing edges that they may need to recalculate
     _from = edgeFrom;
@@ -104,6 +136,10 @@ void EdgeItem::setFrom(NodeItem *edgeFrom)
 
 void EdgeItem::setTo(NodeItem *edgeTo)
 {
+    // Stop following the previous end point unless it is also the other end
+    if(_to != 0 && _to != edgeTo && _to != _from)
+        disconnect(_to, 0, this, 0);
+
     // Assign the node this edge is to and ensure that it sends a signal to
     // existing edges that they may need to recalculate
     _to = edgeTo;
@@ -117,6 +153,29 @@ void EdgeItem::setTo(NodeItem *edgeTo)
     connect(_to, SIGNAL(shapeChanged()), this, SLOT(nodeMoved()));
 }
 
+void EdgeItem::setEdge(Edge *edge, NodeItem *edgeFrom, NodeItem *edgeTo)
+{
+    if(_from != 0)
+        disconnect(_from, 0, this, 0);
+    if(_to != 0)
+        disconnect(_to, 0, this, 0);
+    if(_edge != 0)
+        disconnect(_edge, 0, this, 0);
+    connect(edge, SIGNAL(edgeChanged()), this, SLOT(syncEdge()));
+
+    _edge = edge;
+    _id = edge->id();
+    _label = edge->label().toString();
+    _hover = false;
+    setItemState(edge->isPhantomEdge() ? GraphItem_Deleted : GraphItem_Normal);
+
+    setFrom(edgeFrom);
+    setTo(edgeTo);
+
+    prepareGeometryChange();
+    nodeMoved();
+}
+
 void EdgeItem::deleteEdge()
 {
     setItemState(GraphItem::GraphItem_Deleted);
@@ -147,32 +206,19 @@ QLineF EdgeItem::line() const
 
 QPolygonF EdgeItem::polygon(double polygonWidth) const
 {
+    updateGeometry();
     if(_polygons.contains(polygonWidth))
         return _polygons[polygonWidth];
 
-    QSettings settings;
-    QFont font = settings.value("GraphView/Edges/Font", qApp->font()
-                                ).value<QFont>();
-    qreal arrowSize = settings.value("GraphView/Edges/ArrowSize", 9).toDouble();
-    QFontMetrics metrics(font);
+    GraphViewStyle *style = GraphViewStyle::instance();
+    qreal arrowSize = style->edgeArrowSize();
+    const QFontMetrics &metrics = style->edgeMetrics();
 
     if(_from != _to)
     {
         QLineF edgeLine = line();
         // Is there an edge in the other direction?
-        std::vector<Edge *> edges;
-        if(_to->node() == 0)
-            edges = std::vector<Edge *>();
-        else
-            edges = _to->node()->edgesFrom();
-        bool loopback = false;
-        for(std::vector<Edge *>::iterator iter = edges.begin();
-            iter != edges.end(); ++iter)
-        {
-            Edge *e = *iter;
-            if(e->to()->id() == _from->id())
-                loopback = true;
-        }
+        bool loopback = hasReverseEdge();
 
         if(loopback)
         {
@@ -284,18 +330,18 @@ QPolygonF EdgeItem::edgePolygon(double padding) const
 {
     // This method works exactly like the above one, except that the width of
     // the produced polygon is just sufficient to contain the arrow itself
-    QSettings settings;
-    qreal arrowSize = settings.value("GraphView/Edges/ArrowSize", 9).toDouble();
-    return polygon(arrowSize+(2*padding));
+    return polygon(GraphViewStyle::instance()->edgeArrowSize()+(2*padding));
 }
 
 QRectF EdgeItem::boundingRect() const
 {
+    updateGeometry();
     return _boundingRect;
 }
 
 QPainterPath EdgeItem::shape() const
 {
+    updateGeometry();
     if(!_shape.isEmpty())
         return _shape;
     else
@@ -304,29 +350,17 @@ QPainterPath EdgeItem::shape() const
 
 QPainterPath EdgeItem::path() const
 {
+    updateGeometry();
     if(!_path.isEmpty())
         return _path;
 
-    QSettings settings;
-    qreal lineWidth = settings.value("GraphView/Edges/LineWidth", 1.5).toDouble();
+    qreal lineWidth = GraphViewStyle::instance()->edgeLineWidth();
 
     if(_from != _to)
     {
         QLineF edgeLine = line();
         // Is there an edge in the other direction?
-        std::vector<Edge *> edges;
-        if(_to->node() == 0)
-            edges = std::vector<Edge *>();
-        else
-            edges = _to->node()->edgesFrom();
-        bool loopback = false;
-        for(std::vector<Edge *>::iterator iter = edges.begin();
-            iter != edges.end(); ++iter)
-        {
-            Edge *e = *iter;
-            if(e->to()->id() == _from->id())
-                loopback = true;
-        }
+        bool loopback = hasReverseEdge();
 
         if(loopback)
         {
@@ -419,11 +453,11 @@ QPainterPath EdgeItem::path() const
 
 QPainterPath EdgeItem::arrowHead(qreal adjustment) const
 {
+    updateGeometry();
     if(_arrowHeads.contains(adjustment))
         return _arrowHeads[adjustment];
 
-    QSettings settings;
-    qreal arrowSize = settings.value("GraphView/Edges/ArrowSize", 9).toDouble();
+    qreal arrowSize = GraphViewStyle::instance()->edgeArrowSize();
 
     QLineF drawLine(_path.pointAtPercent(.95 + adjustment),
                     _path.pointAtPercent(1.0 + adjustment));
@@ -472,61 +506,25 @@ void EdgeItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
 {
     Q_UNUSED(widget)
 
-    QSettings settings;
-    QFont font = settings.value("GraphView/Edges/Font", qApp->font()
-                                ).value<QFont>();
-    qreal lineWidth = settings.value("GraphView/Edges/LineWidth", 1.5).toDouble();
-    QFontMetrics metrics(font);
-    QColor textColour = settings.value("GraphView/Edges/TextColour",
-                                       QColor(0x33, 0x33, 0x33)).value<QColor>();
-    QColor lineColour;
-    if(option->state & QStyle::State_Selected)
-    {
-        lineColour  = settings.value("GraphView/Edges/SelectedColour",
-                                     QColor(0xcc,0xcc,0x33)).value<QColor>();
-    }
-    else
+    updateGeometry();
+    GraphViewStyle *style = GraphViewStyle::instance();
+    const QFontMetrics &metrics = style->edgeMetrics();
+    bool selected = option->state & QStyle::State_Selected;
+    qreal detail = option->levelOfDetailFromTransform(painter->worldTransform());
+
+    if(detail < GRAPH_SHAPE_DETAIL_THRESHOLD)
     {
-        if(_hover)
-        {
-            switch(itemState())
-            {
-            case GraphItem_New:
-                lineColour  = settings.value("GraphView/Edges/HoverColourNew",
-                                             QColor(0x33,0xff,0x33)).value<QColor>();
-                break;
-            case GraphItem_Deleted:
-            case GraphItem_Invalid:
-                lineColour  = settings.value("GraphView/Edges/HoverColourDeleted",
-                                             QColor(0xff,0x33,0x33, 0x55)).value<QColor>();
-                break;
-            case GraphItem_Normal:
-            default:
-                lineColour  = settings.value("GraphView/Edges/HoverColour",
-                                             QColor(0x33,0x33,0xdd)).value<QColor>();
-                break;
-            }
-        }
+        // A straight line between the end points is indistinguishable from
+        // the curve at this scale. Loops are drawn as they are as they have no
+        // useful straight approximation.
+        painter->setPen(style->edgePen(itemState(), selected, _hover));
+        painter->setBrush(Qt::NoBrush);
+        if(_from == _to || _path.elementCount() < 2)
+            painter->drawPath(_path);
         else
-        {
-            switch(itemState())
-            {
-            case GraphItem_New:
-                lineColour  = settings.value("GraphView/Edges/ColourNew",
-                                             QColor(0x33,0xdd,0x33)).value<QColor>();
-                break;
-            case GraphItem_Deleted:
-            case GraphItem_Invalid:
-                lineColour  = settings.value("GraphView/Edges/ColourDeleted",
-                                             QColor(0xdd,0x33,0x33, 0x55)).value<QColor>();
-                break;
-            case GraphItem_Normal:
-            default:
-                lineColour  = settings.value("GraphView/Edges/Colour",
-                                             QColor(0x33,0x33,0x33)).value<QColor>();
-                break;
-            }
-        }
+            painter->drawLine(QPointF(_path.elementAt(0)),
+                              _path.currentPosition());
+        return;
     }
 
     if(SHOW_VISUALISATION_DEBUG)
@@ -537,11 +535,9 @@ void EdgeItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
         painter->drawPolygon(edgePolygon());
     }
 
-    QPen pen(lineColour);
-    pen.setWidth(lineWidth);
-    painter->setPen(pen);
+    painter->setPen(style->edgePen(itemState(), selected, _hover));
     painter->setBrush(Qt::NoBrush);
-    painter->setFont(font);
+    painter->setFont(style->edgeFont());
 
     // Draw the arrow
     QPainterPath painterPath = path();
@@ -553,11 +549,14 @@ void EdgeItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
         arrowPath = arrowHead(-0.05);
     else
         arrowPath = arrowHead();
-    painter->setBrush(lineColour);
+    painter->setBrush(style->edgeBrush(itemState(), selected, _hover));
     painter->drawPath(arrowPath);
 
+    if(detail < GRAPH_TEXT_DETAIL_THRESHOLD)
+        return;
+
     // Now draw the label
-    painter->setPen(textColour);
+    painter->setPen(style->edgeTextColour());
     QPointF midPoint = painterPath.pointAtPercent(.5);
     painter->translate(midPoint);
     qreal angle = painterPath.angleAtPercent(.5);
@@ -568,9 +567,7 @@ void EdgeItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
     painter->drawText(QPointF(-xOffset,-3), label());
 
     // Draw the edge ID
-    QColor idColour = textColour;
-    idColour.setAlpha(80);
-    painter->setPen(idColour);
+    painter->setPen(style->edgeIdColour());
     xOffset = metrics.width(id())/2;
     qreal yOffset = metrics.height()-3;
     painter->drawText(QPointF(-xOffset, yOffset), id());
@@ -578,19 +575,70 @@ void EdgeItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
 
 void EdgeItem::nodeMoved()
 {
-    QSettings settings;
-    qreal arrowSize = settings.value("GraphView/Edges/ArrowSize", 9).toDouble();
+    if(_dirty)
+        return;
+
+    // The old geometry is still cached at this point, which is what
+    // prepareGeometryChange() needs
+    prepareGeometryChange();
+    _dirty = true;
+}
+
+void EdgeItem::updateGeometry() const
+{
+    if(!_dirty)
+        return;
+
+    // Cleared first so that the accessors used below compute rather than
+    // recurse into here
+    _dirty = false;
+
+    qreal arrowSize = GraphViewStyle::instance()->edgeArrowSize();
     _path = QPainterPath();
-    _path = path();
     _arrowHeads.clear();
+    _polygons.clear();
+    _shape = QPainterPath();
+
+    _path = path();
     _arrowHeads.insert(0.0, arrowHead());
     _arrowHeads.insert(-0.05, arrowHead(-0.05));
-    _polygons.clear();
     _polygons.insert(-1.0, polygon());
     _polygons.insert(arrowSize, polygon(arrowSize));
-    _shape = QPainterPath();
-    _shape.addPolygon(polygon());
+    _shape.addPolygon(_polygons[-1.0]);
     _boundingRect = _polygons[-1.0].boundingRect();
+}
+
+bool EdgeItem::hasReverseEdge() const
+{
+    Node *fromNode = _from->node();
+    Node *toNode = _to->node();
+    if(fromNode == 0 || toNode == 0 || toNode->parent() == 0)
+        return false;
+
+    return toNode->parent()->hasEdge(toNode, fromNode);
+}
+
+void EdgeItem::syncEdge()
+{
+    // Changes made through this item have already been applied, so this only
+    // does anything when the edge was edited directly. Changes to the end
+    // points are handled by GraphScene, which owns the node items.
+    if(_edge->id() != id())
+        GraphItem::setId(_edge->id());
+
+    if(_edge->isPhantomEdge())
+        setItemState(GraphItem_Deleted);
+    else if(itemState() == GraphItem_Deleted)
+        setItemState(GraphItem_Normal);
+
+    QString edgeLabel = _edge->label().toString();
+    if(edgeLabel != label())
+    {
+        _label = edgeLabel;
+        prepareGeometryChange();
+        nodeMoved();
+    }
+
     update();
 }
 
@@ -45,9 +45,20 @@ public:
     NodeItem *from() const;
     NodeItem *to() const;
 
+    void setId(const QString &itemId);
+    void setLabel(const QString &itemLabel);
     void setFrom(NodeItem *edgeFrom);
     void setTo(NodeItem *edgeTo);
 
+    /*!
+     * \brief Rebind this item to a different edge between the provided node
+     *  items
+     *
+     * The item stops following its previous end points. This allows a
+     * virtualised GraphScene to reuse items as the view scrolls.
+     */
+    void setEdge(Edge *edge, NodeItem *edgeFrom, NodeItem *edgeTo);
+
     void preserveEdge();
     void deleteEdge();
 
@@ -63,8 +74,18 @@ public:
                QWidget *widget);
 
 public slots:
+    /*!
+     * \brief Mark the geometry of this edge as out of date
+     *
+     * The geometry is recomputed once when it is next needed, which is at the
+     * latest when the scene next paints. However many times the end points
+     * move in between, the work is done once per frame.
+     */
     void nodeMoved();
 
+protected slots:
+    void syncEdge();
+
 protected:
     // Handle hover events
     void hoverEnterEvent(QGraphicsSceneHoverEvent *event);
@@ -80,12 +101,18 @@ protected:
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *event);
 
 private:
+    void updateGeometry() const;
+    bool hasReverseEdge() const;
+
     Edge *_edge;
-    QRectF _boundingRect;
-    QMap<qreal, QPolygonF> _polygons;
-    QPainterPath _shape;
-    QPainterPath _path;
-    QMap<qreal, QPainterPath> _arrowHeads;
+    // Geometry caches, filled in by updateGeometry() when first needed after
+    // nodeMoved()
+    mutable bool _dirty;
+    mutable QRectF _boundingRect;
+    mutable QMap<qreal, QPolygonF> _polygons;
+    mutable QPainterPath _shape;
+    mutable QPainterPath _path;
+    mutable QMap<qreal, QPainterPath> _arrowHeads;
     NodeItem *_from;
     NodeItem *_to;
     bool _hover;
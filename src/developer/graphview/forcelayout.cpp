@@ -0,0 +1,723 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "forcelayout.hpp"
+
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Developer {
+
+namespace {
+
+//! Marks a quadtree cell with no body
+const int EMPTY_CELL = -1;
+//! Marks a quadtree cell whose bodies are held by its children
+const int INTERNAL_CELL = -2;
+//! Depth below which bodies share a cell rather than subdividing it further,
+//! this only matters for nodes at (almost) the same position
+const int MAX_DEPTH = 24;
+//! Strength of repulsion relative to attraction. Fruchterman and Reingold only
+//! repel nodes within a short distance, with repulsion over the whole graph a
+//! weaker constant is needed to keep edges near the ideal length (see Hu,
+//! "Efficient and high quality force-directed graph drawing").
+const double REPULSION = 0.2;
+//! Strength of the pull towards the centre of the layout
+const double GRAVITY = 0.05;
+//! Factor applied to the temperature by adaptive cooling
+const double ADAPTIVE_COOLING = 0.9;
+//! Temperature at the end of a layout, as a fraction of the ideal length
+const double FINAL_TEMPERATURE = 0.01;
+//! Coarsening stops once a level has no more than this many nodes
+const int COARSEST_NODES = 50;
+//! Coarsening also stops once a level is no longer much smaller than the one
+//! it came from
+const double COARSENING_LIMIT = 0.8;
+//! Number of ranges the nodes are split into per thread, more than one
+//! balances the load when parts of the graph are denser than others
+const int RANGES_PER_THREAD = 4;
+
+}
+
+ForceLayout::ForceLayout()
+    : _level(0)
+    , _idealLength(80.0)
+    , _theta(0.9)
+    , _temperature(0.0)
+    , _cooling(1.0)
+    , _centreX(0.0)
+    , _centreY(0.0)
+    , _energy(0.0)
+    , _progress(0)
+    , _iteration(0)
+    , _levelIteration(0)
+    , _iterations(300)
+{
+}
+
+void ForceLayout::setGraph(const QVector<QPointF> &positions,
+                           const QVector< QPair<int, int> > &edges)
+{
+    _levels.resize(1);
+    _levels[0].nodeCount = positions.size();
+    _levels[0].parent.clear();
+    buildAdjacency(&_levels[0], edges);
+    _level = 0;
+
+    int nodeCount = positions.size();
+    _initialPositions = positions;
+    _x.resize(nodeCount);
+    _y.resize(nodeCount);
+    _dx.fill(0.0, nodeCount);
+    _dy.fill(0.0, nodeCount);
+    _movable.fill(1, nodeCount);
+    _free.clear();
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        _x[i] = positions.at(i).x();
+        _y[i] = positions.at(i).y();
+    }
+
+    _iteration = 0;
+    _levelIteration = _iterations;
+}
+
+void ForceLayout::setFree(const QVector<int> &nodes)
+{
+    _free = nodes;
+}
+
+double ForceLayout::idealLength() const
+{
+    return _idealLength;
+}
+
+void ForceLayout::setIdealLength(double length)
+{
+    _idealLength = length;
+}
+
+double ForceLayout::theta() const
+{
+    return _theta;
+}
+
+void ForceLayout::setTheta(double openingCriterion)
+{
+    _theta = openingCriterion;
+}
+
+int ForceLayout::iterations() const
+{
+    return _iterations;
+}
+
+void ForceLayout::setIterations(int count)
+{
+    _iterations = count;
+}
+
+int ForceLayout::totalIterations() const
+{
+    return _iterations * _levels.size();
+}
+
+void ForceLayout::start()
+{
+    // Start again from the original graph
+    _levels.resize(1);
+    _levels[0].parent.clear();
+    _level = 0;
+    int nodeCount = _levels.at(0).nodeCount;
+    _x.resize(nodeCount);
+    _y.resize(nodeCount);
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        _x[i] = _initialPositions.at(i).x();
+        _y[i] = _initialPositions.at(i).y();
+    }
+
+    _iteration = 0;
+    _levelIteration = 0;
+    if(nodeCount == 0 || _iterations <= 0)
+    {
+        _levelIteration = _iterations;
+        return;
+    }
+
+    double initialTemperature = _idealLength;
+    if(_free.isEmpty())
+    {
+        while(_levels.last().nodeCount > COARSEST_NODES)
+        {
+            int previous = _levels.last().nodeCount;
+            coarsen();
+            if(_levels.last().nodeCount > COARSENING_LIMIT * previous)
+                break;
+        }
+        _level = _levels.size() - 1;
+        nodeCount = _levels.at(_level).nodeCount;
+
+        // The coarsest graph is scattered over a square sized for it, a fixed
+        // seed keeps the result the same from one run to the next
+        double side = _idealLength * std::sqrt(static_cast<double>(nodeCount));
+        quint32 seed = 1;
+        _x.resize(nodeCount);
+        _y.resize(nodeCount);
+        for(int i = 0; i < nodeCount; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            _x[i] = side * (seed >> 8) / 16777216.0;
+            seed = seed * 1664525u + 1013904223u;
+            _y[i] = side * (seed >> 8) / 16777216.0;
+        }
+        _movable.fill(1, nodeCount);
+        initialTemperature = qMax(_idealLength, side / 10.0);
+    }
+    else
+    {
+        _movable.fill(0, nodeCount);
+        for(int i = 0; i < _free.size(); ++i)
+        {
+            if(_free.at(i) >= 0 && _free.at(i) < nodeCount)
+                _movable[_free.at(i)] = 1;
+        }
+    }
+
+    _dx.fill(0.0, nodeCount);
+    _dy.fill(0.0, nodeCount);
+
+    _centreX = 0.0;
+    _centreY = 0.0;
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        _centreX += _x.at(i);
+        _centreY += _y.at(i);
+    }
+    _centreX /= nodeCount;
+    _centreY /= nodeCount;
+
+    // Cool geometrically to the final temperature over the iterations
+    _temperature = initialTemperature;
+    _cooling = std::pow(_idealLength * FINAL_TEMPERATURE / initialTemperature,
+                        1.0 / _iterations);
+    _energy = std::numeric_limits<double>::max();
+    _progress = 0;
+}
+
+bool ForceLayout::step()
+{
+    if(finished())
+        return false;
+
+    int nodeCount = _x.size();
+    buildTree();
+
+    int rangeCount = qMin(nodeCount,
+                          qMax(1, QThread::idealThreadCount())
+                          * RANGES_PER_THREAD);
+    QVector<ForceRange> ranges(rangeCount);
+    for(int i = 0; i < rangeCount; ++i)
+    {
+        ranges[i].layout = this;
+        ranges[i].dx = _dx.data();
+        ranges[i].dy = _dy.data();
+        ranges[i].begin = static_cast<int>(
+                    static_cast<qint64>(nodeCount) * i / rangeCount);
+        ranges[i].end = static_cast<int>(
+                    static_cast<qint64>(nodeCount) * (i + 1) / rangeCount);
+    }
+    QtConcurrent::blockingMap(ranges, &ForceLayout::computeForces);
+
+    // Move each node along its displacement, by no more than the temperature
+    const double *dx = _dx.constData();
+    const double *dy = _dy.constData();
+    const char *movable = _movable.constData();
+    double *x = _x.data();
+    double *y = _y.data();
+    double temperature = _temperature;
+    double energy = 0.0;
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        double length2 = dx[i] * dx[i] + dy[i] * dy[i];
+        double length = std::sqrt(length2);
+        double scale = (length > temperature) ? temperature / length : 1.0;
+        scale *= movable[i];
+        x[i] += dx[i] * scale;
+        y[i] += dy[i] * scale;
+        energy += length2;
+    }
+
+    // Adaptive cooling (Hu): cool while the forces grow, and warm up again
+    // after a run of improvements, on top of the steady cooling schedule
+    if(energy < _energy)
+    {
+        if(++_progress >= 5)
+        {
+            _progress = 0;
+            _temperature /= ADAPTIVE_COOLING;
+        }
+    }
+    else
+    {
+        _progress = 0;
+        _temperature *= ADAPTIVE_COOLING;
+    }
+    _energy = energy;
+    _temperature *= _cooling;
+
+    ++_iteration;
+    ++_levelIteration;
+    if(_levelIteration >= _iterations)
+    {
+        if(_level > 0)
+            prolong();
+        else if(_free.isEmpty())
+            normalise();
+    }
+
+    return !finished();
+}
+
+int ForceLayout::iteration() const
+{
+    return _iteration;
+}
+
+bool ForceLayout::finished() const
+{
+    return _level == 0 && _levelIteration >= _iterations;
+}
+
+QVector<QPointF> ForceLayout::positions() const
+{
+    // Map each original node through the levels to the node it is part of in
+    // the level being laid out
+    int nodeCount = _levels.at(0).nodeCount;
+    QVector<QPointF> result(nodeCount);
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        int node = i;
+        for(int level = 0; level < _level; ++level)
+            node = _levels.at(level).parent.at(node);
+        result[i] = QPointF(_x.at(node), _y.at(node));
+    }
+    return result;
+}
+
+void ForceLayout::buildAdjacency(Level *level,
+                                 const QVector< QPair<int, int> > &edges)
+{
+    // Count the neighbours of each node, then fill in the rows. Loops exert
+    // no force so they are left out.
+    int nodeCount = level->nodeCount;
+    level->adjacentStart.fill(0, nodeCount + 1);
+    for(int i = 0; i < edges.size(); ++i)
+    {
+        const QPair<int, int> &edge = edges.at(i);
+        if(edge.first == edge.second)
+            continue;
+        ++level->adjacentStart[edge.first + 1];
+        ++level->adjacentStart[edge.second + 1];
+    }
+    for(int i = 0; i < nodeCount; ++i)
+        level->adjacentStart[i + 1] += level->adjacentStart.at(i);
+
+    level->adjacent.resize(level->adjacentStart.at(nodeCount));
+    QVector<int> next = level->adjacentStart;
+    for(int i = 0; i < edges.size(); ++i)
+    {
+        const QPair<int, int> &edge = edges.at(i);
+        if(edge.first == edge.second)
+            continue;
+        level->adjacent[next[edge.first]++] = edge.second;
+        level->adjacent[next[edge.second]++] = edge.first;
+    }
+}
+
+void ForceLayout::coarsen()
+{
+    // Match each node with its unmatched neighbour of lowest degree, so that
+    // hubs are not all merged into one coarse node
+    Level &fine = _levels.last();
+    int nodeCount = fine.nodeCount;
+    fine.parent.fill(-1, nodeCount);
+    int coarseCount = 0;
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        if(fine.parent.at(i) >= 0)
+            continue;
+
+        int match = -1;
+        int matchDegree = 0;
+        for(int j = fine.adjacentStart.at(i);
+            j < fine.adjacentStart.at(i + 1); ++j)
+        {
+            int neighbour = fine.adjacent.at(j);
+            int degree = fine.adjacentStart.at(neighbour + 1)
+                    - fine.adjacentStart.at(neighbour);
+            if(fine.parent.at(neighbour) < 0
+                    && (match < 0 || degree < matchDegree))
+            {
+                match = neighbour;
+                matchDegree = degree;
+            }
+        }
+
+        fine.parent[i] = coarseCount;
+        if(match >= 0)
+            fine.parent[match] = coarseCount;
+        ++coarseCount;
+    }
+
+    // Each edge between two coarse nodes is kept once
+    QVector< QPair<int, int> > edges;
+    edges.reserve(fine.adjacent.size() / 2);
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        for(int j = fine.adjacentStart.at(i);
+            j < fine.adjacentStart.at(i + 1); ++j)
+        {
+            int from = fine.parent.at(i);
+            int to = fine.parent.at(fine.adjacent.at(j));
+            if(from < to)
+                edges.push_back(qMakePair(from, to));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    Level coarse;
+    coarse.nodeCount = coarseCount;
+    buildAdjacency(&coarse, edges);
+    _levels.push_back(coarse);
+}
+
+void ForceLayout::prolong()
+{
+    // Each node starts at the position of the coarse node it was merged into,
+    // spread out to make room for the extra nodes and nudged apart from the
+    // node it was matched with
+    const Level &fine = _levels.at(_level - 1);
+    int nodeCount = fine.nodeCount;
+    double spread = std::sqrt(static_cast<double>(nodeCount) / _x.size());
+    double nudge = 0.1 * _idealLength;
+
+    QVector<double> x(nodeCount);
+    QVector<double> y(nodeCount);
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        int parent = fine.parent.at(i);
+        x[i] = _centreX + (_x.at(parent) - _centreX) * spread
+                + ((i & 1) ? nudge : -nudge);
+        y[i] = _centreY + (_y.at(parent) - _centreY) * spread
+                + ((i & 2) ? nudge : -nudge);
+    }
+
+    --_level;
+    _x = x;
+    _y = y;
+    _dx.fill(0.0, nodeCount);
+    _dy.fill(0.0, nodeCount);
+    _movable.fill(1, nodeCount);
+
+    // The layout is already roughly right, so the finer levels start cool
+    _levelIteration = 0;
+    _temperature = _idealLength;
+    _cooling = std::pow(FINAL_TEMPERATURE, 1.0 / _iterations);
+    _energy = std::numeric_limits<double>::max();
+    _progress = 0;
+}
+
+void ForceLayout::normalise()
+{
+    // Long range repulsion stretches edges as the graph grows, so the finished
+    // layout is scaled to bring the mean edge back to the ideal length
+    const Level &level = _levels.at(0);
+    double total = 0.0;
+    int count = level.adjacent.size();
+    for(int i = 0; i < level.nodeCount; ++i)
+    {
+        for(int j = level.adjacentStart.at(i);
+            j < level.adjacentStart.at(i + 1); ++j)
+        {
+            int neighbour = level.adjacent.at(j);
+            double ex = _x.at(neighbour) - _x.at(i);
+            double ey = _y.at(neighbour) - _y.at(i);
+            total += std::sqrt(ex * ex + ey * ey);
+        }
+    }
+    if(count == 0 || total <= 0.0)
+        return;
+
+    double scale = _idealLength * count / total;
+    for(int i = 0; i < level.nodeCount; ++i)
+    {
+        _x[i] = _centreX + (_x.at(i) - _centreX) * scale;
+        _y[i] = _centreY + (_y.at(i) - _centreY) * scale;
+    }
+}
+
+void ForceLayout::computeForces(ForceRange &range)
+{
+    const ForceLayout *layout = range.layout;
+    for(int i = range.begin; i < range.end; ++i)
+    {
+        double fx = 0.0;
+        double fy = 0.0;
+        if(layout->_movable.at(i))
+        {
+            layout->repulsion(i, &fx, &fy);
+            layout->attraction(i, &fx, &fy);
+            fx -= GRAVITY * (layout->_x.at(i) - layout->_centreX);
+            fy -= GRAVITY * (layout->_y.at(i) - layout->_centreY);
+        }
+
+        // Each range writes only its own nodes, so no locking is needed
+        range.dx[i] = fx;
+        range.dy[i] = fy;
+    }
+}
+
+void ForceLayout::buildTree()
+{
+    int nodeCount = _x.size();
+    double minX = _x.at(0);
+    double maxX = minX;
+    double minY = _y.at(0);
+    double maxY = minY;
+    for(int i = 1; i < nodeCount; ++i)
+    {
+        minX = qMin(minX, _x.at(i));
+        maxX = qMax(maxX, _x.at(i));
+        minY = qMin(minY, _y.at(i));
+        maxY = qMax(maxY, _y.at(i));
+    }
+
+    // Emptied rather than cleared so that the storage is reused
+    int capacity = 2 * nodeCount + 1;
+    _cellX.reserve(capacity);
+    _cellY.reserve(capacity);
+    _cellSize.reserve(capacity);
+    _cellMass.reserve(capacity);
+    _cellSumX.reserve(capacity);
+    _cellSumY.reserve(capacity);
+    _cellBody.reserve(capacity);
+    _cellChildren.reserve(4 * capacity);
+    _cellX.resize(0);
+    _cellY.resize(0);
+    _cellSize.resize(0);
+    _cellMass.resize(0);
+    _cellSumX.resize(0);
+    _cellSumY.resize(0);
+    _cellBody.resize(0);
+    _cellChildren.resize(0);
+
+    // The root is square and slightly larger than the bounds, so that every
+    // node falls strictly inside it
+    double size = qMax(maxX - minX, maxY - minY);
+    size = size * 1.001 + 1.0;
+    createCell(minX - 0.5, minY - 0.5, size);
+
+    for(int i = 0; i < nodeCount; ++i)
+        insertBody(i);
+}
+
+void ForceLayout::insertBody(int body)
+{
+    double x = _x.at(body);
+    double y = _y.at(body);
+    int cell = 0;
+    int depth = 0;
+
+    for(;;)
+    {
+        _cellMass[cell] += 1.0;
+        _cellSumX[cell] += x;
+        _cellSumY[cell] += y;
+
+        int occupant = _cellBody.at(cell);
+        if(occupant == EMPTY_CELL)
+        {
+            _cellBody[cell] = body;
+            return;
+        }
+
+        double half = _cellSize.at(cell) / 2.0;
+        double midX = _cellX.at(cell) + half;
+        double midY = _cellY.at(cell) + half;
+
+        if(occupant >= 0)
+        {
+            if(depth >= MAX_DEPTH)
+                return;
+
+            // Push the current occupant down into a child
+            int quadrant = (_x.at(occupant) >= midX ? 1 : 0)
+                    + (_y.at(occupant) >= midY ? 2 : 0);
+            int child = createCell(_cellX.at(cell) + (quadrant & 1) * half,
+                                   _cellY.at(cell) + (quadrant >> 1) * half,
+                                   half);
+            _cellChildren[cell * 4 + quadrant] = child;
+            _cellMass[child] = 1.0;
+            _cellSumX[child] = _x.at(occupant);
+            _cellSumY[child] = _y.at(occupant);
+            _cellBody[child] = occupant;
+            _cellBody[cell] = INTERNAL_CELL;
+        }
+
+        int quadrant = (x >= midX ? 1 : 0) + (y >= midY ? 2 : 0);
+        int child = _cellChildren.at(cell * 4 + quadrant);
+        if(child < 0)
+        {
+            child = createCell(_cellX.at(cell) + (quadrant & 1) * half,
+                               _cellY.at(cell) + (quadrant >> 1) * half,
+                               half);
+            _cellChildren[cell * 4 + quadrant] = child;
+        }
+
+        cell = child;
+        ++depth;
+    }
+}
+
+int ForceLayout::createCell(double x, double y, double size)
+{
+    int cell = _cellX.size();
+    _cellX.push_back(x);
+    _cellY.push_back(y);
+    _cellSize.push_back(size);
+    _cellMass.push_back(0.0);
+    _cellSumX.push_back(0.0);
+    _cellSumY.push_back(0.0);
+    _cellBody.push_back(EMPTY_CELL);
+    for(int i = 0; i < 4; ++i)
+        _cellChildren.push_back(-1);
+    return cell;
+}
+
+void ForceLayout::repulsion(int body, double *dx, double *dy) const
+{
+    double x = _x.at(body);
+    double y = _y.at(body);
+    double k2 = REPULSION * _idealLength * _idealLength;
+    double theta2 = _theta * _theta;
+    // Nodes at the same position are pushed apart in a direction which
+    // depends on the node, so that they separate
+    double nudgeX = ((body & 1) ? 0.01 : -0.01) * _idealLength;
+    double nudgeY = ((body & 2) ? 0.01 : -0.01) * _idealLength;
+    double minDistance2 = nudgeX * nudgeX + nudgeY * nudgeY;
+
+    const double *cellSize = _cellSize.constData();
+    const double *cellMass = _cellMass.constData();
+    const double *cellSumX = _cellSumX.constData();
+    const double *cellSumY = _cellSumY.constData();
+    const int *cellBody = _cellBody.constData();
+    const int *cellChildren = _cellChildren.constData();
+
+    // Each visit pops one cell and pushes at most four
+    int stack[3 * MAX_DEPTH + 8];
+    int top = 0;
+    stack[top++] = 0;
+
+    double fx = 0.0;
+    double fy = 0.0;
+    while(top > 0)
+    {
+        int cell = stack[--top];
+        double mass = cellMass[cell];
+        double sumX = cellSumX[cell];
+        double sumY = cellSumY[cell];
+        int occupant = cellBody[cell];
+
+        // A node does not repel itself
+        if(occupant == body)
+        {
+            mass -= 1.0;
+            sumX -= x;
+            sumY -= y;
+        }
+        if(mass <= 0.0)
+            continue;
+
+        double ex = x - sumX / mass;
+        double ey = y - sumY / mass;
+        double distance2 = ex * ex + ey * ey;
+
+        // Open cells which are too close to treat as a single mass
+        if(occupant == INTERNAL_CELL
+                && cellSize[cell] * cellSize[cell] >= theta2 * distance2)
+        {
+            for(int i = 0; i < 4; ++i)
+            {
+                int child = cellChildren[cell * 4 + i];
+                if(child >= 0)
+                    stack[top++] = child;
+            }
+            continue;
+        }
+
+        if(distance2 < minDistance2)
+        {
+            ex = nudgeX;
+            ey = nudgeY;
+            distance2 = minDistance2;
+        }
+
+        double force = k2 * mass / distance2;
+        fx += ex * force;
+        fy += ey * force;
+    }
+
+    *dx += fx;
+    *dy += fy;
+}
+
+void ForceLayout::attraction(int body, double *dx, double *dy) const
+{
+    double x = _x.at(body);
+    double y = _y.at(body);
+    double inverseLength = 1.0 / _idealLength;
+    const double *positionsX = _x.constData();
+    const double *positionsY = _y.constData();
+    const Level &level = _levels.at(_level);
+    const int *adjacent = level.adjacent.constData();
+
+    double fx = 0.0;
+    double fy = 0.0;
+    int end = level.adjacentStart.at(body + 1);
+    for(int i = level.adjacentStart.at(body); i < end; ++i)
+    {
+        double ex = positionsX[adjacent[i]] - x;
+        double ey = positionsY[adjacent[i]] - y;
+        double force = std::sqrt(ex * ex + ey * ey) * inverseLength;
+        fx += ex * force;
+        fy += ey * force;
+    }
+
+    *dx += fx;
+    *dy += fy;
+}
+
+}
@@ -0,0 +1,200 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FORCELAYOUT_HPP
+#define FORCELAYOUT_HPP
+
+#include <QPair>
+#include <QPointF>
+#include <QVector>
+
+namespace Developer {
+
+/*!
+ * \brief The ForceLayout class is a multithreaded force-directed layout
+ *  engine for large graphs
+ *
+ * This follows Fruchterman and Reingold: every pair of nodes repels, each
+ * edge pulls its end points together, and the distance a node may move in an
+ * iteration is limited by a temperature which cools as the layout proceeds. A
+ * weak pull towards the centre keeps disconnected components together.
+ *
+ * Repulsion is approximated with a Barnes-Hut quadtree which is rebuilt each
+ * iteration, so an iteration costs O(n log n) rather than O(n^2). A full
+ * layout is multilevel: the graph is repeatedly coarsened by merging matched
+ * neighbours, the coarsest graph is laid out from scratch, and each finer
+ * graph starts from the layout of the one above it. This avoids the folds a
+ * single level layout of a large graph tends to settle into. The forces
+ * on each node only read the tree and the positions, so they are computed in
+ * parallel over ranges of nodes with QtConcurrent. Positions, displacements
+ * and the tree are kept as flat arrays (structure of arrays) so that the
+ * inner loops run over contiguous memory and can be vectorised by the
+ * compiler.
+ *
+ * The engine is driven one iteration at a time with step(), which allows the
+ * caller to check for cancellation, report progress or show intermediate
+ * positions between iterations. If setFree() is called before start() only
+ * the listed nodes move, on a single level, and the layout starts cool so
+ * that new or moved nodes settle into an existing layout without disturbing
+ * the rest of it.
+ *
+ * \code
+ *  ForceLayout layout;
+ *  layout.setGraph(positions, edges);
+ *  layout.start();
+ *  while(layout.step())
+ *      ;
+ *  positions = layout.positions();
+ * \endcode
+ */
+class ForceLayout
+{
+public:
+    ForceLayout();
+
+    /*!
+     * \brief Set the graph to lay out
+     * \param positions The starting position of each node
+     * \param edges     The edges as pairs of indices into positions
+     */
+    void setGraph(const QVector<QPointF> &positions,
+                  const QVector< QPair<int, int> > &edges);
+    /*!
+     * \brief Restrict the layout to the listed nodes
+     *
+     * The remaining nodes keep their positions but still push and pull on the
+     * listed ones. An empty list moves every node.
+     *
+     * \param nodes Indices of the nodes which may move
+     */
+    void setFree(const QVector<int> &nodes);
+
+    double idealLength() const;
+    void setIdealLength(double length);
+    double theta() const;
+    void setTheta(double openingCriterion);
+    /*!
+     * \brief The number of iterations run on each level of the layout
+     */
+    int iterations() const;
+    void setIterations(int count);
+    int totalIterations() const;
+
+    /*!
+     * \brief Prepare to run the layout
+     *
+     * A full layout scatters the nodes over a square sized for the graph and
+     * starts hot. A restricted layout (see setFree()) keeps the current
+     * positions and starts at the ideal edge length.
+     */
+    void start();
+    /*!
+     * \brief Run one iteration of the layout
+     * \return true if there are iterations left to run
+     */
+    bool step();
+    int iteration() const;
+    bool finished() const;
+
+    /*!
+     * \brief The positions of the nodes
+     *
+     * Until the layout has reached the original graph these are the positions
+     * of the coarse nodes each node has been merged into.
+     *
+     * \return The position of each node, by index
+     */
+    QVector<QPointF> positions() const;
+
+private:
+    struct Level
+    {
+        int nodeCount;
+        // Adjacency in compressed rows, the neighbours of node i are
+        // adjacent[adjacentStart[i]] to adjacent[adjacentStart[i+1] - 1]
+        QVector<int> adjacentStart;
+        QVector<int> adjacent;
+        // The node of the next coarser level each node was merged into
+        QVector<int> parent;
+    };
+
+    struct ForceRange
+    {
+        const ForceLayout *layout;
+        double *dx;
+        double *dy;
+        int begin;
+        int end;
+    };
+
+    static void computeForces(ForceRange &range);
+    static void buildAdjacency(Level *level,
+                               const QVector< QPair<int, int> > &edges);
+
+    void coarsen();
+    void prolong();
+    void normalise();
+    void buildTree();
+    void insertBody(int body);
+    int createCell(double x, double y, double size);
+    void repulsion(int body, double *dx, double *dy) const;
+    void attraction(int body, double *dx, double *dy) const;
+
+    // The original graph is level 0, start() adds the coarser levels
+    QVector<Level> _levels;
+    int _level;
+    QVector<QPointF> _initialPositions;
+
+    // Node positions, displacements and whether each node may move, for the
+    // level being laid out
+    QVector<double> _x;
+    QVector<double> _y;
+    QVector<double> _dx;
+    QVector<double> _dy;
+    QVector<char> _movable;
+    QVector<int> _free;
+
+    // The quadtree, cell 0 is the root. A cell holds one body, several bodies
+    // at the depth limit, or has up to four children.
+    QVector<double> _cellX;
+    QVector<double> _cellY;
+    QVector<double> _cellSize;
+    QVector<double> _cellMass;
+    QVector<double> _cellSumX;
+    QVector<double> _cellSumY;
+    QVector<int> _cellBody;
+    QVector<int> _cellChildren;
+
+    double _idealLength;
+    double _theta;
+    double _temperature;
+    double _cooling;
+    double _centreX;
+    double _centreY;
+    double _energy;
+    int _progress;
+    int _iteration;
+    int _levelIteration;
+    int _iterations;
+};
+
+}
+
+#endif // FORCELAYOUT_HPP
@@ -0,0 +1,423 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "graphrenderer.hpp"
+#include "edgeitem.hpp"
+#include "forcelayout.hpp"
+#include "graphviewstyle.hpp"
+#include "graph.hpp"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QGraphicsScene>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+#include <QtSvg/QSvgGenerator>
+#include <cmath>
+
+namespace Developer {
+
+namespace {
+
+/*!
+ * \brief Held while a job builds, measures or paints items
+ *
+ * Every item takes its fonts and font metrics from the one GraphViewStyle,
+ * and Qt's font objects are not safe to use from several threads at once.
+ * Loading, laying out and encoding still run in parallel.
+ */
+QMutex styleMutex;
+
+/*!
+ * \brief Mark a job as failed with the provided message
+ */
+RenderJob failJob(RenderJob job, const QString &message)
+{
+    job.failed = true;
+    job.error = message;
+    return job;
+}
+
+/*!
+ * \brief Lay out a graph whose nodes have no positions with ForceLayout
+ * \param nodes The nodes of the graph, which are moved
+ * \param edges The edges of the graph
+ */
+void layoutGraph(const std::vector<Node *> &nodes,
+                 const std::vector<Edge *> &edges)
+{
+    QHash<Node *, int> indices;
+    QVector<QPointF> positions(static_cast<int>(nodes.size()));
+    for(size_t i = 0; i < nodes.size(); ++i)
+        indices.insert(nodes[i], static_cast<int>(i));
+
+    QVector< QPair<int, int> > ends;
+    ends.reserve(static_cast<int>(edges.size()));
+    for(size_t i = 0; i < edges.size(); ++i)
+        ends.push_back(qMakePair(indices.value(edges[i]->from()),
+                                 indices.value(edges[i]->to())));
+
+    ForceLayout layout;
+    layout.setIdealLength(LAYOUT_DEFAULT_NODE_SIZE + FORCE_LAYOUT_SPACING);
+    layout.setTheta(FORCE_LAYOUT_THETA);
+    layout.setGraph(positions, ends);
+    layout.start();
+    while(layout.step())
+        ;
+
+    positions = layout.positions();
+    for(size_t i = 0; i < nodes.size(); ++i)
+        nodes[i]->setPos(positions.at(static_cast<int>(i)));
+}
+
+/*!
+ * \brief Draw a graph too large to give items as points joined by lines, in
+ *  the same way as the overview of a virtualised GraphScene
+ * \param painter   The painter to draw with, already mapped to the scene
+ * \param nodes     The nodes of the graph
+ * \param edges     The edges of the graph
+ */
+void drawOverview(QPainter *painter, const std::vector<Node *> &nodes,
+                  const std::vector<Edge *> &edges)
+{
+    GraphViewStyle *style = GraphViewStyle::instance();
+
+    QPen edgePen(style->edgeColour(GraphItem::GraphItem_Normal, false, false));
+    edgePen.setCosmetic(true);
+    painter->setPen(edgePen);
+    QVector<QLineF> lines;
+    lines.reserve(static_cast<int>(edges.size()));
+    for(size_t i = 0; i < edges.size(); ++i)
+        lines.push_back(QLineF(edges[i]->from()->pos(),
+                               edges[i]->to()->pos()));
+    painter->drawLines(lines);
+
+    QPen nodePen(style->nodeBorderColour(GraphItem::GraphItem_Normal, false,
+                                         false));
+    nodePen.setCosmetic(true);
+    nodePen.setWidth(2);
+    painter->setPen(nodePen);
+    QPolygonF points;
+    points.reserve(static_cast<int>(nodes.size()));
+    for(size_t i = 0; i < nodes.size(); ++i)
+        points.append(nodes[i]->pos());
+    painter->drawPoints(points);
+}
+
+/*!
+ * \brief Collect the graph files named by the command line, directories are
+ *  searched (not recursively) for files with a graph extension
+ */
+QStringList graphFiles(const QStringList &paths)
+{
+    QStringList filters;
+    filters << QString("*") + GP_GRAPH_ALTERNATIVE_EXTENSION
+            << QString("*") + GP_GRAPH_DOT_EXTENSION
+            << QString("*") + GP_GRAPH_GXL_EXTENSION;
+
+    QStringList files;
+    for(int i = 0; i < paths.size(); ++i)
+    {
+        QFileInfo info(paths.at(i));
+        if(!info.isDir())
+        {
+            files << paths.at(i);
+            continue;
+        }
+
+        QDir dir(paths.at(i));
+        QStringList entries = dir.entryList(filters, QDir::Files, QDir::Name);
+        for(int j = 0; j < entries.size(); ++j)
+            files << dir.filePath(entries.at(j));
+    }
+
+    return files;
+}
+
+}
+
+RenderJob::RenderJob()
+    : format(RenderFormat_Png)
+    , size(RENDER_DEFAULT_SIZE)
+    , failed(false)
+{
+}
+
+RenderJob renderGraph(const RenderJob &job)
+{
+    Graph graph(job.graphPath, false);
+    if(!QFileInfo(job.graphPath).isFile() || !graph.open())
+        return failJob(job, QObject::tr("The graph could not be opened"));
+
+    std::vector<Node *> nodes = graph.nodes();
+    std::vector<Edge *> edges = graph.edges();
+    if(nodes.empty())
+        return failJob(job, QObject::tr("The graph has no nodes"));
+
+    // Graphs saved without a layout get the built in one
+    bool layoutSet = false;
+    for(size_t i = 0; i < nodes.size() && !layoutSet; ++i)
+        layoutSet = (nodes[i]->pos().x() != 0 || nodes[i]->pos().y() != 0);
+    if(!layoutSet)
+        layoutGraph(nodes, edges);
+
+    // As with GraphWidget, graphs too large to give every node and edge an
+    // item are drawn as an overview
+    bool useItems = (nodes.size() + edges.size() <= VIRTUAL_GRAPH_THRESHOLD);
+    QMutexLocker locker(useItems ? &styleMutex : 0);
+
+    QGraphicsScene scene;
+    scene.setItemIndexMethod(QGraphicsScene::NoIndex);
+    QRectF rect;
+    if(useItems)
+    {
+        QHash<Node *, NodeItem *> items;
+        for(size_t i = 0; i < nodes.size(); ++i)
+        {
+            NodeItem *item = new NodeItem(nodes[i]);
+            scene.addItem(item);
+            item->setPos(nodes[i]->pos());
+            items.insert(nodes[i], item);
+        }
+
+        for(size_t i = 0; i < edges.size(); ++i)
+            scene.addItem(new EdgeItem(edges[i], items.value(edges[i]->from()),
+                                       items.value(edges[i]->to())));
+
+        rect = scene.itemsBoundingRect();
+    }
+    else
+    {
+        for(size_t i = 0; i < nodes.size(); ++i)
+            rect |= QRectF(nodes[i]->pos(), QSizeF(1, 1));
+    }
+    rect.adjust(-RENDER_MARGIN, -RENDER_MARGIN, RENDER_MARGIN, RENDER_MARGIN);
+
+    // Scale down to fit, but never up
+    qreal scale = qMin(1.0, job.size / qMax(rect.width(), rect.height()));
+    QSize pixels(qMax(1, static_cast<int>(std::ceil(rect.width() * scale))),
+                 qMax(1, static_cast<int>(std::ceil(rect.height() * scale))));
+    QRectF target(QPointF(0, 0), pixels);
+
+    QImage image;
+    QSvgGenerator generator;
+    QPainter painter;
+    if(job.format == RenderFormat_Svg)
+    {
+        generator.setFileName(job.outputPath);
+        generator.setSize(pixels);
+        generator.setViewBox(target);
+        generator.setTitle(QFileInfo(job.graphPath).fileName());
+        generator.setDescription(QObject::tr("Rendered by GP Developer"));
+        painter.begin(&generator);
+    }
+    else
+    {
+        image = QImage(pixels, QImage::Format_ARGB32_Premultiplied);
+        if(image.isNull())
+            return failJob(job, QObject::tr("Out of memory for the image"));
+        image.fill(QColor(Qt::white).rgba());
+        painter.begin(&image);
+    }
+
+    if(!painter.isActive())
+        return failJob(job, QObject::tr("The image could not be drawn"));
+
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    if(useItems)
+        scene.render(&painter, target, rect, Qt::KeepAspectRatio);
+    else
+    {
+        painter.scale(scale, scale);
+        painter.translate(-rect.topLeft());
+        drawOverview(&painter, nodes, edges);
+    }
+    painter.end();
+    locker.unlock();
+
+    if(job.format == RenderFormat_Png && !image.save(job.outputPath, "PNG"))
+        return failJob(job, QObject::tr("The image could not be saved"));
+
+    return job;
+}
+
+QImage renderThumbnail(const QString &graphPath, int size)
+{
+    Graph graph(graphPath, false);
+    if(!QFileInfo(graphPath).isFile() || !graph.open())
+        return QImage();
+
+    QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+    if(image.isNull())
+        return image;
+    image.fill(QColor(Qt::white).rgba());
+
+    std::vector<Node *> nodes = graph.nodes();
+    std::vector<Edge *> edges = graph.edges();
+    if(nodes.empty())
+        return image;
+
+    bool layoutSet = false;
+    for(size_t i = 0; i < nodes.size() && !layoutSet; ++i)
+        layoutSet = (nodes[i]->pos().x() != 0 || nodes[i]->pos().y() != 0);
+    if(!layoutSet)
+        layoutGraph(nodes, edges);
+
+    // Nodes are drawn as plain circles of the default size, which needs no
+    // fonts and so no items
+    qreal radius = LAYOUT_DEFAULT_NODE_SIZE / 2;
+    QRectF rect;
+    for(size_t i = 0; i < nodes.size(); ++i)
+        rect |= QRectF(nodes[i]->pos(), QSizeF(1, 1));
+    rect.adjust(-radius, -radius, radius, radius);
+    qreal scale = qMin(1.0, (size - 2) / qMax(rect.width(), rect.height()));
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.translate(size / 2.0, size / 2.0);
+    painter.scale(scale, scale);
+    painter.translate(-rect.center());
+
+    // Too small to make out circles, so fall back to the overview
+    if(radius * scale < 2.0)
+    {
+        drawOverview(&painter, nodes, edges);
+        return image;
+    }
+
+    GraphViewStyle *style = GraphViewStyle::instance();
+    QPen edgePen(style->edgeColour(GraphItem::GraphItem_Normal, false, false));
+    edgePen.setCosmetic(true);
+    painter.setPen(edgePen);
+    for(size_t i = 0; i < edges.size(); ++i)
+        painter.drawLine(edges[i]->from()->pos(), edges[i]->to()->pos());
+
+    QPen nodePen(style->nodeBorderColour(GraphItem::GraphItem_Normal, false,
+                                         false));
+    nodePen.setCosmetic(true);
+    painter.setPen(nodePen);
+    painter.setBrush(QColor(Qt::white));
+    for(size_t i = 0; i < nodes.size(); ++i)
+        painter.drawEllipse(nodes[i]->pos(), radius, radius);
+
+    return image;
+}
+
+int renderGraphs(const QStringList &arguments)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    RenderJob defaults;
+    QString outputDir;
+    int threads = 0;
+    QStringList paths;
+    bool valid = true;
+    for(int i = 0; i < arguments.size() && valid; ++i)
+    {
+        QString argument = arguments.at(i);
+        bool hasValue = (i + 1 < arguments.size());
+        if(argument == "--format" && hasValue)
+        {
+            QString format = arguments.at(++i).toLower();
+            valid = (format == "png" || format == "svg");
+            defaults.format = (format == "svg") ? RenderFormat_Svg
+                                                : RenderFormat_Png;
+        }
+        else if(argument == "--size" && hasValue)
+        {
+            defaults.size = arguments.at(++i).toInt(&valid);
+            valid = valid && defaults.size > 0
+                    && defaults.size <= RENDER_MAX_SIZE;
+        }
+        else if(argument == "--jobs" && hasValue)
+        {
+            threads = arguments.at(++i).toInt(&valid);
+            valid = valid && threads > 0;
+        }
+        else if(argument == "--output" && hasValue)
+            outputDir = arguments.at(++i);
+        else if(argument.startsWith("--"))
+            valid = false;
+        else
+            paths << argument;
+    }
+
+    QStringList files = graphFiles(paths);
+    if(!valid || files.isEmpty())
+    {
+        err << "Usage: gpdeveloper --render [--format png|svg] [--size pixels]"
+               " [--jobs threads] [--output directory] graph|directory..."
+            << endl
+            << "The size is of the longest side, at most " << RENDER_MAX_SIZE
+            << " pixels." << endl;
+        return 2;
+    }
+
+    if(!outputDir.isEmpty() && !QDir().mkpath(outputDir))
+    {
+        err << "Could not create the output directory " << outputDir << endl;
+        return 1;
+    }
+
+    QString extension = (defaults.format == RenderFormat_Svg) ? ".svg"
+                                                              : ".png";
+    QList<RenderJob> jobs;
+    for(int i = 0; i < files.size(); ++i)
+    {
+        QFileInfo info(files.at(i));
+        QDir dir = outputDir.isEmpty() ? info.dir() : QDir(outputDir);
+
+        RenderJob job = defaults;
+        job.graphPath = files.at(i);
+        job.outputPath = dir.filePath(info.completeBaseName() + extension);
+        jobs << job;
+    }
+
+    // The style belongs to the application, so it has to be created on this
+    // thread before any job asks for it
+    GraphViewStyle::instance();
+    if(threads > 0)
+        QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+    QFuture<RenderJob> future = QtConcurrent::mapped(jobs, &renderGraph);
+    int failures = 0;
+    for(int i = 0; i < jobs.size(); ++i)
+    {
+        RenderJob result = future.resultAt(i);
+        if(result.failed)
+        {
+            err << result.graphPath << ": " << result.error << endl;
+            ++failures;
+        }
+        else
+            out << result.outputPath << endl;
+    }
+
+    return (failures > 0) ? 1 : 0;
+}
+
+}
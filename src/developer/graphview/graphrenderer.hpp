@@ -0,0 +1,72 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GRAPHRENDERER_HPP
+#define GRAPHRENDERER_HPP
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+#include "global.hpp"
+
+namespace Developer {
+
+/*!
+ * \brief The RenderFormats enum lists the image formats a graph can be batch
+ *  rendered to
+ */
+enum RenderFormats
+{
+    RenderFormat_Png,
+    RenderFormat_Svg
+};
+
+/*!
+ * \brief The RenderJob struct describes one graph to render to an image file
+ *
+ * Jobs are independent of each other and of the GUI: each one opens its own
+ * copy of the graph and builds its own items, so any number can run at once
+ * on worker threads. A job holds at most one graph and one image of at most
+ * RENDER_MAX_SIZE pixels square.
+ */
+struct RenderJob
+{
+    RenderJob();
+
+    QString graphPath;
+    QString outputPath;
+    RenderFormats format;
+    //! The length in pixels of the longest side of the image, graphs smaller
+    //! than this are drawn at their natural size
+    int size;
+
+    bool failed;
+    QString error;
+};
+
+RenderJob renderGraph(const RenderJob &job);
+QImage renderThumbnail(const QString &graphPath, int size = THUMBNAIL_SIZE);
+
+int renderGraphs(const QStringList &arguments);
+
+}
+
+#endif // GRAPHRENDERER_HPP
@@ -19,33 +19,20 @@
  * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "graphscene.hpp"
-
-#include <ogdf/basic/basic.h>
-#include <ogdf/tree/TreeLayout.h>
-#include <ogdf/layered/SugiyamaLayout.h>
-#include <ogdf/tree/RadialTreeLayout.h>
-#include <ogdf/planarlayout/FPPLayout.h>
-#include <ogdf/planarlayout/PlanarDrawLayout.h>
-#include <ogdf/planarlayout/PlanarStraightLayout.h>
-#include <ogdf/planarlayout/SchnyderLayout.h>
-#include <ogdf/planarity/PlanarizationGridLayout.h>
-#include <ogdf/layered/FastHierarchyLayout.h>
-#include <ogdf/misclayout/CircularLayout.h>
-#include <ogdf/energybased/SpringEmbedderFR.h>
-#include <ogdf/energybased/DavidsonHarelLayout.h>
-#include <ogdf/energybased/FMMMLayout.h>
-#include <ogdf/energybased/GEMLayout.h>
+#include "graphviewstyle.hpp"
 
 #include <QGraphicsSceneMouseEvent>
 #include <QKeyEvent>
 #include <QDebug>
+#include <QMutexLocker>
+#include <QTimer>
+#include <QtConcurrentRun>
 
 #include <QPainter>
-#include <QSettings>
 
-namespace Developer {
+#include <cmath>
 
-using ogdf::GraphAttributes;
+namespace Developer {
 
 GraphScene::GraphScene(QObject *parent)
     : QGraphicsScene(parent)
@@ -54,10 +41,56 @@ GraphScene::GraphScene(QObject *parent)
     , _internalGraph(true)
     , _drawingEdge(false)
     , _selecting(false)
+    , _fromNode(0)
+    , _virtualized(false)
+    , _overview(false)
+    , _virtualStale(false)
+    , _nodeGrid(VIRTUAL_GRID_CELL_SIZE)
+    , _densityCellSize(0)
+    , _layoutWatcher(new QFutureWatcher<LayoutJob>(this))
+    , _latestLayout(new QAtomicInt(0))
+    , _layoutProgress(new QAtomicInt(0))
+    , _layoutRevision(0)
+    , _layoutRunning(false)
+    , _animateLayouts(true)
+    , _layoutTimer(new QTimer(this))
+    , _layoutPollTimer(new QTimer(this))
+    , _layoutAnimator(new LayoutAnimator(this, this))
+    , _settleLayout(false)
+    , _edgeBundling(false)
+    , _bundleWatcher(new QFutureWatcher<BundleJob>(this))
+    , _latestBundle(new QAtomicInt(0))
+    , _bundleRevision(0)
+    , _bundleTimer(new QTimer(this))
 {
     _graph = new Graph();
     setItemIndexMethod(QGraphicsScene::NoIndex);
     setBackgroundBrush(QColor(Qt::white));
+
+    _layoutTimer->setSingleShot(true);
+    _layoutTimer->setInterval(LAYOUT_TIMEOUT);
+    _layoutPollTimer->setInterval(100);
+    _bundleTimer->setSingleShot(true);
+    _bundleTimer->setInterval(EDGE_BUNDLING_DELAY);
+
+    connect(GraphViewStyle::instance(), SIGNAL(styleChanged()),
+            this, SLOT(styleChanged()));
+    connect(_layoutWatcher, SIGNAL(finished()), this, SLOT(layoutFinished()));
+    connect(_layoutTimer, SIGNAL(timeout()), this, SLOT(layoutTimedOut()));
+    connect(_layoutPollTimer, SIGNAL(timeout()),
+            this, SLOT(pollLayoutProgress()));
+    connect(_layoutAnimator, SIGNAL(finished()),
+            this, SLOT(layoutAnimationFinished()));
+    connect(_bundleTimer, SIGNAL(timeout()), this, SLOT(startBundling()));
+    connect(_bundleWatcher, SIGNAL(finished()),
+            this, SLOT(bundlingFinished()));
+}
+
+GraphScene::~GraphScene()
+{
+    // A job only holds its own snapshot, so it can be left to finish alone
+    _latestLayout->fetchAndStoreRelaxed(-1);
+    _latestBundle->fetchAndStoreRelaxed(-1);
 }
 
 Graph *GraphScene::graph() const
@@ -67,10 +100,14 @@ Graph *GraphScene::graph() const
 
 void GraphScene::setGraph(Graph *newGraph)
 {
+    // Stop following the previous graph
+    disconnect(_graph, 0, this, 0);
+    cancelLayout();
+    _layoutAnimator->finish();
+    clearBundles();
+
     // Remove child items from the scene
-    qDeleteAll(items());
-    _nodes.clear();
-    _edges.clear();
+    clearItems();
 
     // Only delete if this is an internal graph being replaced
     if(_internalGraph)
@@ -89,8 +126,67 @@ void GraphScene::setGraph(Graph *newGraph)
         setSceneRect(canvas);
     }
 
-    bool layoutSet = false;
+    if(_virtualized)
+    {
+        setVirtualGraph();
+
+        // Any change drops every item and index, which may hold the Node and
+        // Edge objects being deleted, and the scene is rebuilt once the graph
+        // has finished changing
+        connect(_graph, SIGNAL(nodeAdded(Node*)),
+                this, SLOT(virtualGraphChanged()));
+        connect(_graph, SIGNAL(edgeAdded(Edge*)),
+                this, SLOT(virtualGraphChanged()));
+        connect(_graph, SIGNAL(nodeRemoved(QString)),
+                this, SLOT(virtualGraphChanged()));
+        connect(_graph, SIGNAL(edgeRemoved(QString)),
+                this, SLOT(virtualGraphChanged()));
+        connect(_graph, SIGNAL(aboutToClear()),
+                this, SLOT(virtualGraphChanged()));
+        return;
+    }
+
+    // Suspend the scene index, if one is in use, while the items are added in
+    // bulk and rebuild it once at the end
+    QGraphicsScene::ItemIndexMethod indexMethod = itemIndexMethod();
+    setItemIndexMethod(QGraphicsScene::NoIndex);
+
+    // The Graph lookups are linear scans, so the two graphs are compared
+    // through hash sets of their IDs
     std::vector<Node *> nList = _graph->nodes();
+    std::vector<Edge *> eList = _graph->edges();
+    QHash<QString, Node *> nodeIds;
+    QSet<QString> edgeIds;
+    nodeIds.reserve(nList.size());
+    edgeIds.reserve(eList.size());
+    _layoutMirror.reserve(static_cast<int>(nList.size()),
+                          static_cast<int>(eList.size()));
+    for(std::vector<Node *>::iterator iter = nList.begin(); iter != nList.end();
+        ++iter)
+        nodeIds.insert((*iter)->id(), *iter);
+    for(std::vector<Edge *>::iterator iter = eList.begin(); iter != eList.end();
+        ++iter)
+        edgeIds.insert((*iter)->id());
+
+    std::vector<Node *> linkedNodes;
+    std::vector<Edge *> linkedEdges;
+    QSet<QString> linkedNodeIds;
+    QSet<QString> linkedEdgeIds;
+    if(_linkedGraph != 0)
+    {
+        linkedNodes = _linkedGraph->nodes();
+        linkedEdges = _linkedGraph->edges();
+        linkedNodeIds.reserve(linkedNodes.size());
+        linkedEdgeIds.reserve(linkedEdges.size());
+        for(std::vector<Node *>::iterator iter = linkedNodes.begin();
+            iter != linkedNodes.end(); ++iter)
+            linkedNodeIds.insert((*iter)->id());
+        for(std::vector<Edge *>::iterator iter = linkedEdges.begin();
+            iter != linkedEdges.end(); ++iter)
+            linkedEdgeIds.insert((*iter)->id());
+    }
+
+    bool layoutSet = false;
     for(std::vector<Node *>::iterator iter = nList.begin(); iter != nList.end();
         ++iter)
     {
@@ -104,7 +200,8 @@ void GraphScene::setGraph(Graph *newGraph)
         if(_linkedGraph != 0)
         {
             // Check if this node is new
-            if(!_linkedGraph->contains(n->id()))
+            if(!linkedNodeIds.contains(n->id())
+                    && !linkedEdgeIds.contains(n->id()))
             {
                 nodeItem->setItemState(GraphItem::GraphItem_New);
             }
@@ -112,7 +209,7 @@ void GraphScene::setGraph(Graph *newGraph)
             {
                 // It is contained, is it in the linked graph as a node? If it
                 // isn't then this one is invalid
-                if(!_linkedGraph->containsNode(n->id()))
+                if(!linkedNodeIds.contains(n->id()))
                     nodeItem->setItemState(GraphItem::GraphItem_Invalid);
                 else if(n->isPhantomNode())
                     nodeItem->setItemState(GraphItem::GraphItem_Deleted);
@@ -125,82 +222,82 @@ void GraphScene::setGraph(Graph *newGraph)
 
     // If we have a linked graph, check for unrepresented nodes which should be
     // deleted nodes in our graph
-    if(_linkedGraph != 0)
+    for(std::vector<Node *>::iterator iter = linkedNodes.begin();
+        iter != linkedNodes.end(); ++iter)
     {
-        std::vector<Node *> nList = _linkedGraph->nodes();
-        for(std::vector<Node *>::iterator iter = nList.begin(); iter != nList.end();
-            ++iter)
-        {
-            Node *lhsNode = *iter;
+        Node *lhsNode = *iter;
 
-            if(_graph->containsNode(lhsNode->id()))
-                continue;
-            else if(_graph->containsEdge(lhsNode->id()))
-                _nodes[lhsNode->id()]->setItemState(GraphItem::GraphItem_Invalid);
+        // An edge sharing this ID is marked invalid in the edge pass below
+        if(nodeIds.contains(lhsNode->id()) || edgeIds.contains(lhsNode->id()))
+            continue;
 
-            Node *n = _graph->addNode(
-                        lhsNode->id(),
-                        lhsNode->label(),
-                        lhsNode->pos()
-                        );
+        Node *n = _graph->addNode(
+                    lhsNode->id(),
+                    lhsNode->label(),
+                    lhsNode->pos()
+                    );
 
-            if(n == 0)
-            {
-                qDebug() << "Null node returned by Graph::addNode()";
-                continue;
-            }
-            n->setPhantom(true);
+        if(n == 0)
+        {
+            qDebug() << "Null node returned by Graph::addNode()";
+            continue;
+        }
+        n->setPhantom(true);
+        nodeIds.insert(n->id(), n);
 
-            NodeItem *nodeItem = new NodeItem(n);
-            nodeItem->setItemState(GraphItem::GraphItem_Deleted);
-            addNodeItem(nodeItem, n->pos());
+        NodeItem *nodeItem = new NodeItem(n);
+        nodeItem->setItemState(GraphItem::GraphItem_Deleted);
+        addNodeItem(nodeItem, n->pos());
 
-            if(!layoutSet)
-                layoutSet = (nodeItem->pos().x() != 0 || nodeItem->pos().y() != 0);
-        }
+        if(!layoutSet)
+            layoutSet = (nodeItem->pos().x() != 0 || nodeItem->pos().y() != 0);
     }
 
-    std::vector<Edge *> eList = _graph->edges();
+    // Each edge computes its geometry as it is created and the graph already
+    // holds every edge, so the node items need not tell their existing edges
+    // about each new one
+    for(nodeIter iter = _nodes.begin(); iter != _nodes.end(); ++iter)
+        (*iter)->blockSignals(true);
+
     for(std::vector<Edge *>::iterator iter = eList.begin(); iter != eList.end();
         ++iter)
     {
         Edge *e = *iter;
 
         Q_ASSERT(!_edges.contains(e->id()));
-        NodeItem *from;
-        NodeItem *to;
+        NodeItem *from = _nodes.value(e->from()->id());
+        NodeItem *to = _nodes.value(e->to()->id());
 
-        if(!_nodes.contains(e->from()->id()))
+        if(from == 0)
         {
             qDebug() << "Edge missing node with ID " << e->from()->id();
             qDebug() << "Ignoring.";
             continue;
         }
-        from = _nodes[e->from()->id()];
 
-        if(!_nodes.contains(e->to()->id()))
+        if(to == 0)
         {
-            qDebug() << "Edge missing node with ID " << e->from()->id();
+            qDebug() << "Edge missing node with ID " << e->to()->id();
             qDebug() << "Ignoring.";
             continue;
         }
-        to = _nodes[e->to()->id()];
 
         EdgeItem *edgeItem = new EdgeItem(e, from, to);
         addEdgeItem(edgeItem);
 
         if(_linkedGraph != 0)
         {
-            // Check if this node is new
-            if(!_linkedGraph->contains(e->id()))
+            // Check if this edge is new
+            if(!linkedNodeIds.contains(e->id())
+                    && !linkedEdgeIds.contains(e->id()))
             {
                 edgeItem->setItemState(GraphItem::GraphItem_New);
             }
             else
             {
-                // It is contained, is it in the linked graph as a node? If it
+                // It is contained, is it in the linked graph as an edge? If it
                 // isn't then this one is invalid
-                if(!_linkedGraph->containsEdge(e->id()))
+                if(!linkedEdgeIds.contains(e->id()))
                     edgeItem->setItemState(GraphItem::GraphItem_Invalid);
                 else if(e->isPhantomEdge())
                     edgeItem->setItemState(GraphItem::GraphItem_Deleted);
@@ -209,63 +306,72 @@ void GraphScene::setGraph(Graph *newGraph)
     }
 
     // Same linked graph pass for edges instead of nodes
-    if(_linkedGraph != 0)
+    for(std::vector<Edge *>::iterator iter = linkedEdges.begin();
+        iter != linkedEdges.end(); ++iter)
     {
-        std::vector<Edge *> eList = _linkedGraph->edges();
-        for(std::vector<Edge *>::iterator iter = eList.begin(); iter != eList.end();
-            ++iter)
-        {
-            Edge *lhsEdge = *iter;
-            Node *rhsFrom = _graph->node(lhsEdge->from()->id());
-            Node *rhsTo = _graph->node(lhsEdge->to()->id());
+        Edge *lhsEdge = *iter;
 
-            if(_graph->containsEdge(lhsEdge->id()))
-                continue;
-            else if(_graph->containsNode(lhsEdge->id()))
-                _nodes[lhsEdge->id()]->setItemState(GraphItem::GraphItem_Invalid);
+        // A node sharing this ID has already been marked invalid
+        if(edgeIds.contains(lhsEdge->id()) || nodeIds.contains(lhsEdge->id()))
+            continue;
 
-            if(rhsFrom == 0 || rhsTo == 0)
-            {
-                qDebug() << "Edge failed to locate from or to node";
-                continue;
-            }
+        Node *rhsFrom = nodeIds.value(lhsEdge->from()->id());
+        Node *rhsTo = nodeIds.value(lhsEdge->to()->id());
+        if(rhsFrom == 0 || rhsTo == 0)
+        {
+            qDebug() << "Edge failed to locate from or to node";
+            continue;
+        }
 
-            Edge *e = _graph->addEdge(
-                        lhsEdge->id(),
-                        rhsFrom,
-                        rhsTo,
-                        lhsEdge->label()
-                        );
+        Edge *e = _graph->addEdge(
+                    lhsEdge->id(),
+                    rhsFrom,
+                    rhsTo,
+                    lhsEdge->label()
+                    );
 
-            if(e == 0)
-            {
-                qDebug() << "Null edge returned by Graph::addEdge()";
-                continue;
-            }
-            e->setPhantom(true);
+        if(e == 0)
+        {
+            qDebug() << "Null edge returned by Graph::addEdge()";
+            continue;
+        }
+        e->setPhantom(true);
+        edgeIds.insert(e->id());
 
-            NodeItem *from;
-            NodeItem *to;
+        NodeItem *from = _nodes.value(rhsFrom->id());
+        NodeItem *to = _nodes.value(rhsTo->id());
+        if(from == 0 || to == 0)
+            continue;
 
-            if(!_nodes.contains(e->from()->id())
-                    || !_nodes.contains(e->to()->id()))
-                continue;
+        EdgeItem *item = new EdgeItem(e, from, to);
+        item->setItemState(GraphItem::GraphItem_Deleted);
+        addEdgeItem(item);
+    }
 
-            from = _nodes[e->from()->id()];
-            to = _nodes[e->to()->id()];
+    for(nodeIter iter = _nodes.begin(); iter != _nodes.end(); ++iter)
+        (*iter)->blockSignals(false);
 
-            EdgeItem *item = new EdgeItem(e, from, to);
-            item->setItemState(GraphItem::GraphItem_Deleted);
-            addEdgeItem(item);
-        }
-    }
+    setItemIndexMethod(indexMethod);
 
     if(!layoutSet)
         layoutCircular();
+    else
+        _layoutMirror.markSettled();
 
     resizeToContents();
 
     _readOnly = (_graph->status() == GPFile::ReadOnly);
+
+    // From here on only the changes are applied
+    connect(_graph, SIGNAL(nodeAdded(Node*)), this, SLOT(graphNodeAdded(Node*)));
+    connect(_graph, SIGNAL(edgeAdded(Edge*)), this, SLOT(graphEdgeAdded(Edge*)));
+    connect(_graph, SIGNAL(nodeRemoved(QString)),
+            this, SLOT(graphNodeRemoved(QString)));
+    connect(_graph, SIGNAL(edgeRemoved(QString)),
+            this, SLOT(graphEdgeRemoved(QString)));
+    connect(_graph, SIGNAL(aboutToClear()), this, SLOT(graphAboutToClear()));
+
+    scheduleBundling();
 }
 
 Graph *GraphScene::linkedGraph() const
@@ -323,253 +429,800 @@ void GraphScene::setReadOnly(bool readOnlyFlag)
     _readOnly = readOnlyFlag;
 }
 
+bool GraphScene::virtualized() const
+{
+    return _virtualized;
+}
+
+void GraphScene::setVirtualized(bool virtualizedFlag)
+{
+    if(virtualizedFlag == _virtualized)
+        return;
+
+    _virtualized = virtualizedFlag;
+    if(_graph->nodes().empty())
+        return;
+
+    // Rebuild the items for the current graph in the new mode, using the same
+    // trick as setLinkedGraph() to keep setGraph() from deleting the graph
+    bool internalGraph = _internalGraph;
+    _internalGraph = false;
+    setGraph(_graph);
+    _internalGraph = internalGraph;
+}
+
+void GraphScene::setVisibleRect(const QRectF &rect)
+{
+    _visibleRect = rect;
+    materialise(rect);
+}
+
 void GraphScene::addNodeItem(NodeItem *nodeItem, const QPointF &position)
 {
     addItem(nodeItem);
     nodeItem->setPos(position);
     _nodes.insert(nodeItem->id(), nodeItem);
+    _layoutMirror.addNode(nodeItem->id(),
+                          nodeItem->shape().boundingRect().size(), nodeItem);
+    _hitIndex.addNode(nodeItem);
+    connect(nodeItem, SIGNAL(idChanged(QString,QString)),
+            this, SLOT(nodeIdChanged(QString,QString)));
+    connect(nodeItem, SIGNAL(shapeChanged()), this, SLOT(nodeShapeChanged()));
+    connect(nodeItem, SIGNAL(xChanged()), this, SLOT(nodeItemMoved()));
+    connect(nodeItem, SIGNAL(yChanged()), this, SLOT(nodeItemMoved()));
     emit nodeAdded(nodeItem);
 }
 
 void GraphScene::addEdgeItem(EdgeItem *edgeItem)
 {
+    // A running transition would not move the new edge with its end points
+    _layoutAnimator->finish();
     addItem(edgeItem);
     _edges.insert(edgeItem->id(), edgeItem);
+    _layoutMirror.addEdge(edgeItem->id(), edgeItem->from()->id(),
+                          edgeItem->to()->id());
+    _hitIndex.addEdge(edgeItem);
+    scheduleBundling();
+    connect(edgeItem, SIGNAL(idChanged(QString,QString)),
+            this, SLOT(edgeIdChanged(QString,QString)));
+    if(edgeItem->edge() != 0)
+    {
+        connect(edgeItem->edge(), SIGNAL(fromChanged(Node*)),
+                this, SLOT(edgeEndsChanged()));
+        connect(edgeItem->edge(), SIGNAL(toChanged(Node*)),
+                this, SLOT(edgeEndsChanged()));
+    }
     emit edgeAdded(edgeItem);
 }
 
-void GraphScene::layoutInit()
+void GraphScene::clearItems()
 {
-    _g = ogdf::Graph();
-    _ga = GraphAttributes(_g, GraphAttributes::nodeGraphics
-                       | GraphAttributes::edgeGraphics
-                       | GraphAttributes::nodeLabel
-                       | GraphAttributes::edgeLabel);
+    qDeleteAll(items());
+    _nodes.clear();
+    _edges.clear();
+    _fromNode = 0;
+    _drawingEdge = false;
+    _nodeGrid.clear();
+    _incidentEdges.clear();
+    _indexedPositions.clear();
+    _spareNodeItems.clear();
+    _spareEdgeItems.clear();
+    _layoutMirror.clear();
+    _hitIndex.clear();
+    _overview = false;
+    _clippedEdges.clear();
+    _virtualStale = false;
+    _density.clear();
+    _densityImage = QImage();
+}
 
-    _nodeMap.clear();
+void GraphScene::virtualGraphChanged()
+{
+    if(_virtualStale)
+        return;
 
-    for(nodeIter iter = _nodes.begin(); iter != _nodes.end(); ++iter)
+    // Nodes and edges are deleted before their removal is signalled, so
+    // nothing here may look at them
+    cancelLayout();
+    _layoutAnimator->finish();
+    clearItems();
+    _virtualStale = true;
+    update();
+    QTimer::singleShot(0, this, SLOT(rebuildVirtualGraph()));
+}
+
+void GraphScene::rebuildVirtualGraph()
+{
+    if(!_virtualStale || !_virtualized)
+        return;
+
+    _virtualStale = false;
+    setVirtualGraph();
+}
+
+void GraphScene::setVirtualGraph()
+{
+    std::vector<Node *> nList = _graph->nodes();
+    std::vector<Edge *> eList = _graph->edges();
+
+    bool layoutSet = false;
+    for(size_t i = 0; i < nList.size() && !layoutSet; ++i)
+        layoutSet = (nList[i]->pos().x() != 0 || nList[i]->pos().y() != 0);
+
+    // There are no items to pass to OGDF, so a graph without a layout is
+    // spread over a square grid instead
+    int nodeCount = static_cast<int>(nList.size());
+    double side = std::ceil(std::sqrt(static_cast<double>(nodeCount)));
+    int columns = qMax(1, static_cast<int>(side));
+
+    // Most nodes never have an item, so they are laid out at a nominal size
+    QSizeF nodeSize(LAYOUT_DEFAULT_NODE_SIZE, LAYOUT_DEFAULT_NODE_SIZE);
+    _layoutMirror.reserve(nodeCount, static_cast<int>(eList.size()));
+
+    _incidentEdges.reserve(nodeCount);
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        Node *n = nList[i];
+        if(!layoutSet)
+            n->setPos((i % columns) * VIRTUAL_NODE_SPACING,
+                      (i / columns) * VIRTUAL_NODE_SPACING);
+        _nodeGrid.insert(n, QRectF(n->pos(), QSizeF(1, 1)));
+        _layoutMirror.addNode(n->id(), nodeSize, 0, n);
+    }
+
+    for(size_t i = 0; i < eList.size(); ++i)
+    {
+        Edge *e = eList[i];
+        _incidentEdges[e->from()].append(e);
+        if(e->to() != e->from())
+            _incidentEdges[e->to()].append(e);
+        _layoutMirror.addEdge(e->id(), e->from()->id(), e->to()->id());
+    }
+
+    if(layoutSet)
+        _layoutMirror.markSettled();
+
+    _readOnly = true;
+    setDensityGraph();
+    resizeToContents();
+    materialise(_visibleRect);
+}
+
+void GraphScene::setDensityGraph()
+{
+    std::vector<Node *> nList = _graph->nodes();
+    std::vector<Edge *> eList = _graph->edges();
+
+    QVector<QPointF> positions;
+    positions.reserve(static_cast<int>(nList.size()));
+    QHash<Node *, int> indices;
+    indices.reserve(static_cast<int>(nList.size()));
+    for(size_t i = 0; i < nList.size(); ++i)
     {
-        NodeItem *node = *iter;
-        ogdf::node ogdfNode = _g.newNode();
-        _ga.x(ogdfNode) = node->pos().x();
-        _ga.y(ogdfNode) = node->pos().y();
-        _ga.labelNode(ogdfNode) = ogdf::String(node->label().toStdString().c_str());
-        _ga.width(ogdfNode) = node->shape().boundingRect().width();
-        _ga.height(ogdfNode) = node->shape().boundingRect().height();
-        _nodeMap.insert(node->id(), ogdfNode);
+        indices.insert(nList[i], positions.size());
+        positions.append(nList[i]->pos());
     }
 
+    QVector< QPair<int, int> > edges;
+    edges.reserve(static_cast<int>(eList.size()));
+    for(size_t i = 0; i < eList.size(); ++i)
+        edges.append(qMakePair(indices.value(eList[i]->from(), -1),
+                               indices.value(eList[i]->to(), -1)));
+
+    _density.setGraph(positions, edges);
+    _densityImage = QImage();
+    update();
+}
+
+QRectF GraphScene::materialiseRect(const QRectF &rect) const
+{
+    QRectF area = rect.normalized();
+    if(!_virtualized)
+        return area;
+
+    // Halve the area about its centre until few enough nodes are in it, and
+    // the margin around it, to be given items
+    while(area.width() > 1.0 && area.height() > 1.0
+          && _nodeGrid.query(area.adjusted(
+                                 -VIRTUAL_VIEW_MARGIN, -VIRTUAL_VIEW_MARGIN,
+                                 VIRTUAL_VIEW_MARGIN, VIRTUAL_VIEW_MARGIN)
+                             ).size() > VIRTUAL_MAX_NODE_ITEMS)
+    {
+        QPointF centre = area.center();
+        area.setSize(area.size() / 2);
+        area.moveCenter(centre);
+    }
+
+    return area;
+}
+
+void GraphScene::materialise(const QRectF &rect)
+{
+    if(!_virtualized)
+        return;
+
+    QList<Node *> inView;
+    if(!rect.isEmpty())
+        inView = _nodeGrid.query(rect.adjusted(-VIRTUAL_VIEW_MARGIN,
+                                               -VIRTUAL_VIEW_MARGIN,
+                                               VIRTUAL_VIEW_MARGIN,
+                                               VIRTUAL_VIEW_MARGIN));
+
+    bool overview = inView.size() > VIRTUAL_MAX_NODE_ITEMS;
+    if(overview)
+        inView.clear();
+
+    QSet<Node *> wantedNodes;
+    for(int i = 0; i < inView.size(); ++i)
+        wantedNodes.insert(inView.at(i));
+
+    // Edges leaving the area need an item for the node at their far end too.
+    // Those count against the budget as well, so a node with a huge number
+    // of edges cannot bring in an item for each of them and its neighbours
+    QSet<Edge *> wantedEdges;
+    QSet<Edge *> clippedEdges;
+    for(int i = 0; i < inView.size(); ++i)
+    {
+        QVector<Edge *> edges = _incidentEdges.value(inView.at(i));
+        for(int j = 0; j < edges.size(); ++j)
+        {
+            Edge *e = edges.at(j);
+            if(wantedEdges.contains(e) || clippedEdges.contains(e))
+                continue;
+
+            int farNodes = 0;
+            if(!wantedNodes.contains(e->from()))
+                ++farNodes;
+            if(!wantedNodes.contains(e->to()))
+                ++farNodes;
+
+            if(wantedEdges.size() >= VIRTUAL_MAX_EDGE_ITEMS
+                    || wantedNodes.size() + farNodes > VIRTUAL_MAX_NODE_ITEMS)
+            {
+                clippedEdges.insert(e);
+                continue;
+            }
+
+            wantedEdges.insert(e);
+            wantedNodes.insert(e->from());
+            wantedNodes.insert(e->to());
+        }
+    }
+
+    // Release items which are no longer wanted, apart from selected ones so
+    // that a selection survives scrolling
+    QList<EdgeItem *> staleEdges;
     for(edgeIter iter = _edges.begin(); iter != _edges.end(); ++iter)
     {
-        EdgeItem *edge = *iter;
-        Q_ASSERT(_nodeMap.contains(edge->from()->id()));
-        Q_ASSERT(_nodeMap.contains(edge->to()->id()));
-        ogdf::edge ogdfEdge = _g.newEdge(
-                    _nodeMap[edge->from()->id()],
-                    _nodeMap[edge->to()->id()]
-                );
-        _ga.labelEdge(ogdfEdge) = ogdf::String(edge->label().toStdString().c_str());
+        EdgeItem *edgeItem = *iter;
+        if(wantedEdges.contains(edgeItem->edge()))
+            continue;
+
+        if(edgeItem->isSelected())
+        {
+            wantedNodes.insert(edgeItem->edge()->from());
+            wantedNodes.insert(edgeItem->edge()->to());
+        }
+        else
+            staleEdges << edgeItem;
+    }
+    for(int i = 0; i < staleEdges.size(); ++i)
+        releaseEdgeItem(staleEdges.at(i));
+
+    QList<NodeItem *> staleNodes;
+    for(nodeIter iter = _nodes.begin(); iter != _nodes.end(); ++iter)
+    {
+        NodeItem *nodeItem = *iter;
+        if(!wantedNodes.contains(nodeItem->node()) && !nodeItem->isSelected())
+            staleNodes << nodeItem;
+    }
+    for(int i = 0; i < staleNodes.size(); ++i)
+        releaseNodeItem(staleNodes.at(i));
+
+    // Then create items for whatever has come into view
+    for(QSet<Node *>::const_iterator iter = wantedNodes.constBegin();
+        iter != wantedNodes.constEnd(); ++iter)
+    {
+        if(!_nodes.contains((*iter)->id()))
+            acquireNodeItem(*iter);
+    }
+
+    for(QSet<Edge *>::const_iterator iter = wantedEdges.constBegin();
+        iter != wantedEdges.constEnd(); ++iter)
+    {
+        Edge *e = *iter;
+        if(!_edges.contains(e->id()))
+            acquireEdgeItem(e, _nodes.value(e->from()->id()),
+                            _nodes.value(e->to()->id()));
+    }
+
+    if(overview != _overview || clippedEdges != _clippedEdges)
+    {
+        _overview = overview;
+        _clippedEdges = clippedEdges;
+        update();
     }
 }
 
-void GraphScene::layoutTree(LayoutDirections direction)
+NodeItem *GraphScene::acquireNodeItem(Node *node)
 {
-    layoutInit();
+    NodeItem *nodeItem;
+    if(_spareNodeItems.isEmpty())
+    {
+        nodeItem = new NodeItem(node);
+        addItem(nodeItem);
+        connect(nodeItem, SIGNAL(xChanged()), this, SLOT(nodeItemMoved()));
+        connect(nodeItem, SIGNAL(yChanged()), this, SLOT(nodeItemMoved()));
+    }
+    else
+    {
+        nodeItem = _spareNodeItems.takeLast();
+        nodeItem->setNode(node);
+        nodeItem->setVisible(true);
+    }
 
-    ogdf::TreeLayout tree;
-    tree.siblingDistance(40.0);
-    tree.subtreeDistance(30.0);
-    tree.levelDistance(60.0);
-    tree.treeDistance(60.0);
+    nodeItem->setPos(node->pos());
+    _nodes.insert(node->id(), nodeItem);
+    _indexedPositions.insert(nodeItem, node->pos());
+    _hitIndex.addNode(nodeItem);
+    return nodeItem;
+}
+
+void GraphScene::releaseNodeItem(NodeItem *nodeItem)
+{
+    // The node may have been dragged while it had an item
+    Node *node = nodeItem->node();
+    QPointF indexedPos = _indexedPositions.take(nodeItem);
+    if(node->pos() != indexedPos)
+        _nodeGrid.move(node, QRectF(indexedPos, QSizeF(1, 1)),
+                       QRectF(node->pos(), QSizeF(1, 1)));
+
+    _nodes.remove(nodeItem->id());
+    _hitIndex.removeNode(nodeItem);
+    nodeItem->setSelected(false);
+    nodeItem->setVisible(false);
+    _spareNodeItems.append(nodeItem);
+}
 
-    switch(direction)
+EdgeItem *GraphScene::acquireEdgeItem(Edge *edge, NodeItem *from, NodeItem *to)
+{
+    EdgeItem *edgeItem;
+    if(_spareEdgeItems.isEmpty())
     {
-    case Layout_RightToLeft:
-        tree.orientation(ogdf::rightToLeft);
-        break;
-    case Layout_BottomToTop:
-        tree.orientation(ogdf::bottomToTop);
-        break;
-    case Layout_LeftToRight:
-        tree.orientation(ogdf::leftToRight);
-        break;
-    case Layout_TopToBottom:
-    default:
-        tree.orientation(ogdf::topToBottom);
-        break;
+        edgeItem = new EdgeItem(edge, from, to);
+        addItem(edgeItem);
+    }
+    else
+    {
+        edgeItem = _spareEdgeItems.takeLast();
+        edgeItem->setEdge(edge, from, to);
+        edgeItem->setVisible(true);
     }
 
-    tree.call(_ga);
+    _edges.insert(edge->id(), edgeItem);
+    _hitIndex.addEdge(edgeItem);
+    return edgeItem;
+}
 
-    layoutApply();
+void GraphScene::releaseEdgeItem(EdgeItem *edgeItem)
+{
+    // Stop following the end points, their items are about to be reused
+    disconnect(edgeItem->from(), 0, edgeItem, 0);
+    disconnect(edgeItem->to(), 0, edgeItem, 0);
+
+    _edges.remove(edgeItem->id());
+    _hitIndex.removeEdge(edgeItem);
+    edgeItem->setSelected(false);
+    edgeItem->setVisible(false);
+    _spareEdgeItems.append(edgeItem);
 }
 
-void GraphScene::layoutSugiyama()
+void GraphScene::styleChanged()
 {
-    layoutInit();
+    // Nodes resize to fit their labels in the new font, and their edges follow
+    // through the shapeChanged() signal
+    for(QMap<QString, NodeItem *>::iterator iter = _nodes.begin();
+        iter != _nodes.end(); ++iter)
+        iter.value()->recalculate();
 
-    ogdf::SugiyamaLayout sugiyama;
+    _densityImage = QImage();
+    update();
+}
 
-    ogdf::FastHierarchyLayout *fhl = new ogdf::FastHierarchyLayout;
-    fhl->layerDistance(45.0);
-    fhl->nodeDistance(30.0);
-    sugiyama.setLayout(fhl);
+void GraphScene::layout(LayoutAlgorithms algorithm,
+                        LayoutDirections direction)
+{
+    LayoutJob job;
+    job.algorithm = algorithm;
+    job.direction = direction;
+    startLayout(job);
+}
 
-    sugiyama.call(_ga);
+void GraphScene::refineLayout()
+{
+    QVector<int> unsettled = _layoutMirror.unsettledNodes();
+    if(unsettled.isEmpty())
+        return;
 
-    layoutApply();
+    // With nothing settled there is nothing to refine, so lay out in full
+    LayoutJob job;
+    job.algorithm = LayoutAlgorithm_BarnesHut;
+    if(unsettled.size() < _layoutMirror.nodeCount())
+        job.freeNodes = unsettled;
+    startLayout(job);
 }
 
-void GraphScene::layoutRadialTree()
+bool GraphScene::animateLayouts() const
 {
-    layoutInit();
+    return _animateLayouts;
+}
 
-    ogdf::RadialTreeLayout radialTree;
-    radialTree.levelDistance(60.0);
-    radialTree.connectedComponentDistance(60.0);
+void GraphScene::setAnimateLayouts(bool animate)
+{
+    _animateLayouts = animate;
+}
 
-    radialTree.call(_ga);
+bool GraphScene::edgeBundling() const
+{
+    return _edgeBundling;
+}
 
-    layoutApply();
+void GraphScene::setEdgeBundling(bool bundle)
+{
+    if(bundle == _edgeBundling)
+        return;
+
+    _edgeBundling = bundle;
+    if(_edgeBundling)
+        startBundling();
+    else
+        clearBundles();
 }
 
-void GraphScene::layoutFPP()
+void GraphScene::startLayout(LayoutJob job)
 {
-    layoutInit();
+    // Only the latest layout is applied, and it starts from wherever the last
+    // one was going
+    cancelLayout();
+    _layoutAnimator->finish();
+
+    _latestLayout->fetchAndStoreRelaxed(++_layoutRevision);
+    _layoutProgress->fetchAndStoreRelaxed(0);
+
+    job.revision = _layoutRevision;
+    job.latestRevision = _latestLayout;
+    job.progress = _layoutProgress;
+    prepareLayout(&job);
+
+    // Moving every item of a virtualised scene for each frame would defeat
+    // the point of it
+    if(_animateLayouts && !_virtualized
+            && job.algorithm == LayoutAlgorithm_BarnesHut)
+        job.frame = QSharedPointer<LayoutFrame>(new LayoutFrame);
+
+    _layoutJob = job;
+    _layoutRunning = true;
+    _layoutTimer->start();
+    _layoutPollTimer->start();
+    _layoutWatcher->setFuture(QtConcurrent::run(&runLayout, job));
+}
 
-    ogdf::FPPLayout fpp;
+bool GraphScene::layoutRunning() const
+{
+    return _layoutRunning;
+}
 
-    fpp.call(_ga);
+void GraphScene::cancelLayout()
+{
+    if(!_layoutRunning)
+        return;
 
-    layoutApply();
+    // OGDF cannot be interrupted, so the worker may run on until the algorithm
+    // returns but its result will be discarded
+    _latestLayout->fetchAndStoreRelaxed(++_layoutRevision);
+    _layoutRunning = false;
+    _layoutJob = LayoutJob();
+    _layoutTimer->stop();
+    _layoutPollTimer->stop();
+    emit layoutEnded();
 }
 
-void GraphScene::layoutPlanarDraw()
+void GraphScene::layoutFinished()
 {
-    layoutInit();
+    LayoutJob job = _layoutWatcher->result();
+    if(job.cancelled || job.revision != _layoutRevision)
+        return;
 
-    ogdf::PlanarDrawLayout planarDraw;
+    _layoutRunning = false;
+    _layoutJob = LayoutJob();
+    _layoutTimer->stop();
+    _layoutPollTimer->stop();
 
-    planarDraw.call(_ga);
+    if(job.failed)
+        emit layoutFailed(tr("The layout mechanism failed with a precondition "
+                             "error. Ensure that the layout mechanism selected "
+                             "is appropriate for the provided graph."));
+    else
+    {
+        applyLayout(job);
+        emit layoutProgress(100);
+    }
 
-    layoutApply();
+    emit layoutEnded();
 }
 
-void GraphScene::layoutPlanarStraight()
+void GraphScene::layoutTimedOut()
 {
-    layoutInit();
+    if(!_layoutRunning)
+        return;
+
+    cancelLayout();
+    emit layoutFailed(tr("The layout did not finish within %1 seconds and has "
+                         "been abandoned. Try a faster layout mechanism for a "
+                         "graph of this size.").arg(LAYOUT_TIMEOUT / 1000));
+}
+
+void GraphScene::pollLayoutProgress()
+{
+    emit layoutProgress(_layoutProgress->fetchAndAddRelaxed(0));
+
+    if(_layoutJob.frame.isNull())
+        return;
 
-    ogdf::PlanarStraightLayout planarStraight;
+    QVector<QPointF> positions;
+    {
+        QMutexLocker locker(&_layoutJob.frame->mutex);
+        if(!_layoutJob.frame->fresh)
+            return;
+        positions = _layoutJob.frame->positions;
+        _layoutJob.frame->fresh = false;
+    }
+
+    // Each frame is reached just as the next one is due
+    moveNodes(_layoutJob, positions, _layoutPollTimer->interval());
+}
+
+void GraphScene::layoutAnimationFinished()
+{
+    // The animator moves nodes without telling anyone
+    _hitIndex.invalidate();
+    scheduleBundling();
 
-    planarStraight.call(_ga);
+    if(!_settleLayout)
+        return;
 
-    layoutApply();
+    _settleLayout = false;
+    _layoutMirror.markSettled();
+    resizeToContents();
 }
 
-void GraphScene::layoutSchnyder()
+void GraphScene::prepareLayout(LayoutJob *job)
 {
-    layoutInit();
+    // A scene which is not virtualised mirrors its items, which takes in any
+    // nodes and edges only present in the linked graph. A virtualised scene
+    // mirrors its graph.
+    _layoutMirror.snapshot(job);
+}
 
-    ogdf::SchnyderLayout schnyder;
+void GraphScene::moveNodes(const LayoutJob &job,
+                           const QVector<QPointF> &positions, int duration)
+{
+    bool animate = (duration > 0 && _animateLayouts && !_virtualized);
+    QVector<NodeItem *> items;
+    QVector<QPointF> targets;
+
+    // The graph may have been edited while the layout ran. Unless a node has
+    // been removed since, every node is still at the index it had in the job,
+    // otherwise nodes are matched up by ID and any which have gone skipped.
+    bool byIndex = (job.mirrorRevision == _layoutMirror.revision());
+    for(int i = 0; i < job.nodeIds.size(); ++i)
+    {
+        int index = byIndex ? i : _layoutMirror.nodeIndex(job.nodeIds.at(i));
+        if(index < 0)
+            continue;
 
-    schnyder.call(_ga);
+        // Materialised items of a virtualised scene follow their nodes
+        NodeItem *item = _layoutMirror.nodeItem(index);
+        if(item != 0 && animate)
+        {
+            items.push_back(item);
+            targets.push_back(positions.at(i));
+        }
+        else if(item != 0)
+            item->setPos(positions.at(i));
+        else
+            _layoutMirror.node(index)->setPos(positions.at(i));
+    }
 
-    layoutApply();
+    if(animate)
+    {
+        // The bundles would stay behind as the nodes move
+        scheduleBundling();
+        _layoutAnimator->animate(items, targets, _edges.values(), duration);
+    }
 }
 
-void GraphScene::layoutPlanarizationGrid()
+void GraphScene::applyLayout(const LayoutJob &job)
 {
-    layoutInit();
+    if(_animateLayouts && !_virtualized)
+    {
+        // Settled by layoutAnimationFinished() once the nodes arrive
+        _settleLayout = true;
+        moveNodes(job, job.positions, LAYOUT_ANIMATION_DURATION);
+        return;
+    }
 
-    ogdf::PlanarizationGridLayout planarGrid;
-    planarGrid.separation(50.0);
+    moveNodes(job, job.positions);
+    _layoutMirror.markSettled();
 
-    planarGrid.call(_ga);
+    if(!_virtualized)
+    {
+        resizeToContents();
+        return;
+    }
+
+    // Nearly every node has moved, so the index is rebuilt rather than
+    // updated node by node
+    std::vector<Node *> nList = _graph->nodes();
+    _nodeGrid.clear();
+    for(std::vector<Node *>::iterator iter = nList.begin();
+        iter != nList.end(); ++iter)
+        _nodeGrid.insert(*iter, QRectF((*iter)->pos(), QSizeF(1, 1)));
+
+    for(nodeIter iter = _nodes.begin(); iter != _nodes.end(); ++iter)
+        _indexedPositions.insert(*iter, (*iter)->node()->pos());
 
-    layoutApply();
+    setDensityGraph();
+    resizeToContents();
+    materialise(_visibleRect);
 }
 
-void GraphScene::layoutCircular()
+void GraphScene::scheduleBundling()
 {
-    layoutInit();
+    if(!_edgeBundling || _virtualized)
+        return;
 
-    ogdf::CircularLayout circular;
-    circular.minDistCircle(50.0);
-    circular.minDistLevel(50.0);
-    circular.minDistSibling(35.0);
-    circular.minDistCC(50.0);
+    clearBundles();
+    _bundleTimer->start();
+}
 
-    circular.call(_ga);
+void GraphScene::clearBundles()
+{
+    // Any bundling under way is for the old positions
+    _latestBundle->fetchAndStoreRelaxed(++_bundleRevision);
+    _bundleTimer->stop();
+    if(_bundles.paths.isEmpty())
+        return;
 
-    layoutApply();
+    for(int i = 0; i < _bundles.edgeIds.size(); ++i)
+    {
+        EdgeItem *edgeItem = _edges.value(_bundles.edgeIds.at(i));
+        if(edgeItem != 0)
+            edgeItem->setVisible(true);
+    }
+    _bundles = BundleJob();
+    update();
 }
 
-void GraphScene::layoutSpring()
+void GraphScene::startBundling()
 {
-    layoutInit();
+    if(!_edgeBundling || _virtualized)
+        return;
 
-    ogdf::SpringEmbedderFR spring;
-    spring.minDistCC(40.0);
-    spring.scaleFunctionFactor(5.0);
+    clearBundles();
 
-    spring.call(_ga);
+    BundleJob job;
+    job.revision = _bundleRevision;
+    job.latestRevision = _latestBundle;
+    // Edges shown in another state, such as those a rule deletes, keep their
+    // items so that they stand out
+    for(edgeConstIter iter = _edges.constBegin(); iter != _edges.constEnd();
+        ++iter)
+    {
+        EdgeItem *edgeItem = *iter;
+        if(edgeItem->itemState() != GraphItem::GraphItem_Normal)
+            continue;
+        job.edgeIds.push_back(edgeItem->id());
+        job.lines.push_back(QLineF(edgeItem->from()->centerPos(),
+                                   edgeItem->to()->centerPos()));
+    }
 
-    layoutApply();
+    if(!job.lines.isEmpty())
+        _bundleWatcher->setFuture(QtConcurrent::run(&runEdgeBundling, job));
 }
 
-void GraphScene::layoutDavidsonHarel()
+void GraphScene::bundlingFinished()
 {
-    layoutInit();
+    BundleJob job = _bundleWatcher->result();
+    if(job.cancelled || job.revision != _bundleRevision)
+        return;
 
-    ogdf::DavidsonHarelLayout dh;
+    for(int i = 0; i < job.edgeIds.size(); ++i)
+    {
+        EdgeItem *edgeItem = _edges.value(job.edgeIds.at(i));
+        if(edgeItem != 0)
+            edgeItem->setVisible(false);
+    }
+    _bundles = job;
+    update();
+}
 
-    dh.call(_ga);
+void GraphScene::layoutTree(LayoutDirections direction)
+{
+    layout(LayoutAlgorithm_Tree, direction);
+}
 
-    layoutApply();
+void GraphScene::layoutSugiyama()
+{
+    layout(LayoutAlgorithm_Sugiyama);
 }
 
-void GraphScene::layoutFMMM()
+void GraphScene::layoutRadialTree()
 {
-    layoutInit();
+    layout(LayoutAlgorithm_RadialTree);
+}
 
-    ogdf::FMMMLayout fmmm;
+void GraphScene::layoutFPP()
+{
+    layout(LayoutAlgorithm_FPP);
+}
 
-    fmmm.call(_ga);
+void GraphScene::layoutPlanarDraw()
+{
+    layout(LayoutAlgorithm_PlanarDraw);
+}
 
-    layoutApply();
+void GraphScene::layoutPlanarStraight()
+{
+    layout(LayoutAlgorithm_PlanarStraight);
 }
 
-void GraphScene::layoutGEM()
+void GraphScene::layoutSchnyder()
 {
-    layoutInit();
+    layout(LayoutAlgorithm_Schnyder);
+}
 
-    ogdf::GEMLayout gem;
+void GraphScene::layoutPlanarizationGrid()
+{
+    layout(LayoutAlgorithm_PlanarizationGrid);
+}
+
+void GraphScene::layoutCircular()
+{
+    layout(LayoutAlgorithm_Circular);
+}
 
-    gem.call(_ga);
-    gem.desiredLength(20.0);
-    gem.minDistCC(50.0);
+void GraphScene::layoutSpring()
+{
+    layout(LayoutAlgorithm_Spring);
+}
 
-    layoutApply();
+void GraphScene::layoutDavidsonHarel()
+{
+    layout(LayoutAlgorithm_DavidsonHarel);
 }
 
-void GraphScene::layoutApply()
+void GraphScene::layoutFMMM()
 {
-    for(nodeIter iter = _nodes.begin(); iter != _nodes.end(); ++iter)
-    {
-        NodeItem *node = *iter;
-        QPointF newPosition;
-        newPosition.setX(_ga.x(_nodeMap[node->id()]));
-        newPosition.setY(_ga.y(_nodeMap[node->id()]));
-        node->setPos(newPosition);
-    }
+    layout(LayoutAlgorithm_FMMM);
+}
 
-    resizeToContents();
+void GraphScene::layoutGEM()
+{
+    layout(LayoutAlgorithm_GEM);
+}
+
+void GraphScene::layoutBarnesHut()
+{
+    layout(LayoutAlgorithm_BarnesHut);
 }
 
 void GraphScene::resizeToContents()
 {
     QRectF boundingRect = itemsBoundingRect();
+    // Most of a virtualised graph has no items, take in every indexed node
+    if(_virtualized)
+        boundingRect = boundingRect.united(_nodeGrid.bounds());
     QPointF topLeft = boundingRect.topLeft();
     QPointF bottomRight = boundingRect.bottomRight();
 
@@ -589,8 +1242,13 @@ void GraphScene::addNode(const QPointF &position, bool automatic)
     QString label = QString("n") + QVariant(static_cast<int>(_graph->nodes().size()+1)
                                         ).toString();
     Node *n = _graph->addNode(label, position);
+    if(n == 0)
+        return;
 
-    NodeItem *nodeItem = new NodeItem(n);
+    // The item is created in response to the graph's nodeAdded() signal
+    NodeItem *nodeItem = node(n->id());
+    if(nodeItem == 0)
+        return;
 
     if(_linkedGraph != 0)
     {
@@ -614,7 +1272,7 @@ void GraphScene::addNode(const QPointF &position, bool automatic)
     QPointF centerPos(position.x() - boundingRect.width()/2,
                       position.y() - boundingRect.height()/2
                       );
-    addNodeItem(nodeItem, centerPos);
+    nodeItem->setPos(centerPos);
 }
 
 void GraphScene::addNode(qreal x, qreal y)
@@ -629,18 +1287,134 @@ void GraphScene::nodeIdChanged(QString oldId, QString newId)
         NodeItem *nodeItem = _nodes[oldId];
         _nodes.remove(oldId);
         _nodes.insert(newId, nodeItem);
+        _layoutMirror.renameNode(oldId, newId);
     }
 }
 
+void GraphScene::edgeIdChanged(QString oldId, QString newId)
+{
+    if(_edges.contains(oldId))
+    {
+        EdgeItem *edgeItem = _edges[oldId];
+        _edges.remove(oldId);
+        _edges.insert(newId, edgeItem);
+        _layoutMirror.renameEdge(oldId, newId);
+    }
+}
+
+void GraphScene::nodeShapeChanged()
+{
+    NodeItem *nodeItem = qobject_cast<NodeItem *>(sender());
+    if(nodeItem == 0)
+        return;
+
+    _layoutMirror.setNodeSize(nodeItem->id(),
+                              nodeItem->shape().boundingRect().size());
+    _hitIndex.nodeMoved(nodeItem);
+}
+
+void GraphScene::nodeItemMoved()
+{
+    NodeItem *nodeItem = qobject_cast<NodeItem *>(sender());
+    if(nodeItem == 0)
+        return;
+
+    _hitIndex.nodeMoved(nodeItem);
+    scheduleBundling();
+}
+
+void GraphScene::drawBackground(QPainter *painter, const QRectF &rect)
+{
+    QGraphicsScene::drawBackground(painter, rect);
+
+    if(!_bundles.paths.isEmpty())
+    {
+        // Bundled edges are drawn beneath the nodes, translucent so that the
+        // busier bundles stand out
+        GraphViewStyle *style = GraphViewStyle::instance();
+        QColor colour = style->edgeColour(GraphItem::GraphItem_Normal, false,
+                                          false);
+        colour.setAlphaF(0.5);
+        QPen pen(colour);
+        pen.setWidthF(style->edgeLineWidth());
+        painter->setPen(pen);
+        painter->setBrush(Qt::NoBrush);
+
+        qreal margin = style->edgeLineWidth();
+        QRectF exposed = rect.adjusted(-margin, -margin, margin, margin);
+        for(int i = 0; i < _bundles.paths.size(); ++i)
+        {
+            if(_bundles.bounds.at(i).intersects(exposed))
+                painter->drawPath(_bundles.paths.at(i));
+        }
+    }
+
+    if(_virtualized && !_clippedEdges.isEmpty())
+    {
+        // The edges left without items end at the node centres, the painter
+        // clips them to the view
+        GraphViewStyle *style = GraphViewStyle::instance();
+        QPen pen(style->edgeColour(GraphItem::GraphItem_Normal, false,
+                                   false));
+        pen.setWidthF(style->edgeLineWidth());
+        painter->setPen(pen);
+
+        for(QSet<Edge *>::const_iterator iter = _clippedEdges.constBegin();
+            iter != _clippedEdges.constEnd(); ++iter)
+        {
+            Node *from = (*iter)->from();
+            Node *to = (*iter)->to();
+            NodeItem *fromItem = _nodes.value(from->id());
+            NodeItem *toItem = _nodes.value(to->id());
+            painter->drawLine(fromItem != 0 ? fromItem->centerPos()
+                                            : from->pos(),
+                              toItem != 0 ? toItem->centerPos() : to->pos());
+        }
+    }
+
+    if(!_virtualized || !_overview)
+        return;
+
+    // Too many nodes are in view to give them items, so their density is
+    // drawn with a pixel for every DENSITY_CELL_SIZE square of the screen
+    qreal scale = painter->worldTransform().mapRect(QRectF(0, 0, 1, 1)).width();
+    if(scale <= 0)
+        return;
+    qreal cellSize = DENSITY_CELL_SIZE / scale;
+
+    if(_densityImage.isNull() || !_densityRect.contains(rect)
+            || !qFuzzyCompare(cellSize, _densityCellSize))
+    {
+        // Drawn with a margin, so that short scrolls reuse the image
+        qreal marginX = rect.width() / 2;
+        qreal marginY = rect.height() / 2;
+        GraphViewStyle *style = GraphViewStyle::instance();
+        _densityImage = _density.render(
+                    rect.adjusted(-marginX, -marginY, marginX, marginY),
+                    cellSize,
+                    style->nodeBorderColour(GraphItem::GraphItem_Normal,
+                                            false, false),
+                    style->edgeColour(GraphItem::GraphItem_Normal, false,
+                                      false),
+                    &_densityRect);
+        _densityCellSize = cellSize;
+    }
+
+    if(_densityImage.isNull())
+        return;
+
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+    painter->drawImage(_densityRect, _densityImage);
+    painter->restore();
+}
+
 void GraphScene::drawForeground(QPainter *painter, const QRectF &rect)
 {
     Q_UNUSED(rect)
-    QSettings settings;
-    qreal arrowSize = settings.value("GraphView/Edges/ArrowSize", 9).toDouble();
-    qreal lineWidth = settings.value("GraphView/Edges/LineWidth", 1.5).toDouble();
-    QColor lineColour  = settings.value("GraphView/Edges/LineColour",
-                                        QColor(0x33,0x33,0x33)).value<QColor>();
-    lineColour.setAlpha(100);
+    GraphViewStyle *style = GraphViewStyle::instance();
+    qreal arrowSize = style->edgeArrowSize();
+    qreal lineWidth = style->edgeLineWidth();
 
     if(_drawingEdge)
     {
@@ -698,10 +1472,8 @@ void GraphScene::drawForeground(QPainter *painter, const QRectF &rect)
         drawLine.setAngle(angle);
         painterPath.lineTo(drawLine.p2());
 
-        QPen edgePen(lineColour);
-        edgePen.setWidth(lineWidth);
-        painter->setPen(edgePen);
-        painter->setBrush(lineColour);
+        painter->setPen(style->draggedEdgePen());
+        painter->setBrush(style->draggedEdgeBrush());
         painter->drawPath(painterPath);
     }
 
@@ -714,11 +1486,29 @@ void GraphScene::drawForeground(QPainter *painter, const QRectF &rect)
         painter->setBrush(selectionColour);
 
         painter->drawRect(QRectF(_mouseInitialPos, _mousePos));
+    }
+}
 
-        QPainterPath path;
-        path.addRect(QRectF(_mouseInitialPos, _mousePos));
+void GraphScene::selectArea(const QRectF &rect)
+{
+    // QGraphicsScene::setSelectionArea() would test the shape of every item
+    QList<QGraphicsItem *> inside = _hitIndex.itemsIn(rect);
+    QSet<QGraphicsItem *> chosen;
+    for(int i = 0; i < inside.size(); ++i)
+        chosen.insert(inside.at(i));
+
+    QList<QGraphicsItem *> selected = selectedItems();
+    for(int i = 0; i < selected.size(); ++i)
+    {
+        if(!chosen.contains(selected.at(i)))
+            selected.at(i)->setSelected(false);
+    }
 
-        setSelectionArea(path);
+    for(QSet<QGraphicsItem *>::iterator iter = chosen.begin();
+        iter != chosen.end(); ++iter)
+    {
+        if(!(*iter)->isSelected())
+            (*iter)->setSelected(true);
     }
 }
 
@@ -754,70 +1544,137 @@ void GraphScene::removeEdge(EdgeItem *edge)
         return;
     }
 
+    // The item is removed in response to the graph's edgeRemoved() signal
     if(!_graph->removeEdge(edge->id()))
-    {
         qDebug() << "Could not remove edge from graph: " << edge->id();
+}
+
+void GraphScene::removeNode(NodeItem *node)
+{
+    if(node == 0)
+    {
+        qDebug() << "GraphScene::removeNode() passed null pointer, ignoring";
         return;
     }
 
-    edgeIter iter = _edges.begin();
-    while(iter != _edges.end()
-          && (*iter)->id() != edge->id())
-        ++iter;
-
-    if(iter == _edges.end())
+    // Removal cascades to the node's edges, the items are removed in response
+    // to the graph's edgeRemoved() and nodeRemoved() signals
+    if(!_graph->removeNode(node->id()))
     {
-        qDebug() << "Unexpected error in GraphScene::removeEdge() - edge not "
-                 << "found";
+        qDebug() << "Failed to delete all child edges of node: " << node->id();
+        qDebug() << "Could not delete node.";
+    }
+}
+
+void GraphScene::graphNodeAdded(Node *node)
+{
+    if(_nodes.contains(node->id()))
         return;
+
+    NodeItem *nodeItem = new NodeItem(node);
+    if(_linkedGraph != 0)
+    {
+        if(!_linkedGraph->contains(node->id()))
+            nodeItem->setItemState(GraphItem::GraphItem_New);
+        else if(!_linkedGraph->containsNode(node->id()))
+            nodeItem->setItemState(GraphItem::GraphItem_Invalid);
     }
 
-    removeItem(edge);
-    _edges.remove(iter.key());
-    delete edge;
+    addNodeItem(nodeItem, node->pos());
 }
 
-void GraphScene::removeNode(NodeItem *node)
+void GraphScene::graphEdgeAdded(Edge *edge)
 {
-    if(node == 0)
+    if(_edges.contains(edge->id()))
+        return;
+
+    NodeItem *from = _nodes.value(edge->from()->id());
+    NodeItem *to = _nodes.value(edge->to()->id());
+    if(from == 0 || to == 0)
     {
-        qDebug() << "GraphScene::removeNode() passed null pointer, ignoring";
+        qDebug() << "GraphScene::graphEdgeAdded() could not locate either or "
+                 << "both of nodes" << edge->from()->id() << "and"
+                 << edge->to()->id() << "in the visualisation";
         return;
     }
 
-    std::vector<Edge *> edges = node->node()->edges();
-    for(std::vector<Edge *>::iterator iter = edges.begin();
-        iter != edges.end(); ++iter)
+    EdgeItem *edgeItem = new EdgeItem(edge, from, to);
+    if(_linkedGraph != 0)
     {
-        Edge *e = *iter;
-        removeEdge(edge(e->id()));
+        if(!_linkedGraph->contains(edge->id()))
+            edgeItem->setItemState(GraphItem::GraphItem_New);
+        else if(!_linkedGraph->containsEdge(edge->id()))
+            edgeItem->setItemState(GraphItem::GraphItem_Invalid);
     }
 
-    if(node->node()->edges().size() > 0)
-    {
-        qDebug() << "Failed to delete all child edges of node: " << node->id();
-        qDebug() << "Could not delete node.";
+    addEdgeItem(edgeItem);
+}
+
+void GraphScene::graphNodeRemoved(QString id)
+{
+    NodeItem *nodeItem = _nodes.value(id);
+    if(nodeItem == 0)
         return;
+
+    if(_fromNode == nodeItem)
+    {
+        _drawingEdge = false;
+        _fromNode = 0;
     }
 
-    nodeIter iter = _nodes.begin();
-    while(iter != _nodes.end()
-          && (*iter)->id() != node->id())
-        ++iter;
+    _layoutAnimator->finish();
+    removeItem(nodeItem);
+    _nodes.remove(id);
+    _layoutMirror.removeNode(id);
+    _hitIndex.removeNode(nodeItem);
+    delete nodeItem;
+}
 
-    if(iter == _nodes.end())
-    {
-        qDebug() << "Unexpected error in GraphScene::removeNode() - node not "
-                 << "found";
+void GraphScene::graphEdgeRemoved(QString id)
+{
+    EdgeItem *edgeItem = _edges.value(id);
+    if(edgeItem == 0)
         return;
-    }
 
-    removeItem(node);
-    _nodes.remove(iter.key());
-    delete node;
+    _layoutAnimator->finish();
+    removeItem(edgeItem);
+    _edges.remove(id);
+    _layoutMirror.removeEdge(id);
+    _hitIndex.removeEdge(edgeItem);
+    delete edgeItem;
+    scheduleBundling();
+}
+
+void GraphScene::graphAboutToClear()
+{
+    // The graph is being reopened, the new nodes and edges arrive through
+    // graphNodeAdded() and graphEdgeAdded()
+    cancelLayout();
+    _layoutAnimator->finish();
+    clearBundles();
+    clearItems();
+}
 
-    if(!_graph->removeNode(node->id()))
+void GraphScene::edgeEndsChanged()
+{
+    Edge *e = qobject_cast<Edge *>(sender());
+    if(e == 0)
+        return;
+
+    EdgeItem *edgeItem = _edges.value(e->id());
+    NodeItem *from = _nodes.value(e->from()->id());
+    NodeItem *to = _nodes.value(e->to()->id());
+    if(edgeItem == 0 || from == 0 || to == 0)
         return;
+
+    // The index finds the old end points from its own records
+    edgeItem->setFrom(from);
+    edgeItem->setTo(to);
+    edgeItem->nodeMoved();
+    _layoutMirror.setEdgeEnds(e->id(), from->id(), to->id());
+    _hitIndex.removeEdge(edgeItem);
+    _hitIndex.addEdge(edgeItem);
+    scheduleBundling();
 }
 
 void GraphScene::linkedGraphAddedNode(Node *nodeItem)
@@ -825,7 +1682,9 @@ void GraphScene::linkedGraphAddedNode(Node *nodeItem)
     NodeItem *local = node(nodeItem->id());
     if(local == 0)
     {
-        // New node, copy it across as a phantom
+        // New node, copy it across as a phantom. The item is created in
+        // response to the graph's nodeAdded() signal and follows the phantom
+        // flag.
         Node *n = _graph->addNode(
                     nodeItem->id(),
                     nodeItem->label(),
@@ -837,10 +1696,6 @@ void GraphScene::linkedGraphAddedNode(Node *nodeItem)
             return;
         }
         n->setPhantom(true);
-
-        NodeItem *nItem = new NodeItem(n);
-        nItem->setItemState(GraphItem::GraphItem_Deleted);
-        addNodeItem(nItem, n->pos());
     }
     else
     {
@@ -849,7 +1704,6 @@ void GraphScene::linkedGraphAddedNode(Node *nodeItem)
     }
 }
 
-
 void GraphScene::linkedGraphAddedEdge(Edge *edgeItem)
 {
     EdgeItem *local = edge(edgeItem->id());
@@ -866,7 +1720,7 @@ void GraphScene::linkedGraphAddedEdge(Edge *edgeItem)
             return;
         }
 
-        // New node, copy it across as a phantom
+        // New edge, copy it across as a phantom
         Edge *e = _graph->addEdge(edgeItem->id(), from, to, edgeItem->label());
         if(e == 0)
         {
@@ -875,21 +1729,6 @@ void GraphScene::linkedGraphAddedEdge(Edge *edgeItem)
             return;
         }
         e->setPhantom(true);
-
-        NodeItem *fromNode = node(e->from()->id());
-        NodeItem *toNode = node(e->to()->id());
-
-        if(fromNode == 0 || toNode == 0)
-        {
-            qDebug() << "GraphScene::linkedGraphAddedEdge() could not locate "
-                     << "either or both of nodes" << e->from()->id()
-                     << "and" << e->to()->id() << "in the visualisation";
-            return;
-        }
-
-        EdgeItem *eItem = new EdgeItem(e, fromNode, toNode);
-        eItem->setItemState(GraphItem::GraphItem_Deleted);
-        addEdgeItem(eItem);
     }
     else
     {
@@ -989,6 +1828,10 @@ void GraphScene::keyPressEvent(QKeyEvent *event)
 
 void GraphScene::mousePressEvent(QGraphicsSceneMouseEvent *event)
 {
+    // Let nodes be picked up where they are headed rather than moved under
+    // the cursor
+    _layoutAnimator->finish();
+
     if(event->button() == Qt::RightButton)
     {
         // This should only work when the view is editable
@@ -999,31 +1842,26 @@ void GraphScene::mousePressEvent(QGraphicsSceneMouseEvent *event)
         }
 
         // Are we over a node?
-        for(nodeIter iter = _nodes.begin(); iter != _nodes.end(); ++iter)
+        NodeItem *node = _hitIndex.nodeAt(event->scenePos());
+        if(node != 0)
         {
-            NodeItem *node = *iter;
-
             // Don't draw edges from phantoms
             if(node->node()->isPhantomNode())
                 return;
 
-            QPainterPath path = node->shape();
-            path.translate(node->scenePos());
-            if(path.contains(event->scenePos()))
-            {
-                _drawingEdge = true;
-                _selecting = false;
-                _fromNode = node;
-                _mousePos = event->scenePos();
-                update();
-                return;
-            }
+            _drawingEdge = true;
+            _selecting = false;
+            _fromNode = node;
+            _mousePos = event->scenePos();
+            update();
+            return;
         }
     }
     else if(event->button() == Qt::LeftButton)
     {
         // Rubber-band selection, but not when another item should handle this
-        if(itemAt(event->scenePos(), QTransform()) || event->isAccepted())
+        if(!_hitIndex.itemsAt(event->scenePos()).isEmpty()
+                || event->isAccepted())
         {
             QGraphicsScene::mousePressEvent(event);
             return;
@@ -1044,13 +1882,21 @@ void GraphScene::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
     _mousePos = event->scenePos();
     QGraphicsScene::mouseMoveEvent(event);
 
-    QList<QGraphicsItem *> atPoint = items(event->scenePos());
+    // Nodes in a layout transition move without telling the index
+    if(_layoutAnimator->isRunning())
+        _hitIndex.invalidate();
+
+    if(_selecting)
+        selectArea(QRectF(_mouseInitialPos, _mousePos));
+
+    // The topmost item gets its hover events from QGraphicsScene, those below
+    // it are told here
+    QList<QGraphicsItem *> atPoint = _hitIndex.itemsAt(event->scenePos());
     for(int i = 1; i < atPoint.length(); ++i)
     {
-        QGraphicsSceneHoverEvent *hoverEvent = new QGraphicsSceneHoverEvent(
-                    QEvent::GraphicsSceneHoverMove);
-        hoverEvent->setScenePos(event->scenePos());
-        sendEvent(atPoint.at(i), hoverEvent);
+        QGraphicsSceneHoverEvent hoverEvent(QEvent::GraphicsSceneHoverMove);
+        hoverEvent.setScenePos(event->scenePos());
+        sendEvent(atPoint.at(i), &hoverEvent);
     }
     update();
 }
@@ -1064,38 +1910,21 @@ void GraphScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
 
         _drawingEdge = false;
         // Are we above a node at this point? If yes we need to add an edge
-        for(nodeIter iter = _nodes.begin(); iter != _nodes.end(); ++iter)
+        NodeItem *node = _hitIndex.nodeAt(event->scenePos());
+        if(node != 0)
         {
-            NodeItem *node = *iter;
-            QPainterPath path = node->shape();
-            path.translate(node->scenePos());
-            if(path.contains(event->scenePos()))
+            QString newLabel = _fromNode->label() + ":" + node->label();
+            Node *from = _graph->node(_fromNode->id());
+            Node *to = _graph->node(node->id());
+            if(from == 0 || to == 0)
             {
-                QString newLabel = _fromNode->label() + ":" + node->label();
-                Node *from = _graph->node(_fromNode->id());
-                Node *to = _graph->node(node->id());
-                if(from == 0 || to == 0)
-                {
-                    qDebug() << "Edge creation failed to find nodes.";
-                    return;
-                }
-                Edge *e = _graph->addEdge(from, to, newLabel);
-                EdgeItem *edgeItem = new EdgeItem(e, _fromNode, node);
-
-                if(_linkedGraph != 0)
-                {
-                    if(!_linkedGraph->contains(e->id()))
-                    {
-                        edgeItem->setItemState(GraphItem::GraphItem_New);
-                    }
-                    else if(_linkedGraph->containsNode(e->id()))
-                    {
-                        edgeItem->setItemState(GraphItem::GraphItem_Invalid);
-                    }
-                }
-                addEdgeItem(edgeItem);
+                qDebug() << "Edge creation failed to find nodes.";
                 return;
             }
+            // The item is created in response to the graph's edgeAdded()
+            // signal
+            _graph->addEdge(from, to, newLabel);
+            return;
         }
     }
 
@@ -1105,6 +1934,10 @@ void GraphScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
             return;
 
         _selecting = false;
+        if(_virtualized && _overview)
+            emit overviewRegionChosen(
+                        QRectF(_mouseInitialPos, event->scenePos())
+                        .normalized());
     }
 
     QGraphicsScene::mouseReleaseEvent(event);
@@ -1122,47 +1955,39 @@ void GraphScene::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
 
     // If we're over a node then don't add a new node, instead pass the event on
     // to trigger an EditNodeDialog
-    for(nodeIter iter = _nodes.begin(); iter != _nodes.end(); ++iter)
+    NodeItem *node = _hitIndex.nodeAt(event->scenePos());
+    if(node != 0)
     {
-        NodeItem *node = *iter;
-        QPainterPath path = node->shape();
-        path.translate(node->scenePos());
-        if(path.contains(event->scenePos()))
+        if(_linkedGraph != 0)
         {
-            if(_linkedGraph != 0)
+            if(node->itemState() == GraphItem::GraphItem_Deleted)
             {
-                if(node->itemState() == GraphItem::GraphItem_Deleted)
-                {
-                    node->preserveNode();
-                    node->setSelected(false);
-                }
-
-                return;
+                node->preserveNode();
+                node->setSelected(false);
             }
-            QGraphicsScene::mouseDoubleClickEvent(event);
+
             return;
         }
+        QGraphicsScene::mouseDoubleClickEvent(event);
+        return;
     }
 
     // And the same for edges
-    for(edgeIter iter = _edges.begin(); iter != _edges.end(); ++iter)
+    EdgeItem *edge = _hitIndex.edgeAt(event->scenePos());
+    if(edge != 0)
     {
-        EdgeItem *edge = *iter;
-        if(edge->edgePolygon().containsPoint(event->scenePos(), Qt::OddEvenFill))
+        if(_linkedGraph != 0)
         {
-            if(_linkedGraph != 0)
+            if(edge->itemState() == GraphItem::GraphItem_Deleted)
             {
-                if(edge->itemState() == GraphItem::GraphItem_Deleted)
-                {
-                    edge->preserveEdge();
-                    edge->setSelected(false);
-                }
-
-                return;
+                edge->preserveEdge();
+                edge->setSelected(false);
             }
-            QGraphicsScene::mouseDoubleClickEvent(event);
+
             return;
         }
+        QGraphicsScene::mouseDoubleClickEvent(event);
+        return;
     }
 
     event->accept();
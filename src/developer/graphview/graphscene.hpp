@@ -21,24 +21,87 @@
 #ifndef GRAPHSCENE_HPP
 #define GRAPHSCENE_HPP
 
+#include <QFutureWatcher>
 #include <QGraphicsScene>
-
-#include <ogdf/basic/Graph.h>
-#include <ogdf/basic/GraphAttributes.h>
+#include <QSet>
 
 // Implicitly brings in nodeitem.hpp
 #include "graphview/edgeitem.hpp"
+#include "graphview/densityraster.hpp"
+#include "graphview/edgebundler.hpp"
+#include "graphview/hitindex.hpp"
+#include "graphview/layoutanimator.hpp"
+#include "graphview/layoutjob.hpp"
+#include "graphview/layoutmirror.hpp"
+#include "graphview/spatialgrid.hpp"
 #include "graph.hpp"
 #include "global.hpp"
 
+class QTimer;
+
 namespace Developer {
 
+/*!
+ * \brief The GraphScene class holds the NodeItem and EdgeItem objects which
+ *  represent a Graph
+ *
+ * By default every node and edge has an item. A virtualised scene instead
+ * keeps a spatial index over node positions and only has items for the area
+ * set with setVisibleRect() plus a margin, reusing the items as that area
+ * changes. This keeps memory in proportion to the visible area for graphs too
+ * large to materialise in full. Virtualised scenes are read-only and ignore
+ * any linked graph. Rather than follow each change to their graph, they drop
+ * all of their items as soon as it changes and are rebuilt once it settles.
+ *
+ * The nodes at the far end of edges leaving the area are given items too, as
+ * long as no more than VIRTUAL_MAX_NODE_ITEMS nodes and VIRTUAL_MAX_EDGE_ITEMS
+ * edges have items. Edges beyond that, such as most of those of a busy hub,
+ * are drawn as plain lines out to the edge of the view.
+ *
+ * With more than VIRTUAL_MAX_NODE_ITEMS nodes in view a virtualised scene has
+ * no items at all and draws a heatmap of the density of its nodes and edges
+ * instead (see DensityRaster). Dragging out an area of the heatmap, or
+ * clicking on it, emits overviewRegionChosen() so that the view can zoom into
+ * that region, and materialiseRect() tells the view how far in it must go for
+ * the region to be given items.
+ *
+ * A scene which is not virtualised follows changes to its graph: nodes and
+ * edges added to or removed from the Graph gain or lose their items, and each
+ * item follows edits to its own Node or Edge. Only the affected items are
+ * updated, so editing the graph directly (from a layout, an import or a
+ * rewrite step) never requires a call to setGraph().
+ *
+ * Layouts run on a worker thread over a snapshot of the scene (see LayoutJob)
+ * and the new positions are applied in one pass once the algorithm returns.
+ * The layout*() methods only start the layout; layoutProgress(), layoutFailed()
+ * and layoutEnded() report on it, and cancelLayout() abandons it. A layout
+ * which runs for longer than LAYOUT_TIMEOUT is abandoned too.
+ *
+ * The built in force-directed layout (see ForceLayout) can also refine the
+ * current layout, moving only the nodes added or moved since the last layout
+ * was applied, and is shown as it runs unless setAnimateLayouts(false) has
+ * been called. Unless that has been called, nodes also glide to the positions
+ * of any finished layout, all of them moved from one timer per frame (see
+ * LayoutAnimator).
+ *
+ * The scene runs without a QGraphicsScene index, so hover, clicks, edge
+ * drawing and rubber-band selection find their items through a HitIndex
+ * instead of testing every item.
+ *
+ * With setEdgeBundling() the edges of a scene which is not virtualised are
+ * bundled on a worker thread (see EdgeBundler) once the graph has been still
+ * for EDGE_BUNDLING_DELAY, and drawn as a few shared paths beneath the nodes in
+ * place of their items. Bundled edges are hidden, so they cannot be clicked and
+ * show no labels or arrows. Moving a node or changing an edge shows the
+ * straight edges again until the graph has settled.
+ */
 class GraphScene : public QGraphicsScene
 {
     Q_OBJECT
 
 public:
     explicit GraphScene(QObject *parent = 0);
+    ~GraphScene();
 
     Graph *graph() const;
     void setGraph(Graph *newGraph);
@@ -46,6 +109,8 @@ public:
     void setLinkedGraph(Graph *linkGraph);
     bool readOnly() const;
     void setReadOnly(bool readOnlyFlag);
+    bool virtualized() const;
+    void setVirtualized(bool virtualizedFlag);
 
     NodeItem *node(const QString &id) const;
     EdgeItem *edge(const QString &id) const;
@@ -53,6 +118,14 @@ public:
     void addNodeItem(NodeItem *nodeItem, const QPointF &position);
     void addEdgeItem(EdgeItem *edgeItem);
 
+    void layout(LayoutAlgorithms algorithm,
+                LayoutDirections direction = DEFAULT_LAYOUT_DIRECTION);
+    bool layoutRunning() const;
+    void refineLayout();
+    bool animateLayouts() const;
+    void setAnimateLayouts(bool animate);
+    bool edgeBundling() const;
+    void setEdgeBundling(bool bundle);
     void layoutTree(LayoutDirections direction = DEFAULT_LAYOUT_DIRECTION);
     void layoutSugiyama();
     void layoutRadialTree();
@@ -66,8 +139,10 @@ public:
     void layoutDavidsonHarel();
     void layoutFMMM();
     void layoutGEM();
+    void layoutBarnesHut();
 
     void resizeToContents();
+    QRectF materialiseRect(const QRectF &rect) const;
 
 public slots:
     void addNode(const QPointF &position, bool automatic = false);
@@ -77,19 +152,65 @@ public slots:
     void removeNode(NodeItem *node);
 
     void nodeIdChanged(QString oldId, QString newId);
+    void edgeIdChanged(QString oldId, QString newId);
+
+    void setVisibleRect(const QRectF &rect);
+
+    void cancelLayout();
 
 signals:
     void nodeAdded(NodeItem *nodeItem);
     void edgeAdded(EdgeItem *edgeItem);
 
+    void layoutProgress(int percent);
+    void layoutFailed(QString message);
+    void layoutEnded();
+
+    void overviewRegionChosen(QRectF region);
+
 protected slots:
     void linkedGraphAddedNode(Node *nodeItem);
     void linkedGraphAddedEdge(Edge *edgeItem);
+    void graphNodeAdded(Node *node);
+    void graphEdgeAdded(Edge *edge);
+    void graphNodeRemoved(QString id);
+    void graphEdgeRemoved(QString id);
+    void graphAboutToClear();
+    void edgeEndsChanged();
+    void styleChanged();
+    void nodeShapeChanged();
+    void nodeItemMoved();
+    void layoutFinished();
+    void layoutTimedOut();
+    void pollLayoutProgress();
+    void layoutAnimationFinished();
+    void startBundling();
+    void bundlingFinished();
+    void virtualGraphChanged();
+    void rebuildVirtualGraph();
 
 protected:
-    void layoutInit();
-    void layoutApply();
+    void startLayout(LayoutJob job);
+    void prepareLayout(LayoutJob *job);
+    void selectArea(const QRectF &rect);
+
+    void moveNodes(const LayoutJob &job, const QVector<QPointF> &positions,
+                   int duration = 0);
+    void applyLayout(const LayoutJob &job);
 
+    void scheduleBundling();
+    void clearBundles();
+
+    void clearItems();
+    void setVirtualGraph();
+    void setDensityGraph();
+    void materialise(const QRectF &rect);
+    NodeItem *acquireNodeItem(Node *node);
+    void releaseNodeItem(NodeItem *nodeItem);
+    EdgeItem *acquireEdgeItem(Edge *edge, NodeItem *from, NodeItem *to);
+    void releaseEdgeItem(EdgeItem *edgeItem);
+
+    void drawBackground(QPainter *painter, const QRectF &rect);
     void drawForeground(QPainter *painter, const QRectF &rect);
 
     void keyPressEvent(QKeyEvent *event);
@@ -113,9 +234,56 @@ protected:
     QMap<QString, EdgeItem*> _edges;
     QMap<QString, NodeItem*> _nodes;
 
-    ogdf::Graph _g;
-    ogdf::GraphAttributes _ga;
-    QMap<QString, ogdf::node> _nodeMap;
+    bool _virtualized;
+    bool _overview;
+    //! Set between a change to the graph of a virtualised scene and the
+    //! rebuild which follows it
+    bool _virtualStale;
+    QRectF _visibleRect;
+    SpatialGrid<Node *> _nodeGrid;
+    QHash<Node *, QVector<Edge *> > _incidentEdges;
+    //! Edges in view which did not fit within the item budgets, drawn as
+    //! plain lines instead
+    QSet<Edge *> _clippedEdges;
+    //! Where each materialised node was indexed, to correct the index if the
+    //! node has been moved by the time its item is released
+    QHash<NodeItem *, QPointF> _indexedPositions;
+    QList<NodeItem *> _spareNodeItems;
+    QList<EdgeItem *> _spareEdgeItems;
+    DensityRaster _density;
+    //! The last heatmap drawn, which is drawn again while the view stays
+    //! within it at the same scale
+    QImage _densityImage;
+    QRectF _densityRect;
+    qreal _densityCellSize;
+
+    //! Finds the items under the mouse, see HitIndex
+    HitIndex _hitIndex;
+
+    LayoutMirror _layoutMirror;
+    QFutureWatcher<LayoutJob> *_layoutWatcher;
+    QSharedPointer<QAtomicInt> _latestLayout;
+    QSharedPointer<QAtomicInt> _layoutProgress;
+    int _layoutRevision;
+    bool _layoutRunning;
+    bool _animateLayouts;
+    //! The job which is running, shared with the worker
+    LayoutJob _layoutJob;
+    QTimer *_layoutTimer;
+    QTimer *_layoutPollTimer;
+    LayoutAnimator *_layoutAnimator;
+    //! Set while the nodes move to a finished layout, which is settled once
+    //! they arrive
+    bool _settleLayout;
+
+    bool _edgeBundling;
+    QFutureWatcher<BundleJob> *_bundleWatcher;
+    QSharedPointer<QAtomicInt> _latestBundle;
+    int _bundleRevision;
+    QTimer *_bundleTimer;
+    //! The bundles being drawn, holding no paths while the edges are drawn
+    //! by their items
+    BundleJob _bundles;
 
     typedef QMap<QString, EdgeItem*>::iterator edgeIter;
     typedef QMap<QString, NodeItem*>::iterator nodeIter;
@@ -0,0 +1,334 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "graphviewstyle.hpp"
+#include "graphitem.hpp"
+
+#include <QApplication>
+#include <QSettings>
+
+namespace Developer {
+
+GraphViewStyle *GraphViewStyle::_instance = 0;
+
+namespace {
+
+QColor colourSetting(const QSettings &settings, const QString &key,
+                     const QColor &defaultColour)
+{
+    return settings.value(key, defaultColour).value<QColor>();
+}
+
+}
+
+GraphViewStyle::GraphViewStyle(QObject *parent)
+    : QObject(parent)
+    , _nodeMetrics(QFont())
+    , _edgeMetrics(QFont())
+{
+    load();
+}
+
+GraphViewStyle *GraphViewStyle::instance()
+{
+    if(_instance == 0)
+        _instance = new GraphViewStyle(qApp);
+    return _instance;
+}
+
+const QFont &GraphViewStyle::nodeFont() const
+{
+    return _nodeFont;
+}
+
+const QFontMetrics &GraphViewStyle::nodeMetrics() const
+{
+    return _nodeMetrics;
+}
+
+qreal GraphViewStyle::nodeTopPadding() const
+{
+    return _nodeTopPadding;
+}
+
+qreal GraphViewStyle::nodeRightPadding() const
+{
+    return _nodeRightPadding;
+}
+
+qreal GraphViewStyle::nodeBottomPadding() const
+{
+    return _nodeBottomPadding;
+}
+
+qreal GraphViewStyle::nodeLeftPadding() const
+{
+    return _nodeLeftPadding;
+}
+
+qreal GraphViewStyle::nodeBorderWidth(bool root) const
+{
+    return root ? _nodeBorderWidth * 1.5 : _nodeBorderWidth;
+}
+
+qreal GraphViewStyle::nodeCornerRadius() const
+{
+    return _nodeCornerRadius;
+}
+
+const QColor &GraphViewStyle::nodeTextColour() const
+{
+    return _nodeTextColour;
+}
+
+const QColor &GraphViewStyle::nodeIdColour() const
+{
+    return _nodeIdColour;
+}
+
+const QColor &GraphViewStyle::nodeBackground(int state, bool selected) const
+{
+    if(selected)
+        return _nodeSelectedBackground;
+    return _nodeBackgrounds[qBound(0, state, StateCount-1)];
+}
+
+const QColor &GraphViewStyle::nodeBorderColour(int state, bool selected,
+                                               bool hover) const
+{
+    return _nodeBorderColours[stateIndex(state, selected, hover)];
+}
+
+const QPen &GraphViewStyle::nodeBorderPen(int state, bool selected, bool hover,
+                                          bool root) const
+{
+    int index = stateIndex(state, selected, hover);
+    return root ? _rootBorderPens[index] : _nodeBorderPens[index];
+}
+
+const QFont &GraphViewStyle::edgeFont() const
+{
+    return _edgeFont;
+}
+
+const QFontMetrics &GraphViewStyle::edgeMetrics() const
+{
+    return _edgeMetrics;
+}
+
+qreal GraphViewStyle::edgeLineWidth() const
+{
+    return _edgeLineWidth;
+}
+
+qreal GraphViewStyle::edgeArrowSize() const
+{
+    return _edgeArrowSize;
+}
+
+const QColor &GraphViewStyle::edgeTextColour() const
+{
+    return _edgeTextColour;
+}
+
+const QColor &GraphViewStyle::edgeIdColour() const
+{
+    return _edgeIdColour;
+}
+
+const QColor &GraphViewStyle::edgeColour(int state, bool selected,
+                                         bool hover) const
+{
+    return _edgeColours[stateIndex(state, selected, hover)];
+}
+
+const QPen &GraphViewStyle::edgePen(int state, bool selected, bool hover) const
+{
+    return _edgePens[stateIndex(state, selected, hover)];
+}
+
+const QBrush &GraphViewStyle::edgeBrush(int state, bool selected,
+                                        bool hover) const
+{
+    return _edgeBrushes[stateIndex(state, selected, hover)];
+}
+
+const QPen &GraphViewStyle::draggedEdgePen() const
+{
+    return _draggedEdgePen;
+}
+
+const QBrush &GraphViewStyle::draggedEdgeBrush() const
+{
+    return _draggedEdgeBrush;
+}
+
+void GraphViewStyle::reload()
+{
+    load();
+    emit styleChanged();
+}
+
+void GraphViewStyle::load()
+{
+    QSettings settings;
+
+    // Nodes
+    _nodeFont = settings.value("GraphView/Nodes/Font", qApp->font()
+                               ).value<QFont>();
+    _nodeMetrics = QFontMetrics(_nodeFont);
+    _nodeTopPadding    = settings.value("GraphView/Nodes/Padding/Top", 6
+                                        ).toDouble();
+    _nodeRightPadding  = settings.value("GraphView/Nodes/Padding/Right", 8
+                                        ).toDouble();
+    _nodeBottomPadding = settings.value("GraphView/Nodes/Padding/Bottom", 6
+                                        ).toDouble();
+    _nodeLeftPadding   = settings.value("GraphView/Nodes/Padding/Left", 8
+                                        ).toDouble();
+    _nodeBorderWidth = settings.value("GraphView/Nodes/Borders/Width", 2
+                                      ).toDouble();
+    _nodeCornerRadius = settings.value("GraphView/Nodes/CornerRadius", 6
+                                       ).toDouble();
+    _nodeTextColour = colourSetting(settings, "GraphView/Nodes/TextColour",
+                                    QColor(0x33,0x33,0x33));
+    _nodeIdColour = _nodeTextColour;
+    _nodeIdColour.setAlpha(80);
+
+    _nodeSelectedBackground = colourSetting(
+                settings, "GraphView/Nodes/SelectedBackground",
+                QColor(0xff,0xff,0xcc)); // light yellow
+    _nodeBackgrounds[GraphItem::GraphItem_Normal] = colourSetting(
+                settings, "GraphView/Nodes/Background",
+                QColor(0xcc,0xcc,0xff)); // light blue
+    _nodeBackgrounds[GraphItem::GraphItem_New] = colourSetting(
+                settings, "GraphView/Nodes/Borders/ColourNew",
+                QColor(0xcd,0xff,0xc6,0xaa)); // green
+    _nodeBackgrounds[GraphItem::GraphItem_Deleted] = colourSetting(
+                settings, "GraphView/Nodes/Borders/ColourDeleted",
+                QColor(0xff,0xaa,0xaa,0x55)); // light red
+    _nodeBackgrounds[GraphItem::GraphItem_Invalid] =
+            _nodeBackgrounds[GraphItem::GraphItem_Deleted];
+
+    _nodeBorderColours[stateIndex(0, true, false)] = colourSetting(
+                settings, "GraphView/Nodes/Borders/SelectedColour",
+                QColor(0xff,0xff,0x66)); // yellow
+    _nodeBorderColours[stateIndex(GraphItem::GraphItem_Normal, false, true)] =
+            colourSetting(settings, "GraphView/Nodes/Borders/HoverColour",
+                          QColor(0xcc,0xcc,0xff)); // blue
+    _nodeBorderColours[stateIndex(GraphItem::GraphItem_New, false, true)] =
+            colourSetting(settings, "GraphView/Nodes/Borders/HoverColourNew",
+                          QColor(0xcc,0xff,0xcc)); // light green
+    _nodeBorderColours[stateIndex(GraphItem::GraphItem_Deleted, false, true)] =
+            colourSetting(settings,
+                          "GraphView/Nodes/Borders/HoverColourDeleted",
+                          QColor(0xff,0xaa,0xaa,0x55)); // light red
+    _nodeBorderColours[stateIndex(GraphItem::GraphItem_Normal, false, false)] =
+            colourSetting(settings, "GraphView/Nodes/Borders/Colour",
+                          QColor(0xaa,0xaa,0xff)); // blue
+    _nodeBorderColours[stateIndex(GraphItem::GraphItem_New, false, false)] =
+            colourSetting(settings, "GraphView/Nodes/Borders/HoverColourNew",
+                          QColor(0xaa,0xff,0xaa)); // green
+    _nodeBorderColours[stateIndex(GraphItem::GraphItem_Deleted, false, false)] =
+            colourSetting(settings,
+                          "GraphView/Nodes/Borders/HoverColourDeleted",
+                          QColor(0xff,0x8f,0x8f,0x55)); // red
+    _nodeBorderColours[stateIndex(GraphItem::GraphItem_Invalid, false, true)] =
+            _nodeBorderColours[stateIndex(GraphItem::GraphItem_Deleted, false,
+                                          true)];
+    _nodeBorderColours[stateIndex(GraphItem::GraphItem_Invalid, false, false)] =
+            _nodeBorderColours[stateIndex(GraphItem::GraphItem_Deleted, false,
+                                          false)];
+
+    for(int i = 0; i < StyleCount; ++i)
+    {
+        QPen pen(_nodeBorderColours[i]);
+        pen.setWidth(nodeBorderWidth(false));
+        _nodeBorderPens[i] = pen;
+        pen.setWidth(nodeBorderWidth(true));
+        _rootBorderPens[i] = pen;
+    }
+
+    // Edges
+    _edgeFont = settings.value("GraphView/Edges/Font", qApp->font()
+                               ).value<QFont>();
+    _edgeMetrics = QFontMetrics(_edgeFont);
+    _edgeLineWidth = settings.value("GraphView/Edges/LineWidth", 1.5
+                                    ).toDouble();
+    _edgeArrowSize = settings.value("GraphView/Edges/ArrowSize", 9).toDouble();
+    _edgeTextColour = colourSetting(settings, "GraphView/Edges/TextColour",
+                                    QColor(0x33,0x33,0x33));
+    _edgeIdColour = _edgeTextColour;
+    _edgeIdColour.setAlpha(80);
+
+    _edgeColours[stateIndex(0, true, false)] = colourSetting(
+                settings, "GraphView/Edges/SelectedColour",
+                QColor(0xcc,0xcc,0x33));
+    _edgeColours[stateIndex(GraphItem::GraphItem_Normal, false, true)] =
+            colourSetting(settings, "GraphView/Edges/HoverColour",
+                          QColor(0x33,0x33,0xdd));
+    _edgeColours[stateIndex(GraphItem::GraphItem_New, false, true)] =
+            colourSetting(settings, "GraphView/Edges/HoverColourNew",
+                          QColor(0x33,0xff,0x33));
+    _edgeColours[stateIndex(GraphItem::GraphItem_Deleted, false, true)] =
+            colourSetting(settings, "GraphView/Edges/HoverColourDeleted",
+                          QColor(0xff,0x33,0x33, 0x55));
+    _edgeColours[stateIndex(GraphItem::GraphItem_Normal, false, false)] =
+            colourSetting(settings, "GraphView/Edges/Colour",
+                          QColor(0x33,0x33,0x33));
+    _edgeColours[stateIndex(GraphItem::GraphItem_New, false, false)] =
+            colourSetting(settings, "GraphView/Edges/ColourNew",
+                          QColor(0x33,0xdd,0x33));
+    _edgeColours[stateIndex(GraphItem::GraphItem_Deleted, false, false)] =
+            colourSetting(settings, "GraphView/Edges/ColourDeleted",
+                          QColor(0xdd,0x33,0x33, 0x55));
+    _edgeColours[stateIndex(GraphItem::GraphItem_Invalid, false, true)] =
+            _edgeColours[stateIndex(GraphItem::GraphItem_Deleted, false, true)];
+    _edgeColours[stateIndex(GraphItem::GraphItem_Invalid, false, false)] =
+            _edgeColours[stateIndex(GraphItem::GraphItem_Deleted, false,
+                                    false)];
+
+    for(int i = 0; i < StyleCount; ++i)
+    {
+        QPen pen(_edgeColours[i]);
+        pen.setWidth(_edgeLineWidth);
+        _edgePens[i] = pen;
+        _edgeBrushes[i] = QBrush(_edgeColours[i]);
+    }
+
+    QColor draggedColour = colourSetting(settings, "GraphView/Edges/LineColour",
+                                         QColor(0x33,0x33,0x33));
+    draggedColour.setAlpha(100);
+    _draggedEdgePen = QPen(draggedColour);
+    _draggedEdgePen.setWidth(_edgeLineWidth);
+    _draggedEdgeBrush = QBrush(draggedColour);
+}
+
+int GraphViewStyle::stateIndex(int state, bool selected, bool hover)
+{
+    if(selected)
+        return 0;
+
+    int index = 1 + qBound(0, state, StateCount-1);
+    if(hover)
+        index += StateCount;
+    return index;
+}
+
+}
@@ -0,0 +1,151 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GRAPHVIEWSTYLE_HPP
+#define GRAPHVIEWSTYLE_HPP
+
+#include <QObject>
+#include <QBrush>
+#include <QColor>
+#include <QFont>
+#include <QFontMetrics>
+#include <QPen>
+
+namespace Developer {
+
+/*!
+ * \brief The GraphViewStyle class holds the appearance settings used to draw
+ *  graphs
+ *
+ * The settings are read once into a single shared instance along with the
+ * font metrics, pens and brushes derived from them, so that painting and
+ * geometry calculations in NodeItem, EdgeItem and GraphScene never go to
+ * QSettings.
+ *
+ * Call reload() after the appearance settings change, the styleChanged()
+ * signal then tells the graph scenes to recompute their items.
+ *
+ * Colours which depend on an item's state take the state as a value from the
+ * GraphItem::ItemState enum.
+ */
+class GraphViewStyle : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+     * \brief Get the shared style, loading it on first use
+     */
+    static GraphViewStyle *instance();
+
+    const QFont &nodeFont() const;
+    const QFontMetrics &nodeMetrics() const;
+    qreal nodeTopPadding() const;
+    qreal nodeRightPadding() const;
+    qreal nodeBottomPadding() const;
+    qreal nodeLeftPadding() const;
+    /*!
+     * \brief Get the width of node borders
+     * \param root  Whether the node is a root node, which has a thicker border
+     */
+    qreal nodeBorderWidth(bool root = false) const;
+    qreal nodeCornerRadius() const;
+    const QColor &nodeTextColour() const;
+    //! The colour of the ID shown beneath each node, a faded text colour
+    const QColor &nodeIdColour() const;
+    /*!
+     * \brief Get the background of a node before hovering and marking are
+     *  taken into account
+     */
+    const QColor &nodeBackground(int state, bool selected) const;
+    const QColor &nodeBorderColour(int state, bool selected, bool hover) const;
+    const QPen &nodeBorderPen(int state, bool selected, bool hover,
+                              bool root) const;
+
+    const QFont &edgeFont() const;
+    const QFontMetrics &edgeMetrics() const;
+    qreal edgeLineWidth() const;
+    qreal edgeArrowSize() const;
+    const QColor &edgeTextColour() const;
+    //! The colour of the ID shown beneath each edge label
+    const QColor &edgeIdColour() const;
+    const QColor &edgeColour(int state, bool selected, bool hover) const;
+    const QPen &edgePen(int state, bool selected, bool hover) const;
+    //! The brush used to fill arrow heads
+    const QBrush &edgeBrush(int state, bool selected, bool hover) const;
+
+    //! The pen used for the edge being drawn while the user drags between
+    //! nodes
+    const QPen &draggedEdgePen() const;
+    const QBrush &draggedEdgeBrush() const;
+
+public slots:
+    /*!
+     * \brief Read the settings again and notify anything drawing graphs
+     */
+    void reload();
+
+signals:
+    void styleChanged();
+
+private:
+    explicit GraphViewStyle(QObject *parent = 0);
+
+    void load();
+    static int stateIndex(int state, bool selected, bool hover);
+
+    //! Selected, then each state not hovered, then each state hovered
+    enum { StateCount = 4, StyleCount = 1 + 2 * StateCount };
+
+    QFont _nodeFont;
+    QFontMetrics _nodeMetrics;
+    qreal _nodeTopPadding;
+    qreal _nodeRightPadding;
+    qreal _nodeBottomPadding;
+    qreal _nodeLeftPadding;
+    qreal _nodeBorderWidth;
+    qreal _nodeCornerRadius;
+    QColor _nodeTextColour;
+    QColor _nodeIdColour;
+    QColor _nodeSelectedBackground;
+    QColor _nodeBackgrounds[StateCount];
+    QColor _nodeBorderColours[StyleCount];
+    QPen _nodeBorderPens[StyleCount];
+    QPen _rootBorderPens[StyleCount];
+
+    QFont _edgeFont;
+    QFontMetrics _edgeMetrics;
+    qreal _edgeLineWidth;
+    qreal _edgeArrowSize;
+    QColor _edgeTextColour;
+    QColor _edgeIdColour;
+    QColor _edgeColours[StyleCount];
+    QPen _edgePens[StyleCount];
+    QBrush _edgeBrushes[StyleCount];
+
+    QPen _draggedEdgePen;
+    QBrush _draggedEdgeBrush;
+
+    static GraphViewStyle *_instance;
+};
+
+}
+
+#endif // GRAPHVIEWSTYLE_HPP
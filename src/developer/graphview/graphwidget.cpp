@@ -26,12 +26,16 @@
 #include <QKeyEvent>
 #include <QWheelEvent>
 #include <QFocusEvent>
+#include <QResizeEvent>
+#include <QPaintEvent>
+#include <QPainter>
 #include <cmath>
 
 namespace Developer {
 
 GraphWidget::GraphWidget(QWidget *parent)
     : QGraphicsView(parent)
+    , _tiledRendering(false)
 {
     _scene = new GraphScene(this);
 
@@ -41,6 +45,9 @@ GraphWidget::GraphWidget(QWidget *parent)
     sceneRect.setHeight(sceneRect.height()-8);
     _scene->setSceneRect(sceneRect);
 
+    connect(_scene, SIGNAL(overviewRegionChosen(QRectF)),
+            this, SLOT(zoomToRegion(QRectF)));
+
     setScene(_scene);
     setRenderHint(QPainter::Antialiasing, true);
     setViewportUpdateMode(BoundingRectViewportUpdate);
@@ -59,7 +66,11 @@ GraphScene *GraphWidget::graphScene() const
 
 void GraphWidget::setGraph(Graph *newGraph)
 {
+    _tiles.clear();
+    size_t elements = newGraph->nodes().size() + newGraph->edges().size();
+    _scene->setVirtualized(elements > VIRTUAL_GRAPH_THRESHOLD);
     _scene->setGraph(newGraph);
+    updateVisibleRect();
 }
 
 void GraphWidget::setLinkedGraph(Graph *linkGraph)
@@ -67,6 +78,35 @@ void GraphWidget::setLinkedGraph(Graph *linkGraph)
     _scene->setLinkedGraph(linkGraph);
 }
 
+void GraphWidget::setVirtualized(bool virtualizedFlag)
+{
+    _scene->setVirtualized(virtualizedFlag);
+    updateVisibleRect();
+}
+
+bool GraphWidget::tiledRendering() const
+{
+    return _tiledRendering;
+}
+
+void GraphWidget::setTiledRendering(bool tiled)
+{
+    if(tiled == _tiledRendering)
+        return;
+
+    // The scene only reports the areas it changes to views which ask, and
+    // reporting them costs an untiled view its partial updates
+    _tiledRendering = tiled;
+    _tiles.clear();
+    if(tiled)
+        connect(_scene, SIGNAL(changed(QList<QRectF>)),
+                this, SLOT(sceneChanged(QList<QRectF>)));
+    else
+        disconnect(_scene, SIGNAL(changed(QList<QRectF>)),
+                   this, SLOT(sceneChanged(QList<QRectF>)));
+    viewport()->update();
+}
+
 void GraphWidget::layoutTree(LayoutDirections direction)
 {
     _scene->layoutTree(direction);
@@ -132,6 +172,16 @@ void GraphWidget::layoutGEM()
     _scene->layoutGEM();
 }
 
+void GraphWidget::layoutBarnesHut()
+{
+    _scene->layoutBarnesHut();
+}
+
+void GraphWidget::refineLayout()
+{
+    _scene->refineLayout();
+}
+
 void GraphWidget::mouseMoveEvent(QMouseEvent *event)
 {
     if(event->modifiers() & Qt::SHIFT)
@@ -167,6 +217,8 @@ void GraphWidget::keyPressEvent(QKeyEvent *event)
         QGraphicsView::keyPressEvent(event);
         break;
     }
+
+    updateVisibleRect();
 }
 
 void GraphWidget::keyReleaseEvent(QKeyEvent *event)
@@ -192,6 +244,105 @@ void GraphWidget::scaleView(qreal scaleFactor)
 
     scale(scaleFactor, scaleFactor);
     _scene->resizeToContents();
+    updateVisibleRect();
+}
+
+void GraphWidget::resizeEvent(QResizeEvent *event)
+{
+    QGraphicsView::resizeEvent(event);
+    updateVisibleRect();
+}
+
+void GraphWidget::scrollContentsBy(int dx, int dy)
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+    updateVisibleRect();
+}
+
+void GraphWidget::paintEvent(QPaintEvent *event)
+{
+    QTransform matrix = viewportTransform();
+    if(!_tiledRendering || matrix.type() > QTransform::TxScale
+            || matrix.m11() != matrix.m22())
+    {
+        QGraphicsView::paintEvent(event);
+        return;
+    }
+
+    // Tiles are cut from the scene origin, so scrolling only moves them
+    int zoom = TileCache::zoomLevel(matrix.m11());
+    int size = _tiles.tileSize();
+    QPoint offset(qRound(matrix.dx()), qRound(matrix.dy()));
+    QRect exposed = event->rect().translated(-offset);
+    int left = static_cast<int>(std::floor(qreal(exposed.left()) / size));
+    int top = static_cast<int>(std::floor(qreal(exposed.top()) / size));
+    int right = static_cast<int>(std::floor(qreal(exposed.right()) / size));
+    int bottom = static_cast<int>(std::floor(qreal(exposed.bottom()) / size));
+
+    QPainter painter(viewport());
+    painter.setClipRect(event->rect());
+    for(int y = top; y <= bottom; ++y)
+    {
+        for(int x = left; x <= right; ++x)
+        {
+            TileKey key(zoom, x, y);
+            QPixmap *cached = _tiles.tile(key);
+            QPixmap tile = (cached != 0) ? *cached : renderTile(key);
+            painter.drawPixmap(offset + QPoint(x * size, y * size), tile);
+        }
+    }
+}
+
+void GraphWidget::sceneChanged(const QList<QRectF> &region)
+{
+    for(int i = 0; i < region.size(); ++i)
+        _tiles.invalidate(region.at(i));
+}
+
+QPixmap GraphWidget::renderTile(const TileKey &key)
+{
+    int size = _tiles.tileSize();
+    QPixmap tile(size, size);
+    tile.fill(viewport()->palette().color(viewport()->backgroundRole()));
+
+    QPainter painter(&tile);
+    painter.setRenderHints(renderHints());
+    _scene->render(&painter, QRectF(0, 0, size, size), _tiles.sceneRect(key),
+                   Qt::IgnoreAspectRatio);
+    painter.end();
+
+    _tiles.insert(key, tile);
+    return tile;
+}
+
+void GraphWidget::zoomToRegion(QRectF region)
+{
+    QRectF view = mapToScene(viewport()->rect()).boundingRect();
+    QSizeF onScreen = transform().mapRect(region).size();
+    if(onScreen.width() < DENSITY_DRAG_DISTANCE
+            && onScreen.height() < DENSITY_DRAG_DISTANCE)
+    {
+        // A click rather than a drag, zoom in on that point
+        QPointF centre = region.center();
+        region.setSize(view.size() / 4);
+        region.moveCenter(centre);
+    }
+    else if(!view.isEmpty())
+    {
+        // Widen the region to the shape of the view, so that all of it is
+        // given items once the view fits it
+        QPointF centre = region.center();
+        qreal aspect = view.width() / view.height();
+        if(region.width() < region.height() * aspect)
+            region.setWidth(region.height() * aspect);
+        else
+            region.setHeight(region.width() / aspect);
+        region.moveCenter(centre);
+    }
+
+    fitInView(_scene->materialiseRect(region), Qt::KeepAspectRatio);
+    _scene->resizeToContents();
+    updateVisibleRect();
 }
 
 void GraphWidget::focusInEvent(QFocusEvent *event)
@@ -208,4 +359,10 @@ void GraphWidget::focusOutEvent(QFocusEvent *event)
     emit graphLostFocus(this);
 }
 
+void GraphWidget::updateVisibleRect()
+{
+    if(_scene->virtualized())
+        _scene->setVisibleRect(mapToScene(viewport()->rect()).boundingRect());
+}
+
 }
@@ -23,6 +23,7 @@
 
 #include <QGraphicsView>
 
+#include "graphview/tilecache.hpp"
 #include "global.hpp"
 
 namespace Developer {
@@ -36,6 +37,18 @@ class GraphScene;
  * This widget provides a wrapper around the graph visualisation code in GP
  * Developer. It contains a graphics view with NodeItem and EdgeItem objects
  * tied to the Graph passed to the widget.
+ *
+ * Graphs with more than VIRTUAL_GRAPH_THRESHOLD nodes and edges are shown in a
+ * virtualised scene, which the widget keeps informed of the visible area.
+ * When too much of such a graph is in view the scene draws a density overview,
+ * and a region dragged out on it, or a point clicked, is zoomed into until
+ * the scene can give the nodes there items.
+ *
+ * Views which are rarely edited can set tiled rendering, which paints the
+ * scene from a TileCache rather than item by item. Tiles are rendered as they
+ * first come into view and are only rendered again when an item within them
+ * changes, so panning a tiled view only copies pixmaps. Views with a rotated
+ * or sheared transform are always painted item by item.
  */
 class GraphWidget : public QGraphicsView
 {
@@ -47,6 +60,9 @@ public:
     GraphScene *graphScene() const;
     void setGraph(Graph *newGraph);
     void setLinkedGraph(Graph *linkGraph);
+    void setVirtualized(bool virtualizedFlag);
+    bool tiledRendering() const;
+    void setTiledRendering(bool tiled);
 
     void layoutTree(LayoutDirections direction = DEFAULT_LAYOUT_DIRECTION);
     void layoutSugiyama();
@@ -61,6 +77,8 @@ public:
     void layoutDavidsonHarel();
     void layoutFMMM();
     void layoutGEM();
+    void layoutBarnesHut();
+    void refineLayout();
 
 protected:
     void mouseMoveEvent(QMouseEvent *event);
@@ -68,16 +86,28 @@ protected:
     void keyReleaseEvent(QKeyEvent *event);
     void wheelEvent(QWheelEvent *event);
     void scaleView(qreal scaleFactor);
+    void resizeEvent(QResizeEvent *event);
+    void scrollContentsBy(int dx, int dy);
+    void paintEvent(QPaintEvent *event);
 
     void focusInEvent(QFocusEvent *event);
     void focusOutEvent(QFocusEvent *event);
 
+protected slots:
+    void sceneChanged(const QList<QRectF> &region);
+    void zoomToRegion(QRectF region);
+
 signals:
     void graphHasFocus(GraphWidget *graphWidget);
     void graphLostFocus(GraphWidget *graphWidget);
 
 private:
+    void updateVisibleRect();
+    QPixmap renderTile(const TileKey &key);
+
     GraphScene *_scene;
+    bool _tiledRendering;
+    TileCache _tiles;
 };
 
 }
@@ -0,0 +1,274 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "hitindex.hpp"
+#include "edgeitem.hpp"
+
+#include <QPainterPath>
+
+namespace Developer {
+
+namespace {
+
+/*!
+ * \brief Filter candidates from the index down to the visible items whose
+ *  shape contains the provided scene position
+ */
+template <class T>
+QList<QGraphicsItem *> itemsContaining(const QList<T *> &candidates,
+                                       const QPointF &pos)
+{
+    QList<QGraphicsItem *> result;
+    for(int i = 0; i < candidates.size(); ++i)
+    {
+        T *item = candidates.at(i);
+        if(item->isVisible() && item->contains(item->mapFromScene(pos)))
+            result.append(item);
+    }
+    return result;
+}
+
+/*!
+ * \brief Filter candidates from the index down to the visible items whose
+ *  shape intersects the provided scene path
+ */
+template <class T>
+QList<QGraphicsItem *> itemsColliding(const QList<T *> &candidates,
+                                      const QPainterPath &path)
+{
+    QList<QGraphicsItem *> result;
+    for(int i = 0; i < candidates.size(); ++i)
+    {
+        T *item = candidates.at(i);
+        if(item->isVisible()
+                && item->collidesWithPath(item->mapFromScene(path),
+                                          Qt::IntersectsItemShape))
+            result.append(item);
+    }
+    return result;
+}
+
+}
+
+HitIndex::HitIndex(qreal cellSize)
+    : _nodeGrid(cellSize)
+    , _edgeGrid(cellSize)
+    , _stale(false)
+{
+}
+
+void HitIndex::clear()
+{
+    _nodeGrid.clear();
+    _edgeGrid.clear();
+    _nodeRects.clear();
+    _edges.clear();
+    _nodeEdges.clear();
+    _movedNodes.clear();
+    _movedEdges.clear();
+    _stale = false;
+}
+
+void HitIndex::invalidate()
+{
+    _stale = true;
+}
+
+void HitIndex::addNode(NodeItem *node)
+{
+    // Indexed by the next lookup, by which time the node is in place
+    _nodeRects.insert(node, QRectF());
+    _movedNodes.insert(node);
+}
+
+void HitIndex::removeNode(NodeItem *node)
+{
+    QRectF rect = _nodeRects.take(node);
+    if(!rect.isNull())
+        _nodeGrid.remove(node, rect);
+
+    // The scene removes a node's edges first, so this should be empty
+    QVector<EdgeItem *> edges = _nodeEdges.take(node);
+    for(int i = 0; i < edges.size(); ++i)
+        removeEdge(edges.at(i));
+
+    _movedNodes.remove(node);
+}
+
+void HitIndex::nodeMoved(NodeItem *node)
+{
+    if(_nodeRects.contains(node))
+        _movedNodes.insert(node);
+}
+
+void HitIndex::addEdge(EdgeItem *edge)
+{
+    EdgeEntry entry;
+    entry.from = edge->from();
+    entry.to = edge->to();
+    _edges.insert(edge, entry);
+
+    _nodeEdges[entry.from].push_back(edge);
+    if(entry.to != entry.from)
+        _nodeEdges[entry.to].push_back(edge);
+
+    // Left for the next lookup, so that adding edges in bulk does not compute
+    // the geometry of each
+    _movedEdges.insert(edge);
+}
+
+void HitIndex::removeEdge(EdgeItem *edge)
+{
+    QHash<EdgeItem *, EdgeEntry>::iterator iter = _edges.find(edge);
+    if(iter == _edges.end())
+        return;
+
+    EdgeEntry entry = iter.value();
+    _edges.erase(iter);
+    if(!entry.rect.isNull())
+        _edgeGrid.remove(edge, entry.rect);
+
+    detach(entry.from, edge);
+    if(entry.to != entry.from)
+        detach(entry.to, edge);
+    _movedEdges.remove(edge);
+}
+
+NodeItem *HitIndex::nodeAt(const QPointF &pos)
+{
+    update();
+    QList<QGraphicsItem *> nodes = itemsContaining(_nodeGrid.query(pos), pos);
+    return nodes.isEmpty() ? 0 : static_cast<NodeItem *>(nodes.first());
+}
+
+EdgeItem *HitIndex::edgeAt(const QPointF &pos)
+{
+    update();
+
+    // The same test as EdgeItem's hover events, which is tighter than its
+    // shape as that takes in the label
+    QList<EdgeItem *> candidates = _edgeGrid.query(pos);
+    for(int i = 0; i < candidates.size(); ++i)
+    {
+        EdgeItem *edge = candidates.at(i);
+        if(edge->isVisible()
+                && edge->edgePolygon().containsPoint(pos, Qt::OddEvenFill))
+            return edge;
+    }
+
+    return 0;
+}
+
+QList<QGraphicsItem *> HitIndex::itemsAt(const QPointF &pos)
+{
+    update();
+
+    // Nodes are drawn above edges, and the result is topmost first as with
+    // QGraphicsScene::items()
+    QList<QGraphicsItem *> result = itemsContaining(_nodeGrid.query(pos), pos);
+    result.append(itemsContaining(_edgeGrid.query(pos), pos));
+    return result;
+}
+
+QList<QGraphicsItem *> HitIndex::itemsIn(const QRectF &rect)
+{
+    update();
+
+    QPainterPath path;
+    path.addRect(rect.normalized());
+    QList<QGraphicsItem *> result = itemsColliding(_nodeGrid.query(rect),
+                                                   path);
+    result.append(itemsColliding(_edgeGrid.query(rect), path));
+    return result;
+}
+
+void HitIndex::update()
+{
+    if(_stale)
+    {
+        // Everything goes back in from scratch
+        _nodeGrid.clear();
+        _edgeGrid.clear();
+        for(QHash<NodeItem *, QRectF>::iterator iter = _nodeRects.begin();
+            iter != _nodeRects.end(); ++iter)
+        {
+            iter.value() = QRectF();
+            _movedNodes.insert(iter.key());
+        }
+        for(QHash<EdgeItem *, EdgeEntry>::iterator iter = _edges.begin();
+            iter != _edges.end(); ++iter)
+        {
+            iter.value().rect = QRectF();
+            _movedEdges.insert(iter.key());
+        }
+        _stale = false;
+    }
+
+    for(QSet<NodeItem *>::iterator iter = _movedNodes.begin();
+        iter != _movedNodes.end(); ++iter)
+    {
+        NodeItem *node = *iter;
+        QRectF &rect = _nodeRects[node];
+        QRectF newRect = node->sceneBoundingRect();
+        if(rect.isNull())
+            _nodeGrid.insert(node, newRect);
+        else if(newRect != rect)
+            _nodeGrid.move(node, rect, newRect);
+        rect = newRect;
+
+        // Edges follow their end points
+        QVector<EdgeItem *> edges = _nodeEdges.value(node);
+        for(int i = 0; i < edges.size(); ++i)
+            _movedEdges.insert(edges.at(i));
+    }
+    _movedNodes.clear();
+
+    for(QSet<EdgeItem *>::iterator iter = _movedEdges.begin();
+        iter != _movedEdges.end(); ++iter)
+    {
+        EdgeItem *edge = *iter;
+        EdgeEntry &entry = _edges[edge];
+        QRectF newRect = edge->sceneBoundingRect();
+        if(entry.rect.isNull())
+            _edgeGrid.insert(edge, newRect);
+        else if(newRect != entry.rect)
+            _edgeGrid.move(edge, entry.rect, newRect);
+        entry.rect = newRect;
+    }
+    _movedEdges.clear();
+}
+
+void HitIndex::detach(NodeItem *node, EdgeItem *edge)
+{
+    QHash<NodeItem *, QVector<EdgeItem *> >::iterator iter
+            = _nodeEdges.find(node);
+    if(iter == _nodeEdges.end())
+        return;
+
+    QVector<EdgeItem *> &edges = iter.value();
+    int index = edges.indexOf(edge);
+    if(index >= 0)
+    {
+        edges[index] = edges.last();
+        edges.pop_back();
+    }
+}
+
+}
@@ -0,0 +1,105 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef HITINDEX_HPP
+#define HITINDEX_HPP
+
+#include <QHash>
+#include <QList>
+#include <QPointF>
+#include <QRectF>
+#include <QSet>
+#include <QVector>
+
+#include "graphview/spatialgrid.hpp"
+#include "global.hpp"
+
+class QGraphicsItem;
+
+namespace Developer {
+
+class NodeItem;
+class EdgeItem;
+
+/*!
+ * \brief The HitIndex class answers which node and edge items are under a
+ *  point or within a rectangle
+ *
+ * GraphScene runs with no index of its own, as the items move too often for a
+ * BSP tree to pay off, so a scene lookup tests every item in the scene. This
+ * index keeps the bounding rectangle of each node and edge item in a pair of
+ * SpatialGrid objects, so a lookup only tests the exact shapes of the few
+ * items in the cells it touches.
+ *
+ * New and moved items are only marked, each marked node also marking its
+ * edges, and their rectangles are brought up to date by the next lookup. An
+ * item which moves several times between lookups is updated once, and adding
+ * edges in bulk does not compute the geometry of each. Items moved without
+ * telling the index, such as by a LayoutAnimator, are handled by invalidate(),
+ * which refreshes every item on the next lookup. Hidden items, such as
+ * bundled edges, are never returned.
+ */
+class HitIndex
+{
+public:
+    explicit HitIndex(qreal cellSize = HIT_GRID_CELL_SIZE);
+
+    void clear();
+    void invalidate();
+
+    void addNode(NodeItem *node);
+    void removeNode(NodeItem *node);
+    void nodeMoved(NodeItem *node);
+    void addEdge(EdgeItem *edge);
+    void removeEdge(EdgeItem *edge);
+
+    NodeItem *nodeAt(const QPointF &pos);
+    EdgeItem *edgeAt(const QPointF &pos);
+    QList<QGraphicsItem *> itemsAt(const QPointF &pos);
+    QList<QGraphicsItem *> itemsIn(const QRectF &rect);
+
+private:
+    /*!
+     * \brief What the index needs to move or remove an edge, its end points
+     *  may already have changed by then
+     */
+    struct EdgeEntry
+    {
+        QRectF rect;
+        NodeItem *from;
+        NodeItem *to;
+    };
+
+    void update();
+    void detach(NodeItem *node, EdgeItem *edge);
+
+    SpatialGrid<NodeItem *> _nodeGrid;
+    SpatialGrid<EdgeItem *> _edgeGrid;
+    QHash<NodeItem *, QRectF> _nodeRects;
+    QHash<EdgeItem *, EdgeEntry> _edges;
+    QHash<NodeItem *, QVector<EdgeItem *> > _nodeEdges;
+    QSet<NodeItem *> _movedNodes;
+    QSet<EdgeItem *> _movedEdges;
+    bool _stale;
+};
+
+}
+
+#endif // HITINDEX_HPP
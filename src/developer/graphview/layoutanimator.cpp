@@ -0,0 +1,152 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "layoutanimator.hpp"
+#include "edgeitem.hpp"
+#include "node.hpp"
+
+#include <QSet>
+#include <QTimer>
+
+namespace Developer {
+
+LayoutAnimator::LayoutAnimator(QGraphicsScene *scene, QObject *parent)
+    : QObject(parent)
+    , _scene(scene)
+    , _timer(new QTimer(this))
+    , _duration(LAYOUT_ANIMATION_DURATION)
+    , _running(false)
+    , _indexMethod(QGraphicsScene::NoIndex)
+{
+    _timer->setInterval(LAYOUT_ANIMATION_FRAME_INTERVAL);
+    connect(_timer, SIGNAL(timeout()), this, SLOT(advance()));
+}
+
+bool LayoutAnimator::isRunning() const
+{
+    return _running;
+}
+
+void LayoutAnimator::animate(const QVector<NodeItem *> &items,
+                             const QVector<QPointF> &positions,
+                             const QList<EdgeItem *> &edges, int duration)
+{
+    // A transition which is already running carries on from wherever its
+    // items have got to
+    _items.clear();
+    _from.clear();
+    _to.clear();
+    _edges.clear();
+
+    QSet<NodeItem *> moving;
+    for(int i = 0; i < items.size(); ++i)
+    {
+        NodeItem *item = items.at(i);
+        if(item == 0 || item->pos() == positions.at(i))
+            continue;
+
+        _items.push_back(item);
+        _from.push_back(item->pos());
+        _to.push_back(positions.at(i));
+        moving.insert(item);
+    }
+
+    if(_items.isEmpty())
+    {
+        if(_running)
+            end();
+        else
+            emit finished();
+        return;
+    }
+
+    for(int i = 0; i < edges.size(); ++i)
+    {
+        EdgeItem *edge = edges.at(i);
+        if(moving.contains(edge->from()) || moving.contains(edge->to()))
+            _edges.push_back(edge);
+    }
+
+    if(!_running)
+    {
+        _indexMethod = _scene->itemIndexMethod();
+        _scene->setItemIndexMethod(QGraphicsScene::NoIndex);
+        _running = true;
+    }
+
+    _duration = qMax(duration, 1);
+    _clock.start();
+    _timer->start();
+}
+
+void LayoutAnimator::finish()
+{
+    if(_running)
+        end();
+}
+
+void LayoutAnimator::advance()
+{
+    qreal t = qreal(_clock.elapsed()) / _duration;
+    if(t >= 1.0)
+    {
+        end();
+        return;
+    }
+
+    // Ease in and out so that nodes neither jump into motion nor stop dead
+    moveItems(t * t * (3.0 - 2.0 * t));
+}
+
+void LayoutAnimator::moveItems(qreal t)
+{
+    for(int i = 0; i < _items.size(); ++i)
+    {
+        NodeItem *item = _items.at(i);
+        QPointF pos = _from.at(i) + (_to.at(i) - _from.at(i)) * t;
+
+        // Without the signals the node and the edges have to be told here
+        item->blockSignals(true);
+        item->setPos(pos);
+        item->blockSignals(false);
+        if(item->node() != 0)
+            item->node()->setPos(pos);
+    }
+
+    for(int i = 0; i < _edges.size(); ++i)
+        _edges.at(i)->nodeMoved();
+}
+
+void LayoutAnimator::end()
+{
+    moveItems(1.0);
+
+    _timer->stop();
+    _running = false;
+    _items.clear();
+    _from.clear();
+    _to.clear();
+    _edges.clear();
+    _scene->setItemIndexMethod(_indexMethod);
+
+    emit finished();
+}
+
+}
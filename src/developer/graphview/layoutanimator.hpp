@@ -0,0 +1,95 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LAYOUTANIMATOR_HPP
+#define LAYOUTANIMATOR_HPP
+
+#include <QElapsedTimer>
+#include <QGraphicsScene>
+#include <QObject>
+#include <QPointF>
+#include <QVector>
+
+#include "global.hpp"
+
+class QTimer;
+
+namespace Developer {
+
+class NodeItem;
+class EdgeItem;
+
+/*!
+ * \brief The LayoutAnimator class moves node items smoothly to new positions
+ *
+ * Moving a NodeItem normally emits a signal per coordinate, which writes the
+ * position back to its Node and marks each attached EdgeItem as needing new
+ * geometry. This is fine for a dragged node but not for tens of thousands of
+ * nodes sixty times a second, so the animator moves every item from a single
+ * timer per frame with the item signals blocked, writes the nodes back itself
+ * and marks each affected edge once. The scene index, if there is one, is
+ * suspended until the transition ends and rebuilt once.
+ *
+ * The animator only holds plain pointers to the items, so the scene must call
+ * finish() before deleting any of them or adding edges to them.
+ */
+class LayoutAnimator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LayoutAnimator(QGraphicsScene *scene, QObject *parent = 0);
+
+    bool isRunning() const;
+
+    void animate(const QVector<NodeItem *> &items,
+                 const QVector<QPointF> &positions,
+                 const QList<EdgeItem *> &edges,
+                 int duration = LAYOUT_ANIMATION_DURATION);
+
+public slots:
+    void finish();
+
+signals:
+    void finished();
+
+protected slots:
+    void advance();
+
+protected:
+    void moveItems(qreal t);
+    void end();
+
+    QGraphicsScene *_scene;
+    QTimer *_timer;
+    QElapsedTimer _clock;
+    int _duration;
+    bool _running;
+    QGraphicsScene::ItemIndexMethod _indexMethod;
+
+    QVector<NodeItem *> _items;
+    QVector<QPointF> _from;
+    QVector<QPointF> _to;
+    QVector<EdgeItem *> _edges;
+};
+
+}
+
+#endif // LAYOUTANIMATOR_HPP
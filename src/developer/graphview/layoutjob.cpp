@@ -0,0 +1,337 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "layoutjob.hpp"
+#include "forcelayout.hpp"
+
+#include <ogdf/basic/basic.h>
+#include <ogdf/basic/Graph.h>
+#include <ogdf/basic/GraphAttributes.h>
+#include <ogdf/tree/TreeLayout.h>
+#include <ogdf/layered/SugiyamaLayout.h>
+#include <ogdf/tree/RadialTreeLayout.h>
+#include <ogdf/planarlayout/FPPLayout.h>
+#include <ogdf/planarlayout/PlanarDrawLayout.h>
+#include <ogdf/planarlayout/PlanarStraightLayout.h>
+#include <ogdf/planarlayout/SchnyderLayout.h>
+#include <ogdf/planarity/PlanarizationGridLayout.h>
+#include <ogdf/layered/FastHierarchyLayout.h>
+#include <ogdf/misclayout/CircularLayout.h>
+#include <ogdf/energybased/SpringEmbedderFR.h>
+#include <ogdf/energybased/DavidsonHarelLayout.h>
+#include <ogdf/energybased/FMMMLayout.h>
+#include <ogdf/energybased/GEMLayout.h>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+using ogdf::GraphAttributes;
+
+namespace Developer {
+
+namespace {
+
+/*
+ * The algorithms which need configuring get their own function below, with the
+ * spacings the graph view has always used.
+ */
+
+void callTree(GraphAttributes &ga, LayoutDirections direction)
+{
+    ogdf::TreeLayout tree;
+    tree.siblingDistance(40.0);
+    tree.subtreeDistance(30.0);
+    tree.levelDistance(60.0);
+    tree.treeDistance(60.0);
+
+    switch(direction)
+    {
+    case Layout_RightToLeft:
+        tree.orientation(ogdf::rightToLeft);
+        break;
+    case Layout_BottomToTop:
+        tree.orientation(ogdf::bottomToTop);
+        break;
+    case Layout_LeftToRight:
+        tree.orientation(ogdf::leftToRight);
+        break;
+    case Layout_TopToBottom:
+    default:
+        tree.orientation(ogdf::topToBottom);
+        break;
+    }
+
+    tree.call(ga);
+}
+
+void callSugiyama(GraphAttributes &ga)
+{
+    ogdf::SugiyamaLayout sugiyama;
+
+    ogdf::FastHierarchyLayout *fhl = new ogdf::FastHierarchyLayout;
+    fhl->layerDistance(45.0);
+    fhl->nodeDistance(30.0);
+    sugiyama.setLayout(fhl);
+
+    sugiyama.call(ga);
+}
+
+void callRadialTree(GraphAttributes &ga)
+{
+    ogdf::RadialTreeLayout radialTree;
+    radialTree.levelDistance(60.0);
+    radialTree.connectedComponentDistance(60.0);
+
+    radialTree.call(ga);
+}
+
+void callPlanarizationGrid(GraphAttributes &ga)
+{
+    ogdf::PlanarizationGridLayout planarGrid;
+    planarGrid.separation(50.0);
+
+    planarGrid.call(ga);
+}
+
+void callCircular(GraphAttributes &ga)
+{
+    ogdf::CircularLayout circular;
+    circular.minDistCircle(50.0);
+    circular.minDistLevel(50.0);
+    circular.minDistSibling(35.0);
+    circular.minDistCC(50.0);
+
+    circular.call(ga);
+}
+
+void callSpring(GraphAttributes &ga)
+{
+    ogdf::SpringEmbedderFR spring;
+    spring.minDistCC(40.0);
+    spring.scaleFunctionFactor(5.0);
+
+    spring.call(ga);
+}
+
+void callGEM(GraphAttributes &ga)
+{
+    ogdf::GEMLayout gem;
+    gem.desiredLength(20.0);
+    gem.minDistCC(50.0);
+
+    gem.call(ga);
+}
+
+/*!
+ * \brief Run the algorithm requested by a job
+ * \param ga   The attributes of the graph to lay out, updated in place
+ * \param job  The job describing the algorithm to use
+ */
+void callAlgorithm(GraphAttributes &ga, const LayoutJob &job)
+{
+    switch(job.algorithm)
+    {
+    case LayoutAlgorithm_Tree:
+        callTree(ga, job.direction);
+        break;
+    case LayoutAlgorithm_Sugiyama:
+        callSugiyama(ga);
+        break;
+    case LayoutAlgorithm_RadialTree:
+        callRadialTree(ga);
+        break;
+    case LayoutAlgorithm_FPP:
+    {
+        ogdf::FPPLayout fpp;
+        fpp.call(ga);
+        break;
+    }
+    case LayoutAlgorithm_PlanarDraw:
+    {
+        ogdf::PlanarDrawLayout planarDraw;
+        planarDraw.call(ga);
+        break;
+    }
+    case LayoutAlgorithm_PlanarStraight:
+    {
+        ogdf::PlanarStraightLayout planarStraight;
+        planarStraight.call(ga);
+        break;
+    }
+    case LayoutAlgorithm_Schnyder:
+    {
+        ogdf::SchnyderLayout schnyder;
+        schnyder.call(ga);
+        break;
+    }
+    case LayoutAlgorithm_PlanarizationGrid:
+        callPlanarizationGrid(ga);
+        break;
+    case LayoutAlgorithm_Spring:
+        callSpring(ga);
+        break;
+    case LayoutAlgorithm_DavidsonHarel:
+    {
+        ogdf::DavidsonHarelLayout dh;
+        dh.call(ga);
+        break;
+    }
+    case LayoutAlgorithm_FMMM:
+    {
+        ogdf::FMMMLayout fmmm;
+        fmmm.call(ga);
+        break;
+    }
+    case LayoutAlgorithm_GEM:
+        callGEM(ga);
+        break;
+    case LayoutAlgorithm_Circular:
+    default:
+        callCircular(ga);
+        break;
+    }
+}
+
+/*!
+ * \brief Run the built in force-directed layout
+ *
+ * Unlike the OGDF algorithms this runs one iteration at a time, so the job can
+ * give up, report progress and pass on intermediate positions as it goes.
+ *
+ * \param job  The job to run
+ * \return The job with the new positions filled in
+ */
+LayoutJob runForceLayout(LayoutJob job)
+{
+    // Edges aim to leave a constant gap between nodes of the average size
+    double size = 0.0;
+    for(int i = 0; i < job.sizes.size(); ++i)
+        size += (job.sizes.at(i).width() + job.sizes.at(i).height()) / 2.0;
+    if(!job.sizes.isEmpty())
+        size /= job.sizes.size();
+
+    ForceLayout layout;
+    layout.setIdealLength(size + FORCE_LAYOUT_SPACING);
+    layout.setTheta(FORCE_LAYOUT_THETA);
+    layout.setIterations(job.freeNodes.isEmpty()
+                         ? FORCE_LAYOUT_ITERATIONS
+                         : FORCE_LAYOUT_REFINE_ITERATIONS);
+    layout.setGraph(job.positions, job.edges);
+    layout.setFree(job.freeNodes);
+    layout.start();
+
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+    while(layout.step())
+    {
+        if(job.isStale())
+        {
+            job.cancelled = true;
+            return job;
+        }
+
+        job.setProgress(100 * layout.iteration() / layout.totalIterations());
+
+        if(!job.frame.isNull()
+                && frameTimer.elapsed() >= FORCE_LAYOUT_FRAME_INTERVAL)
+        {
+            QVector<QPointF> positions = layout.positions();
+            QMutexLocker locker(&job.frame->mutex);
+            job.frame->positions = positions;
+            job.frame->fresh = true;
+            frameTimer.restart();
+        }
+    }
+
+    job.positions = layout.positions();
+    return job;
+}
+
+}
+
+LayoutJob runLayout(LayoutJob job)
+{
+    job.setProgress(0);
+    if(job.isStale())
+    {
+        job.cancelled = true;
+        return job;
+    }
+
+    if(job.algorithm == LayoutAlgorithm_BarnesHut)
+        return runForceLayout(job);
+
+    ogdf::Graph g;
+    GraphAttributes ga(g, GraphAttributes::nodeGraphics
+                       | GraphAttributes::edgeGraphics);
+
+    int nodeCount = job.nodeIds.size();
+    QVector<ogdf::node> nodes(nodeCount);
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        ogdf::node n = g.newNode();
+        ga.x(n) = job.positions.at(i).x();
+        ga.y(n) = job.positions.at(i).y();
+        ga.width(n) = job.sizes.at(i).width();
+        ga.height(n) = job.sizes.at(i).height();
+        nodes[i] = n;
+    }
+
+    for(int i = 0; i < job.edges.size(); ++i)
+        g.newEdge(nodes.at(job.edges.at(i).first),
+                  nodes.at(job.edges.at(i).second));
+
+    // The algorithm itself cannot be interrupted, the job can only give up
+    // before and after it
+    job.setProgress(10);
+    if(job.isStale())
+    {
+        job.cancelled = true;
+        return job;
+    }
+
+    try
+    {
+        callAlgorithm(ga, job);
+    }
+    catch(ogdf::Exception e)
+    {
+        Q_UNUSED(e)
+        qDebug() << "Layout algorithm" << job.algorithm
+                 << "failed with a precondition error";
+        job.failed = true;
+        return job;
+    }
+
+    job.setProgress(90);
+    if(job.isStale())
+    {
+        job.cancelled = true;
+        return job;
+    }
+
+    for(int i = 0; i < nodeCount; ++i)
+        job.positions[i] = QPointF(ga.x(nodes.at(i)), ga.y(nodes.at(i)));
+
+    return job;
+}
+
+}
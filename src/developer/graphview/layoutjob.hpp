@@ -0,0 +1,147 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LAYOUTJOB_HPP
+#define LAYOUTJOB_HPP
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QPair>
+#include <QPointF>
+#include <QSharedPointer>
+#include <QSizeF>
+#include <QString>
+#include <QVector>
+
+#include "global.hpp"
+
+namespace Developer {
+
+/*!
+ * \brief The LayoutFrame struct passes intermediate positions from a running
+ *  layout to the scene, so that the layout can be watched as it proceeds
+ *
+ * The worker replaces the positions and sets fresh, the scene takes them and
+ * clears it. Only the latest frame is kept.
+ */
+struct LayoutFrame
+{
+    LayoutFrame()
+        : fresh(false)
+    {
+    }
+
+    QMutex mutex;
+    //! The position of each node, indexed as in the job
+    QVector<QPointF> positions;
+    //! Whether the positions have been updated since the scene last took them
+    bool fresh;
+};
+
+/*!
+ * \brief The LayoutJob struct carries a snapshot of a graph's topology to a
+ *  background layout and the resulting node positions back again
+ *
+ * Nodes are referred to by their index into the nodeIds vector, so the job
+ * holds no pointers into the Graph and the graph may be edited or destroyed
+ * while the layout runs. The positions vector is replaced with the laid out
+ * positions by runLayout().
+ *
+ * Like ParseJob each job is tagged with a revision, and the scene shares the
+ * latest revision with its jobs so that a cancelled or superseded job can give
+ * up between stages and its result be discarded.
+ */
+struct LayoutJob
+{
+    LayoutJob()
+        : algorithm(LayoutAlgorithm_Circular)
+        , direction(DEFAULT_LAYOUT_DIRECTION)
+        , revision(0)
+        , mirrorRevision(0)
+        , cancelled(false)
+        , failed(false)
+    {
+    }
+
+    /*!
+     * \brief Check whether this job has been cancelled or superseded
+     * \return true if the result of this job will not be used
+     */
+    bool isStale() const
+    {
+        return latestRevision.isNull()
+                || latestRevision->fetchAndAddRelaxed(0) != revision;
+    }
+
+    /*!
+     * \brief Record how far through the job the worker has got
+     * \param percent   The progress, from 0 to 100
+     */
+    void setProgress(int percent) const
+    {
+        if(!progress.isNull())
+            progress->fetchAndStoreRelaxed(percent);
+    }
+
+    //! The algorithm to run
+    LayoutAlgorithms algorithm;
+    //! The orientation, used by the tree layout
+    LayoutDirections direction;
+    //! The revision of the layout request this job was started for
+    int revision;
+    //! The latest layout request, shared with the scene
+    QSharedPointer<QAtomicInt> latestRevision;
+    //! The progress of the job as a percentage, shared with the scene
+    QSharedPointer<QAtomicInt> progress;
+    //! The revision of the scene's LayoutMirror the snapshot was taken from
+    int mirrorRevision;
+    //! The ID of each node
+    QVector<QString> nodeIds;
+    //! The position of each node, replaced with the result of the layout
+    QVector<QPointF> positions;
+    //! The size of each node
+    QVector<QSizeF> sizes;
+    //! The edges as pairs of indices into nodeIds
+    QVector< QPair<int, int> > edges;
+    //! For a refinement, the indices of the nodes which may move. Empty for a
+    //! full layout.
+    QVector<int> freeNodes;
+    //! Intermediate positions, for algorithms which provide them
+    QSharedPointer<LayoutFrame> frame;
+    //! Set if the job gave up because it had become stale
+    bool cancelled;
+    //! Set if the algorithm rejected the graph
+    bool failed;
+};
+
+/*!
+ * \brief Run the layout algorithm requested by the job over its snapshot
+ *
+ * This is run on a worker thread. OGDF exceptions are caught and reported
+ * through the failed flag since they cannot cross back to the GUI thread.
+ *
+ * \param job   The job to run
+ * \return The job with the new positions filled in
+ */
+LayoutJob runLayout(LayoutJob job);
+
+}
+
+#endif // LAYOUTJOB_HPP
@@ -0,0 +1,338 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "layoutmirror.hpp"
+#include "layoutjob.hpp"
+#include "nodeitem.hpp"
+#include "node.hpp"
+
+#include <QDebug>
+
+namespace Developer {
+
+namespace {
+
+void removeIndex(QVector<int> &indices, int index)
+{
+    int i = indices.indexOf(index);
+    if(i < 0)
+        return;
+    indices[i] = indices.last();
+    indices.pop_back();
+}
+
+void replaceIndex(QVector<int> &indices, int oldIndex, int newIndex)
+{
+    int i = indices.indexOf(oldIndex);
+    if(i >= 0)
+        indices[i] = newIndex;
+}
+
+}
+
+LayoutMirror::LayoutMirror()
+    : _revision(0)
+{
+}
+
+void LayoutMirror::clear()
+{
+    _nodeIds.clear();
+    _positions.clear();
+    _sizes.clear();
+    _items.clear();
+    _nodes.clear();
+    _settledPositions.clear();
+    _settled.clear();
+    _incidentEdges.clear();
+    _nodeIndices.clear();
+    _edgeIds.clear();
+    _edges.clear();
+    _edgeIndices.clear();
+    ++_revision;
+}
+
+void LayoutMirror::reserve(int nodeCount, int edgeCount)
+{
+    _nodeIds.reserve(nodeCount);
+    _positions.reserve(nodeCount);
+    _sizes.reserve(nodeCount);
+    _items.reserve(nodeCount);
+    _nodes.reserve(nodeCount);
+    _settledPositions.reserve(nodeCount);
+    _settled.reserve(nodeCount);
+    _incidentEdges.reserve(nodeCount);
+    _nodeIndices.reserve(nodeCount);
+    _edgeIds.reserve(edgeCount);
+    _edges.reserve(edgeCount);
+    _edgeIndices.reserve(edgeCount);
+}
+
+int LayoutMirror::revision() const
+{
+    return _revision;
+}
+
+int LayoutMirror::nodeCount() const
+{
+    return _nodeIds.size();
+}
+
+int LayoutMirror::edgeCount() const
+{
+    return _edgeIds.size();
+}
+
+int LayoutMirror::nodeIndex(const QString &id) const
+{
+    return _nodeIndices.value(id, -1);
+}
+
+NodeItem *LayoutMirror::nodeItem(int index) const
+{
+    return _items.at(index);
+}
+
+Node *LayoutMirror::node(int index) const
+{
+    return _nodes.at(index);
+}
+
+void LayoutMirror::addNode(const QString &id, const QSizeF &size,
+                           NodeItem *item, Node *node)
+{
+    Q_ASSERT(item != 0 || node != 0);
+    if(_nodeIndices.contains(id))
+    {
+        qDebug() << "LayoutMirror: node" << id << "is already present";
+        return;
+    }
+
+    _nodeIndices.insert(id, _nodeIds.size());
+    _nodeIds.push_back(id);
+    _positions.push_back(item != 0 ? item->pos() : node->pos());
+    _sizes.push_back(size);
+    _items.push_back(item);
+    _nodes.push_back(node);
+    _settledPositions.push_back(QPointF());
+    _settled.push_back(0);
+    _incidentEdges.push_back(QVector<int>());
+}
+
+void LayoutMirror::removeNode(const QString &id)
+{
+    int index = _nodeIndices.value(id, -1);
+    if(index < 0)
+        return;
+
+    // The scene removes edges first, so this is not normally needed
+    while(!_incidentEdges.at(index).isEmpty())
+        removeEdgeAt(_incidentEdges.at(index).last());
+
+    // Move the last node into the gap, then point its edges at it
+    int last = _nodeIds.size() - 1;
+    if(index != last)
+    {
+        _nodeIds[index] = _nodeIds.at(last);
+        _positions[index] = _positions.at(last);
+        _sizes[index] = _sizes.at(last);
+        _items[index] = _items.at(last);
+        _nodes[index] = _nodes.at(last);
+        _settledPositions[index] = _settledPositions.at(last);
+        _settled[index] = _settled.at(last);
+        _incidentEdges[index] = _incidentEdges.at(last);
+        _nodeIndices.insert(_nodeIds.at(index), index);
+
+        const QVector<int> &incident = _incidentEdges.at(index);
+        for(int i = 0; i < incident.size(); ++i)
+        {
+            QPair<int, int> &edge = _edges[incident.at(i)];
+            if(edge.first == last)
+                edge.first = index;
+            if(edge.second == last)
+                edge.second = index;
+        }
+    }
+
+    _nodeIndices.remove(id);
+    _nodeIds.pop_back();
+    _positions.pop_back();
+    _sizes.pop_back();
+    _items.pop_back();
+    _nodes.pop_back();
+    _settledPositions.pop_back();
+    _settled.pop_back();
+    _incidentEdges.pop_back();
+    ++_revision;
+}
+
+void LayoutMirror::renameNode(const QString &oldId, const QString &newId)
+{
+    int index = _nodeIndices.value(oldId, -1);
+    if(index < 0)
+        return;
+
+    _nodeIndices.remove(oldId);
+    _nodeIndices.insert(newId, index);
+    _nodeIds[index] = newId;
+}
+
+void LayoutMirror::setNodeSize(const QString &id, const QSizeF &size)
+{
+    int index = _nodeIndices.value(id, -1);
+    if(index >= 0)
+        _sizes[index] = size;
+}
+
+void LayoutMirror::addEdge(const QString &id, const QString &from,
+                           const QString &to)
+{
+    int fromIndex = _nodeIndices.value(from, -1);
+    int toIndex = _nodeIndices.value(to, -1);
+    if(fromIndex < 0 || toIndex < 0)
+    {
+        qDebug() << "LayoutMirror: could not locate either or both of nodes"
+                 << from << "and" << to << "for edge" << id;
+        return;
+    }
+
+    if(_edgeIndices.contains(id))
+    {
+        qDebug() << "LayoutMirror: edge" << id << "is already present";
+        return;
+    }
+
+    _edgeIndices.insert(id, _edgeIds.size());
+    _edgeIds.push_back(id);
+    _edges.push_back(qMakePair(fromIndex, toIndex));
+    attachEdge(_edges.size() - 1);
+}
+
+void LayoutMirror::removeEdge(const QString &id)
+{
+    int index = _edgeIndices.value(id, -1);
+    if(index >= 0)
+        removeEdgeAt(index);
+}
+
+void LayoutMirror::removeEdgeAt(int index)
+{
+    int last = _edgeIds.size() - 1;
+    detachEdge(index);
+    _edgeIndices.remove(_edgeIds.at(index));
+    if(index != last)
+    {
+        _edgeIds[index] = _edgeIds.at(last);
+        _edges[index] = _edges.at(last);
+        _edgeIndices.insert(_edgeIds.at(index), index);
+
+        // Point the moved edge's end points at its new index
+        const QPair<int, int> &edge = _edges.at(index);
+        replaceIndex(_incidentEdges[edge.first], last, index);
+        if(edge.second != edge.first)
+            replaceIndex(_incidentEdges[edge.second], last, index);
+    }
+
+    _edgeIds.pop_back();
+    _edges.pop_back();
+}
+
+void LayoutMirror::attachEdge(int index)
+{
+    const QPair<int, int> &edge = _edges.at(index);
+    _incidentEdges[edge.first].push_back(index);
+    if(edge.second != edge.first)
+        _incidentEdges[edge.second].push_back(index);
+}
+
+void LayoutMirror::detachEdge(int index)
+{
+    const QPair<int, int> &edge = _edges.at(index);
+    removeIndex(_incidentEdges[edge.first], index);
+    if(edge.second != edge.first)
+        removeIndex(_incidentEdges[edge.second], index);
+}
+
+void LayoutMirror::renameEdge(const QString &oldId, const QString &newId)
+{
+    int index = _edgeIndices.value(oldId, -1);
+    if(index < 0)
+        return;
+
+    _edgeIndices.remove(oldId);
+    _edgeIndices.insert(newId, index);
+    _edgeIds[index] = newId;
+}
+
+void LayoutMirror::setEdgeEnds(const QString &id, const QString &from,
+                               const QString &to)
+{
+    int index = _edgeIndices.value(id, -1);
+    int fromIndex = _nodeIndices.value(from, -1);
+    int toIndex = _nodeIndices.value(to, -1);
+    if(index < 0 || fromIndex < 0 || toIndex < 0)
+        return;
+
+    detachEdge(index);
+    _edges[index] = qMakePair(fromIndex, toIndex);
+    attachEdge(index);
+}
+
+void LayoutMirror::snapshot(LayoutJob *job)
+{
+    updatePositions();
+
+    job->mirrorRevision = _revision;
+    job->nodeIds = _nodeIds;
+    job->positions = _positions;
+    job->sizes = _sizes;
+    job->edges = _edges;
+}
+
+void LayoutMirror::markSettled()
+{
+    updatePositions();
+    _settledPositions = _positions;
+    _settled.fill(1, _positions.size());
+}
+
+QVector<int> LayoutMirror::unsettledNodes()
+{
+    updatePositions();
+
+    QVector<int> nodes;
+    for(int i = 0; i < _positions.size(); ++i)
+    {
+        if(!_settled.at(i) || _positions.at(i) != _settledPositions.at(i))
+            nodes.push_back(i);
+    }
+    return nodes;
+}
+
+void LayoutMirror::updatePositions()
+{
+    for(int i = 0; i < _positions.size(); ++i)
+    {
+        NodeItem *item = _items.at(i);
+        _positions[i] = (item != 0) ? item->pos() : _nodes.at(i)->pos();
+    }
+}
+
+}
@@ -0,0 +1,146 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LAYOUTMIRROR_HPP
+#define LAYOUTMIRROR_HPP
+
+#include <QHash>
+#include <QPair>
+#include <QPointF>
+#include <QSizeF>
+#include <QString>
+#include <QVector>
+
+namespace Developer {
+
+class Node;
+class NodeItem;
+struct LayoutJob;
+
+/*!
+ * \brief The LayoutMirror class keeps the topology of a GraphScene in the
+ *  integer-indexed form handed to a LayoutJob
+ *
+ * The scene updates the mirror as nodes and edges gain, lose or rename their
+ * items, so starting a layout only copies the mirror's (implicitly shared)
+ * vectors instead of walking every item, measuring every node and mapping
+ * every edge end point through its ID.
+ *
+ * Removal swaps the last node or edge into the vacated index. Each node keeps
+ * the indices of its incident edges, so removing a node or an edge only
+ * touches the edges of the nodes involved rather than every edge. revision()
+ * changes whenever a node may have moved to another index, so a finished
+ * layout can be applied by index if no node has been removed in the meantime
+ * and by ID otherwise.
+ *
+ * Positions are not tracked as they change, they are read back from the items
+ * (or from the nodes, for entries without an item) in index order when a
+ * snapshot is taken. The mirror also remembers where each node was when the
+ * layout was last settled, so that a refinement can be limited to the nodes
+ * added or moved since.
+ */
+class LayoutMirror
+{
+public:
+    LayoutMirror();
+
+    void clear();
+    void reserve(int nodeCount, int edgeCount);
+
+    int revision() const;
+    int nodeCount() const;
+    int edgeCount() const;
+    int nodeIndex(const QString &id) const;
+    NodeItem *nodeItem(int index) const;
+    Node *node(int index) const;
+
+    /*!
+     * \brief Add a node to the mirror
+     *
+     * A node with an item takes its position from the item, otherwise from
+     * the node.
+     *
+     * \param id    The ID of the node
+     * \param size  The size of the node
+     * \param item  The item representing the node, or 0 if it has none
+     * \param node  The node, or 0 if it has an item
+     */
+    void addNode(const QString &id, const QSizeF &size, NodeItem *item,
+                 Node *node = 0);
+    /*!
+     * \brief Remove a node, and any edges still attached to it
+     * \param id    The ID of the node to remove
+     */
+    void removeNode(const QString &id);
+    void renameNode(const QString &oldId, const QString &newId);
+    void setNodeSize(const QString &id, const QSizeF &size);
+
+    void addEdge(const QString &id, const QString &from, const QString &to);
+    void removeEdge(const QString &id);
+    void renameEdge(const QString &oldId, const QString &newId);
+    void setEdgeEnds(const QString &id, const QString &from,
+                     const QString &to);
+
+    /*!
+     * \brief Fill in the topology of a layout job
+     *
+     * The vectors are shared with the job rather than copied, the positions
+     * are brought up to date first.
+     *
+     * \param job   The job to fill in
+     */
+    void snapshot(LayoutJob *job);
+
+    /*!
+     * \brief Record the current positions as a settled layout
+     */
+    void markSettled();
+    /*!
+     * \brief List the nodes added or moved since markSettled() was last called
+     * \return The indices of the nodes
+     */
+    QVector<int> unsettledNodes();
+
+private:
+    void removeEdgeAt(int index);
+    void attachEdge(int index);
+    void detachEdge(int index);
+    void updatePositions();
+
+    QVector<QString> _nodeIds;
+    QVector<QPointF> _positions;
+    QVector<QSizeF> _sizes;
+    QVector<NodeItem *> _items;
+    QVector<Node *> _nodes;
+    QVector<QPointF> _settledPositions;
+    QVector<char> _settled;
+    QVector< QVector<int> > _incidentEdges;
+    QHash<QString, int> _nodeIndices;
+
+    QVector<QString> _edgeIds;
+    QVector< QPair<int, int> > _edges;
+    QHash<QString, int> _edgeIndices;
+
+    int _revision;
+};
+
+}
+
+#endif // LAYOUTMIRROR_HPP
@@ -21,13 +21,13 @@
 #include "nodeitem.hpp"
 #include "node.hpp"
 #include "editnodedialog.hpp"
+#include "graphviewstyle.hpp"
 
 #include "graph.hpp"
 
 #include <QApplication>
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
-#include <QSettings>
 #include <QGraphicsSceneMouseEvent>
 #include <QGraphicsSceneHoverEvent>
 #include <QGraphicsScene>
@@ -52,6 +52,10 @@ NodeItem::NodeItem(Node *node, QGraphicsItem *parent)
     connect(this, SIGNAL(xChanged()), this, SLOT(positionChanged()));
     connect(this, SIGNAL(yChanged()), this, SLOT(positionChanged()));
 
+    connect(node, SIGNAL(nodeChanged()), this, SLOT(syncNode()));
+    connect(node, SIGNAL(posChanged(QPointF)),
+            this, SLOT(syncPosition(QPointF)));
+
     if(node->isPhantomNode())
         setItemState(GraphItem_Deleted);
 }
@@ -78,10 +82,8 @@ void NodeItem::recalculate()
 {
     _boundingRect = QRectF();
     _boundingRect = boundingRect();
-    qDebug() << _boundingRect;
     _shape = QPainterPath();
     _shape = shape();
-    qDebug() << _shape;
     emit shapeChanged();
 }
 
@@ -105,6 +107,29 @@ Node *NodeItem::node() const
     return _node;
 }
 
+void NodeItem::setNode(Node *node)
+{
+    if(_node != 0)
+        disconnect(_node, 0, this, 0);
+    connect(node, SIGNAL(nodeChanged()), this, SLOT(syncNode()));
+    connect(node, SIGNAL(posChanged(QPointF)),
+            this, SLOT(syncPosition(QPointF)));
+
+    // Set the members directly, the setters would write them back to the node
+    // and announce an ID change
+    _node = node;
+    _id = node->id();
+    _label = node->label().toString();
+    _isRoot = node->isRoot();
+    _marked = node->marked();
+    _hover = false;
+    setItemState(node->isPhantomNode() ? GraphItem_Deleted : GraphItem_Normal);
+    setToolTip(QString());
+
+    prepareGeometryChange();
+    recalculate();
+}
+
 void NodeItem::setId(const QString &itemId)
 {
     if(itemId == id())
@@ -172,11 +197,8 @@ QPainterPath NodeItem::shape() const
     if(!_shape.isEmpty())
         return _shape;
 
-    QSettings settings;
-    QFont font = settings.value("GraphView/Nodes/Font", qApp->font()
-                                ).value<QFont>();
-
-    QFontMetrics metrics(font);
+    GraphViewStyle *style = GraphViewStyle::instance();
+    const QFontMetrics &metrics = style->nodeMetrics();
 
     QRectF rect = boundingRect();
     // Leave space for the ID underneath
@@ -202,8 +224,7 @@ QPainterPath NodeItem::shape() const
 
     case RoundedRectangle:
     {
-        qreal radius = settings.value("GraphView/Nodes/CornerRadius", 6
-                                      ).toDouble();
+        qreal radius = style->nodeCornerRadius();
         path.addRoundedRect(rect, radius, radius);
     }
         break;
@@ -247,11 +268,7 @@ QList<QPointF> NodeItem::intersection(QLineF line) const
 
 QPointF NodeItem::centerPos() const
 {
-    QSettings settings;
-    QFont font = settings.value("GraphView/Nodes/Font", qApp->font()
-                                ).value<QFont>();
-
-    QFontMetrics metrics(font);
+    const QFontMetrics &metrics = GraphViewStyle::instance()->nodeMetrics();
 
     QRectF rect = boundingRect();
     // Leave space for the ID underneath
@@ -267,24 +284,13 @@ QRectF NodeItem::boundingRect() const
     if(!_boundingRect.isEmpty())
         return _boundingRect;
 
-    QSettings settings;
-    qreal topPadding    = settings.value("GraphView/Nodes/Padding/Top", 6
-                                         ).toDouble();
-    qreal rightPadding  = settings.value("GraphView/Nodes/Padding/Right", 8
-                                         ).toDouble();
-    qreal bottomPadding = settings.value("GraphView/Nodes/Padding/Bottom", 6
-                                         ).toDouble();
-    qreal leftPadding   = settings.value("GraphView/Nodes/Padding/Left", 8
-                                         ).toDouble();
-    qreal borderWidth = settings.value("GraphView/Nodes/Borders/Width", 2
-                                       ).toDouble();
-    QFont font = settings.value("GraphView/Nodes/Font", qApp->font()
-                                ).value<QFont>();
-
-    QFontMetrics metrics(font);
-
-    if(_isRoot)
-        borderWidth *= 1.5;
+    GraphViewStyle *style = GraphViewStyle::instance();
+    qreal topPadding    = style->nodeTopPadding();
+    qreal rightPadding  = style->nodeRightPadding();
+    qreal bottomPadding = style->nodeBottomPadding();
+    qreal leftPadding   = style->nodeLeftPadding();
+    qreal borderWidth = style->nodeBorderWidth(_isRoot);
+    const QFontMetrics &metrics = style->nodeMetrics();
 
     qreal width  = borderWidth + leftPadding + metrics.width(label())
             + rightPadding + borderWidth;
@@ -298,36 +304,33 @@ void NodeItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
                      QWidget *widget)
 {
     Q_UNUSED(widget);
-    QSettings settings;
-
-    qreal topPadding    = settings.value("GraphView/Nodes/Padding/Top", 6
-                                         ).toDouble();
-    qreal leftPadding   = settings.value("GraphView/Nodes/Padding/Left", 8
-                                         ).toDouble();
-    QFont font = settings.value("GraphView/Nodes/Font", qApp->font()
-                                ).value<QFont>();
-    QColor textColour = settings.value("GraphView/Nodes/TextColour",
-                                       QColor(0x33,0x33,0x33)
-                                         ).value<QColor>();
-    qreal borderWidth = settings.value("GraphView/Nodes/Borders/Width", 2
-                                       ).toDouble();
-
-    // Aha, switch to British English and now this symbols is not already
-    // assigned, man, the UK is just better isn't it?
-    QColor borderColour = borderColor(option);
-    QColor bgColour = backgroundColor(option);
-
-    QFontMetrics metrics(font);
-
-    if(_isRoot)
-        borderWidth *= 1.5;
+    GraphViewStyle *style = GraphViewStyle::instance();
+    qreal detail = option->levelOfDetailFromTransform(painter->worldTransform());
+
+    if(detail < GRAPH_SHAPE_DETAIL_THRESHOLD)
+    {
+        // Zoomed too far out for the outline to be seen, just mark where the
+        // node is
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(style->nodeBorderColour(
+                              itemState(),
+                              option->state & QStyle::State_Selected, _hover));
+        painter->drawEllipse(shape().boundingRect());
+        return;
+    }
+
+    qreal topPadding    = style->nodeTopPadding();
+    qreal leftPadding   = style->nodeLeftPadding();
+    qreal borderWidth = style->nodeBorderWidth(_isRoot);
+    const QFontMetrics &metrics = style->nodeMetrics();
+
     qreal textWidth  = metrics.width(label());
     qreal textHeight = metrics.height();
 
-    painter->setBrush(bgColour);
-    QPen pen(borderColour);
-    pen.setWidth(borderWidth);
-    painter->setPen(pen);
+    painter->setBrush(backgroundColor(option));
+    painter->setPen(style->nodeBorderPen(itemState(),
+                                         option->state & QStyle::State_Selected,
+                                         _hover, _isRoot));
 
     QPainterPath path = shape();
     QRectF pathRect = path.boundingRect();
@@ -346,17 +349,18 @@ void NodeItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
                       "is not permitted."));
     }
 
-    painter->setPen(textColour);
-    painter->setFont(font);
+    if(detail < GRAPH_TEXT_DETAIL_THRESHOLD)
+        return;
+
+    painter->setPen(style->nodeTextColour());
+    painter->setFont(style->nodeFont());
     painter->drawText(QRectF(leftPadding+borderWidth, topPadding+borderWidth,
                              textWidth, textHeight),
                       Qt::AlignCenter,
                       label());
 
     // Draw the node ID
-    QColor idColour = textColour;
-    idColour.setAlpha(80);
-    painter->setPen(idColour);
+    painter->setPen(style->nodeIdColour());
     qreal xOffset = (pathRect.width()/2)-metrics.width(id())/2;
     qreal yOffset = pathRect.height() + metrics.height() + 1;
     painter->drawText(QPointF(xOffset, yOffset), id());
@@ -364,38 +368,12 @@ void NodeItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
 
 QColor NodeItem::backgroundColor(const QStyleOptionGraphicsItem *option) const
 {
-    QSettings settings;
-    QColor ret;
+    bool selected = option->state & QStyle::State_Selected;
+    QColor ret = GraphViewStyle::instance()->nodeBackground(itemState(),
+                                                            selected);
 
-    if(option->state & QStyle::State_Selected)
-    {
-        ret = settings.value("GraphView/Nodes/SelectedBackground",
-                              QColor(0xff,0xff,0xcc) // light yellow
-                              ).value<QColor>();
-    }
-    else
+    if(!selected)
     {
-        switch(itemState())
-        {
-        case GraphItem_New:
-            ret = settings.value("GraphView/Nodes/Borders/ColourNew",
-                                 QColor(0xcd,0xff,0xc6,0xaa) // green
-                                 ).value<QColor>();
-            break;
-        case GraphItem_Deleted:
-        case GraphItem_Invalid:
-            ret = settings.value("GraphView/Nodes/Borders/ColourDeleted",
-                                 QColor(0xff,0xaa,0xaa,0x55) // light red
-                                 ).value<QColor>();
-            break;
-        case GraphItem_Normal:
-        default:
-            ret = settings.value("GraphView/Nodes/Background",
-                                 QColor(0xcc,0xcc,0xff) // light blue
-                                 ).value<QColor>();
-            break;
-        }
-
         // Is this a hover-ed node or a marked node? If yes, lighten or darken the
         // colour as appropriate
         if(_hover && !_marked)
@@ -404,74 +382,52 @@ QColor NodeItem::backgroundColor(const QStyleOptionGraphicsItem *option) const
             ret = ret.darker(110);
     }
 
-
     return ret;
 }
 
 QColor NodeItem::borderColor(const QStyleOptionGraphicsItem *option) const
 {
-    QSettings settings;
+    return GraphViewStyle::instance()->nodeBorderColour(
+                itemState(), option->state & QStyle::State_Selected, _hover);
+}
 
-    if(option->state & QStyle::State_Selected)
-    {
-        return settings.value("GraphView/Nodes/Borders/SelectedColour",
-                              QColor(0xff,0xff,0x66) // yellow
-                              ).value<QColor>();
-    }
-    else
+void NodeItem::positionChanged()
+{
+    if(_node != 0)
+        _node->setPos(pos());
+}
+
+void NodeItem::syncNode()
+{
+    // Changes made through this item have already been applied, so this only
+    // does anything when the node was edited directly
+    if(_node->id() != id())
+        GraphItem::setId(_node->id());
+
+    QString nodeLabel = _node->label().toString();
+    bool geometryChanged = (nodeLabel != label() || _node->isRoot() != _isRoot);
+    _label = nodeLabel;
+    _isRoot = _node->isRoot();
+    _marked = _node->marked();
+
+    if(_node->isPhantomNode())
+        setItemState(GraphItem_Deleted);
+    else if(itemState() == GraphItem_Deleted)
+        setItemState(GraphItem_Normal);
+
+    if(geometryChanged)
     {
-        if(_hover)
-        {
-            switch(itemState())
-            {
-            case GraphItem_New:
-                return settings.value("GraphView/Nodes/Borders/HoverColourNew",
-                                      QColor(0xcc,0xff,0xcc) // light green
-                                      ).value<QColor>();
-            case GraphItem_Deleted:
-            case GraphItem_Invalid:
-                return settings.value("GraphView/Nodes/Borders/HoverColourDeleted",
-                                      QColor(0xff,0xaa,0xaa,0x55) // light red
-                                      ).value<QColor>();
-            case GraphItem_Normal:
-            default:
-                return settings.value("GraphView/Nodes/Borders/HoverColour",
-                                      QColor(0xcc,0xcc,0xff) // blue
-                                      ).value<QColor>();
-            }
-
-        }
-        else
-        {
-            switch(itemState())
-            {
-            case GraphItem_New:
-                return settings.value("GraphView/Nodes/Borders/HoverColourNew",
-                                      QColor(0xaa,0xff,0xaa) // green
-                                      ).value<QColor>();
-            case GraphItem_Deleted:
-            case GraphItem_Invalid:
-                return settings.value("GraphView/Nodes/Borders/HoverColourDeleted",
-                                      QColor(0xff,0x8f,0x8f,0x55) // red
-                                      ).value<QColor>();
-            case GraphItem_Normal:
-            default:
-                return settings.value("GraphView/Nodes/Borders/Colour",
-                                      QColor(0xaa,0xaa,0xff) // blue
-                                      ).value<QColor>();
-            }
-
-        }
+        prepareGeometryChange();
+        recalculate();
     }
 
-    // Shouldn't happen
-    return QColor();
+    update();
 }
 
-void NodeItem::positionChanged()
+void NodeItem::syncPosition(const QPointF &position)
 {
-    if(_node != 0)
-        _node->setPos(pos());
+    if(position != pos())
+        setPos(position);
 }
 
 void NodeItem::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
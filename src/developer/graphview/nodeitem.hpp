@@ -52,6 +52,15 @@ public:
     bool marked() const;
     Node *node() const;
 
+    /*!
+     * \brief Rebind this item to a different node, taking its ID, label and
+     *  flags
+     *
+     * This allows a virtualised GraphScene to reuse items rather than create
+     * new ones as the view scrolls. The item's position is left to the caller.
+     */
+    void setNode(Node *node);
+
     void setId(const QString &itemId);
     void setLabel(const QString &itemLabel);
     void setIsRoot(bool root);
@@ -76,6 +85,8 @@ public slots:
 
 protected slots:
     void positionChanged();
+    void syncNode();
+    void syncPosition(const QPointF &position);
 
 signals:
     void edgeAdded();
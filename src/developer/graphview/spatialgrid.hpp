@@ -0,0 +1,226 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SPATIALGRID_HPP
+#define SPATIALGRID_HPP
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QRectF>
+#include <QSet>
+#include <QVector>
+
+#include <cmath>
+
+namespace Developer {
+
+/*!
+ * \brief The SpatialGrid class is a uniform grid index over values placed at
+ *  rectangles in the scene
+ *
+ * The scene is divided into square cells of a fixed size and each value is
+ * listed in every cell its rectangle touches. Queries visit only the cells
+ * under the query rectangle, so their cost depends on the area asked about
+ * rather than the number of values in the grid. Only occupied cells are
+ * stored.
+ *
+ * The grid does not keep the rectangles themselves, so the same rectangle
+ * must be passed to remove() as was passed to insert(), and rectangles should
+ * have a non-zero size so that they count towards bounds(). Query results are
+ * candidates: every value whose rectangle intersects the query is returned,
+ * along with possibly some in the same cells which do not.
+ *
+ * T must be usable as a QSet member, pointers are the intended use.
+ */
+template <class T>
+class SpatialGrid
+{
+public:
+    explicit SpatialGrid(qreal cellSize = 256.0)
+        : _cellSize(cellSize)
+        , _count(0)
+    {
+    }
+
+    qreal cellSize() const
+    {
+        return _cellSize;
+    }
+
+    //! The number of values in the grid
+    int count() const
+    {
+        return _count;
+    }
+
+    /*!
+     * \brief Get the union of every rectangle inserted since the grid was
+     *  last cleared
+     *
+     * This does not shrink when values are removed.
+     */
+    QRectF bounds() const
+    {
+        return _bounds;
+    }
+
+    void clear()
+    {
+        _cells.clear();
+        _count = 0;
+        _bounds = QRectF();
+    }
+
+    void reserve(int cellCount)
+    {
+        _cells.reserve(cellCount);
+    }
+
+    void insert(const T &value, const QRectF &rect)
+    {
+        int left, top, right, bottom;
+        cellRange(rect, &left, &top, &right, &bottom);
+        for(int y = top; y <= bottom; ++y)
+            for(int x = left; x <= right; ++x)
+                _cells[Cell(x, y)].append(value);
+
+        _bounds = _bounds.isNull() ? rect : _bounds.united(rect);
+        ++_count;
+    }
+
+    void remove(const T &value, const QRectF &rect)
+    {
+        int left, top, right, bottom;
+        cellRange(rect, &left, &top, &right, &bottom);
+        bool found = false;
+        for(int y = top; y <= bottom; ++y)
+        {
+            for(int x = left; x <= right; ++x)
+            {
+                typename QHash<Cell, QVector<T> >::iterator cell
+                        = _cells.find(Cell(x, y));
+                if(cell == _cells.end())
+                    continue;
+
+                QVector<T> &values = cell.value();
+                int index = values.indexOf(value);
+                if(index < 0)
+                    continue;
+
+                // Order within a cell does not matter, swap in the last value
+                values[index] = values.last();
+                values.pop_back();
+                if(values.isEmpty())
+                    _cells.erase(cell);
+                found = true;
+            }
+        }
+
+        if(found)
+            --_count;
+    }
+
+    void move(const T &value, const QRectF &oldRect, const QRectF &newRect)
+    {
+        remove(value, oldRect);
+        insert(value, newRect);
+    }
+
+    /*!
+     * \brief Get the values in the cells touched by the provided rectangle,
+     *  each value is returned once
+     */
+    QList<T> query(const QRectF &rect) const
+    {
+        QList<T> result;
+        if(_cells.isEmpty())
+            return result;
+
+        // Clamp to the occupied area so that a query for a huge rectangle does
+        // not walk millions of empty cells
+        QRectF area = rect.normalized();
+        if(area.width() > 0 && area.height() > 0)
+        {
+            area = area.intersected(_bounds.adjusted(-_cellSize, -_cellSize,
+                                                     _cellSize, _cellSize));
+            if(area.isEmpty())
+                return result;
+        }
+
+        int left, top, right, bottom;
+        cellRange(area, &left, &top, &right, &bottom);
+
+        // A value spanning several cells is listed in each of them
+        bool single = (left == right && top == bottom);
+        QSet<T> seen;
+        for(int y = top; y <= bottom; ++y)
+        {
+            for(int x = left; x <= right; ++x)
+            {
+                typename QHash<Cell, QVector<T> >::const_iterator cell
+                        = _cells.constFind(Cell(x, y));
+                if(cell == _cells.constEnd())
+                    continue;
+
+                const QVector<T> &values = cell.value();
+                for(int i = 0; i < values.size(); ++i)
+                {
+                    if(single)
+                        result.append(values.at(i));
+                    else if(!seen.contains(values.at(i)))
+                    {
+                        seen.insert(values.at(i));
+                        result.append(values.at(i));
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+    QList<T> query(const QPointF &point) const
+    {
+        return query(QRectF(point, QSizeF(0, 0)));
+    }
+
+private:
+    typedef QPair<int, int> Cell;
+
+    void cellRange(const QRectF &rect, int *left, int *top, int *right,
+                   int *bottom) const
+    {
+        QRectF r = rect.normalized();
+        *left = static_cast<int>(std::floor(r.left() / _cellSize));
+        *top = static_cast<int>(std::floor(r.top() / _cellSize));
+        *right = static_cast<int>(std::floor(r.right() / _cellSize));
+        *bottom = static_cast<int>(std::floor(r.bottom() / _cellSize));
+    }
+
+    qreal _cellSize;
+    int _count;
+    QRectF _bounds;
+    QHash<Cell, QVector<T> > _cells;
+};
+
+}
+
+#endif // SPATIALGRID_HPP
@@ -0,0 +1,111 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "tilecache.hpp"
+
+#include <QList>
+
+namespace Developer {
+
+namespace {
+
+/*!
+ * \brief The number of zoom levels per unit of view scale, fine enough that
+ *  the rounding moves the far edge of a large view by well under a pixel
+ */
+const int ZOOM_PRECISION = 65536;
+
+}
+
+TileKey::TileKey(int zoomLevel, int tileX, int tileY)
+    : zoom(zoomLevel)
+    , x(tileX)
+    , y(tileY)
+{
+}
+
+bool TileKey::operator==(const TileKey &other) const
+{
+    return zoom == other.zoom && x == other.x && y == other.y;
+}
+
+uint qHash(const TileKey &key)
+{
+    return uint(key.zoom) ^ (uint(key.x) << 16) ^ (uint(key.x) >> 16)
+            ^ uint(key.y);
+}
+
+TileCache::TileCache(int tileSize, int maxKilobytes)
+    : _tileSize(tileSize)
+    , _tiles(maxKilobytes)
+{
+}
+
+int TileCache::tileSize() const
+{
+    return _tileSize;
+}
+
+int TileCache::zoomLevel(qreal scale)
+{
+    return qMax(qRound(scale * ZOOM_PRECISION), 1);
+}
+
+qreal TileCache::scale(int zoomLevel)
+{
+    return qreal(zoomLevel) / ZOOM_PRECISION;
+}
+
+QRectF TileCache::sceneRect(const TileKey &key) const
+{
+    qreal size = _tileSize / scale(key.zoom);
+    return QRectF(key.x * size, key.y * size, size, size);
+}
+
+QPixmap *TileCache::tile(const TileKey &key) const
+{
+    return _tiles.object(key);
+}
+
+void TileCache::insert(const TileKey &key, const QPixmap &pixmap)
+{
+    int cost = pixmap.width() * pixmap.height() * pixmap.depth() / 8192;
+    _tiles.insert(key, new QPixmap(pixmap), qMax(cost, 1));
+}
+
+void TileCache::invalidate(const QRectF &rect)
+{
+    QList<TileKey> keys = _tiles.keys();
+    for(int i = 0; i < keys.size(); ++i)
+    {
+        // Antialiasing can reach a pixel beyond the changed area
+        qreal pixel = 1.0 / scale(keys.at(i).zoom);
+        QRectF changed = rect.adjusted(-pixel, -pixel, pixel, pixel);
+        if(changed.intersects(sceneRect(keys.at(i))))
+            _tiles.remove(keys.at(i));
+    }
+}
+
+void TileCache::clear()
+{
+    _tiles.clear();
+}
+
+}
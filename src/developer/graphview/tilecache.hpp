@@ -0,0 +1,86 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TILECACHE_HPP
+#define TILECACHE_HPP
+
+#include <QCache>
+#include <QPixmap>
+#include <QRectF>
+
+#include "global.hpp"
+
+namespace Developer {
+
+/*!
+ * \brief Identifies one tile of a TileCache
+ */
+struct TileKey
+{
+    TileKey(int zoomLevel = 0, int tileX = 0, int tileY = 0);
+
+    bool operator==(const TileKey &other) const;
+
+    //! The zoom level the tile was rendered at, see TileCache::zoomLevel()
+    int zoom;
+    //! The column of the tile, counted from the scene origin
+    int x;
+    //! The row of the tile, counted from the scene origin
+    int y;
+};
+
+uint qHash(const TileKey &key);
+
+/*!
+ * \brief The TileCache class holds square pixmaps of a scene rendered at one
+ *  or more zoom levels
+ *
+ * At each zoom level the scene is cut into tiles of tileSize() pixels from the
+ * scene origin, so scrolling a view only changes which tiles are visible and
+ * where they are drawn, never their contents. Zoom levels are the view scale
+ * rounded to a fixed precision, so returning to an earlier zoom finds the
+ * tiles from last time. The least recently used tiles are dropped once the
+ * cache reaches its size limit.
+ */
+class TileCache
+{
+public:
+    explicit TileCache(int tileSize = GRAPH_TILE_SIZE,
+                       int maxKilobytes = GRAPH_TILE_CACHE_SIZE);
+
+    int tileSize() const;
+
+    static int zoomLevel(qreal scale);
+    static qreal scale(int zoomLevel);
+    QRectF sceneRect(const TileKey &key) const;
+
+    QPixmap *tile(const TileKey &key) const;
+    void insert(const TileKey &key, const QPixmap &pixmap);
+    void invalidate(const QRectF &rect);
+    void clear();
+
+private:
+    int _tileSize;
+    QCache<TileKey, QPixmap> _tiles;
+};
+
+}
+
+#endif // TILECACHE_HPP
@@ -0,0 +1,293 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "lexer.hpp"
+#include "programtokens.hpp"
+#include "conditiontokens.hpp"
+
+namespace Developer {
+
+// Character classes for the ASCII range, anything outside of it only counts as
+// whitespace (checked through QChar) and never as part of an identifier
+enum CharacterClasses
+{
+    ___ = 0x0,
+    Ltr = 0x1,
+    Dgt = 0x2,
+    Usc = 0x4,
+    Spc = 0x8
+};
+
+static const unsigned char characterClasses[128] = {
+    ___, ___, ___, ___, ___, ___, ___, ___,
+    ___, Spc, Spc, Spc, Spc, Spc, ___, ___,
+    ___, ___, ___, ___, ___, ___, ___, ___,
+    ___, ___, ___, ___, ___, ___, ___, ___,
+    Spc, ___, ___, ___, ___, ___, ___, ___,
+    ___, ___, ___, ___, ___, ___, ___, ___,
+    Dgt, Dgt, Dgt, Dgt, Dgt, Dgt, Dgt, Dgt,
+    Dgt, Dgt, ___, ___, ___, ___, ___, ___,
+    ___, Ltr, Ltr, Ltr, Ltr, Ltr, Ltr, Ltr,
+    Ltr, Ltr, Ltr, Ltr, Ltr, Ltr, Ltr, Ltr,
+    Ltr, Ltr, Ltr, Ltr, Ltr, Ltr, Ltr, Ltr,
+    Ltr, Ltr, Ltr, ___, ___, ___, ___, Usc,
+    ___, Ltr, Ltr, Ltr, Ltr, Ltr, Ltr, Ltr,
+    Ltr, Ltr, Ltr, Ltr, Ltr, Ltr, Ltr, Ltr,
+    Ltr, Ltr, Ltr, Ltr, Ltr, Ltr, Ltr, Ltr,
+    Ltr, Ltr, Ltr, ___, ___, ___, ___, ___
+};
+
+static const LexerTableEntry programSymbols[] = {
+    { "/*", ProgramLexeme_CommentOpen },
+    { "*/", ProgramLexeme_CommentClose },
+    { "=", ProgramLexeme_DeclarationOperator },
+    { ".", ProgramLexeme_DeclarationSeparator },
+    { "(", ProgramLexeme_OpenParen },
+    { ")", ProgramLexeme_CloseParen },
+    { "{", ProgramLexeme_OpenBrace },
+    { "}", ProgramLexeme_CloseBrace },
+    { "!", ProgramLexeme_Repeat },
+    { ";", ProgramLexeme_StatementSeparator },
+    { ",", ProgramLexeme_RuleSeparator }
+};
+
+static const LexerTableEntry programKeywords[] = {
+    { "main", ProgramLexeme_Keyword },
+    { "if", ProgramLexeme_Keyword },
+    { "try", ProgramLexeme_Keyword },
+    { "then", ProgramLexeme_Keyword },
+    { "else", ProgramLexeme_Keyword },
+    { "skip", ProgramLexeme_Keyword },
+    { "fail", ProgramLexeme_Keyword },
+    { "or", ProgramLexeme_Keyword }
+};
+
+const LexerLanguage ProgramLanguage = {
+    programSymbols, sizeof(programSymbols) / sizeof(LexerTableEntry),
+    programKeywords, sizeof(programKeywords) / sizeof(LexerTableEntry),
+    ProgramLexeme_Identifier,
+    -1,
+    -1,
+    -1,
+    ProgramLexeme_CommentOpen,
+    ProgramLexeme_CommentClose
+};
+
+static const LexerTableEntry conditionSymbols[] = {
+    { ":", ListSeparator },
+    { ",", Comma },
+    { "(", OpeningParen },
+    { ")", ClosingParen },
+    { "-", Negation },
+    { "-", Minus },
+    { "+", Plus },
+    { "*", Times },
+    { "/", Divide },
+    { "/*", ConditionLexeme_CommentOpen },
+    { "*/", ConditionLexeme_CommentClose },
+    { "<", LessThan },
+    { "<=", LessThanEqualTo },
+    { ">", GreaterThan },
+    { ">=", GreaterThanEqualTo },
+    { "=", Equals },
+    { "!=", NotEquals }
+};
+
+static const LexerTableEntry conditionKeywords[] = {
+    { "empty", Empty },
+    { "indeg", DegreeTest },
+    { "outdeg", DegreeTest },
+    { "not", Not },
+    { "edge", EdgeTest },
+    { "and", And },
+    { "or", Or }
+};
+
+const LexerLanguage ConditionLanguage = {
+    conditionSymbols, sizeof(conditionSymbols) / sizeof(LexerTableEntry),
+    conditionKeywords, sizeof(conditionKeywords) / sizeof(LexerTableEntry),
+    Variable,
+    GraphLexeme,
+    Integer,
+    QuotedString,
+    ConditionLexeme_CommentOpen,
+    ConditionLexeme_CommentClose
+};
+
+static inline int characterClass(QChar c)
+{
+    ushort u = c.unicode();
+    if(u < 128)
+        return characterClasses[u];
+    return c.isSpace() ? Spc : ___;
+}
+
+Lexer::Lexer(const LexerLanguage &language)
+    : _language(language)
+{
+}
+
+int Lexer::match(const QString &text, int pos, int *lexeme, int hint) const
+{
+    *lexeme = -1;
+    if(pos < 0 || pos >= text.length())
+        return 0;
+
+    const QChar *data = text.constData() + pos;
+    int remaining = text.length() - pos;
+    int best = -1;
+    int bestLength = 0;
+
+    // Fixed symbols
+    for(int i = 0; i < _language.symbolCount; ++i)
+    {
+        int length = matchEntry(data, remaining, _language.symbols[i]);
+        consider(_language.symbols[i].lexeme, length, hint, &best, &bestLength);
+    }
+
+    // Identifiers, graph identifiers, keywords and integers all start from the
+    // same run of word characters
+    int first = characterClass(data[0]);
+    int wordLength = 0;
+    while(wordLength < remaining
+          && (characterClass(data[wordLength]) & (Ltr | Dgt | Usc)))
+        ++wordLength;
+
+    if(wordLength > 0)
+    {
+        int capped = qMin(wordLength, static_cast<int>(MaxIdentifierLength));
+
+        if(_language.wordLexeme >= 0)
+            consider(_language.wordLexeme, capped, hint, &best, &bestLength);
+
+        if(_language.identifierLexeme >= 0 && !(first & Dgt))
+        {
+            // Keywords replace the identifier when they make up the whole word
+            int identifier = _language.identifierLexeme;
+            for(int i = 0; i < _language.keywordCount; ++i)
+            {
+                if(matchEntry(data, wordLength, _language.keywords[i])
+                        == wordLength)
+                {
+                    identifier = _language.keywords[i].lexeme;
+                    break;
+                }
+            }
+            consider(identifier, capped, hint, &best, &bestLength);
+        }
+
+        if(_language.integerLexeme >= 0 && (first & Dgt))
+        {
+            int length = 0;
+            while(length < remaining && (characterClass(data[length]) & Dgt))
+                ++length;
+            consider(_language.integerLexeme, length, hint, &best, &bestLength);
+        }
+    }
+
+    // Quoted strings, which must be closed to match
+    if(_language.stringLexeme >= 0 && data[0] == QLatin1Char('"'))
+    {
+        int length = 1;
+        while(length < remaining && data[length] != QLatin1Char('"'))
+            ++length;
+        if(length < remaining)
+            consider(_language.stringLexeme, length + 1, hint, &best,
+                     &bestLength);
+    }
+
+    *lexeme = best;
+    return bestLength;
+}
+
+int Lexer::matchIdentifier(const QString &text, int pos) const
+{
+    if(pos < 0 || pos >= text.length())
+        return 0;
+
+    const QChar *data = text.constData() + pos;
+    int remaining = qMin(text.length() - pos,
+                         static_cast<int>(MaxIdentifierLength));
+    if(!(characterClass(data[0]) & (Ltr | Usc)))
+        return 0;
+
+    int length = 1;
+    while(length < remaining
+          && (characterClass(data[length]) & (Ltr | Dgt | Usc)))
+        ++length;
+    return length;
+}
+
+int Lexer::skipWhitespace(const QString &text, int pos) const
+{
+    while(pos < text.length() && (characterClass(text.at(pos)) & Spc))
+        ++pos;
+    return pos;
+}
+
+int Lexer::findCommentClose(const QString &text, int pos) const
+{
+    const QChar *data = text.constData();
+    for(int i = pos; i + 1 < text.length(); ++i)
+    {
+        if(data[i] == QLatin1Char('*') && data[i+1] == QLatin1Char('/'))
+            return i + 2;
+    }
+
+    return -1;
+}
+
+const LexerLanguage &Lexer::language() const
+{
+    return _language;
+}
+
+void Lexer::consider(int lexeme, int length, int hint, int *best,
+                     int *bestLength) const
+{
+    if(length <= 0 || length < *bestLength)
+        return;
+
+    if(length == *bestLength)
+    {
+        // Break ties in favour of the hint, then the earliest enumerator
+        if(*best == hint || (lexeme != hint && lexeme > *best))
+            return;
+    }
+
+    *best = lexeme;
+    *bestLength = length;
+}
+
+int Lexer::matchEntry(const QChar *data, int remaining,
+                      const LexerTableEntry &entry) const
+{
+    int length = 0;
+    while(entry.text[length] != '\0')
+    {
+        if(length >= remaining || data[length] != QLatin1Char(entry.text[length]))
+            return 0;
+        ++length;
+    }
+
+    return length;
+}
+
+}
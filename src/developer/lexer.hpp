@@ -0,0 +1,161 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LEXER_HPP
+#define LEXER_HPP
+
+#include <QString>
+
+namespace Developer {
+
+/*!
+ * \brief The LexerTableEntry struct maps a fixed piece of text onto a lexeme
+ */
+struct LexerTableEntry
+{
+    //! The text to match, this is always plain ASCII
+    const char *text;
+    //! The lexeme produced, a value from the language's lexeme enum
+    int lexeme;
+};
+
+/*!
+ * \brief The LexerLanguage struct describes a language to the Lexer
+ *
+ * Each language is a static table of fixed symbols (operators, brackets and so
+ * on), a table of keywords, and the lexemes to use for each of the classes of
+ * variable-length token. A class which the language does not use is set to -1.
+ *
+ * The tables for the program and condition languages are defined in lexer.cpp
+ * in terms of the ProgramLexemes and ConditionLexemes enums.
+ */
+struct LexerLanguage
+{
+    //! Fixed symbols, matched anywhere
+    const LexerTableEntry *symbols;
+    //! The number of entries in symbols
+    int symbolCount;
+    //! Keywords, only matched against a whole identifier
+    const LexerTableEntry *keywords;
+    //! The number of entries in keywords
+    int keywordCount;
+    //! Lexeme for identifiers: [a-zA-Z_][a-zA-Z0-9_]{,62}
+    int identifierLexeme;
+    //! Lexeme for graph identifiers: [a-zA-Z0-9_]{1,63}
+    int wordLexeme;
+    //! Lexeme for integers: [0-9]+
+    int integerLexeme;
+    //! Lexeme for quoted strings: "[^"]*"
+    int stringLexeme;
+    //! Lexeme which opens a comment, this must also be in the symbol table
+    int commentOpenLexeme;
+    //! Lexeme which closes a comment, this must also be in the symbol table
+    int commentCloseLexeme;
+};
+
+//! The lexer table for GP programs, producing ProgramLexemes values
+extern const LexerLanguage ProgramLanguage;
+//! The lexer table for rule conditions, producing ConditionLexemes values
+extern const LexerLanguage ConditionLanguage;
+
+/*!
+ * \brief The Lexer class provides a table-driven maximal-munch lexer shared by
+ *  the code editors and anything else which needs to tokenise GP source
+ *
+ * Previously each editor built a QRegExp for every lexeme it tried, and tried
+ * each pattern in turn at every position. This class instead classifies
+ * characters through a static table and matches the symbol and keyword tables
+ * of the language directly against the text. Nothing is allocated while
+ * matching, the caller receives the lexeme and the length of the match and
+ * decides what (if anything) to build from it.
+ *
+ * When several lexemes match the same longest run of text the hint passed to
+ * match() wins if it is one of them, otherwise the lowest enumerator value
+ * wins. This matches the order in which the editors used to try patterns, so
+ * for example "empty" lexes as Empty rather than Variable unless the caller
+ * asks for a GraphLexeme.
+ */
+class Lexer
+{
+public:
+    /*!
+     * \brief Construct a lexer for the provided language
+     * \param language  The language tables to use, usually ProgramLanguage or
+     *  ConditionLanguage
+     */
+    explicit Lexer(const LexerLanguage &language);
+
+    //! The maximum length of an identifier in GP
+    static const int MaxIdentifierLength = 63;
+
+    /*!
+     * \brief Find the longest lexeme at a position in the text
+     *
+     * Whitespace is not skipped, see skipWhitespace().
+     *
+     * \param text      The text to match against
+     * \param pos       The position to match at
+     * \param lexeme    Output for the lexeme matched, -1 if there is no match
+     * \param hint      The lexeme to prefer when several match equally well
+     * \return The length of the match, 0 if nothing matched
+     */
+    int match(const QString &text, int pos, int *lexeme, int hint = -1) const;
+
+    /*!
+     * \brief Get the length of the identifier at a position in the text
+     * \param text  The text to match against
+     * \param pos   The position to match at
+     * \return The length of the identifier, 0 if there is no identifier here
+     */
+    int matchIdentifier(const QString &text, int pos) const;
+
+    /*!
+     * \brief Skip over any whitespace at a position in the text
+     * \param text  The text to scan
+     * \param pos   The position to start at
+     * \return The position of the first non-whitespace character, or the
+     *  length of the text if there is none
+     */
+    int skipWhitespace(const QString &text, int pos) const;
+
+    /*!
+     * \brief Find the end of a comment
+     * \param text  The text to scan
+     * \param pos   A position inside the comment, after the opening symbol
+     * \return The position immediately after the closing symbol, or -1 if the
+     *  comment is not closed within the text
+     */
+    int findCommentClose(const QString &text, int pos) const;
+
+    //! The language this lexer was constructed with
+    const LexerLanguage &language() const;
+
+private:
+    void consider(int lexeme, int length, int hint, int *best,
+                  int *bestLength) const;
+    int matchEntry(const QChar *data, int remaining,
+                   const LexerTableEntry &entry) const;
+
+    const LexerLanguage &_language;
+};
+
+}
+
+#endif // LEXER_HPP
@@ -20,15 +20,27 @@
  */
 #include <QApplication>
 #include "mainwindow.hpp"
+#include "graphview/graphrenderer.hpp"
 
 int main(int argc, char *argv[])
 {
+    // Batch rendering needs no display, under Qt 5 it runs on the offscreen
+    // platform unless another has been asked for
+    bool render = (argc > 1 && QString(argv[1]) == "--render");
+    if(render && qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
     QApplication a(argc, argv);
 
     a.setOrganizationName("UoYCS");
     a.setOrganizationDomain("www.cs.york.ac.uk");
     a.setApplicationName("GP Developer");
 
+    // The organisation and application names are needed first so that the
+    // user's graph style is used
+    if(render)
+        return Developer::renderGraphs(a.arguments().mid(2));
+
     Developer::MainWindow w;
     w.show();
     
@@ -21,9 +21,6 @@
 #include "mainwindow.hpp"
 #include "ui_mainwindow.h"
 
-// We need OGDF's exceptions header to catch precondition errors
-#include <ogdf/basic/basic.h>
-
 // Include main page elements
 #include "welcome.hpp"
 #include "edit.hpp"
@@ -45,11 +42,16 @@
 #include "preferences/preferencesdialog.hpp"
 #include "helpdialog.hpp"
 #include "aboutdialog.hpp"
+#include "symbolindex.hpp"
+#include "findreplacedialog.hpp"
+#include "projectvalidator.hpp"
 
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QSettings>
 #include <QCloseEvent>
 #include <QMessageBox>
+#include <QProgressDialog>
 #include <QUndoStack>
 #include <QtSvg/QSvgGenerator>
 
@@ -514,75 +516,187 @@ void MainWindow::selectAll()
 
 void MainWindow::findReplaceCurrentFile()
 {
-    // find replace in current file
+    if(_activeProject == 0 || _activeProject->currentFile() == 0)
+        return;
+
+    FindReplaceDialog dialog(_activeProject, _activeProject->currentFile(),
+                             this);
+    dialog.exec();
 }
 
 void MainWindow::findReplaceProject()
 {
-    // find replace in this project
+    if(_activeProject == 0)
+        return;
+
+    FindReplaceDialog dialog(_activeProject, 0, this);
+    dialog.exec();
 }
 
-void MainWindow::layoutTreeTopToBottom()
+void MainWindow::findReferences()
 {
-    if(_currentGraph == 0)
+    if(_activeProject == 0)
         return;
 
-    try
+    QString symbol = QInputDialog::getText(this, tr("Find References"),
+                                           tr("Rule or macro name:"));
+    if(symbol.isEmpty())
+        return;
+
+    QVector<SymbolReference> references =
+            _activeProject->symbolIndex()->references(symbol);
+    if(references.isEmpty())
     {
-        _currentGraph->layoutTree(Layout_TopToBottom);
+        QMessageBox::information(this, tr("Find References"),
+                                 tr("No references to '%1' were found.").arg(
+                                     symbol));
+        return;
     }
-    catch(ogdf::Exception e)
+
+    QStringList lines;
+    for(int i = 0; i < references.size(); ++i)
     {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
+        const SymbolReference &reference = references.at(i);
+        QString file = QFileInfo(reference.filePath).fileName();
+        switch(reference.type)
+        {
+        case SymbolReference_RuleDefinition:
+            lines << tr("%1: rule definition").arg(file);
+            break;
+        case SymbolReference_MacroDefinition:
+        case SymbolReference_Use:
+        default:
+        {
+            // Report the line the reference is on rather than the offset
+            int line = 1;
+            QVector<Program *> programs = _activeProject->programs();
+            for(int j = 0; j < programs.size(); ++j)
+            {
+                Program *program = programs.at(j);
+                if(program->path() == reference.filePath)
+                {
+                    line += program->program().left(
+                                reference.startPos).count('\n');
+                    break;
+                }
+            }
+            lines << ((reference.type == SymbolReference_Use)
+                      ? tr("%1:%2: used").arg(file).arg(line)
+                      : tr("%1:%2: macro definition").arg(file).arg(line));
+            break;
+        }
+        }
     }
+
+    QMessageBox::information(this, tr("Find References"),
+                             tr("References to '%1':\n\n%2").arg(
+                                 symbol, lines.join("\n")));
 }
 
-void MainWindow::layoutTreeRightToLeft()
+void MainWindow::renameSymbol()
 {
-    if(_currentGraph == 0)
+    if(_activeProject == 0)
         return;
 
-    try
+    SymbolIndex *index = _activeProject->symbolIndex();
+    QString symbol = QInputDialog::getText(this, tr("Rename Rule or Macro"),
+                                           tr("Rule or macro to rename:"));
+    if(symbol.isEmpty())
+        return;
+
+    if(!index->contains(symbol))
     {
-        _currentGraph->layoutTree(Layout_RightToLeft);
+        QMessageBox::information(this, tr("Rename Rule or Macro"),
+                                 tr("No references to '%1' were found.").arg(
+                                     symbol));
+        return;
     }
-    catch(ogdf::Exception e)
+
+    QString replacement = QInputDialog::getText(
+                this, tr("Rename Rule or Macro"),
+                tr("Rename '%1' to:").arg(symbol), QLineEdit::Normal, symbol);
+    if(replacement.isEmpty() || replacement == symbol)
+        return;
+
+    int renamed = index->rename(symbol, replacement);
+    if(renamed == SymbolRename_InvalidIdentifier)
     {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
+        QMessageBox::warning(this, tr("Rename Rule or Macro"),
+                             tr("'%1' is not a valid identifier.").arg(
+                                 replacement));
+        return;
     }
+    if(renamed == SymbolRename_AlreadyDefined)
+    {
+        QMessageBox::warning(this, tr("Rename Rule or Macro"),
+                             tr("A rule or macro named '%1' already "
+                                "exists.").arg(replacement));
+        return;
+    }
+
+    statusBar()->showMessage(tr("Renamed %1 references to '%2'.").arg(
+                                 renamed).arg(symbol));
 }
 
-void MainWindow::layoutTreeBottomToTop()
+void MainWindow::validateProject()
 {
-    if(_currentGraph == 0)
+    if(_activeProject == 0)
         return;
 
-    try
+    ProjectValidator *validator = _activeProject->validator();
+    QVector<ValidationIssue> issues = validator->validate();
+    statusBar()->showMessage(tr("Validated project, %1 files checked.").arg(
+                                 validator->checkedCount()));
+
+    if(issues.isEmpty())
     {
-        _currentGraph->layoutTree(Layout_BottomToTop);
+        QMessageBox::information(this, tr("Validate Project"),
+                                 tr("No problems were found."));
+        return;
     }
-    catch(ogdf::Exception e)
+
+    QStringList lines;
+    for(int i = 0; i < issues.size(); ++i)
     {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
+        const ValidationIssue &issue = issues.at(i);
+        QString file = QFileInfo(issue.filePath).fileName();
+        if(issue.line > 0)
+            lines << tr("%1:%2: %3").arg(file).arg(issue.line).arg(
+                         issue.message);
+        else
+            lines << tr("%1: %2").arg(file, issue.message);
     }
+
+    QMessageBox::warning(this, tr("Validate Project"),
+                         tr("%1 problems were found:\n\n%2").arg(
+                             issues.size()).arg(lines.join("\n")));
+}
+
+void MainWindow::layoutTreeTopToBottom()
+{
+    if(_currentGraph == 0)
+        return;
+
+    _currentGraph->layoutTree(Layout_TopToBottom);
+    watchLayout(_currentGraph->graphScene());
+}
+
+void MainWindow::layoutTreeRightToLeft()
+{
+    if(_currentGraph == 0)
+        return;
+
+    _currentGraph->layoutTree(Layout_RightToLeft);
+    watchLayout(_currentGraph->graphScene());
+}
+
+void MainWindow::layoutTreeBottomToTop()
+{
+    if(_currentGraph == 0)
+        return;
+
+    _currentGraph->layoutTree(Layout_BottomToTop);
+    watchLayout(_currentGraph->graphScene());
 }
 
 void MainWindow::layoutTreeLeftToRight()
@@ -590,20 +704,8 @@ void MainWindow::layoutTreeLeftToRight()
     if(_currentGraph == 0)
         return;
 
-    try
-    {
-        _currentGraph->layoutTree(Layout_LeftToRight);
-    }
-    catch(ogdf::Exception e)
-    {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
-    }
+    _currentGraph->layoutTree(Layout_LeftToRight);
+    watchLayout(_currentGraph->graphScene());
 }
 
 void MainWindow::layoutRadialTree()
@@ -611,20 +713,8 @@ void MainWindow::layoutRadialTree()
     if(_currentGraph == 0)
         return;
 
-    try
-    {
-        _currentGraph->layoutRadialTree();
-    }
-    catch(ogdf::Exception e)
-    {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
-    }
+    _currentGraph->layoutRadialTree();
+    watchLayout(_currentGraph->graphScene());
 }
 
 void MainWindow::layoutSugiyama()
@@ -632,20 +722,8 @@ void MainWindow::layoutSugiyama()
     if(_currentGraph == 0)
         return;
 
-    try
-    {
-        _currentGraph->layoutSugiyama();
-    }
-    catch(ogdf::Exception e)
-    {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
-    }
+    _currentGraph->layoutSugiyama();
+    watchLayout(_currentGraph->graphScene());
 }
 
 void MainWindow::layoutFPP()
@@ -653,20 +731,8 @@ void MainWindow::layoutFPP()
     if(_currentGraph == 0)
         return;
 
-    try
-    {
-        _currentGraph->layoutFPP();
-    }
-    catch(ogdf::Exception e)
-    {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
-    }
+    _currentGraph->layoutFPP();
+    watchLayout(_currentGraph->graphScene());
 }
 
 void MainWindow::layoutPlanarDraw()
@@ -674,20 +740,8 @@ void MainWindow::layoutPlanarDraw()
     if(_currentGraph == 0)
         return;
 
-    try
-    {
-        _currentGraph->layoutPlanarDraw();
-    }
-    catch(ogdf::Exception e)
-    {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
-    }
+    _currentGraph->layoutPlanarDraw();
+    watchLayout(_currentGraph->graphScene());
 }
 
 void MainWindow::layoutPlanarStraight()
@@ -695,20 +749,8 @@ void MainWindow::layoutPlanarStraight()
     if(_currentGraph == 0)
         return;
 
-    try
-    {
-        _currentGraph->layoutPlanarStraight();
-    }
-    catch(ogdf::Exception e)
-    {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
-    }
+    _currentGraph->layoutPlanarStraight();
+    watchLayout(_currentGraph->graphScene());
 }
 
 void MainWindow::layoutSchnyder()
@@ -716,20 +758,8 @@ void MainWindow::layoutSchnyder()
     if(_currentGraph == 0)
         return;
 
-    try
-    {
-        _currentGraph->layoutSchnyder();
-    }
-    catch(ogdf::Exception e)
-    {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
-    }
+    _currentGraph->layoutSchnyder();
+    watchLayout(_currentGraph->graphScene());
 }
 
 void MainWindow::layoutPlanarizationGrid()
@@ -737,20 +767,8 @@ void MainWindow::layoutPlanarizationGrid()
     if(_currentGraph == 0)
         return;
 
-    try
-    {
-        _currentGraph->layoutPlanarizationGrid();
-    }
-    catch(ogdf::Exception e)
-    {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
-    }
+    _currentGraph->layoutPlanarizationGrid();
+    watchLayout(_currentGraph->graphScene());
 }
 
 void MainWindow::layoutCircular()
@@ -758,20 +776,8 @@ void MainWindow::layoutCircular()
     if(_currentGraph == 0)
         return;
 
-    try
-    {
-        _currentGraph->layoutCircular();
-    }
-    catch(ogdf::Exception e)
-    {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
-    }
+    _currentGraph->layoutCircular();
+    watchLayout(_currentGraph->graphScene());
 }
 
 void MainWindow::layoutSpring()
@@ -779,20 +785,8 @@ void MainWindow::layoutSpring()
     if(_currentGraph == 0)
         return;
 
-    try
-    {
-        _currentGraph->layoutSpring();
-    }
-    catch(ogdf::Exception e)
-    {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
-    }
+    _currentGraph->layoutSpring();
+    watchLayout(_currentGraph->graphScene());
 }
 
 void MainWindow::layoutDavidsonHarel()
@@ -800,20 +794,8 @@ void MainWindow::layoutDavidsonHarel()
     if(_currentGraph == 0)
         return;
 
-    try
-    {
-        _currentGraph->layoutDavidsonHarel();
-    }
-    catch(ogdf::Exception e)
-    {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
-    }
+    _currentGraph->layoutDavidsonHarel();
+    watchLayout(_currentGraph->graphScene());
 }
 
 void MainWindow::layoutFMMM()
@@ -821,20 +803,8 @@ void MainWindow::layoutFMMM()
     if(_currentGraph == 0)
         return;
 
-    try
-    {
-        _currentGraph->layoutFMMM();
-    }
-    catch(ogdf::Exception e)
-    {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
-    }
+    _currentGraph->layoutFMMM();
+    watchLayout(_currentGraph->graphScene());
 }
 
 void MainWindow::layoutGEM()
@@ -842,20 +812,58 @@ void MainWindow::layoutGEM()
     if(_currentGraph == 0)
         return;
 
-    try
-    {
-        _currentGraph->layoutGEM();
-    }
-    catch(ogdf::Exception e)
-    {
-        Q_UNUSED(e)
-        QMessageBox::information(
-                    this,
-                    tr("Layout Failed"),
-                    tr("The layout mechanism failed with a precondition error "
-                       "error. Ensure that the layout mechanism selected is "
-                       "appropriate for the provided graph."));
-    }
+    _currentGraph->layoutGEM();
+    watchLayout(_currentGraph->graphScene());
+}
+
+void MainWindow::layoutBarnesHut()
+{
+    if(_currentGraph == 0)
+        return;
+
+    _currentGraph->layoutBarnesHut();
+    watchLayout(_currentGraph->graphScene());
+}
+
+void MainWindow::refineLayout()
+{
+    if(_currentGraph == 0)
+        return;
+
+    _currentGraph->refineLayout();
+    watchLayout(_currentGraph->graphScene());
+}
+
+void MainWindow::bundleEdges(bool bundle)
+{
+    if(_currentGraph == 0)
+        return;
+
+    _currentGraph->graphScene()->setEdgeBundling(bundle);
+}
+
+void MainWindow::watchLayout(GraphScene *scene)
+{
+    if(!scene->layoutRunning())
+        return;
+
+    QProgressDialog *progress = new QProgressDialog(tr("Laying out graph..."),
+                                                    tr("Cancel"), 0, 100, this);
+    progress->setWindowTitle(tr("Layout"));
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(LAYOUT_PROGRESS_DELAY);
+    progress->setValue(0);
+
+    connect(scene, SIGNAL(layoutProgress(int)), progress, SLOT(setValue(int)));
+    connect(progress, SIGNAL(canceled()), scene, SLOT(cancelLayout()));
+    connect(scene, SIGNAL(layoutEnded()), progress, SLOT(deleteLater()));
+    connect(scene, SIGNAL(layoutFailed(QString)),
+            this, SLOT(layoutFailed(QString)), Qt::UniqueConnection);
+}
+
+void MainWindow::layoutFailed(QString message)
+{
+    QMessageBox::information(this, tr("Layout Failed"), message);
 }
 
 void MainWindow::exportGraphToPng()
@@ -1052,6 +1060,8 @@ void MainWindow::graphHasFocus(GraphWidget *graphWidget)
     _currentGraph = graphWidget;
     _ui->menuLayout->setEnabled(true);
     _ui->menuExport->setEnabled(true);
+    _ui->actionBundleEdges->setChecked(
+                graphWidget->graphScene()->edgeBundling());
 }
 
 void MainWindow::graphLostFocus(GraphWidget *graphWidget)
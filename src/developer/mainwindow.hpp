@@ -39,6 +39,7 @@ class Edit;
 class Run;
 class Results;
 class GraphWidget;
+class GraphScene;
 
 /*!
  * \brief The MainWindow class forms the basis of GP Developer, containing the
@@ -212,6 +213,20 @@ public slots:
     void findReplaceCurrentFile();
     void findReplaceProject();
 
+    /*!
+     * \brief List the definitions and uses of a rule or macro across the
+     *  project
+     */
+    void findReferences();
+    /*!
+     * \brief Rename a rule or macro everywhere it is used in the project
+     */
+    void renameSymbol();
+    /*!
+     * \brief Check every file in the project for problems and list them
+     */
+    void validateProject();
+
     void layoutTreeTopToBottom();
     void layoutTreeRightToLeft();
     void layoutTreeBottomToTop();
@@ -228,6 +243,17 @@ public slots:
     void layoutDavidsonHarel();
     void layoutFMMM();
     void layoutGEM();
+    void layoutBarnesHut();
+    /*!
+     * \brief Settle the nodes added or moved since the current graph was last
+     *  laid out, leaving the rest where they are
+     */
+    void refineLayout();
+    /*!
+     * \brief Draw the edges of the current graph in bundles, or straight
+     * \param bundle    Whether to bundle the edges
+     */
+    void bundleEdges(bool bundle);
 
     void exportGraphToPng();
     void exportGraphToSvg();
@@ -285,6 +311,12 @@ public slots:
     void graphHasFocus(GraphWidget *graphWidget);
     void graphLostFocus(GraphWidget *graphWidget);
 
+    /*!
+     * \brief Tell the user that a layout could not be completed
+     * \param message  The reason given by the graph scene
+     */
+    void layoutFailed(QString message);
+
 signals:
     /*!
      * \brief Signal emitted when the list of recent projects has changed
@@ -301,6 +333,16 @@ protected:
      */
     void restoreWindowDimensions();
 
+    /*!
+     * \brief Show the progress of a layout just started in the provided scene
+     *
+     * A progress dialog with a cancel button is shown if the layout takes
+     * longer than LAYOUT_PROGRESS_DELAY, and any failure is reported.
+     *
+     * \param scene The scene running the layout
+     */
+    void watchLayout(GraphScene *scene);
+
 private:
     Ui::MainWindow *_ui;
     Project *_activeProject;
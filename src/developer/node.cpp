@@ -143,7 +143,11 @@ void Node::setLabel(const List &nodeLabel)
 
 void Node::setPos(const QPointF &nodePos)
 {
+    if(nodePos == _pos)
+        return;
+
     _pos = nodePos;
+    emit posChanged(nodePos);
 }
 
 void Node::setPos(qreal x, qreal y)
@@ -75,6 +75,7 @@ signals:
     void isRootChanged(bool root);
     void markedChanged(bool isMarked);
     void isPhantomNodeChanged(bool phantom);
+    void posChanged(QPointF pos);
 
 private:
     QString _id;
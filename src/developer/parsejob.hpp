@@ -0,0 +1,138 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PARSEJOB_HPP
+#define PARSEJOB_HPP
+
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include "tokenbuffer.hpp"
+
+namespace Developer {
+
+/*!
+ * \brief The ParseBlock struct is a snapshot of a single text block handed to
+ *  a parse job
+ *
+ * It carries the cached lexer state for the block (see CodeBlockData) so the
+ * job can skip lexing blocks which have not changed. The job updates the
+ * lexer state, lexemes and format hash in place.
+ *
+ * Copying a block's text out of the document is not free, so blocks which are
+ * not expected to be lexed again are sent without it.
+ */
+struct ParseBlock
+{
+    ParseBlock()
+        : position(0)
+        , length(0)
+        , hasText(true)
+        , startState(-1)
+        , endState(0)
+        , dirty(true)
+        , relexed(false)
+        , formatHash(0)
+    {
+    }
+
+    //! The text of the block, if hasText is set
+    QString text;
+    //! The position of the block within the document
+    int position;
+    //! The length of the block's text, used when the text is not sent
+    int length;
+    //! Whether the text of the block has been sent
+    bool hasText;
+    //! The lexer state the block was last lexed with, -1 if never lexed
+    int startState;
+    //! The lexer state at the end of the block
+    int endState;
+    //! Whether the block has been edited since it was last lexed
+    bool dirty;
+    //! Set by the job if the block was lexed again
+    bool relexed;
+    //! The hash of the block-relative token spans the block was highlighted
+    //! with, the job replaces this with the hash for the new tokens
+    uint formatHash;
+    //! The lexemes in the block, positions relative to the start of the block
+    QVector<Token> lexemes;
+
+    //! The length of the block's text, whether or not it has been sent
+    int textLength() const
+    {
+        return hasText ? text.length() : length;
+    }
+};
+
+/*!
+ * \brief The ParseJob struct carries a snapshot of an editor's document to a
+ *  background parse and the resulting tokens back again
+ *
+ * Each job is tagged with the revision of the document it was taken from. The
+ * editor shares the latest revision with all of its jobs, so a job can notice
+ * that the document has been edited since it started and give up early, and
+ * the editor can discard any result which does not match the document it is
+ * currently showing.
+ */
+struct ParseJob
+{
+    ParseJob()
+        : revision(0)
+        , tokens(0)
+        , cancelled(false)
+        , missingText(-1)
+    {
+    }
+
+    /*!
+     * \brief Check whether the document has changed since this job started
+     * \return true if the result of this job will not be used
+     */
+    bool isStale() const
+    {
+        return latestRevision.isNull()
+                || latestRevision->fetchAndAddRelaxed(0) != revision;
+    }
+
+    //! The revision of the document this job was taken from
+    int revision;
+    //! The latest revision of the document, shared with the editor
+    QSharedPointer<QAtomicInt> latestRevision;
+    //! The full text of the document, for parsers which work on the whole text
+    QString text;
+    //! Per-block snapshots, for parsers which work incrementally
+    QVector<ParseBlock> blocks;
+    //! The buffer the tokens are written to, this is owned by the editor and
+    //! reused from one job to the next
+    TokenBuffer *tokens;
+    //! Set if the job gave up because it had become stale, or because it was
+    //! missing the text of a block
+    bool cancelled;
+    //! The first block the job had to lex again without being sent its text,
+    //! or -1
+    int missingText;
+};
+
+}
+
+#endif // PARSEJOB_HPP
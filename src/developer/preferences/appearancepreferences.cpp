@@ -26,6 +26,7 @@
 
 #include "programhighlighter.hpp"
 #include "graph.hpp"
+#include "graphview/graphviewstyle.hpp"
 
 namespace Developer {
 
@@ -43,7 +44,10 @@ AppearancePreferences::AppearancePreferences(QWidget *parent)
     _ui->plainTextEdit->setPlainText(example);
     _ui->plainTextEdit->parse();
 
-    // Set up a simple graph
+    // Set up a simple graph, the previews are only redrawn when the style
+    // changes so they are painted from cached tiles
+    _ui->lhsGraph->setTiledRendering(true);
+    _ui->rhsGraph->setTiledRendering(true);
     Graph *lhsGraph = new Graph(":/templates/example_graph.gpg");
     _ui->lhsGraph->setGraph(lhsGraph);
     Graph *rhsGraph = new Graph(":/templates/example_graph_rhs.gpg");
@@ -166,6 +170,10 @@ void AppearancePreferences::reset()
 void AppearancePreferences::apply()
 {
     QSettings settings;
+
+    // Items in open graph views read their appearance from the shared style,
+    // refresh it so that they pick up any changes
+    GraphViewStyle::instance()->reload();
 }
 
 }
@@ -75,6 +75,15 @@ void Program::setDocumentation(const QString &programDocumentation)
     emit statusChanged(_status);
 }
 
+QString Program::toString() const
+{
+    // Construct the save file, this means making the documentation into a
+    // comment and then concatenating the program contents
+    QString docText = _documentation;
+    docText.replace("\n","\n * ");
+    return QString("/*!\n * ") + docText + "\n */\n" + _program;
+}
+
 bool Program::save()
 {
     // Some initial sanity checks
@@ -86,11 +95,7 @@ bool Program::save()
     _fp->open(QFile::Truncate | QFile::WriteOnly);
     qDebug() << "Saving program file: " << _fp->fileName();
 
-    // Construct the save file, this means making the documentation into a
-    // comment and then concatenating the program contents
-    QString docText = _documentation;
-    docText.replace("\n","\n * ");
-    QString saveText = QString("/*!\n * ") + docText + "\n */\n" + _program;
+    QString saveText = toString();
 
     ++_internalChanges;
     int status = _fp->write(QVariant(saveText).toByteArray());
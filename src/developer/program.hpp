@@ -39,6 +39,12 @@ public:
     QString documentation() const;
     void setDocumentation(const QString &programDocumentation);
 
+    /*!
+     * \brief Get the contents this program would be saved with
+     * \return The documentation as a comment followed by the program
+     */
+    QString toString() const;
+
     bool save();
     bool saveAs(const QString &filePath = QString());
 
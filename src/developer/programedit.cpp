@@ -53,6 +53,9 @@ void ProgramEdit::setProgram(Program *program)
         return;
     }
 
+    if(_program != 0)
+        disconnect(_program, 0, this, 0);
+
     _setUp = false;
     _program = program;
     _programCache = _program->program();
@@ -62,6 +65,9 @@ void ProgramEdit::setProgram(Program *program)
     _ui->editor->parse();
     _setUp = true;
 
+    connect(_program, SIGNAL(statusChanged(FileStatus)),
+            this, SLOT(programChanged()));
+
      _ui->documentationEdit->setEnabled(_program->status() != GPFile::ReadOnly);
      _ui->editor->setEnabled(_program->status() != GPFile::ReadOnly);
 }
@@ -83,9 +89,22 @@ void ProgramEdit::textEdited()
     else if(_program != 0
             && _documentationCache != docs)
     {
-        _programCache = docs;
+        _documentationCache = docs;
         _program->setDocumentation(docs);
     }
 }
 
+void ProgramEdit::programChanged()
+{
+    // Our own edits are cached before they reach the program
+    if(_program == 0 || _program->program() == _programCache)
+        return;
+
+    _setUp = false;
+    _programCache = _program->program();
+    _ui->editor->setPlainText(_programCache);
+    _ui->editor->parse();
+    _setUp = true;
+}
+
 }
@@ -43,6 +43,11 @@ public:
 
 public slots:
     void textEdited();
+    /*!
+     * \brief Show changes made to the program outside of this editor, such as
+     *  a symbol being renamed across the project
+     */
+    void programChanged();
     
 private:
     Ui::ProgramEdit *_ui;
@@ -20,25 +20,21 @@
  */
 #include "programeditor.hpp"
 #include "programhighlighter.hpp"
+#include "programparser.hpp"
+#include "codeblockdata.hpp"
 
 #include <QSettings>
-#include <QDebug>
 #include <QEvent>
+#include <QTextBlock>
 #include <QToolTip>
+#include <QtConcurrentRun>
 
 namespace Developer {
 
 ProgramEditor::ProgramEditor(QWidget *parent)
     : CodeEditor(parent)
-    , _program("")
-    , _pos(0)
-    , _scopeDepth(0)
-    , _cache("")
+    , _textFrom(-1)
 {
-    // Set the list of keywords
-    _keywords << "main" << "if" << "try" << "then" << "else" << "skip" << "fail"
-              << "or";
-
     // Mouse tracking is required for tooltips
     setMouseTracking(true);
 
@@ -49,713 +45,122 @@ ProgramEditor::ProgramEditor(QWidget *parent)
     _highlighter->setTokens(_tokens);
 }
 
-void ProgramEditor::parse()
-{
-    _program = toPlainText();
-    if(_program.isEmpty())
-        return;
-
-    // Don't run this again if the program hasn't changed
-    if(_cache == _program)
-        return;
-    else
-        _cache = _program;
-
-    // Clear the token vector, we're going to repopulate it in this pass
-    for(int i = 0; i < _tokens.count(); ++i)
-        delete _tokens.at(i);
-    _tokens.clear();
-
-    _pos = 0;
-    parseDeclarations();
-
-    if(_pos != _program.length())
-    {
-        qDebug() << "Parsing finished before the end of the input. Stopped at:"
-                 << _pos;
-    }
-
-    _highlighter->setTokens(_tokens);
-    _highlighter->rehighlight();
-}
-
 ProgramHighlighter *ProgramEditor::highlighter() const
 {
     return _highlighter;
 }
 
-bool ProgramEditor::consumeWhitespace()
+void ProgramEditor::documentChanged(int position, int charsRemoved,
+                                    int charsAdded)
 {
-    QRegExp rx("\\s+");
-    if(rx.indexIn(_program,_pos) == _pos)
-    {
-        Q_ASSERT(rx.matchedLength() > 0);
-        _pos += rx.matchedLength();
-        return true;
-    }
-    else
-        return false;
-}
-
-bool ProgramEditor::consumeComments()
-{
-    // Check for a comment
-    QRegExp rx = pattern(ProgramLexeme_CommentOpen);
-    int matchPos = -1;
-    Token *token = new Token;
-    token->startPos = _pos;
-    if((matchPos = rx.indexIn(_program,_pos)) == _pos)
-    {
-        // Comment found, now we need to check for an ending and if we can't
-        // find one then we just mark a comment to the end of the program
-        // and finish
-        token->lexeme = ProgramLexeme_Comment;
-        _pos += rx.matchedLength();
-        rx = pattern(ProgramLexeme_CommentClose);
-        if((matchPos = rx.indexIn(_program, _pos)) > 0)
-        {
-            // We found a closing token, set the end position correctly and
-            // advance the position
-            token->text = _program.mid(
-                        _pos,
-                        (matchPos-_pos) + rx.matchedLength());
-            _pos = matchPos + rx.matchedLength();
-            token->endPos = _pos;
-            _tokens.push_back(token);
-            return true;
-        }
-        else
-        {
-            // There was no closing token, match to the end of the string
-            token->text = _program.mid(
-                        _pos,
-                        _program.length() - _pos);
-            token->endPos = _program.length();
-            _pos = _program.length();
-            _tokens.push_back(token);
-            return true;
-        }
-    }
-
-    // No comment found
-    delete token;
-    return false;
-}
-
-void ProgramEditor::consumeError(const QString &expecting)
-{
-    Token *error = new Token;
-    error->lexeme = ProgramLexeme_Error;
-    error->startPos = _pos;
-
-    // Identifiers are the only contiguous segments
-    QRegExp rx = pattern(ProgramLexeme_Identifier);
-    if(rx.indexIn(_program,_pos) != _pos)
-    {
-        // This isn't a block, move along one char
-        error->text = QString(_program.at(_pos));
-        error->description = errorString(error->text, _pos) +
-                expecting;
-        error->endPos = ++_pos;
-        _tokens.push_back(error);
+    if(_rehighlighting)
         return;
-    }
 
-    error->text = rx.cap(0);
-    error->endPos = _pos + rx.matchedLength();
-    error->description = errorString(error->text, _pos) +
-            expecting;
-    _tokens.push_back(error);
-    _pos += rx.matchedLength();
-}
+    CodeEditor::documentChanged(position, charsRemoved, charsAdded);
 
-void ProgramEditor::parseDeclarations()
-{
-    // We want to loop until we reach the end of this scope or we overshoot the
-    // end of the string
-    bool finished = false;
-    bool canExit = true;
-    QRegExp rx;
-    int previousPosition = -1;
-    while(!finished && _pos < _program.length())
+    QTextBlock block = document()->findBlock(position);
+    QTextBlock last = document()->findBlock(position + charsAdded);
+    for(; block.isValid(); block = block.next())
     {
-        if(previousPosition == _pos)
-        {
-            qDebug() << "Parsing ended before end of string. Ended at " << _pos;
-            return;
-        }
-        else
-            previousPosition = _pos;
-
-        // Ignore whitespace and comments
-        if(consumeComments() || consumeWhitespace())
-            continue;
-
-        // Check for a closing paren, if we are within a scope then this brings
-        // us up one.
-        if(_pos < _program.length() && _program.at(_pos) == QChar(')'))
-        {
-            Token *token = new Token;
-            token->startPos = _pos;
-            token->endPos = ++_pos;
-            token->text = ")";
-
-            // If we can exit then record that token and do so
-            if(canExit)
-            {
-                // Check if there is a parent scope to exit to
-                if(_scopeDepth > 0)
-                {
-                    token->lexeme = ProgramLexeme_CloseParen;
-                    _tokens.push_back(token);
-                    return;
-                }
-                else
-                {
-                    token->lexeme = ProgramLexeme_Error;
-                    token->description = errorString("CloseParen", _pos) + tr(
-                                "No parent scope to exit to");
-                }
-            }
-            else
-            {
-                token->lexeme = ProgramLexeme_Error;
-                token->description = errorString("CloseParen",_pos) + tr(
-                            "Scope cannot be exited here.");
-            }
-            _tokens.push_back(token);
-            continue;
-        }
-
-        // This is now non-whitespace and not a comment, it should be an
-        // identifier or main:
-        Token *declarationName = new Token;
-        declarationName->startPos = _pos;
-
-        // Check for "main"
-        rx = QRegExp("main\\b");
-        QRegExp keywords = pattern(ProgramLexeme_Keyword);
-        if(rx.indexIn(_program,_pos) == _pos)
-        {
-            declarationName->lexeme = ProgramLexeme_Keyword;
-        }
-        // Not main. Check for an identifier
-        else if((rx = pattern(ProgramLexeme_Identifier)).indexIn(_program,_pos) == _pos
-                && !keywords.exactMatch(rx.cap(0)))
-        {
-            declarationName->lexeme = ProgramLexeme_Identifier;
-            canExit = false;
-        }
-        // Not either, it's an error
-        else
-        {
-            delete declarationName;
-            consumeError(tr("Expected identifier or 'main'"));
-            continue;
-        }
-
-        // We now have an identifier or main
-        declarationName->text = rx.cap(0);
-        declarationName->endPos = _pos + rx.matchedLength();
-        _tokens.push_back(declarationName);
-        _pos += rx.matchedLength();
-        canExit = false;
-
-        // An assignment operator is now required
-        while(_pos < _program.length() && _program.at(_pos) != QChar('='))
-        {
-            if(consumeWhitespace() || consumeComments())
-                continue;
-            consumeError(tr("Expected '=' operator."));
-        }
-
-        // Are we at the end of the string? If not we've found it
-        if(_pos != _program.length())
-        {
-            // Now we have found our equals check if the previous token was an
-            // identifier, if yes then mark it as a declaration
-            if(_tokens.back()->lexeme == ProgramLexeme_Identifier)
-                _tokens.back()->lexeme = ProgramLexeme_Declaration;
-
-            Token *token = new Token;
-            token->startPos = _pos;
-            token->endPos = ++_pos;
-            token->lexeme = ProgramLexeme_DeclarationOperator;
-            token->text = "=";
-            _tokens.push_back(token);
-
-            // Ok, now that we've hit a declaration we can actually proceed
-            parseCommandSeqence();
-
-            // Once we return from the command sequence a full stop is required
-            while(_pos < _program.length() && _program.at(_pos) != QChar('.'))
-            {
-                if(consumeWhitespace() || consumeComments())
-                    continue;
-                consumeError(tr("Expected '.' terminator."));
-            }
-
-            // Similar to the above, if this is not the EOF then we've found it
-            if(_pos != _program.length())
-            {
-                token = new Token;
-                token->startPos = _pos;
-                token->endPos = ++_pos;
-                token->lexeme = ProgramLexeme_DeclarationSeparator;
-                token->text = ".";
-                _tokens.push_back(token);
-            }
-        }
-    }
-}
-
-void ProgramEditor::parseCommandSeqence()
-{
-    // Termination of a command sequence occurs when any of these are found:
-    //  - the declaration separator: .
-    //  - a block end: )
-    //  - end of string
-    bool wantCommand = true;
-    while(_pos != _program.length() && _program.at(_pos) != QChar('.')
-          && _program.at(_pos) != QChar(')'))
-    {
-        if(consumeWhitespace() || consumeComments())
-            continue;
-
-        // Read in a command
-        if(wantCommand)
-        {
-            parseCommand();
-            wantCommand = false;
-        }
-        // We now need to terminate or reach a statement separator
-        else
-        {
-            if(_program.at(_pos) == QChar(';'))
-            {
-                Token *token = new Token;
-                token->startPos = _pos;
-                token->endPos = ++_pos;
-                token->lexeme = ProgramLexeme_StatementSeparator;
-                token->text = ";";
-                _tokens.push_back(token);
-                wantCommand = true;
-            }
-            else
-                consumeError("Expecting statement separator (;)");
-        }
-    }
+        // Blocks without any data yet are always lexed
+        CodeBlockData *data = static_cast<CodeBlockData *>(block.userData());
+        if(data != 0)
+            data->dirty = true;
 
-    // If wantCommand is true check if the last token was a separator - if it
-    // was then this is an error by our grammar
-    if(wantCommand && _tokens.back()->text == ";")
-    {
-        _tokens.back()->lexeme = ProgramLexeme_Error;
-        _tokens.back()->description = errorString("StatementSeparator", _pos-1)
-                + tr("No statement following this separator");
+        if(block == last)
+            break;
     }
 }
 
-void ProgramEditor::parseCommand()
+bool ProgramEditor::prepareJob(ParseJob *job)
 {
-    // A command may be:
-    // - Block { '!' }
-    // - Block 'or' Block
-    // - if Block then Block { else Block }
-    // - try Block { then Block { else Block } }
-
-    // Make sure we're at the first token in the command
-    while(consumeWhitespace() || consumeComments());
-
-    // Check for if or try first
-    QRegExp ifExp("if\\b");
-    QRegExp tryExp("try\\b");
-    if(ifExp.indexIn(_program,_pos) == _pos)
-        parseIf();
-    else if(tryExp.indexIn(_program, _pos) == _pos)
-        parseTry();
-    else
+    // Snapshot each block along with its cached lexer state. The lexemes are
+    // implicitly shared so this does not copy them, but QTextBlock::text()
+    // builds a new string each time so the text is only taken for blocks
+    // which are expected to be lexed again
+    bool changed = false;
+    job->blocks.reserve(document()->blockCount());
+    int number = 0;
+    for(QTextBlock block = document()->begin(); block.isValid();
+        block = block.next(), ++number)
     {
-        // Take the first block
-        parseBlock();
-
-        // We now might either have a '!' or 'or', but first (as always):
-        while(consumeWhitespace() || consumeComments());
+        ParseBlock snapshot;
+        snapshot.position = block.position();
+        // The length includes the block separator
+        snapshot.length = block.length() - 1;
 
-        QRegExp orExp = QRegExp("or\\b");
-        if(_pos != _program.length() && _program.at(_pos) == QChar('!'))
+        CodeBlockData *data = static_cast<CodeBlockData *>(block.userData());
+        if(data != 0)
         {
-            Token *token = new Token;
-            token->startPos = _pos;
-            token->endPos = ++_pos;
-            token->lexeme = ProgramLexeme_Repeat;
-            token->text = "!";
-            _tokens.push_back(token);
+            snapshot.startState = data->startState;
+            snapshot.endState = data->endState;
+            snapshot.dirty = data->dirty;
+            snapshot.formatHash = data->formatHash;
+            snapshot.lexemes = data->lexemes;
         }
-        else if(orExp.indexIn(_program, _pos) == _pos)
-        {
-            Token *token = new Token;
-            token->startPos = _pos;
-            token->endPos = _pos + orExp.matchedLength();
-            token->lexeme = ProgramLexeme_Keyword;
-            token->text = "or";
-            _tokens.push_back(token);
-            _pos += orExp.matchedLength();
-
-            // This is followed by another block
-            parseBlock();
-        }
-    }
-}
-
-void ProgramEditor::parseIf()
-{
-    // To get here it should be the case that the first token in the program is
-    // the initial 'if' keyword.
-    QRegExp rx("if\\b");
-    if(rx.indexIn(_program,_pos) != _pos)
-    {
-        qDebug() << "Program parser error in parseIf(): no if keyword found at "
-                    "position " << _pos;
-        return;
-    }
-
-    Token *token = new Token;
-    token->startPos = _pos;
-    token->endPos = (_pos += rx.matchedLength());
-    token->lexeme = ProgramLexeme_Keyword;
-    token->text = "if";
-    _tokens.push_back(token);
 
-    // Then a block follows
-    parseBlock();
+        snapshot.hasText = snapshot.dirty
+                || (_textFrom >= 0 && number >= _textFrom);
+        if(snapshot.hasText)
+            snapshot.text = block.text();
 
-    // Now we expect a 'then' keyword. Look for it
-    rx = QRegExp("then\\b");
-    while(_pos < _program.length() && rx.indexIn(_program,_pos) != _pos)
-    {
-        if(consumeWhitespace() || consumeComments())
-            continue;
-        else
-            consumeError("Expecting 'then' keyword.");
+        changed = changed || snapshot.dirty;
+        job->blocks.push_back(snapshot);
     }
 
-    token = new Token;
-    token->startPos = _pos;
-    token->endPos = (_pos += rx.matchedLength());
-    token->lexeme = ProgramLexeme_Keyword;
-    token->text = "then";
-    _tokens.push_back(token);
-
-    // Another block follows
-    parseBlock();
-
-    // The 'else' portion is optional, check for it but just exit if it is not
-    // present
-    while(consumeWhitespace() || consumeComments());
-
-    rx = QRegExp("else\\b");
-    if(rx.indexIn(_program,_pos) == _pos)
-    {
-        token = new Token;
-        token->startPos = _pos;
-        token->endPos = (_pos += rx.matchedLength());
-        token->lexeme = ProgramLexeme_Keyword;
-        token->text = "else";
-        _tokens.push_back(token);
-
-        // And a final block
-        parseBlock();
-    }
+    // Don't run this again if the program hasn't changed
+    return changed;
 }
 
-void ProgramEditor::parseTry()
+QFuture<ParseJob> ProgramEditor::startJob(const ParseJob &job)
 {
-    // To get here it should be the case that the first token in the program is
-    // the initial 'if' keyword.
-    QRegExp rx("try\\b");
-    if(rx.indexIn(_program,_pos) != _pos)
-    {
-        qDebug() << "Program parser error in parseTry(): no try keyword found "
-                    "at position " << _pos;
-        return;
-    }
-
-    Token *token = new Token;
-    token->startPos = _pos;
-    token->endPos = (_pos += rx.matchedLength());
-    token->lexeme = ProgramLexeme_Keyword;
-    token->text = "try";
-    _tokens.push_back(token);
-
-    // Then a block follows
-    parseBlock();
-
-    // The 'then' portion is optional, check for it but just exit if it is not
-    // present
-    while(consumeWhitespace() || consumeComments());
-
-    rx = QRegExp("then\\b");
-    if(rx.indexIn(_program,_pos) == _pos)
-    {
-        token = new Token;
-        token->startPos = _pos;
-        token->endPos = (_pos += rx.matchedLength());
-        token->lexeme = ProgramLexeme_Keyword;
-        token->text = "then";
-        _tokens.push_back(token);
-
-        // Another block follows
-        parseBlock();
-
-        // The 'else' portion is optional, check for it but just exit if it is
-        // not present
-        while(consumeWhitespace() || consumeComments());
-
-        rx = QRegExp("else\\b");
-        if(rx.indexIn(_program,_pos) == _pos)
-        {
-            token = new Token;
-            token->startPos = _pos;
-            token->endPos = (_pos += rx.matchedLength());
-            token->lexeme = ProgramLexeme_Keyword;
-            token->text = "else";
-            _tokens.push_back(token);
-
-            // And a final block
-            parseBlock();
-        }
-    }
+    return QtConcurrent::run(&ProgramParser::run, job);
 }
 
-void ProgramEditor::parseBlock()
+void ProgramEditor::applyJob(const ParseJob &job)
 {
-    // A block can be:
-    //  - '(' CommandSequence ')'
-    //  - RuleSetCall (this covers calling single rules as well)
-    //  - MacroCall (syntactically exactly the same as a single rule call)
-    //  - skip
-    //  - fail
+    _textFrom = -1;
+    _highlighter->setTokens(_tokens);
 
-    // Make sure we're starting at the first real token
-    while(_pos < _program.length())
+    // Store the new lexer state back into the blocks, then re-highlight those
+    // which were re-lexed or whose tokens have changed. Re-lexed blocks are
+    // always re-highlighted as they will have been highlighted against stale
+    // tokens when edited
+    _rehighlighting = true;
+    int i = 0;
+    for(QTextBlock block = document()->begin();
+        block.isValid() && i < job.blocks.size(); block = block.next(), ++i)
     {
-        if(consumeWhitespace() || consumeComments())
-            continue;
-
-        Token *token = new Token;
-        token->startPos = _pos;
-
-        // Check for keywords
-        QRegExp rx("(skip|fail)\\b");
-        if(rx.indexIn(_program,_pos) == _pos)
+        const ParseBlock &result = job.blocks.at(i);
+        CodeBlockData *data = static_cast<CodeBlockData *>(block.userData());
+        if(data == 0)
         {
-            token->endPos = (_pos += rx.matchedLength());
-            token->text = rx.cap(0);
-            token->lexeme = ProgramLexeme_Keyword;
-            _tokens.push_back(token);
-            return;
+            data = new CodeBlockData;
+            block.setUserData(data);
         }
 
-        // Check for an identifier
-        rx = pattern(ProgramLexeme_Identifier);
-        QRegExp keywords = pattern(ProgramLexeme_Keyword);
-        if(rx.indexIn(_program,_pos) == _pos)
-        {
-            token->endPos = (_pos += rx.matchedLength());
-            token->text = rx.cap(0);
-            if(keywords.exactMatch(token->text))
-            {
-                token->lexeme = ProgramLexeme_Error;
-                token->description = errorString("Keyword", token->startPos)
-                        + tr("Identifiers cannot be keywords");
-            }
-            else
-                token->lexeme = ProgramLexeme_Identifier;
-            _tokens.push_back(token);
-            return;
-        }
-
-        // Check for an open paren
-        if(_pos < _program.length() && _program.at(_pos) == QChar('('))
-        {
-            token->endPos = ++_pos;
-            token->text = "(";
-            token->lexeme = ProgramLexeme_OpenParen;
-            _tokens.push_back(token);
-
-            // We now expect a command sequence
-            parseCommandSeqence();
-
-            // Once we're back we require a closing parenthesis - if we can't
-            // find one just mark the opening parenthesis as unmatched - it's
-            // simpler than marking the entire rest of the program.
-            while(consumeWhitespace() || consumeComments());
-            if(_pos < _program.length() && _program.at(_pos) == QChar(')'))
-            {
-                token = new Token;
-                token->startPos = _pos;
-                token->endPos = ++_pos;
-                token->text = ")";
-                token->lexeme = ProgramLexeme_CloseParen;
-                _tokens.push_back(token);
-            }
-            else
-            {
-                token->lexeme = ProgramLexeme_Error;
-                token->description = errorString("OpenParen", token->startPos)
-                        + tr("Unmatched parenthesis");
-            }
-            return;
-        }
-
-        // Check for an opening curly brace
-        if(_pos < _program.length() && _program.at(_pos) == QChar('{'))
-        {
-            parseRuleSet();
-            return;
-        }
-
-        // No match, consume an error and continue looking
-        delete token;
-        consumeError("Expecting command.");
-    }
-}
-
-void ProgramEditor::parseRuleSet()
-{
-    // Move to the first real token if we're not already there
-    while(consumeWhitespace() || consumeComments());
-
-    if(_pos < _program.length() && _program.at(_pos) == QChar('{'))
-    {
-        Token *token = new Token;
-        token->startPos = _pos;
-        token->endPos = ++_pos;
-        token->lexeme = ProgramLexeme_OpenBrace;
-        token->text = "{";
-        _tokens.push_back(token);
+        data->startState = result.startState;
+        data->endState = result.endState;
+        data->lexemes = result.lexemes;
+        data->dirty = false;
 
-        bool wantsRule = true;
-        while(_pos < _program.length())
+        if(result.relexed || data->formatHash != result.formatHash)
         {
-            if(consumeWhitespace() || consumeComments())
-                continue;
-
-            token = new Token;
-            token->startPos = _pos;
-
-            // Finish upon finding a closing curly brace
-            if(_pos < _program.length() && _program.at(_pos) == QChar('}'))
-            {
-                // Handle a trailing comma for the user
-                if(wantsRule && _tokens.back()->text == ",")
-                {
-                    _tokens.back()->lexeme = ProgramLexeme_Error;
-                    _tokens.back()->description = errorString(
-                                "RuleSeparator",
-                                _tokens.back()->startPos) + tr("Separator is not "
-                                                               "followed by a rule.");
-                }
-
-                token->endPos = ++_pos;
-                token->text = "}";
-                token->lexeme = ProgramLexeme_CloseBrace;
-                _tokens.push_back(token);
-                break;
-            }
-
-            // We haven't ended, take a rule identifier or a comma as required
-            if(wantsRule)
-            {
-                QRegExp rx = pattern(ProgramLexeme_Identifier);
-                QRegExp keywords = pattern(ProgramLexeme_Keyword);
-                if(rx.indexIn(_program,_pos) == _pos)
-                {
-                    token->endPos = (_pos += rx.matchedLength());
-                    token->text = rx.cap(0);
-                    if(keywords.exactMatch(token->text))
-                    {
-                        token->lexeme = ProgramLexeme_Error;
-                        token->description = errorString("Keyword", token->startPos)
-                                + tr("Identifiers cannot be keywords");
-                    }
-                    else
-                        token->lexeme = ProgramLexeme_Identifier;
-                    _tokens.push_back(token);
-                    wantsRule = false;
-                    continue;
-                }
-            }
-            else
-            {
-                if(_pos < _program.length() && _program.at(_pos) == QChar(','))
-                {
-                    token->endPos = ++_pos;
-                    token->text = ",";
-                    token->lexeme = ProgramLexeme_RuleSeparator;
-                    _tokens.push_back(token);
-                    wantsRule = true;
-                    continue;
-                }
-            }
-
-            delete token;
-            consumeError("Expecting comma-delimited list of rules.");
+            data->formatHash = result.formatHash;
+            _highlighter->rehighlightBlock(block);
         }
     }
-    else
-    {
-        qDebug() << "Program parser error: parseRuleSet() called but unable to "
-                    "find a '{' character at position: " << _pos;
-        return;
-    }
+    _rehighlighting = false;
 }
 
-QString ProgramEditor::errorString(const QString &tokenFound, int position)
+bool ProgramEditor::retryJob(const ParseJob &job)
 {
-    QString ret =  tr("Unexpected token %1 at position %2. ").arg(
-                tokenFound,
-                QVariant(position).toString());
-    //qDebug() << ret;
-    return ret;
-}
+    if(job.missingText < 0)
+        return false;
 
-QRegExp ProgramEditor::pattern(int type) const
-{
-    switch(type)
-    {
-    case ProgramLexeme_Comment:
-        return QRegExp("[^*]*");
-    case ProgramLexeme_CommentOpen:
-        return QRegExp("/\\*");
-    case ProgramLexeme_CommentClose:
-        return QRegExp("\\*/");
-    case ProgramLexeme_Keyword:
-        return QRegExp(_keywords.join("\\b|"));
-    case ProgramLexeme_Declaration:
-    case ProgramLexeme_Identifier:
-        return QRegExp("[a-zA-Z_][a-zA-Z0-9_]{,62}");
-    case ProgramLexeme_DeclarationOperator:
-        return QRegExp("=");
-    case ProgramLexeme_OpenParen:
-        return QRegExp("\\(");
-    case ProgramLexeme_CloseParen:
-        return QRegExp("\\)");
-    case ProgramLexeme_OpenBrace:
-        return QRegExp("\\{");
-    case ProgramLexeme_CloseBrace:
-        return QRegExp("\\}");
-    case ProgramLexeme_Repeat:
-        return QRegExp("!");
-    case ProgramLexeme_StatementSeparator:
-        return QRegExp(";");
-    case ProgramLexeme_Default:
-    case ProgramLexeme_Error:
-    default:
-        qDebug() << "Attempted to find pattern for invalid type: " << type;
-        return QRegExp();
-    }
+    if(_textFrom < 0 || job.missingText < _textFrom)
+        _textFrom = job.missingText;
+    return true;
 }
 
 void ProgramEditor::mouseMoveEvent(QMouseEvent *e)
@@ -769,15 +174,14 @@ void ProgramEditor::mouseMoveEvent(QMouseEvent *e)
         //! \todo Adapt this to handle error tokens /inside/ what the editor
         //! considers words
         // We have a word here, is it an error token?
-        for(QVector<Token *>::iterator iter = _tokens.begin();
-            iter != _tokens.end(); ++iter)
+        for(int i = 0; i < _tokens->size(); ++i)
         {
-            Token *t = *iter;
-            if(textCursor.position() >= t->startPos
-                    && textCursor.position() <= t->endPos)
+            const Token &t = _tokens->at(i);
+            if(textCursor.position() >= t.startPos
+                    && textCursor.position() <= t.endPos)
             {
-                if(t->lexeme == ProgramLexeme_Error)
-                    QToolTip::showText(e->globalPos(), t->description);
+                if(t.lexeme == ProgramLexeme_Error)
+                    QToolTip::showText(e->globalPos(), t.description);
             }
         }
     }
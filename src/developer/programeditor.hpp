@@ -22,6 +22,7 @@
 #define PROGRAMEDITOR_HPP
 
 #include "codeeditor.hpp"
+#include "programtokens.hpp"
 
 namespace Developer {
 
@@ -31,10 +32,19 @@ class ProgramHighlighter;
  * \brief The ProgramEditor class encapsulates the necessary classes to display
  *  and edit a GP program
  *
- * It handles parsing the program into a sequence of tokens and passes those
- * along to a ProgramHighlighter instance for syntax highlighting. Error tokens
- * display descriptions in tooltips when the user hovers their mouse over the
- * erroneous token.
+ * It hands the program to a ProgramParser running in the background and passes
+ * the resulting tokens along to a ProgramHighlighter instance for syntax
+ * highlighting. Error tokens display descriptions in tooltips when the user
+ * hovers their mouse over the erroneous token.
+ *
+ * The lexemes found in each text block are cached in the block's CodeBlockData
+ * along with the lexer state at the end of the block. Each parse job takes a
+ * snapshot of these so only blocks which have been edited (or which follow a
+ * block whose end state changed) are lexed again, and only blocks whose
+ * highlighting has changed as a result are re-highlighted. Only the text of
+ * edited blocks is copied into the snapshot. If an edit changes the state the
+ * following blocks are entered with, the job gives up and the next one carries
+ * the text of every block from the first it was missing onwards.
  */
 class ProgramEditor : public CodeEditor
 {
@@ -43,42 +53,23 @@ class ProgramEditor : public CodeEditor
 public:
     ProgramEditor(QWidget *parent = 0);
 
-    QRegExp pattern(int type) const;
-
 public slots:
-    /*!
-     * \brief Parse the program being edited into a vector of tokens
-     */
-    void parse();
-
     ProgramHighlighter *highlighter() const;
 
-protected:
-    bool consumeComments();
-    bool consumeWhitespace();
-    void consumeError(const QString &expecting = QString());
-
-    void parseDeclarations();
-    void parseCommandSeqence();
-    void parseCommand();
-    void parseBlock();
-    void parseRuleSet();
-    void parseIf();
-    void parseTry();
-
+protected slots:
     /*!
-     * \brief Produce a simple formatted text string when an invalid token is
-     *  found
-     *
-     * This is just to keep the error messages looking consistent.
+     * \brief Mark the blocks touched by a change to the document as needing
+     *  to be re-lexed
      *
-     * \todo Convert position into line:column
-     *
-     * \param tokenFound    The unexpected token which was found
-     * \param position      The position of the token
-     * \return A formatted QString with the provided details
+     * The parameters match QTextDocument::contentsChange()
      */
-    QString errorString(const QString &tokenFound, int position);
+    void documentChanged(int position, int charsRemoved, int charsAdded);
+
+protected:
+    bool prepareJob(ParseJob *job);
+    QFuture<ParseJob> startJob(const ParseJob &job);
+    void applyJob(const ParseJob &job);
+    bool retryJob(const ParseJob &job);
 
     /*!
      * \brief Catch mouse movement over the editor in order to overlay error
@@ -89,10 +80,9 @@ protected:
 
 private:
     ProgramHighlighter *_highlighter;
-    QString _program;
-    int _pos;
-    int _scopeDepth;
-    QString _cache;
+    //! The first block to send the text of whether or not it has been edited,
+    //! or -1 to only send edited blocks
+    int _textFrom;
 };
 
 }
@@ -34,9 +34,9 @@ ProgramHighlighter::ProgramHighlighter(QTextDocument *parent)
 {
 }
 
-void ProgramHighlighter::setTokens(QVector<Token *> tokens)
+void ProgramHighlighter::setTokens(const TokenBuffer *tokens)
 {
-    _tokens = tokens;
+    _index.setTokens(tokens);
 }
 
 void ProgramHighlighter::highlightBlock(const QString &text)
@@ -46,41 +46,20 @@ void ProgramHighlighter::highlightBlock(const QString &text)
     int startPosition = currentBlock().position();
     int endPosition = startPosition + text.length();
 
-    for(QVector<Token *>::iterator iter = _tokens.begin()
-        ; iter != _tokens.end(); ++iter)
+    // Only visit the tokens which overlap this block, the index is sorted by
+    // start position so we can stop at the first token beyond the block
+    for(int i = _index.firstOverlapping(startPosition); i < _index.count(); ++i)
     {
-        Token *t = *iter;
-        // Is this entire block contained in this token?
-        if(t->startPos <= startPosition && t->endPos >= endPosition)
-        {
-            setFormat(0, text.length(), format(t->lexeme));
-            return;
-        }
+        const Token &t = _index.at(i);
+        if(t.startPos >= endPosition)
+            break;
+        if(t.endPos <= startPosition)
+            continue;
 
-        // Is the start position of this token in range?
-        if(t->startPos >= startPosition && t->startPos < endPosition)
-        {
-            if(t->endPos > endPosition)
-                setFormat(t->startPos - startPosition,
-                          text.length() - (t->startPos - startPosition),
-                          format(t->lexeme));
-            else
-                setFormat(t->startPos - startPosition,
-                          t->endPos - t->startPos,
-                          format(t->lexeme));
-        }
-        // If not is the end position in range?
-        else if(t->endPos > startPosition && t->endPos <= endPosition)
-        {
-            if(t->startPos < startPosition)
-                setFormat(0,
-                          t->endPos - t->startPos,
-                          format(t->lexeme));
-            else
-                setFormat(t->startPos - startPosition,
-                          t->endPos - t->startPos,
-                          format(t->lexeme));
-        }
+        // Clip the token to the extent of this block
+        int start = qMax(t.startPos, startPosition) - startPosition;
+        int end = qMin(t.endPos, endPosition) - startPosition;
+        setFormat(start, end - start, format(t.lexeme));
     }
 }
 
@@ -23,6 +23,7 @@
 
 #include "programtokens.hpp"
 #include "token.hpp"
+#include "tokenindex.hpp"
 
 #include <QSyntaxHighlighter>
 #include <QRegExp>
@@ -67,14 +68,18 @@ namespace Developer {
  * background thread as an easier solution than a massively sophisticated parser
  * with update support.
  *
- * Therefore this class takes the simple but effective approach of parsing the
- * document when things are changed, that occurs in parseProgram() which produces
- * a vector of ProgramHighlighter::Token instances. The highlightBlock() portion
- * is now an interface onto that token vector, each Token is checked to see if
- * it applies to the block in question, and if yes the correct portion is
- * coloured according to the format() member function.
+ * Therefore this class takes the simple but effective approach of working from
+ * a vector of tokens covering the whole document, which is produced by
+ * ProgramEditor::parse(). The highlightBlock() portion is an interface onto
+ * that token vector, each Token is checked to see if it applies to the block in
+ * question, and if yes the correct portion is coloured according to the
+ * format() member function.
  *
- * \todo Alter the above to reflect that parsing occurs in ProgramEditor now
+ * To keep typing responsive in long programs the editor lexes each block
+ * separately and caches the result in the block (see CodeBlockData), and only
+ * asks for blocks to be re-highlighted through rehighlightBlock() when their
+ * tokens have actually changed. The whole-document grammar check still runs on
+ * each parse, but over the cached lexemes rather than the raw text.
  */
 class ProgramHighlighter : public QSyntaxHighlighter
 {
@@ -99,9 +104,9 @@ public:
 public slots:
     /*!
      * \brief Set the sequence of tokens which correspond with this program
-     * \param tokens    The sequence of tokens
+     * \param tokens    The sequence of tokens, these are owned by the editor
      */
-    void setTokens(QVector<Token *> tokens);
+    void setTokens(const TokenBuffer *tokens);
     /*!
      * \brief A wrapper function which complies with the standard
      *  QSyntaxHighlighter interface
@@ -110,7 +115,7 @@ public slots:
     void highlightBlock(const QString &text);
 
 private:
-    QVector<Token *> _tokens;
+    TokenIndex _index;
 };
 
 }
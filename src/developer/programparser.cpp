@@ -0,0 +1,688 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "programparser.hpp"
+
+#include <QDebug>
+#include <QStringList>
+#include <QVariant>
+
+namespace Developer {
+
+ProgramParser::ProgramParser()
+    : _lexer(ProgramLanguage)
+    , _tokens(0)
+    , _index(0)
+    , _scopeDepth(0)
+{
+}
+
+ParseJob ProgramParser::run(ParseJob job)
+{
+    ProgramParser parser;
+    parser.parse(&job);
+    return job;
+}
+
+void ProgramParser::parse(ParseJob *job)
+{
+    // Bring the lexemes cached for each block up to date. A block needs to be
+    // lexed again if it has been edited or if the state it is entered with
+    // has changed, e.g. a comment has been opened or closed above it
+    int state = ProgramLexerState_Default;
+    for(int i = 0; i < job->blocks.size(); ++i)
+    {
+        if(job->isStale())
+        {
+            job->cancelled = true;
+            return;
+        }
+
+        ParseBlock &block = job->blocks[i];
+        block.relexed = block.dirty || block.startState != state;
+        if(block.relexed)
+        {
+            // The state entering a block which was sent without its text has
+            // changed, the editor has to send the text and try again
+            if(!block.hasText)
+            {
+                job->missingText = i;
+                job->cancelled = true;
+                return;
+            }
+
+            block.startState = state;
+            block.endState = lexBlock(block.text, state, &block.lexemes);
+            block.dirty = false;
+        }
+
+        state = block.endState;
+    }
+
+    // The grammar is checked over the whole document, so gather up the lexemes
+    // with their absolute positions
+    _lexemes.clear();
+    for(int i = 0; i < job->blocks.size(); ++i)
+    {
+        const ParseBlock &block = job->blocks.at(i);
+        for(int j = 0; j < block.lexemes.size(); ++j)
+        {
+            Token lexeme = block.lexemes.at(j);
+            lexeme.startPos += block.position;
+            lexeme.endPos += block.position;
+            _lexemes.push_back(lexeme);
+        }
+    }
+
+    // Reuse the token storage from the last time this buffer was parsed into
+    _tokens = job->tokens;
+    _tokens->clear();
+    _index = 0;
+    _scopeDepth = 0;
+    parseDeclarations();
+
+    if(!atEnd())
+    {
+        qDebug() << "Parsing finished before the end of the input. Stopped at:"
+                 << _lexemes.at(_index).startPos;
+    }
+
+    // Tokens are in document order and never span blocks, so they can be
+    // walked alongside the blocks to work out which blocks will highlight
+    // differently
+    int index = 0;
+    for(int i = 0; i < job->blocks.size(); ++i)
+    {
+        ParseBlock &block = job->blocks[i];
+        int end = block.position + block.textLength() + 1;
+        uint hash = 0;
+        for(; index < _tokens->size() && _tokens->at(index).startPos < end;
+            ++index)
+        {
+            const Token &t = _tokens->at(index);
+            hash = hash * 31 + static_cast<uint>(t.startPos - block.position);
+            hash = hash * 31 + static_cast<uint>(t.endPos - block.position);
+            hash = hash * 31 + static_cast<uint>(t.lexeme);
+        }
+        block.formatHash = hash;
+    }
+
+    _tokens = 0;
+}
+
+void ProgramParser::parseProgram(const QString &program, TokenBuffer *tokens)
+{
+    // Nothing else knows about this job, so it can never become stale
+    ParseJob job;
+    job.latestRevision = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    job.tokens = tokens;
+
+    int position = 0;
+    QStringList lines = program.split('\n');
+    for(int i = 0; i < lines.size(); ++i)
+    {
+        ParseBlock block;
+        block.text = lines.at(i);
+        block.position = position;
+        job.blocks.push_back(block);
+        position += lines.at(i).length() + 1;
+    }
+
+    parse(&job);
+}
+
+int ProgramParser::lexBlock(const QString &text, int state,
+                            QVector<Token> *lexemes) const
+{
+    lexemes->clear();
+
+    int pos = 0;
+    while(pos < text.length())
+    {
+        Token token;
+        token.startPos = pos;
+
+        // Either a comment is carried over from a previous block or we have
+        // to look for the next lexeme
+        if(state == ProgramLexerState_Comment)
+            token.lexeme = ProgramLexeme_CommentOpen;
+        else
+        {
+            pos = _lexer.skipWhitespace(text, pos);
+            if(pos >= text.length())
+                break;
+            token.startPos = pos;
+
+            int length = _lexer.match(text, pos, &token.lexeme);
+            if(length == 0)
+            {
+                // The parser attaches a description to this
+                token.lexeme = ProgramLexeme_Error;
+                length = 1;
+            }
+            pos += length;
+        }
+
+        switch(token.lexeme)
+        {
+        case ProgramLexeme_CommentOpen:
+        {
+            // Comments run until a closing token or the end of the block
+            int end = _lexer.findCommentClose(text, pos);
+            if(end >= 0)
+            {
+                pos = end;
+                state = ProgramLexerState_Default;
+            }
+            else
+            {
+                pos = text.length();
+                state = ProgramLexerState_Comment;
+            }
+            token.lexeme = ProgramLexeme_Comment;
+            break;
+        }
+        case ProgramLexeme_CommentClose:
+            // There is no comment open to close
+            token.lexeme = ProgramLexeme_Error;
+            break;
+        default:
+            break;
+        }
+
+        token.endPos = pos;
+        token.text = text.mid(token.startPos, pos - token.startPos);
+        lexemes->push_back(token);
+    }
+
+    return state;
+}
+
+bool ProgramParser::atEnd() const
+{
+    return _index >= _lexemes.size();
+}
+
+bool ProgramParser::lookingAt(int lexeme, const QString &text) const
+{
+    if(atEnd())
+        return false;
+
+    const Token &current = _lexemes.at(_index);
+    return current.lexeme == lexeme && (text.isNull() || current.text == text);
+}
+
+Token *ProgramParser::consumeToken(int lexeme)
+{
+    Q_ASSERT(!atEnd());
+
+    Token *token = _tokens->append(_lexemes.at(_index++));
+    token->lexeme = lexeme;
+    return token;
+}
+
+bool ProgramParser::consumeComments()
+{
+    bool consumed = false;
+    while(lookingAt(ProgramLexeme_Comment))
+    {
+        consumeToken(ProgramLexeme_Comment);
+        consumed = true;
+    }
+
+    return consumed;
+}
+
+void ProgramParser::consumeError(const QString &expecting)
+{
+    if(atEnd())
+        return;
+
+    // The lexer has already split the input into identifiers and single
+    // characters, so the error is whichever of those comes next
+    Token *error = consumeToken(ProgramLexeme_Error);
+    error->description = errorString(error->text, error->startPos) + expecting;
+}
+
+void ProgramParser::parseDeclarations()
+{
+    // We want to loop until we reach the end of this scope or we overshoot the
+    // end of the input
+    bool canExit = true;
+    int previousIndex = -1;
+    while(!atEnd())
+    {
+        if(previousIndex == _index)
+        {
+            qDebug() << "Parsing ended before end of string. Ended at "
+                     << _lexemes.at(_index).startPos;
+            return;
+        }
+        else
+            previousIndex = _index;
+
+        // Ignore comments
+        if(consumeComments())
+            continue;
+
+        // Check for a closing paren, if we are within a scope then this brings
+        // us up one.
+        if(lookingAt(ProgramLexeme_CloseParen))
+        {
+            Token *token = consumeToken(ProgramLexeme_Error);
+
+            // If we can exit then record that token and do so
+            if(canExit)
+            {
+                // Check if there is a parent scope to exit to
+                if(_scopeDepth > 0)
+                {
+                    token->lexeme = ProgramLexeme_CloseParen;
+                    return;
+                }
+                else
+                {
+                    token->description = errorString("CloseParen",
+                                                      token->startPos) + tr(
+                                "No parent scope to exit to");
+                }
+            }
+            else
+            {
+                token->description = errorString("CloseParen", token->startPos)
+                        + tr("Scope cannot be exited here.");
+            }
+            continue;
+        }
+
+        // This is now not a comment, it should be an identifier or main
+        if(lookingAt(ProgramLexeme_Keyword, "main"))
+            consumeToken(ProgramLexeme_Keyword);
+        else if(lookingAt(ProgramLexeme_Identifier))
+            consumeToken(ProgramLexeme_Identifier);
+        // Not either, it's an error
+        else
+        {
+            consumeError(tr("Expected identifier or 'main'"));
+            continue;
+        }
+
+        canExit = false;
+
+        // An assignment operator is now required
+        while(!atEnd() && !lookingAt(ProgramLexeme_DeclarationOperator))
+        {
+            if(consumeComments())
+                continue;
+            consumeError(tr("Expected '=' operator."));
+        }
+
+        // Are we at the end of the input? If not we've found it
+        if(!atEnd())
+        {
+            // Now we have found our equals check if the previous token was an
+            // identifier, if yes then mark it as a declaration
+            if(_tokens->last().lexeme == ProgramLexeme_Identifier)
+                _tokens->last().lexeme = ProgramLexeme_Declaration;
+
+            consumeToken(ProgramLexeme_DeclarationOperator);
+
+            // Ok, now that we've hit a declaration we can actually proceed
+            parseCommandSeqence();
+
+            // Once we return from the command sequence a full stop is required
+            while(!atEnd() && !lookingAt(ProgramLexeme_DeclarationSeparator))
+            {
+                if(consumeComments())
+                    continue;
+                consumeError(tr("Expected '.' terminator."));
+            }
+
+            // Similar to the above, if this is not the EOF then we've found it
+            if(!atEnd())
+                consumeToken(ProgramLexeme_DeclarationSeparator);
+        }
+    }
+}
+
+void ProgramParser::parseCommandSeqence()
+{
+    // Termination of a command sequence occurs when any of these are found:
+    //  - the declaration separator: .
+    //  - a block end: )
+    //  - end of input
+    bool wantCommand = true;
+    while(!atEnd() && !lookingAt(ProgramLexeme_DeclarationSeparator)
+          && !lookingAt(ProgramLexeme_CloseParen))
+    {
+        if(consumeComments())
+            continue;
+
+        // Read in a command
+        if(wantCommand)
+        {
+            parseCommand();
+            wantCommand = false;
+        }
+        // We now need to terminate or reach a statement separator
+        else
+        {
+            if(lookingAt(ProgramLexeme_StatementSeparator))
+            {
+                consumeToken(ProgramLexeme_StatementSeparator);
+                wantCommand = true;
+            }
+            else
+                consumeError("Expecting statement separator (;)");
+        }
+    }
+
+    // If wantCommand is true check if the last token was a separator - if it
+    // was then this is an error by our grammar
+    if(wantCommand && !_tokens->isEmpty() && _tokens->last().text == ";")
+    {
+        _tokens->last().lexeme = ProgramLexeme_Error;
+        _tokens->last().description = errorString("StatementSeparator",
+                                                  _tokens->last().startPos)
+                + tr("No statement following this separator");
+    }
+}
+
+void ProgramParser::parseCommand()
+{
+    // A command may be:
+    // - Block { '!' }
+    // - Block 'or' Block
+    // - if Block then Block { else Block }
+    // - try Block { then Block { else Block } }
+
+    // Make sure we're at the first token in the command
+    consumeComments();
+
+    // Check for if or try first
+    if(lookingAt(ProgramLexeme_Keyword, "if"))
+        parseIf();
+    else if(lookingAt(ProgramLexeme_Keyword, "try"))
+        parseTry();
+    else
+    {
+        // Take the first block
+        parseBlock();
+
+        // We now might either have a '!' or 'or', but first (as always):
+        consumeComments();
+
+        if(lookingAt(ProgramLexeme_Repeat))
+            consumeToken(ProgramLexeme_Repeat);
+        else if(lookingAt(ProgramLexeme_Keyword, "or"))
+        {
+            consumeToken(ProgramLexeme_Keyword);
+
+            // This is followed by another block
+            parseBlock();
+        }
+    }
+}
+
+void ProgramParser::parseIf()
+{
+    // To get here it should be the case that the next token in the program is
+    // the initial 'if' keyword.
+    if(!lookingAt(ProgramLexeme_Keyword, "if"))
+    {
+        qDebug() << "Program parser error in parseIf(): no if keyword found at "
+                    "token " << _index;
+        return;
+    }
+
+    consumeToken(ProgramLexeme_Keyword);
+
+    // Then a block follows
+    parseBlock();
+
+    // Now we expect a 'then' keyword. Look for it
+    while(!atEnd() && !lookingAt(ProgramLexeme_Keyword, "then"))
+    {
+        if(consumeComments())
+            continue;
+        else
+            consumeError("Expecting 'then' keyword.");
+    }
+
+    if(atEnd())
+        return;
+
+    consumeToken(ProgramLexeme_Keyword);
+
+    // Another block follows
+    parseBlock();
+
+    // The 'else' portion is optional, check for it but just exit if it is not
+    // present
+    consumeComments();
+
+    if(lookingAt(ProgramLexeme_Keyword, "else"))
+    {
+        consumeToken(ProgramLexeme_Keyword);
+
+        // And a final block
+        parseBlock();
+    }
+}
+
+void ProgramParser::parseTry()
+{
+    // To get here it should be the case that the next token in the program is
+    // the initial 'try' keyword.
+    if(!lookingAt(ProgramLexeme_Keyword, "try"))
+    {
+        qDebug() << "Program parser error in parseTry(): no try keyword found "
+                    "at token " << _index;
+        return;
+    }
+
+    consumeToken(ProgramLexeme_Keyword);
+
+    // Then a block follows
+    parseBlock();
+
+    // The 'then' portion is optional, check for it but just exit if it is not
+    // present
+    consumeComments();
+
+    if(lookingAt(ProgramLexeme_Keyword, "then"))
+    {
+        consumeToken(ProgramLexeme_Keyword);
+
+        // Another block follows
+        parseBlock();
+
+        // The 'else' portion is optional, check for it but just exit if it is
+        // not present
+        consumeComments();
+
+        if(lookingAt(ProgramLexeme_Keyword, "else"))
+        {
+            consumeToken(ProgramLexeme_Keyword);
+
+            // And a final block
+            parseBlock();
+        }
+    }
+}
+
+void ProgramParser::parseBlock()
+{
+    // A block can be:
+    //  - '(' CommandSequence ')'
+    //  - RuleSetCall (this covers calling single rules as well)
+    //  - MacroCall (syntactically exactly the same as a single rule call)
+    //  - skip
+    //  - fail
+
+    // Make sure we're starting at the first real token
+    while(!atEnd())
+    {
+        if(consumeComments())
+            continue;
+
+        // Check for keywords
+        if(lookingAt(ProgramLexeme_Keyword, "skip")
+                || lookingAt(ProgramLexeme_Keyword, "fail"))
+        {
+            consumeToken(ProgramLexeme_Keyword);
+            return;
+        }
+
+        // Check for an identifier
+        if(lookingAt(ProgramLexeme_Identifier))
+        {
+            consumeToken(ProgramLexeme_Identifier);
+            return;
+        }
+        else if(lookingAt(ProgramLexeme_Keyword))
+        {
+            Token *token = consumeToken(ProgramLexeme_Error);
+            token->description = errorString("Keyword", token->startPos)
+                    + tr("Identifiers cannot be keywords");
+            return;
+        }
+
+        // Check for an open paren
+        if(lookingAt(ProgramLexeme_OpenParen))
+        {
+            // Remember where the parenthesis is rather than holding on to
+            // it, the buffer may grow while the sequence is parsed
+            int open = _tokens->size();
+            consumeToken(ProgramLexeme_OpenParen);
+
+            // We now expect a command sequence
+            parseCommandSeqence();
+
+            // Once we're back we require a closing parenthesis - if we can't
+            // find one just mark the opening parenthesis as unmatched - it's
+            // simpler than marking the entire rest of the program.
+            consumeComments();
+            if(lookingAt(ProgramLexeme_CloseParen))
+                consumeToken(ProgramLexeme_CloseParen);
+            else
+            {
+                Token &token = (*_tokens)[open];
+                token.lexeme = ProgramLexeme_Error;
+                token.description = errorString("OpenParen", token.startPos)
+                        + tr("Unmatched parenthesis");
+            }
+            return;
+        }
+
+        // Check for an opening curly brace
+        if(lookingAt(ProgramLexeme_OpenBrace))
+        {
+            parseRuleSet();
+            return;
+        }
+
+        // No match, consume an error and continue looking
+        consumeError("Expecting command.");
+    }
+}
+
+void ProgramParser::parseRuleSet()
+{
+    // Move to the first real token if we're not already there
+    consumeComments();
+
+    if(lookingAt(ProgramLexeme_OpenBrace))
+    {
+        consumeToken(ProgramLexeme_OpenBrace);
+
+        bool wantsRule = true;
+        while(!atEnd())
+        {
+            if(consumeComments())
+                continue;
+
+            // Finish upon finding a closing curly brace
+            if(lookingAt(ProgramLexeme_CloseBrace))
+            {
+                // Handle a trailing comma for the user
+                if(wantsRule && _tokens->last().text == ",")
+                {
+                    Token &separator = _tokens->last();
+                    separator.lexeme = ProgramLexeme_Error;
+                    separator.description = errorString(
+                                "RuleSeparator",
+                                separator.startPos) + tr("Separator is not "
+                                                         "followed by a rule.");
+                }
+
+                consumeToken(ProgramLexeme_CloseBrace);
+                break;
+            }
+
+            // We haven't ended, take a rule identifier or a comma as required
+            if(wantsRule)
+            {
+                if(lookingAt(ProgramLexeme_Identifier))
+                {
+                    consumeToken(ProgramLexeme_Identifier);
+                    wantsRule = false;
+                    continue;
+                }
+                else if(lookingAt(ProgramLexeme_Keyword))
+                {
+                    Token *token = consumeToken(ProgramLexeme_Error);
+                    token->description = errorString("Keyword", token->startPos)
+                            + tr("Identifiers cannot be keywords");
+                    wantsRule = false;
+                    continue;
+                }
+            }
+            else
+            {
+                if(lookingAt(ProgramLexeme_RuleSeparator))
+                {
+                    consumeToken(ProgramLexeme_RuleSeparator);
+                    wantsRule = true;
+                    continue;
+                }
+            }
+
+            consumeError("Expecting comma-delimited list of rules.");
+        }
+    }
+    else
+    {
+        qDebug() << "Program parser error: parseRuleSet() called but unable to "
+                    "find a '{' character at token: " << _index;
+        return;
+    }
+}
+
+QString ProgramParser::errorString(const QString &tokenFound, int position)
+{
+    QString ret =  tr("Unexpected token %1 at position %2. ").arg(
+                tokenFound,
+                QVariant(position).toString());
+    //qDebug() << ret;
+    return ret;
+}
+
+}
@@ -0,0 +1,136 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PROGRAMPARSER_HPP
+#define PROGRAMPARSER_HPP
+
+#include <QCoreApplication>
+
+#include "lexer.hpp"
+#include "parsejob.hpp"
+#include "programtokens.hpp"
+
+namespace Developer {
+
+/*!
+ * \brief The ProgramParser class turns the text of a GP program into a
+ *  sequence of tokens, marking any errors found
+ *
+ * Parsing happens in two stages. Each text block is lexed on its own and the
+ * resulting lexemes are cached along with the lexer state at the end of the
+ * block, so only blocks which have been edited (or which follow a block whose
+ * end state changed) are lexed again. The grammar is then checked over the
+ * cached lexemes of the whole document, which is cheap compared to the lexing.
+ *
+ * The parser holds no references to the editor or its document and can run on
+ * any thread, ProgramEditor runs it in the background through run().
+ */
+class ProgramParser
+{
+    Q_DECLARE_TR_FUNCTIONS(ProgramParser)
+
+public:
+    ProgramParser();
+
+    /*!
+     * \brief Run a parse job, this is the entry point used for background jobs
+     * \param job   The job to run
+     * \return The job with its blocks and tokens updated
+     */
+    static ParseJob run(ParseJob job);
+
+    /*!
+     * \brief Bring the lexemes of each block in the job up to date, check the
+     *  grammar and produce the resulting tokens
+     *
+     * This gives up early, marking the job as cancelled, if the job becomes
+     * stale while it is running.
+     *
+     * \param job   The job to process
+     */
+    void parse(ParseJob *job);
+
+    /*!
+     * \brief Parse a whole program outside of an editor
+     *
+     * The program is split into blocks as the editor would and parsed from
+     * scratch, this is used to scan files which are not open for editing.
+     *
+     * \param program The text of the program
+     * \param tokens  The buffer to write the tokens to
+     */
+    void parseProgram(const QString &program, TokenBuffer *tokens);
+
+    /*!
+     * \brief Split a single block of program text into lexemes
+     * \param text     The text of the block
+     * \param state    The lexer state at the end of the previous block, a
+     *  value from the ProgramLexerStates enum
+     * \param lexemes  Output vector for the lexemes found, positions are
+     *  relative to the start of the block
+     * \return The lexer state at the end of this block
+     */
+    int lexBlock(const QString &text, int state, QVector<Token> *lexemes) const;
+
+protected:
+    bool atEnd() const;
+    bool lookingAt(int lexeme, const QString &text = QString()) const;
+    /*!
+     * \brief Copy the current lexeme into the output as a token
+     * \param lexeme  The type to give the token
+     * \return The new token, valid until the next token is consumed
+     */
+    Token *consumeToken(int lexeme);
+    bool consumeComments();
+    void consumeError(const QString &expecting = QString());
+
+    void parseDeclarations();
+    void parseCommandSeqence();
+    void parseCommand();
+    void parseBlock();
+    void parseRuleSet();
+    void parseIf();
+    void parseTry();
+
+    /*!
+     * \brief Produce a simple formatted text string when an invalid token is
+     *  found
+     *
+     * This is just to keep the error messages looking consistent.
+     *
+     * \todo Convert position into line:column
+     *
+     * \param tokenFound    The unexpected token which was found
+     * \param position      The position of the token
+     * \return A formatted QString with the provided details
+     */
+    QString errorString(const QString &tokenFound, int position);
+
+private:
+    Lexer _lexer;
+    QVector<Token> _lexemes;
+    TokenBuffer *_tokens;
+    int _index;
+    int _scopeDepth;
+};
+
+}
+
+#endif // PROGRAMPARSER_HPP
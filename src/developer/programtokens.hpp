@@ -72,6 +72,18 @@ enum ProgramLexemes
     ProgramLexeme_Error
 };
 
+/*!
+ * \brief The ProgramLexerStates enum defines the states that the program lexer
+ *  can be in at the boundary between two text blocks
+ */
+enum ProgramLexerStates
+{
+    //! Not inside any multi-line construct
+    ProgramLexerState_Default,
+    //! Inside a comment which has not yet been closed
+    ProgramLexerState_Comment
+};
+
 }
 
 #endif // PROGRAMTOKENS_HPP
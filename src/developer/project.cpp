@@ -19,6 +19,8 @@
  * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "project.hpp"
+#include "symbolindex.hpp"
+#include "projectvalidator.hpp"
 
 #include <QMessageBox>
 #include <QDateTime>
@@ -37,7 +39,11 @@ Project::Project(const QString &projectPath, bool autoInitialise, QObject *paren
     , _nodeCount(0)
     , _edgeCount(0)
     , _error("")
+    , _currentFile(0)
 {
+    _symbolIndex = new SymbolIndex(this);
+    _validator = new ProjectValidator(this);
+
     if(!projectPath.isEmpty() && autoInitialise)
         open(projectPath);
     else
@@ -293,6 +299,21 @@ QVector<RunConfig *> Project::runConfigurations() const
     return _runConfigurations;
 }
 
+SymbolIndex *Project::symbolIndex() const
+{
+    return _symbolIndex;
+}
+
+ProjectValidator *Project::validator() const
+{
+    return _validator;
+}
+
+GPFile *Project::currentFile() const
+{
+    return _currentFile;
+}
+
 bool Project::hasUnsavedChanges() const
 {
     for(ruleConstIter iter = _rules.begin(); iter != _rules.end(); ++iter)
@@ -33,6 +33,8 @@
 namespace Developer {
 
 class OpenThread;
+class SymbolIndex;
+class ProjectValidator;
 
 /*!
  * \brief Container type for GP projects, allowing for monitoring and updating
@@ -280,6 +282,24 @@ public:
 
     QVector<RunConfig *> runConfigurations() const;
 
+    /*!
+     * \brief Get the index of rule and macro names used across this project
+     * \return The project's SymbolIndex, owned by the project
+     */
+    SymbolIndex *symbolIndex() const;
+
+    /*!
+     * \brief Get the validator which checks this project's files for problems
+     * \return The project's ProjectValidator, owned by the project
+     */
+    ProjectValidator *validator() const;
+
+    /*!
+     * \brief Get the file which is currently active in the IDE
+     * \return The current file, or 0 if no file has been made active yet
+     */
+    GPFile *currentFile() const;
+
     /*!
      * \brief Checks if the project has any unsaved changes stored
      * \return True if there are unsaved changes, false otherwise
@@ -583,6 +603,8 @@ private:
     QString _error;
 
     GPFile *_currentFile;
+    SymbolIndex *_symbolIndex;
+    ProjectValidator *_validator;
 
     QVector<Rule *> _rules;
     QVector<Graph *> _graphs;
@@ -0,0 +1,512 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "projectvalidator.hpp"
+#include "project.hpp"
+#include "rule.hpp"
+#include "program.hpp"
+#include "graph.hpp"
+#include "list.hpp"
+#include "parsertypes.hpp"
+#include "ruleparser.hpp"
+#include "graphparser.hpp"
+#include "symbolindex.hpp"
+#include "typeinference.hpp"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFile>
+#include <QtConcurrentMap>
+
+namespace Developer {
+
+namespace {
+
+/*!
+ * \brief Read a snapshot's text from disk if required and hash it, run across
+ *  the thread pool before the cache is consulted
+ * \param snapshot  The snapshot to complete
+ */
+void loadSnapshot(ValidationSnapshot &snapshot)
+{
+    if(snapshot.fromDisk)
+    {
+        QFile fp(snapshot.filePath);
+        if(fp.open(QFile::ReadOnly))
+            snapshot.text = QString::fromUtf8(fp.readAll());
+        else
+            qDebug() << "Could not open file for validation: "
+                     << snapshot.filePath;
+        snapshot.fromDisk = false;
+    }
+
+    QByteArray data = QByteArray::number(snapshot.type);
+    data += snapshot.text.toUtf8();
+    snapshot.hash = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+}
+
+void addIssue(FileValidation *result, int line, const QString &message)
+{
+    ValidationIssue issue;
+    issue.filePath = result->filePath;
+    issue.line = line;
+    issue.message = message;
+    result->issues.push_back(issue);
+}
+
+/*!
+ * \brief Check that a label parsed from a file would also be accepted by the
+ *  label editor
+ */
+bool isCleanLabel(const label_t &label)
+{
+    List list(label);
+    return List(list.toString()).isClean();
+}
+
+/*!
+ * \brief Collect the variables used in a graph's labels
+ */
+QStringList graphVariables(const graph_t &graph)
+{
+    QStringList result;
+    for(size_t i = 0; i < graph.nodes.size(); ++i)
+        result += List(graph.nodes.at(i).label).variables();
+    for(size_t i = 0; i < graph.edges.size(); ++i)
+        result += List(graph.edges.at(i).label).variables();
+
+    // The "empty" list has no variable name
+    result.removeAll(QString());
+    result.removeDuplicates();
+    return result;
+}
+
+/*!
+ * \brief Collect the node identifiers in a graph
+ */
+QSet<QString> graphNodes(const graph_t &graph)
+{
+    QSet<QString> result;
+    for(size_t i = 0; i < graph.nodes.size(); ++i)
+        result.insert(graph.nodes.at(i).id.c_str());
+    return result;
+}
+
+void checkLabels(const graph_t &graph, const QString &where,
+                 FileValidation *result)
+{
+    for(size_t i = 0; i < graph.nodes.size(); ++i)
+    {
+        const node_t &node = graph.nodes.at(i);
+        if(!isCleanLabel(node.label))
+            addIssue(result, 0, QObject::tr("The label of node '%1'%2 does "
+                                            "not parse cleanly.").arg(
+                         node.id.c_str(), where));
+    }
+
+    for(size_t i = 0; i < graph.edges.size(); ++i)
+    {
+        const edge_t &edge = graph.edges.at(i);
+        if(!isCleanLabel(edge.label))
+            addIssue(result, 0, QObject::tr("The label of edge '%1'%2 does "
+                                            "not parse cleanly.").arg(
+                         edge.id.c_str(), where));
+    }
+}
+
+void validateRule(const ValidationSnapshot &snapshot, FileValidation *result)
+{
+    rule_t rule = parseRule(snapshot.text.toStdString());
+    result->ruleName = rule.id.c_str();
+
+    graph_t lhs;
+    graph_t rhs;
+    if(rule.lhs.is_initialized())
+        lhs = rule.lhs.get();
+    if(rule.rhs.is_initialized())
+        rhs = rule.rhs.get();
+
+    checkLabels(lhs, QObject::tr(" in the LHS"), result);
+    checkLabels(rhs, QObject::tr(" in the RHS"), result);
+
+    // As in RuleEdit::updateVariables(), every RHS variable must be bound by
+    // the LHS
+    QStringList lhsVariables = graphVariables(lhs);
+    QStringList rhsVariables = graphVariables(rhs);
+    for(int i = 0; i < rhsVariables.size(); ++i)
+    {
+        if(!lhsVariables.contains(rhsVariables.at(i)))
+            addIssue(result, 0, QObject::tr("The variable '%1' does not "
+                                            "appear in the LHS.").arg(
+                         rhsVariables.at(i)));
+    }
+
+    // Declared parameter types must agree with the way the variables are used
+    TypeInference inference;
+    inference.addVariables(lhsVariables);
+    inference.addVariables(rhsVariables);
+    for(size_t i = 0; i < rule.parameters.size(); ++i)
+    {
+        const param_t &parameter = rule.parameters.at(i);
+        for(size_t j = 0; j < parameter.variables.size(); ++j)
+            inference.declare(parameter.variables.at(j).c_str(),
+                              parameter.type.c_str());
+    }
+    if(rule.condition.is_initialized())
+        inference.addCondition(QString(rule.condition.get().c_str()));
+
+    QStringList typeErrors = inference.errors();
+    for(int i = 0; i < typeErrors.size(); ++i)
+        addIssue(result, 0, typeErrors.at(i));
+
+    QSet<QString> lhsNodes = graphNodes(lhs);
+    QSet<QString> rhsNodes = graphNodes(rhs);
+    for(size_t i = 0; i < rule.interfaces.size(); ++i)
+    {
+        const interface_t &pair = rule.interfaces.at(i);
+        if(!lhsNodes.contains(pair.lhsId.c_str()))
+            addIssue(result, 0, QObject::tr("The interface refers to node "
+                                            "'%1' which is not in the "
+                                            "LHS.").arg(
+                         pair.lhsId.c_str()));
+        if(!rhsNodes.contains(pair.rhsId.c_str()))
+            addIssue(result, 0, QObject::tr("The interface refers to node "
+                                            "'%1' which is not in the "
+                                            "RHS.").arg(
+                         pair.rhsId.c_str()));
+    }
+}
+
+void validateProgram(const ValidationSnapshot &snapshot,
+                     FileValidation *result)
+{
+    ProgramSnapshot program;
+    program.filePath = snapshot.filePath;
+    program.text = snapshot.text;
+    QVector<SymbolReference> references = SymbolIndex::scanProgram(program);
+
+    // References come back in order, so lines can be counted as we go
+    int line = 1;
+    int position = 0;
+    for(int i = 0; i < references.size(); ++i)
+    {
+        const SymbolReference &reference = references.at(i);
+        for(; position < reference.startPos
+            && position < snapshot.text.length(); ++position)
+        {
+            if(snapshot.text.at(position) == '\n')
+                ++line;
+        }
+
+        if(reference.type == SymbolReference_MacroDefinition)
+            result->macros.insert(reference.symbol);
+        else
+            result->uses.push_back(qMakePair(reference.symbol, line));
+    }
+}
+
+void validateGraph(const ValidationSnapshot &snapshot, FileValidation *result)
+{
+    graph_t graph = parseAlternativeGraph(snapshot.text.toStdString());
+    checkLabels(graph, QString(), result);
+}
+
+}
+
+ProjectValidator::ProjectValidator(Project *project)
+    : QObject(project)
+    , _project(project)
+    , _checkedCount(0)
+{
+    // Each change to a file's contents, in memory or on disk, passes through
+    // its status
+    connect(project, SIGNAL(ruleStatusChanged(QString,int)),
+            this, SLOT(markDirty(QString)));
+    connect(project, SIGNAL(programStatusChanged(QString,int)),
+            this, SLOT(markDirty(QString)));
+    connect(project, SIGNAL(graphStatusChanged(QString,int)),
+            this, SLOT(markDirty(QString)));
+    connect(project, SIGNAL(fileListChanged()),
+            this, SLOT(forgetSnapshots()));
+}
+
+QVector<ValidationIssue> ProjectValidator::validate()
+{
+    // Only files without a current snapshot are read and hashed, which is
+    // spread across the thread pool as well as the checks themselves
+    QVector<ValidationSnapshot> current = snapshots();
+    QVector<ValidationSnapshot> fresh;
+    QVector<int> freshIndices;
+    for(int i = 0; i < current.size(); ++i)
+    {
+        if(current.at(i).hash.isEmpty())
+        {
+            fresh.push_back(current.at(i));
+            freshIndices.push_back(i);
+        }
+    }
+
+    QtConcurrent::blockingMap(fresh, &loadSnapshot);
+    for(int i = 0; i < fresh.size(); ++i)
+    {
+        current[freshIndices.at(i)] = fresh.at(i);
+        _snapshots.insert(fresh.at(i).filePath, fresh.at(i));
+    }
+    _dirty.clear();
+
+    QSet<QString> present;
+    QList<ValidationSnapshot> stale;
+    for(int i = 0; i < current.size(); ++i)
+    {
+        const ValidationSnapshot &snapshot = current.at(i);
+        present.insert(snapshot.filePath);
+
+        QHash<QString, FileValidation>::const_iterator cached =
+                _files.constFind(snapshot.filePath);
+        if(cached == _files.constEnd() || cached.value().hash != snapshot.hash)
+            stale << snapshot;
+    }
+
+    // Forget files which have left the project
+    QStringList cachedPaths = _files.keys();
+    for(int i = 0; i < cachedPaths.size(); ++i)
+    {
+        if(!present.contains(cachedPaths.at(i)))
+        {
+            _files.remove(cachedPaths.at(i));
+            _resolved.remove(cachedPaths.at(i));
+        }
+    }
+
+    QStringList snapshotPaths = _snapshots.keys();
+    for(int i = 0; i < snapshotPaths.size(); ++i)
+    {
+        if(!present.contains(snapshotPaths.at(i)))
+            _snapshots.remove(snapshotPaths.at(i));
+    }
+
+    QList<FileValidation> results = QtConcurrent::blockingMapped(
+                stale, &ProjectValidator::validateFile);
+    QSet<QString> changed;
+    for(int i = 0; i < results.size(); ++i)
+    {
+        _files.insert(results.at(i).filePath, results.at(i));
+        changed.insert(results.at(i).filePath);
+    }
+    _checkedCount = results.size();
+
+    // Programs depend on the rules they call, find the rule names which have
+    // appeared or disappeared so those callers can be resolved again
+    QSet<QString> ruleNames;
+    for(QHash<QString, FileValidation>::const_iterator iter = _files.constBegin();
+        iter != _files.constEnd(); ++iter)
+    {
+        const FileValidation &file = iter.value();
+        if(file.type == Project::RuleFile && !file.ruleName.isEmpty())
+            ruleNames.insert(file.ruleName);
+    }
+
+    QSet<QString> added = ruleNames;
+    added.subtract(_ruleNames);
+    QSet<QString> affectedNames = _ruleNames;
+    affectedNames.subtract(ruleNames);
+    affectedNames.unite(added);
+    _ruleNames = ruleNames;
+
+    QVector<ValidationIssue> ret;
+    for(int i = 0; i < current.size(); ++i)
+    {
+        const FileValidation &file = _files[current.at(i).filePath];
+        ret += file.issues;
+
+        if(file.type != Project::ProgramFile)
+            continue;
+
+        bool resolve = changed.contains(file.filePath)
+                || !_resolved.contains(file.filePath);
+        for(int j = 0; !resolve && j < file.uses.size(); ++j)
+            resolve = affectedNames.contains(file.uses.at(j).first);
+
+        if(resolve)
+        {
+            resolveProgram(file);
+            if(!changed.contains(file.filePath))
+                ++_checkedCount;
+        }
+        ret += _resolved.value(file.filePath);
+    }
+
+    return ret;
+}
+
+QVector<ValidationIssue> ProjectValidator::issues(const QString &filePath) const
+{
+    QVector<ValidationIssue> ret = _files.value(filePath).issues;
+    ret += _resolved.value(filePath);
+    return ret;
+}
+
+int ProjectValidator::checkedCount() const
+{
+    return _checkedCount;
+}
+
+FileValidation ProjectValidator::validateFile(const ValidationSnapshot &snapshot)
+{
+    FileValidation result;
+    result.filePath = snapshot.filePath;
+    result.type = snapshot.type;
+    result.hash = snapshot.hash;
+
+    switch(snapshot.type)
+    {
+    case Project::RuleFile:
+        validateRule(snapshot, &result);
+        break;
+    case Project::ProgramFile:
+        validateProgram(snapshot, &result);
+        break;
+    case Project::GraphFile:
+        validateGraph(snapshot, &result);
+        break;
+    default:
+        qDebug() << "Invalid file type passed into "
+                 << "ProjectValidator::validateFile()";
+    }
+
+    return result;
+}
+
+void ProjectValidator::invalidate()
+{
+    _files.clear();
+    _resolved.clear();
+    _ruleNames.clear();
+    forgetSnapshots();
+}
+
+void ProjectValidator::markDirty(const QString &filePath)
+{
+    _dirty.insert(filePath);
+}
+
+void ProjectValidator::forgetSnapshots()
+{
+    // Files may have been replaced or renamed, the validation results are
+    // keyed by hash and so survive this
+    _snapshots.clear();
+    _dirty.clear();
+}
+
+QVector<ValidationSnapshot> ProjectValidator::snapshots() const
+{
+    QVector<ValidationSnapshot> ret;
+
+    // Unmodified rules are read back from disk, the in-memory Rule does not
+    // keep everything the file holds (such as the interface)
+    QVector<Rule *> rules = _project->rules();
+    for(int i = 0; i < rules.size(); ++i)
+    {
+        Rule *rule = rules.at(i);
+        if(cachedSnapshot(rule->path(), &ret))
+            continue;
+
+        ValidationSnapshot snapshot;
+        snapshot.filePath = rule->path();
+        snapshot.type = Project::RuleFile;
+        if(rule->status() == GPFile::Modified)
+            snapshot.text = rule->toString();
+        else
+            snapshot.fromDisk = true;
+        ret.push_back(snapshot);
+    }
+
+    QVector<Program *> programs = _project->programs();
+    for(int i = 0; i < programs.size(); ++i)
+    {
+        if(cachedSnapshot(programs.at(i)->path(), &ret))
+            continue;
+
+        ValidationSnapshot snapshot;
+        snapshot.filePath = programs.at(i)->path();
+        snapshot.type = Project::ProgramFile;
+        snapshot.text = programs.at(i)->program();
+        ret.push_back(snapshot);
+    }
+
+    // Graphs may be in any of the supported formats on disk, so they are
+    // always taken from memory in the alternative format
+    QVector<Graph *> graphs = _project->graphs();
+    for(int i = 0; i < graphs.size(); ++i)
+    {
+        if(cachedSnapshot(graphs.at(i)->path(), &ret))
+            continue;
+
+        ValidationSnapshot snapshot;
+        snapshot.filePath = graphs.at(i)->path();
+        snapshot.type = Project::GraphFile;
+        snapshot.text = graphs.at(i)->toAlternative();
+        ret.push_back(snapshot);
+    }
+
+    return ret;
+}
+
+/*!
+ * \brief Append the snapshot kept for a file, if the file has not changed
+ *  since it was taken
+ * \return True if a snapshot was appended
+ */
+bool ProjectValidator::cachedSnapshot(
+        const QString &filePath, QVector<ValidationSnapshot> *snapshots) const
+{
+    if(_dirty.contains(filePath))
+        return false;
+
+    QHash<QString, ValidationSnapshot>::const_iterator cached =
+            _snapshots.constFind(filePath);
+    if(cached == _snapshots.constEnd())
+        return false;
+
+    snapshots->push_back(cached.value());
+    return true;
+}
+
+void ProjectValidator::resolveProgram(const FileValidation &program)
+{
+    QVector<ValidationIssue> issues;
+    for(int i = 0; i < program.uses.size(); ++i)
+    {
+        const QString &symbol = program.uses.at(i).first;
+        if(_ruleNames.contains(symbol) || program.macros.contains(symbol))
+            continue;
+
+        ValidationIssue issue;
+        issue.filePath = program.filePath;
+        issue.line = program.uses.at(i).second;
+        issue.message = tr("No rule or macro named '%1' exists in this "
+                           "project.").arg(symbol);
+        issues.push_back(issue);
+    }
+
+    _resolved.insert(program.filePath, issues);
+}
+
+}
@@ -0,0 +1,214 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PROJECTVALIDATOR_HPP
+#define PROJECTVALIDATOR_HPP
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+namespace Developer {
+
+class Project;
+
+/*!
+ * \brief The ValidationIssue struct describes a single problem found by the
+ *  project validator
+ */
+struct ValidationIssue
+{
+    ValidationIssue()
+        : line(0)
+    {
+    }
+
+    //! The path of the file containing the problem, as given by
+    //! GPFile::path()
+    QString filePath;
+    //! The line the problem is on, starting from 1, or 0 if the problem
+    //! concerns the file as a whole
+    int line;
+    //! A description of the problem
+    QString message;
+};
+
+/*!
+ * \brief The ValidationSnapshot struct carries the contents of a project file
+ *  to be validated on a worker thread
+ */
+struct ValidationSnapshot
+{
+    ValidationSnapshot()
+        : type(0)
+        , fromDisk(false)
+    {
+    }
+
+    QString filePath;
+    //! The type of file, a value from the Project::FileTypes enum
+    int type;
+    //! Whether the text still needs to be read from the file on disk
+    bool fromDisk;
+    QString text;
+    //! A hash of the type and text, used to detect unchanged files
+    QByteArray hash;
+};
+
+/*!
+ * \brief The FileValidation struct holds the result of validating a single
+ *  file, which is everything the validator needs to know about the file
+ *  without looking at it again
+ */
+struct FileValidation
+{
+    FileValidation()
+        : type(0)
+    {
+    }
+
+    QString filePath;
+    int type;
+    //! The hash of the snapshot this result was produced from
+    QByteArray hash;
+    //! Problems found within the file itself
+    QVector<ValidationIssue> issues;
+    //! For rules, the name the rule defines
+    QString ruleName;
+    //! For programs, the rules and macros called along with the line of each
+    //! call
+    QVector<QPair<QString, int> > uses;
+    //! For programs, the macros the program declares
+    QSet<QString> macros;
+};
+
+/*!
+ * \brief The ProjectValidator class checks every file in a project for
+ *  problems
+ *
+ * The checks made are:
+ *  - each rule or macro called from a program exists, either as a rule in
+ *    the project or a macro in the same program
+ *  - each variable in a rule's RHS also appears in its LHS
+ *  - each interface pair refers to nodes which exist in the LHS and RHS
+ *  - each node and edge label parses cleanly (List::isClean())
+ *  - each variable is used consistently with its declared type and its other
+ *    uses (see TypeInference)
+ *
+ * Each file is validated on its own across the global thread pool, and the
+ * result is cached against a hash of the file's contents. Validating again
+ * after an edit therefore only re-checks the files which actually changed.
+ * Programs are the only files which depend on others, so the check that
+ * their calls resolve is repeated for a program when it changes or when a rule
+ * named in one of its calls appears or disappears.
+ *
+ * Rules and graphs are checked as they are on disk unless they have unsaved
+ * changes, in which case the in-memory version is checked. Programs are always
+ * checked as they are in memory.
+ *
+ * The snapshot taken of each file is kept as well, and is only taken again
+ * once the project reports a change in the file's status or a change to its
+ * list of files. Files which have not changed are therefore neither read nor
+ * hashed again.
+ */
+class ProjectValidator : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+     * \brief Construct a validator for the provided project
+     * \param project   The project to validate, this is also the parent object
+     */
+    explicit ProjectValidator(Project *project);
+
+    /*!
+     * \brief Validate the whole project, re-checking only what has changed
+     *  since the last call
+     * \return Every problem found in the project
+     */
+    QVector<ValidationIssue> validate();
+
+    /*!
+     * \brief Get the problems found in a file by the last validation
+     * \param filePath  The path of the file, as given by GPFile::path()
+     * \return The problems found within the file
+     */
+    QVector<ValidationIssue> issues(const QString &filePath) const;
+
+    /*!
+     * \brief Get the number of files which were checked by the last call to
+     *  validate(), rather than being taken from the cache
+     *
+     * Programs which were only resolved again because a rule they call
+     * appeared or disappeared are included.
+     *
+     * \return The number of files checked
+     */
+    int checkedCount() const;
+
+    /*!
+     * \brief Validate a single file
+     *
+     * This does not touch the cache and is safe to call from any thread.
+     *
+     * \param snapshot  The file to validate
+     * \return The result of validating the file
+     */
+    static FileValidation validateFile(const ValidationSnapshot &snapshot);
+
+public slots:
+    /*!
+     * \brief Discard all cached results, everything is checked again on the
+     *  next call to validate()
+     */
+    void invalidate();
+
+private slots:
+    void markDirty(const QString &filePath);
+    void forgetSnapshots();
+
+private:
+    QVector<ValidationSnapshot> snapshots() const;
+    bool cachedSnapshot(const QString &filePath,
+                        QVector<ValidationSnapshot> *snapshots) const;
+    void resolveProgram(const FileValidation &program);
+
+    Project *_project;
+    //! The snapshot last taken of each file
+    QHash<QString, ValidationSnapshot> _snapshots;
+    //! The files which have changed since their snapshot was taken
+    QSet<QString> _dirty;
+    //! The cached result for each file
+    QHash<QString, FileValidation> _files;
+    //! The problems found when resolving each program's calls
+    QHash<QString, QVector<ValidationIssue> > _resolved;
+    //! The rule names defined in the project as of the last validation
+    QSet<QString> _ruleNames;
+    int _checkedCount;
+};
+
+}
+
+#endif // PROJECTVALIDATOR_HPP
@@ -29,6 +29,8 @@ Results::Results(QWidget *parent)
 {
     _ui->setupUi(this);
 
+    // Result graphs are not edited, so they are painted from cached tiles
+    _ui->graphWidget->setTiledRendering(true);
 
     QStringList items;
     items << "Results";
@@ -108,14 +108,14 @@ void Rule::setLhs(Graph *lhsGraph)
 void Rule::setRhs(Graph *rhsGraph)
 {
     _rhs = rhsGraph;
-    connect(_lhs, SIGNAL(statusChanged(FileStatus)), this, SLOT(rhsGraphChanged()));
+    connect(_rhs, SIGNAL(statusChanged(FileStatus)), this, SLOT(rhsGraphChanged()));
     _status = Modified;
     emit statusChanged(_status);
 }
 
 void Rule::setCondition(const QString &conditionString)
 {
-    if(conditionString.isEmpty() || conditionString == _condition)
+    if(conditionString == _condition)
         return;
 
     _condition = conditionString;
@@ -148,17 +148,8 @@ void Rule::setInjectiveMatching(bool injective)
         _options &= ~Rule_InjectiveMatching;
 }
 
-bool Rule::save()
+QString Rule::toString() const
 {
-    // Some initial sanity checks
-    if(_path.isEmpty() || !_fp->isOpen())
-        return false;
-
-    _fp->close();
-    ++_internalChanges;
-    _fp->open(QFile::Truncate | QFile::WriteOnly);
-    qDebug() << "Saving rule file: " << _fp->fileName();
-
     // Construct the save file, this means making the documentation into a
     // comment and then concatenating the program contents
     QString docText = _documentation;
@@ -182,6 +173,22 @@ bool Rule::save()
     saveText += _condition;
     saveText += "\n";
 
+    return saveText;
+}
+
+bool Rule::save()
+{
+    // Some initial sanity checks
+    if(_path.isEmpty() || !_fp->isOpen())
+        return false;
+
+    _fp->close();
+    ++_internalChanges;
+    _fp->open(QFile::Truncate | QFile::WriteOnly);
+    qDebug() << "Saving rule file: " << _fp->fileName();
+
+    QString saveText = toString();
+
     ++_internalChanges;
     int status = _fp->write(QVariant(saveText).toByteArray());
     if(status <= 0)
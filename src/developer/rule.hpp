@@ -90,6 +90,12 @@ public:
     void setOptions(int options);
     void setInjectiveMatching(bool injective);
 
+    /*!
+     * \brief Get the contents this rule would be saved with
+     * \return The rule in the GP rule file format
+     */
+    QString toString() const;
+
     bool save();
     bool saveAs(const QString &filePath);
 
@@ -24,6 +24,9 @@
 #include "rule.hpp"
 #include "helpdialog.hpp"
 #include "graph.hpp"
+#include "typeinference.hpp"
+
+#include <QComboBox>
 
 namespace Developer {
 
@@ -33,6 +36,9 @@ RuleEdit::RuleEdit(QWidget *parent)
     , _rule(0)
 {
     _ui->setupUi(this);
+
+    connect(_ui->conditionsEdit, SIGNAL(conditionParsed()),
+            this, SLOT(conditionParsed()));
 }
 
 RuleEdit::~RuleEdit()
@@ -43,6 +49,7 @@ RuleEdit::~RuleEdit()
 void RuleEdit::setRule(Rule *rule)
 {
     _rule = rule;
+    _chosenTypes.clear();
 
     _ui->nameEdit->setText(_rule->name());
     _ui->documentationEdit->setPlainText(_rule->documentation());
@@ -101,9 +108,37 @@ void RuleEdit::conditionChanged()
     if(_rule == 0)
         return;
 
+    // Keep the rule in step with the editor, so that its unsaved changes are
+    // seen by anything reading the rule, such as a search
+    _rule->setCondition(_ui->conditionsEdit->toPlainText());
     _ui->conditionsEdit->parse();
 }
 
+void RuleEdit::conditionParsed()
+{
+    if(_rule == 0)
+        return;
+
+    updateTypes();
+}
+
+void RuleEdit::typeChosen(int index)
+{
+    QComboBox *comboBox = qobject_cast<QComboBox *>(sender());
+    if(comboBox == 0)
+        return;
+
+    for(int row = 0; row < _ui->variablesWidget->rowCount(); ++row)
+    {
+        if(_ui->variablesWidget->cellWidget(row, 1) == comboBox)
+        {
+            _chosenTypes.insert(_ui->variablesWidget->item(row, 0)->text(),
+                                index);
+            return;
+        }
+    }
+}
+
 void RuleEdit::updateVariables()
 {
     _ui->variablesWidget->clear();
@@ -122,12 +157,12 @@ void RuleEdit::updateVariables()
 
     // Remove all the variables from the LHS from the RHS set, those that
     // remain are currently errors as they do not exist in the LHS
-    QStringList diff = rhsVariables;
+    _rhsOnly = rhsVariables;
     for(int i = 0; i < lhsVariables.length(); ++i)
     {
         QString variable = lhsVariables.at(i);
-        if(diff.contains(variable))
-            diff.removeOne(variable);
+        if(_rhsOnly.contains(variable))
+            _rhsOnly.removeOne(variable);
     }
 
     QStringList types;
@@ -138,7 +173,7 @@ void RuleEdit::updateVariables()
         QTableWidgetItem *item = new QTableWidgetItem(variable);
         item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
 
-        if(diff.contains(variable))
+        if(_rhsOnly.contains(variable))
         {
             item->setToolTip(tr("The variable '%1' does not appear in the LHS. "
                                 "All variables in the RHS must appear in the "
@@ -150,8 +185,64 @@ void RuleEdit::updateVariables()
 
         QComboBox *comboBox = new QComboBox(_ui->variablesWidget);
         comboBox->addItems(types);
+        // Only picks made by the user are remembered
+        connect(comboBox, SIGNAL(activated(int)), this, SLOT(typeChosen(int)));
         _ui->variablesWidget->setCellWidget(i, 1, comboBox);
     }
+
+    updateTypes();
+}
+
+void RuleEdit::updateTypes()
+{
+    // The rows are updated in place, so the tokens of the last background
+    // parse are all that is needed
+    QStringList variables;
+    for(int row = 0; row < _ui->variablesWidget->rowCount(); ++row)
+        variables << _ui->variablesWidget->item(row, 0)->text();
+
+    TypeInference inference;
+    inference.addVariables(variables);
+    inference.addCondition(_ui->conditionsEdit->tokens());
+
+    for(int row = 0; row < variables.length(); ++row)
+    {
+        QString variable = variables.at(row);
+        QTableWidgetItem *item = _ui->variablesWidget->item(row, 0);
+        QComboBox *comboBox = qobject_cast<QComboBox *>(
+                    _ui->variablesWidget->cellWidget(row, 1));
+
+        int type = inference.type(variable);
+        if(!_rhsOnly.contains(variable))
+        {
+            if(type == VariableType_Conflict)
+            {
+                item->setToolTip(tr("The variable '%1' is used as "
+                                    "incompatible types: %2.").arg(
+                                     variable,
+                                     inference.reasons(variable).join(", ")));
+                item->setBackgroundColor(QColor(0xff,0xaa,0xaa,0x55));
+            }
+            else
+            {
+                if(inference.reasons(variable).isEmpty())
+                    item->setToolTip(QString());
+                else
+                    item->setToolTip(tr("Inferred from use: %1.").arg(
+                                         inference.reasons(variable).join(
+                                             ", ")));
+                item->setBackground(QBrush());
+            }
+        }
+
+        if(comboBox == 0)
+            continue;
+
+        if(_chosenTypes.contains(variable))
+            comboBox->setCurrentIndex(_chosenTypes.value(variable));
+        else if(type != VariableType_Conflict)
+            comboBox->setCurrentIndex(type);
+    }
 }
 
 }
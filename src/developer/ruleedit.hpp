@@ -21,6 +21,8 @@
 #ifndef RULEEDIT_HPP
 #define RULEEDIT_HPP
 
+#include <QHash>
+#include <QStringList>
 #include <QWidget>
 
 namespace Ui {
@@ -33,6 +35,11 @@ class Rule;
 
 /*!
  * \brief The RuleEdit class encapsulates the UI components for editing rules
+ *
+ * The variables table lists each variable in the LHS and RHS graphs with a
+ * type. The type is preselected from the condition by TypeInference each
+ * time the condition editor finishes a background parse, unless the user has
+ * chosen one for that variable.
  */
 class RuleEdit : public QWidget
 {
@@ -67,8 +74,11 @@ public slots:
     void rhsChanged();
     void injectiveChanged(int index);
     void conditionChanged();
+    void conditionParsed();
+    void typeChosen(int index);
 
     void updateVariables();
+    void updateTypes();
 
     /*!
      * \brief Slot to handle displaying the "injective matching" help page from
@@ -79,6 +89,10 @@ public slots:
 private:
     Ui::RuleEdit *_ui;
     Rule *_rule;
+    //! Variables in the RHS which are missing from the LHS
+    QStringList _rhsOnly;
+    //! Types picked by the user, which inference leaves alone
+    QHash<QString, int> _chosenTypes;
 };
 
 }
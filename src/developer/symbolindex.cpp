@@ -0,0 +1,331 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "symbolindex.hpp"
+#include "project.hpp"
+#include "programparser.hpp"
+
+#include <QDebug>
+#include <QtAlgorithms>
+#include <QtConcurrentMap>
+
+namespace Developer {
+
+static bool referenceStartGreaterThan(const SymbolReference &a,
+                                      const SymbolReference &b)
+{
+    return a.startPos > b.startPos;
+}
+
+SymbolIndex::SymbolIndex(Project *project)
+    : QObject(project)
+    , _project(project)
+    , _rebuild(true)
+{
+    connect(_project, SIGNAL(programStatusChanged(QString,int)),
+            this, SLOT(programChanged(QString)));
+    connect(_project, SIGNAL(ruleStatusChanged(QString,int)),
+            this, SLOT(ruleChanged(QString)));
+    connect(_project, SIGNAL(fileListChanged()), this, SLOT(invalidate()));
+}
+
+QVector<SymbolReference> SymbolIndex::references(const QString &symbol)
+{
+    update();
+    return _references.value(symbol);
+}
+
+QVector<SymbolReference> SymbolIndex::definitions(const QString &symbol)
+{
+    QVector<SymbolReference> all = references(symbol);
+    QVector<SymbolReference> ret;
+    for(int i = 0; i < all.size(); ++i)
+    {
+        if(all.at(i).type != SymbolReference_Use)
+            ret.push_back(all.at(i));
+    }
+
+    return ret;
+}
+
+QVector<SymbolReference> SymbolIndex::uses(const QString &symbol)
+{
+    QVector<SymbolReference> all = references(symbol);
+    QVector<SymbolReference> ret;
+    for(int i = 0; i < all.size(); ++i)
+    {
+        if(all.at(i).type == SymbolReference_Use)
+            ret.push_back(all.at(i));
+    }
+
+    return ret;
+}
+
+QStringList SymbolIndex::callers(const QString &symbol)
+{
+    QVector<SymbolReference> all = uses(symbol);
+    QStringList ret;
+    for(int i = 0; i < all.size(); ++i)
+    {
+        if(!ret.contains(all.at(i).filePath))
+            ret << all.at(i).filePath;
+    }
+
+    return ret;
+}
+
+QStringList SymbolIndex::symbols()
+{
+    update();
+    return _references.keys();
+}
+
+bool SymbolIndex::contains(const QString &symbol)
+{
+    update();
+    return _references.contains(symbol);
+}
+
+int SymbolIndex::rename(const QString &symbol, const QString &replacement)
+{
+    // Only rename to something the program parser will accept as an identifier
+    Lexer lexer(ProgramLanguage);
+    int lexeme = ProgramLexeme_Error;
+    if(replacement.isEmpty()
+            || lexer.match(replacement, 0, &lexeme) != replacement.length()
+            || lexeme != ProgramLexeme_Identifier)
+        return SymbolRename_InvalidIdentifier;
+
+    QVector<SymbolReference> all = references(symbol);
+    if(all.isEmpty() || symbol == replacement)
+        return 0;
+
+    // Uses of an undefined name are fine to adopt, a definition is not
+    QVector<SymbolReference> existing = references(replacement);
+    for(int i = 0; i < existing.size(); ++i)
+    {
+        if(existing.at(i).type != SymbolReference_Use)
+            return SymbolRename_AlreadyDefined;
+    }
+
+    // Split the references up by file, rules are renamed directly
+    int renamed = 0;
+    QHash<QString, QVector<SymbolReference> > byFile;
+    QVector<Rule *> rules = _project->rules();
+    for(int i = 0; i < all.size(); ++i)
+    {
+        const SymbolReference &reference = all.at(i);
+        if(reference.type != SymbolReference_RuleDefinition)
+        {
+            byFile[reference.filePath].push_back(reference);
+            continue;
+        }
+
+        for(int j = 0; j < rules.size(); ++j)
+        {
+            if(rules.at(j)->path() == reference.filePath)
+            {
+                rules.at(j)->setName(replacement);
+                ++renamed;
+            }
+        }
+    }
+
+    QVector<Program *> programs = _project->programs();
+    for(int i = 0; i < programs.size(); ++i)
+    {
+        Program *program = programs.at(i);
+        if(!byFile.contains(program->path()))
+            continue;
+
+        // Work backwards through the program so that the earlier positions
+        // are not shifted by the replacements
+        QVector<SymbolReference> references = byFile.value(program->path());
+        qSort(references.begin(), references.end(), referenceStartGreaterThan);
+
+        QString text = program->program();
+        for(int j = 0; j < references.size(); ++j)
+        {
+            const SymbolReference &reference = references.at(j);
+            int length = reference.endPos - reference.startPos;
+            if(text.mid(reference.startPos, length) != symbol)
+            {
+                qDebug() << "SymbolIndex::rename() found a stale reference to"
+                         << symbol << "in" << program->path();
+                continue;
+            }
+
+            text.replace(reference.startPos, length, replacement);
+            ++renamed;
+        }
+
+        program->setProgram(text);
+    }
+
+    return renamed;
+}
+
+void SymbolIndex::update()
+{
+    if(_rebuild)
+    {
+        _references.clear();
+        _fileSymbols.clear();
+        _dirtyPrograms.clear();
+        _dirtyRules.clear();
+
+        QVector<Rule *> rules = _project->rules();
+        for(int i = 0; i < rules.size(); ++i)
+            _dirtyRules.insert(rules.at(i)->path());
+        QVector<Program *> programs = _project->programs();
+        for(int i = 0; i < programs.size(); ++i)
+            _dirtyPrograms.insert(programs.at(i)->path());
+
+        _rebuild = false;
+    }
+
+    if(_dirtyPrograms.isEmpty() && _dirtyRules.isEmpty())
+        return;
+
+    // Drop everything the dirty files contributed, this also handles files
+    // which are no longer part of the project
+    for(QSet<QString>::const_iterator iter = _dirtyRules.constBegin();
+        iter != _dirtyRules.constEnd(); ++iter)
+        removeFile(*iter);
+    for(QSet<QString>::const_iterator iter = _dirtyPrograms.constBegin();
+        iter != _dirtyPrograms.constEnd(); ++iter)
+        removeFile(*iter);
+
+    // Rules only define their own name
+    QVector<Rule *> rules = _project->rules();
+    for(int i = 0; i < rules.size(); ++i)
+    {
+        Rule *rule = rules.at(i);
+        if(!_dirtyRules.contains(rule->path()) || rule->name().isEmpty())
+            continue;
+
+        SymbolReference reference;
+        reference.type = SymbolReference_RuleDefinition;
+        reference.symbol = rule->name();
+        reference.filePath = rule->path();
+        addReference(reference);
+    }
+
+    // Programs need parsing, which is spread across the thread pool
+    QList<ProgramSnapshot> snapshots;
+    QVector<Program *> programs = _project->programs();
+    for(int i = 0; i < programs.size(); ++i)
+    {
+        Program *program = programs.at(i);
+        if(!_dirtyPrograms.contains(program->path()))
+            continue;
+
+        ProgramSnapshot snapshot;
+        snapshot.filePath = program->path();
+        snapshot.text = program->program();
+        snapshots << snapshot;
+    }
+
+    QList<QVector<SymbolReference> > results = QtConcurrent::blockingMapped(
+                snapshots, &SymbolIndex::scanProgram);
+    for(int i = 0; i < results.size(); ++i)
+    {
+        const QVector<SymbolReference> &references = results.at(i);
+        for(int j = 0; j < references.size(); ++j)
+            addReference(references.at(j));
+    }
+
+    _dirtyPrograms.clear();
+    _dirtyRules.clear();
+}
+
+QVector<SymbolReference> SymbolIndex::scanProgram(
+        const ProgramSnapshot &program)
+{
+    TokenBuffer tokens;
+    ProgramParser parser;
+    parser.parseProgram(program.text, &tokens);
+
+    QVector<SymbolReference> ret;
+    for(int i = 0; i < tokens.size(); ++i)
+    {
+        const Token &token = tokens.at(i);
+
+        SymbolReference reference;
+        if(token.lexeme == ProgramLexeme_Identifier)
+            reference.type = SymbolReference_Use;
+        else if(token.lexeme == ProgramLexeme_Declaration)
+            reference.type = SymbolReference_MacroDefinition;
+        else
+            continue;
+
+        reference.symbol = token.text;
+        reference.filePath = program.filePath;
+        reference.startPos = token.startPos;
+        reference.endPos = token.endPos;
+        ret.push_back(reference);
+    }
+
+    return ret;
+}
+
+void SymbolIndex::invalidate()
+{
+    _rebuild = true;
+}
+
+void SymbolIndex::programChanged(QString filePath)
+{
+    _dirtyPrograms.insert(filePath);
+}
+
+void SymbolIndex::ruleChanged(QString filePath)
+{
+    _dirtyRules.insert(filePath);
+}
+
+void SymbolIndex::removeFile(const QString &filePath)
+{
+    QSet<QString> symbols = _fileSymbols.take(filePath);
+    for(QSet<QString>::const_iterator iter = symbols.constBegin();
+        iter != symbols.constEnd(); ++iter)
+    {
+        QVector<SymbolReference> &references = _references[*iter];
+        QVector<SymbolReference> kept;
+        for(int i = 0; i < references.size(); ++i)
+        {
+            if(references.at(i).filePath != filePath)
+                kept.push_back(references.at(i));
+        }
+
+        if(kept.isEmpty())
+            _references.remove(*iter);
+        else
+            references = kept;
+    }
+}
+
+void SymbolIndex::addReference(const SymbolReference &reference)
+{
+    _references[reference.symbol].push_back(reference);
+    _fileSymbols[reference.filePath].insert(reference.symbol);
+}
+
+}
@@ -0,0 +1,234 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SYMBOLINDEX_HPP
+#define SYMBOLINDEX_HPP
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+namespace Developer {
+
+class Project;
+
+/*!
+ * \brief The SymbolReferenceTypes enum describes how a symbol is referred to
+ */
+enum SymbolReferenceTypes
+{
+    //! A rule or macro being called from a program
+    SymbolReference_Use,
+    //! A macro declaration within a program (identifier = ...)
+    SymbolReference_MacroDefinition,
+    //! A rule file defining a rule of this name
+    SymbolReference_RuleDefinition
+};
+
+/*!
+ * \brief The SymbolRenameErrors enum lists the reasons SymbolIndex::rename()
+ *  can refuse a rename
+ */
+enum SymbolRenameErrors
+{
+    //! The replacement is not a valid identifier
+    SymbolRename_InvalidIdentifier = -1,
+    //! A rule or macro with the replacement name already exists
+    SymbolRename_AlreadyDefined = -2
+};
+
+/*!
+ * \brief The SymbolReference struct records a single occurrence of a symbol
+ *  within a project file
+ *
+ * Positions are offsets into the program text as returned by
+ * Program::program(), which is what the program editor displays. Rule
+ * definitions refer to the rule file as a whole and have an empty range.
+ */
+struct SymbolReference
+{
+    SymbolReference()
+        : type(SymbolReference_Use)
+        , startPos(0)
+        , endPos(0)
+    {
+    }
+
+    //! The type of reference, a value from the SymbolReferenceTypes enum
+    int type;
+    //! The symbol referred to
+    QString symbol;
+    //! The path of the file containing the reference, as given by
+    //! GPFile::path()
+    QString filePath;
+    //! The start position of the reference
+    int startPos;
+    //! The end position of the reference
+    int endPos;
+};
+
+/*!
+ * \brief The ProgramSnapshot struct carries the text of a program to be
+ *  scanned for symbols on a worker thread
+ */
+struct ProgramSnapshot
+{
+    QString filePath;
+    QString text;
+};
+
+/*!
+ * \brief The SymbolIndex class maintains an inverted index of the rule and
+ *  macro names used throughout a project
+ *
+ * Programs are scanned with the same ProgramParser used by the program editor,
+ * each identifier becomes a use of that symbol and each macro declaration a
+ * definition, and every rule in the project defines its name. The index maps
+ * each symbol to the references to it, so queries such as "which programs call
+ * this rule" are a single hash lookup no matter how large the project is.
+ *
+ * The index lives as long as its Project and is kept up to date
+ * incrementally. It listens for the status of files changing (edits, saves and
+ * changes picked up by the file watchers) and marks those files as dirty, only
+ * dirty files are scanned again and this is deferred until the next query.
+ * Changes to the list of files in the project cause a full rebuild. Scanning
+ * runs across a thread pool when several programs are dirty at once.
+ */
+class SymbolIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+     * \brief Construct an index over the provided project
+     *
+     * The index is built lazily, on the first query.
+     *
+     * \param project   The project to index, this is also the parent object
+     */
+    explicit SymbolIndex(Project *project);
+
+    /*!
+     * \brief Get every reference to the provided symbol
+     * \param symbol    The rule or macro name to look up
+     * \return The references found, definitions and uses alike
+     */
+    QVector<SymbolReference> references(const QString &symbol);
+    /*!
+     * \brief Get the definitions of the provided symbol
+     * \param symbol    The rule or macro name to look up
+     * \return The rule files and macro declarations defining this symbol
+     */
+    QVector<SymbolReference> definitions(const QString &symbol);
+    /*!
+     * \brief Get the uses of the provided symbol
+     * \param symbol    The rule or macro name to look up
+     * \return The places this symbol is called from
+     */
+    QVector<SymbolReference> uses(const QString &symbol);
+    /*!
+     * \brief Get the files which use the provided symbol
+     * \param symbol    The rule or macro name to look up
+     * \return The paths of the programs calling this symbol
+     */
+    QStringList callers(const QString &symbol);
+    /*!
+     * \brief Get all of the symbols known to the index
+     * \return The list of rule and macro names
+     */
+    QStringList symbols();
+    /*!
+     * \brief Check whether the provided symbol is referred to anywhere
+     * \param symbol    The rule or macro name to look up
+     * \return true if the symbol has any references, false otherwise
+     */
+    bool contains(const QString &symbol);
+
+    /*!
+     * \brief Rename a symbol throughout the project
+     *
+     * Every use and macro declaration is rewritten in the affected programs and
+     * rules of this name are renamed. The changes go through the usual
+     * Program and Rule setters, so the files are marked as modified and are
+     * saved in the normal way.
+     *
+     * Nothing is renamed if a rule or macro is already defined with the new
+     * name, as the two symbols would otherwise be merged silently.
+     *
+     * \param symbol        The rule or macro to rename
+     * \param replacement   The new name, which must be a valid identifier
+     * \return The number of references renamed, or a value from the
+     *  SymbolRenameErrors enum if the rename was refused
+     */
+    int rename(const QString &symbol, const QString &replacement);
+
+    /*!
+     * \brief Bring the index up to date by scanning any dirty files
+     *
+     * This is called automatically by each query.
+     */
+    void update();
+
+    /*!
+     * \brief Scan a single program for symbol references
+     *
+     * This does not touch the index and is safe to call from any thread.
+     *
+     * \param program   The program to scan
+     * \return The references found within the program
+     */
+    static QVector<SymbolReference> scanProgram(const ProgramSnapshot &program);
+
+public slots:
+    /*!
+     * \brief Discard the whole index, it is rebuilt on the next query
+     */
+    void invalidate();
+    /*!
+     * \brief Mark a program as needing to be scanned again
+     * \param filePath  The path of the program, as given by GPFile::path()
+     */
+    void programChanged(QString filePath);
+    /*!
+     * \brief Mark a rule as needing to be scanned again
+     * \param filePath  The path of the rule, as given by GPFile::path()
+     */
+    void ruleChanged(QString filePath);
+
+private:
+    void removeFile(const QString &filePath);
+    void addReference(const SymbolReference &reference);
+
+    Project *_project;
+    //! The inverted index from symbols to their references
+    QHash<QString, QVector<SymbolReference> > _references;
+    //! The symbols each file refers to, so a file can be removed without
+    //! visiting the whole index
+    QHash<QString, QSet<QString> > _fileSymbols;
+    QSet<QString> _dirtyPrograms;
+    QSet<QString> _dirtyRules;
+    bool _rebuild;
+};
+
+}
+
+#endif // SYMBOLINDEX_HPP
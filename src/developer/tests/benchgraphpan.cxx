@@ -0,0 +1,191 @@
+/*!
+ * \file
+ *
+ * This file contains a panning and zooming benchmark for GraphWidget. A large
+ * grid graph is loaded into a widget the size of a maximised graph view, then
+ * the view is scrolled and zoomed a step at a time and the time taken to paint
+ * each frame is reported, both item by item and from cached tiles. The tiled
+ * zoom figures include rendering the tiles for each new zoom level.
+ *
+ * This is not run as part of the test suite, run it by hand when working on the
+ * graph view. It requires a display (or QT_QPA_PLATFORM=offscreen under Qt 5).
+ * The number of nodes may be given as the first argument, graphs above
+ * VIRTUAL_GRAPH_THRESHOLD nodes and edges are shown virtualised.
+ */
+#include <iostream>
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QScrollBar>
+#include <QVariant>
+
+#include "graph.hpp"
+#include "graphview/graphscene.hpp"
+#include "graphview/graphwidget.hpp"
+
+using namespace Developer;
+
+//! The default number of nodes in the generated graph
+#define BENCHMARK_NODES 5000
+//! The number of nodes in each row of the generated grid
+#define BENCHMARK_COLUMNS 100
+//! The distance between neighbouring nodes in the grid
+#define BENCHMARK_SPACING 80
+//! The size of the widget, roughly that of a maximised graph view
+#define BENCHMARK_WIDTH 1280
+#define BENCHMARK_HEIGHT 800
+//! The number of frames panned, and the distance in pixels panned per frame
+#define BENCHMARK_PAN_FRAMES 60
+#define BENCHMARK_PAN_STEP 20
+//! The number of zoom steps taken out and then back in again
+#define BENCHMARK_ZOOM_FRAMES 10
+
+/*!
+ * \brief Generate a grid graph where every node has an edge to the node on
+ *  its right and the node below it
+ * \param graph     The graph to add the nodes and edges to
+ * \param nodeCount The number of nodes to generate
+ */
+void generateGraph(Graph *graph, int nodeCount)
+{
+    std::vector<Node *> nodes;
+    nodes.reserve(nodeCount);
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        QPointF pos((i % BENCHMARK_COLUMNS) * BENCHMARK_SPACING,
+                    (i / BENCHMARK_COLUMNS) * BENCHMARK_SPACING);
+        nodes.push_back(graph->addNode("n" + QVariant(i).toString(),
+                                       List(QVariant(i).toString()), pos));
+    }
+
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        if((i % BENCHMARK_COLUMNS) != BENCHMARK_COLUMNS - 1
+                && i + 1 < nodeCount)
+            graph->addEdge("r" + QVariant(i).toString(), nodes[i], nodes[i+1]);
+        if(i + BENCHMARK_COLUMNS < nodeCount)
+            graph->addEdge("d" + QVariant(i).toString(), nodes[i],
+                           nodes[i+BENCHMARK_COLUMNS]);
+    }
+}
+
+/*!
+ * \brief Paint the widget's viewport into an image and time it
+ * \param widget    The widget to paint
+ * \param image     The image to paint into
+ * \return The time taken in milliseconds
+ */
+qint64 timeFrame(GraphWidget *widget, QImage *image)
+{
+    QElapsedTimer timer;
+    timer.start();
+    widget->viewport()->render(image);
+    return timer.elapsed();
+}
+
+/*!
+ * \brief Scroll the widget across and back, painting each frame
+ * \param widget    The widget to pan
+ * \param worst     Output for the slowest frame time in milliseconds
+ * \return The mean frame time in milliseconds
+ */
+qint64 timePan(GraphWidget *widget, qint64 *worst)
+{
+    QImage image(widget->viewport()->size(),
+                 QImage::Format_ARGB32_Premultiplied);
+    QScrollBar *scrollBar = widget->horizontalScrollBar();
+    scrollBar->setValue(scrollBar->minimum());
+
+    qint64 total = 0;
+    *worst = 0;
+    for(int frame = 0; frame < BENCHMARK_PAN_FRAMES; ++frame)
+    {
+        // Out and back again, which is when cached tiles are reused
+        int step = (frame < BENCHMARK_PAN_FRAMES / 2) ? BENCHMARK_PAN_STEP
+                                                      : -BENCHMARK_PAN_STEP;
+        scrollBar->setValue(scrollBar->value() + step);
+
+        qint64 elapsed = timeFrame(widget, &image);
+        total += elapsed;
+        if(elapsed > *worst)
+            *worst = elapsed;
+    }
+
+    return total / BENCHMARK_PAN_FRAMES;
+}
+
+/*!
+ * \brief Zoom the widget out and back in again, painting each frame
+ * \param widget    The widget to zoom
+ * \param worst     Output for the slowest frame time in milliseconds
+ * \return The mean frame time in milliseconds
+ */
+qint64 timeZoom(GraphWidget *widget, qint64 *worst)
+{
+    QImage image(widget->viewport()->size(),
+                 QImage::Format_ARGB32_Premultiplied);
+
+    qint64 total = 0;
+    *worst = 0;
+    for(int frame = 0; frame < 2 * BENCHMARK_ZOOM_FRAMES; ++frame)
+    {
+        qreal factor = (frame < BENCHMARK_ZOOM_FRAMES) ? 1 / 1.2 : 1.2;
+        widget->scale(factor, factor);
+
+        qint64 elapsed = timeFrame(widget, &image);
+        total += elapsed;
+        if(elapsed > *worst)
+            *worst = elapsed;
+    }
+
+    widget->resetTransform();
+    return total / (2 * BENCHMARK_ZOOM_FRAMES);
+}
+
+/*!
+ * \brief Entry point for the benchmark, generate the graph and report the
+ *  frame times
+ * \return Integer, non-zero on any failure
+ */
+int main(int argc, char **argv)
+{
+    QApplication app(argc, argv);
+
+    int nodeCount = BENCHMARK_NODES;
+    if(argc > 1)
+        nodeCount = QString(argv[1]).toInt();
+    if(nodeCount < 1)
+    {
+        std::cerr << "Usage: " << argv[0] << " [node count]" << std::endl;
+        return 1;
+    }
+
+    Graph graph;
+    generateGraph(&graph, nodeCount);
+
+    GraphWidget widget;
+    widget.resize(BENCHMARK_WIDTH, BENCHMARK_HEIGHT);
+    widget.setGraph(&graph);
+    widget.show();
+    app.processEvents();
+    std::cout << "GraphWidget: " << graph.nodes().size() << " nodes, "
+              << graph.edges().size() << " edges" << std::endl;
+
+    for(int tiled = 0; tiled < 2; ++tiled)
+    {
+        widget.setTiledRendering(tiled == 1);
+        const char *mode = tiled ? "Tiled" : "Items";
+
+        qint64 worst = 0;
+        qint64 mean = timePan(&widget, &worst);
+        std::cout << mode << " pan: mean " << mean << "ms, worst " << worst
+                  << "ms" << std::endl;
+
+        mean = timeZoom(&widget, &worst);
+        std::cout << mode << " zoom: mean " << mean << "ms, worst " << worst
+                  << "ms" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*!
+ * \file
+ *
+ * This file contains a rendering benchmark for the graph view. A large grid
+ * graph is generated and loaded into a GraphScene, then a window's worth of
+ * the scene is rendered at several zoom levels and the frame times reported.
+ * The lower zoom levels exercise the reduced levels of detail drawn by
+ * NodeItem and EdgeItem.
+ *
+ * This is not run as part of the test suite, run it by hand when working on the
+ * graph view. It requires a display (or QT_QPA_PLATFORM=offscreen under Qt 5)
+ * as the items construct fonts. The number of nodes may be given as the first
+ * argument, smaller graphs load considerably faster.
+ */
+#include <iostream>
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPainter>
+#include <QVariant>
+
+#include "graph.hpp"
+#include "graphview/graphscene.hpp"
+
+using namespace Developer;
+
+//! The default number of nodes in the generated graph
+#define BENCHMARK_NODES 50000
+//! The number of nodes in each row of the generated grid
+#define BENCHMARK_COLUMNS 250
+//! The distance between neighbouring nodes in the grid
+#define BENCHMARK_SPACING 80
+//! The size of the rendered frame, roughly that of a maximised graph view
+#define BENCHMARK_WIDTH 1280
+#define BENCHMARK_HEIGHT 800
+//! The number of frames rendered at each zoom level
+#define BENCHMARK_RUNS 5
+
+/*!
+ * \brief Generate a grid graph where every node has an edge to the node on
+ *  its right and the node below it
+ * \param graph     The graph to add the nodes and edges to
+ * \param nodeCount The number of nodes to generate
+ */
+void generateGraph(Graph *graph, int nodeCount)
+{
+    std::vector<Node *> nodes;
+    nodes.reserve(nodeCount);
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        QPointF pos((i % BENCHMARK_COLUMNS) * BENCHMARK_SPACING,
+                    (i / BENCHMARK_COLUMNS) * BENCHMARK_SPACING);
+        nodes.push_back(graph->addNode("n" + QVariant(i).toString(),
+                                       List(QVariant(i).toString()), pos));
+    }
+
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        if((i % BENCHMARK_COLUMNS) != BENCHMARK_COLUMNS - 1
+                && i + 1 < nodeCount)
+            graph->addEdge("r" + QVariant(i).toString(), nodes[i], nodes[i+1]);
+        if(i + BENCHMARK_COLUMNS < nodeCount)
+            graph->addEdge("d" + QVariant(i).toString(), nodes[i],
+                           nodes[i+BENCHMARK_COLUMNS]);
+    }
+}
+
+/*!
+ * \brief Render the centre of the scene at the provided zoom level
+ * \param scene The scene to render
+ * \param zoom  The zoom level, 1.0 draws the scene at its natural size
+ * \param mean  Output for the mean frame time in milliseconds
+ * \return The fastest frame time in milliseconds
+ */
+qint64 timeFrames(GraphScene *scene, qreal zoom, qint64 *mean)
+{
+    QImage image(BENCHMARK_WIDTH, BENCHMARK_HEIGHT,
+                 QImage::Format_ARGB32_Premultiplied);
+    QRectF target(0, 0, BENCHMARK_WIDTH, BENCHMARK_HEIGHT);
+
+    QRectF source(0, 0, BENCHMARK_WIDTH / zoom, BENCHMARK_HEIGHT / zoom);
+    source.moveCenter(scene->itemsBoundingRect().center());
+
+    qint64 best = -1;
+    qint64 total = 0;
+    for(int run = 0; run < BENCHMARK_RUNS; ++run)
+    {
+        image.fill(0);
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing, true);
+
+        QElapsedTimer timer;
+        timer.start();
+        scene->render(&painter, target, source, Qt::IgnoreAspectRatio);
+        qint64 elapsed = timer.elapsed();
+
+        total += elapsed;
+        if(best < 0 || elapsed < best)
+            best = elapsed;
+    }
+
+    *mean = total / BENCHMARK_RUNS;
+    return best;
+}
+
+/*!
+ * \brief Entry point for the benchmark, generate the graph and report the
+ *  frame times
+ * \return Integer, non-zero on any failure
+ */
+int main(int argc, char **argv)
+{
+    QApplication app(argc, argv);
+
+    int nodeCount = BENCHMARK_NODES;
+    if(argc > 1)
+        nodeCount = QString(argv[1]).toInt();
+    if(nodeCount < 1)
+    {
+        std::cerr << "Usage: " << argv[0] << " [node count]" << std::endl;
+        return 1;
+    }
+
+    Graph graph;
+    generateGraph(&graph, nodeCount);
+
+    QElapsedTimer timer;
+    timer.start();
+    GraphScene scene;
+    scene.setGraph(&graph);
+    std::cout << "GraphScene: " << graph.nodes().size() << " nodes, "
+              << graph.edges().size() << " edges, loaded in "
+              << timer.elapsed() << "ms" << std::endl;
+
+    // Full size, the text culling threshold, the shape threshold and then far
+    // enough out to see the whole graph
+    qreal zooms[] = { 1.0, 0.5, 0.3, 0.2, 0.05, 0.02 };
+    int zoomCount = sizeof(zooms) / sizeof(zooms[0]);
+    for(int i = 0; i < zoomCount; ++i)
+    {
+        qint64 mean = 0;
+        qint64 best = timeFrames(&scene, zooms[i], &mean);
+        std::cout << "Zoom " << zooms[i] << ": best " << best << "ms, mean "
+                  << mean << "ms" << std::endl;
+    }
+
+    return 0;
+}
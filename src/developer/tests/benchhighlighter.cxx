@@ -0,0 +1,176 @@
+/*!
+ * \file
+ *
+ * This file contains a benchmark for the syntax highlighters. A large program
+ * is generated along with its token sequence and the time taken to re-highlight
+ * the whole document is reported.
+ *
+ * This is not run as part of the test suite, run it by hand when working on the
+ * highlighters. It requires a display (or QT_QPA_PLATFORM=offscreen under Qt 5)
+ * as the highlighters construct fonts.
+ */
+#include <iostream>
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QTextDocument>
+#include <QVariant>
+
+#include "programhighlighter.hpp"
+#include "conditionhighlighter.hpp"
+#include "conditiontokens.hpp"
+
+using namespace Developer;
+
+//! The number of lines in the generated documents
+#define BENCHMARK_LINES 50000
+//! The number of times each re-highlight is repeated
+#define BENCHMARK_RUNS 3
+
+/*!
+ * \brief Append a token to the generated text and token sequence
+ * \param text      The text being generated
+ * \param tokens    The tokens being generated
+ * \param value     The text of the new token
+ * \param lexeme    The lexeme of the new token
+ */
+void appendToken(QString *text, TokenBuffer *tokens, const QString &value,
+                 int lexeme)
+{
+    Token token;
+    token.startPos = text->length();
+    token.endPos = token.startPos + value.length();
+    token.lexeme = lexeme;
+    token.text = value;
+    tokens->append(token);
+    text->append(value);
+}
+
+/*!
+ * \brief Generate a program of BENCHMARK_LINES lines, a mix of rule calls,
+ *  rule sets and comments
+ * \param text      Output for the program text
+ * \param tokens    Output for the token sequence
+ */
+void generateProgram(QString *text, TokenBuffer *tokens)
+{
+    appendToken(text, tokens, "main", ProgramLexeme_Keyword);
+    text->append(" ");
+    appendToken(text, tokens, "=", ProgramLexeme_DeclarationOperator);
+    text->append("\n");
+
+    for(int i = 1; i < BENCHMARK_LINES - 1; ++i)
+    {
+        QString n = QVariant(i).toString();
+        text->append("    ");
+        if(i % 10 == 0)
+            appendToken(text, tokens, "/* Step " + n + " */",
+                        ProgramLexeme_Comment);
+        else if(i % 3 == 0)
+        {
+            appendToken(text, tokens, "{", ProgramLexeme_OpenBrace);
+            appendToken(text, tokens, "rule" + n, ProgramLexeme_Identifier);
+            appendToken(text, tokens, ",", ProgramLexeme_RuleSeparator);
+            text->append(" ");
+            appendToken(text, tokens, "other" + n, ProgramLexeme_Identifier);
+            appendToken(text, tokens, "}", ProgramLexeme_CloseBrace);
+            appendToken(text, tokens, "!", ProgramLexeme_Repeat);
+            appendToken(text, tokens, ";", ProgramLexeme_StatementSeparator);
+        }
+        else
+        {
+            appendToken(text, tokens, "rule" + n, ProgramLexeme_Identifier);
+            appendToken(text, tokens, ";", ProgramLexeme_StatementSeparator);
+        }
+        text->append("\n");
+    }
+
+    appendToken(text, tokens, "skip", ProgramLexeme_Keyword);
+    appendToken(text, tokens, ".", ProgramLexeme_DeclarationSeparator);
+}
+
+/*!
+ * \brief Generate a condition of BENCHMARK_LINES lines
+ * \param text      Output for the condition text
+ * \param tokens    Output for the token sequence
+ */
+void generateCondition(QString *text, TokenBuffer *tokens)
+{
+    for(int i = 0; i < BENCHMARK_LINES; ++i)
+    {
+        QString n = QVariant(i).toString();
+        appendToken(text, tokens, "indeg", DegreeTest);
+        appendToken(text, tokens, "(", OpeningParen);
+        appendToken(text, tokens, "n" + n, GraphLexeme);
+        appendToken(text, tokens, ")", ClosingParen);
+        text->append(" ");
+        appendToken(text, tokens, ">", GreaterThan);
+        text->append(" ");
+        appendToken(text, tokens, n, Integer);
+        text->append(" ");
+        appendToken(text, tokens, "and", And);
+        text->append(" ");
+        appendToken(text, tokens, "\"s" + n + "\"", QuotedString);
+        text->append("\n");
+    }
+}
+
+/*!
+ * \brief Time a full re-highlight of the provided document
+ * \param highlighter   The highlighter attached to the document
+ * \return The fastest run in milliseconds
+ */
+template <class Highlighter>
+qint64 timeRehighlight(Highlighter *highlighter)
+{
+    qint64 best = -1;
+    for(int run = 0; run < BENCHMARK_RUNS; ++run)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        highlighter->rehighlight();
+        qint64 elapsed = timer.elapsed();
+        if(best < 0 || elapsed < best)
+            best = elapsed;
+    }
+
+    return best;
+}
+
+/*!
+ * \brief Entry point for the benchmark, generate the documents and report the
+ *  re-highlight times
+ * \return Integer, non-zero on any failure
+ */
+int main(int argc, char **argv)
+{
+    QApplication app(argc, argv);
+
+    QString programText;
+    TokenBuffer programTokens;
+    generateProgram(&programText, &programTokens);
+
+    QTextDocument programDocument;
+    programDocument.setPlainText(programText);
+    ProgramHighlighter programHighlighter(&programDocument);
+    programHighlighter.setTokens(&programTokens);
+
+    std::cout << "ProgramHighlighter: " << programDocument.blockCount()
+              << " blocks, " << programTokens.size() << " tokens, "
+              << timeRehighlight(&programHighlighter) << "ms" << std::endl;
+
+    QString conditionText;
+    TokenBuffer conditionTokens;
+    generateCondition(&conditionText, &conditionTokens);
+
+    QTextDocument conditionDocument;
+    conditionDocument.setPlainText(conditionText);
+    ConditionHighlighter conditionHighlighter(&conditionDocument);
+    conditionHighlighter.setTokens(&conditionTokens);
+
+    std::cout << "ConditionHighlighter: " << conditionDocument.blockCount()
+              << " blocks, " << conditionTokens.size() << " tokens, "
+              << timeRehighlight(&conditionHighlighter) << "ms" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*!
+ * \file
+ *
+ * This file contains tests for the force-directed edge bundler. Like the
+ * layout tests the checks are loose, they catch bundles which fail to form,
+ * end points which move, and edges which are bent towards edges they have
+ * nothing in common with.
+ */
+#include <iostream>
+#include <cmath>
+
+#include "graphview/edgebundler.hpp"
+
+using namespace Developer;
+
+//! The number of parallel edges in the test bundle
+#define BUNDLE_SIZE 5
+//! The gap between neighbouring edges of the test bundle
+#define BUNDLE_GAP 10.0
+
+/*!
+ * \brief Return the gap between the highest and lowest of the middle points
+ *  of the test bundle's edges
+ */
+double bundleSpread(const QVector<QPolygonF> &polylines)
+{
+    double top = 0.0;
+    double bottom = 0.0;
+    for(int i = 0; i < BUNDLE_SIZE; ++i)
+    {
+        const QPolygonF &polyline = polylines.at(i);
+        double y = polyline.at(polyline.size() / 2).y();
+        if(i == 0 || y < top)
+            top = y;
+        if(i == 0 || y > bottom)
+            bottom = y;
+    }
+    return bottom - top;
+}
+
+/*!
+ * \brief Bundle a set of parallel edges alongside an unrelated edge and a
+ *  loop, and check that only the parallel edges are drawn together
+ * \return Integer, non-zero on failure
+ */
+int testBundle()
+{
+    QVector<QLineF> lines;
+    for(int i = 0; i < BUNDLE_SIZE; ++i)
+        lines.push_back(QLineF(0.0, i * BUNDLE_GAP, 400.0, i * BUNDLE_GAP));
+    int perpendicular = lines.size();
+    lines.push_back(QLineF(600.0, 0.0, 600.0, 400.0));
+    int loop = lines.size();
+    lines.push_back(QLineF(700.0, 700.0, 700.0, 700.0));
+
+    EdgeBundler bundler;
+    bundler.setEdges(lines);
+    bundler.start();
+    int steps = 1;
+    while(bundler.step())
+        ++steps;
+    if(steps != bundler.totalIterations())
+    {
+        std::cerr << "Bundling ran " << steps << " iterations, expected "
+                  << bundler.totalIterations() << std::endl;
+        return 1;
+    }
+
+    QVector<QPolygonF> polylines = bundler.polylines();
+    if(bundler.bundled(loop) || !polylines.at(loop).isEmpty())
+    {
+        std::cerr << "A loop was bundled" << std::endl;
+        return 1;
+    }
+
+    for(int i = 0; i < loop; ++i)
+    {
+        const QPolygonF &polyline = polylines.at(i);
+        if(polyline.size() < 3 || polyline.first() != lines.at(i).p1()
+                || polyline.last() != lines.at(i).p2())
+        {
+            std::cerr << "Edge " << i << " does not run between its end "
+                      << "points" << std::endl;
+            return 1;
+        }
+    }
+
+    double spread = bundleSpread(polylines);
+    if(spread > 0.5 * (BUNDLE_SIZE - 1) * BUNDLE_GAP)
+    {
+        std::cerr << "Parallel edges were not bundled, their middles are "
+                  << spread << " apart" << std::endl;
+        return 1;
+    }
+
+    const QPolygonF &straight = polylines.at(perpendicular);
+    for(int i = 0; i < straight.size(); ++i)
+    {
+        if(std::fabs(straight.at(i).x() - 600.0) > 1e-6)
+        {
+            std::cerr << "An edge with no compatible edges was bent"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+ * \brief Check that bundling no edges finishes immediately
+ * \return Integer, non-zero on failure
+ */
+int testNoEdges()
+{
+    EdgeBundler bundler;
+    bundler.setEdges(QVector<QLineF>());
+    bundler.start();
+    if(bundler.step() || !bundler.finished() || !bundler.polylines().isEmpty())
+    {
+        std::cerr << "Bundling no edges did not finish immediately"
+                  << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+ * \brief Entry point for this test program, run the tests
+ * \return Integer, non-zero on any failure
+ */
+int main(void)
+{
+    int failures = testNoEdges();
+    failures += testBundle();
+
+    if(failures > 0)
+    {
+        std::cerr << failures << " edge bundler test(s) failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,241 @@
+/*!
+ * \file
+ *
+ * This file contains tests for the built in force-directed layout engine. The
+ * engine only depends on QtCore, so these run without a display. The checks
+ * are deliberately loose, a force-directed layout has no single right answer,
+ * but they catch layouts which collapse, fail to converge, or move nodes a
+ * refinement was asked to leave alone.
+ */
+#include <iostream>
+#include <cmath>
+
+#include "graphview/forcelayout.hpp"
+
+using namespace Developer;
+
+//! The number of nodes in each row and column of the test grid
+#define GRID_SIZE 20
+//! The ideal edge length used by the tests
+#define IDEAL_LENGTH 80.0
+
+/*!
+ * \brief Return the distance between two points
+ */
+double distance(const QPointF &a, const QPointF &b)
+{
+    double dx = a.x() - b.x();
+    double dy = a.y() - b.y();
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+/*!
+ * \brief Build a square grid graph with every node at the origin
+ * \param positions Output for the node positions
+ * \param edges     Output for the edges
+ */
+void makeGrid(QVector<QPointF> *positions, QVector< QPair<int, int> > *edges)
+{
+    int nodeCount = GRID_SIZE * GRID_SIZE;
+    positions->fill(QPointF(0.0, 0.0), nodeCount);
+    for(int i = 0; i < nodeCount; ++i)
+    {
+        if((i % GRID_SIZE) != GRID_SIZE - 1)
+            edges->push_back(qMakePair(i, i + 1));
+        if(i + GRID_SIZE < nodeCount)
+            edges->push_back(qMakePair(i, i + GRID_SIZE));
+    }
+}
+
+/*!
+ * \brief Run a layout to completion
+ * \return The number of iterations run
+ */
+int run(ForceLayout *layout)
+{
+    layout->start();
+    int steps = 0;
+    while(layout->step())
+        ++steps;
+    return steps + 1;
+}
+
+/*!
+ * \brief Lay out a grid from scratch and check the result is spread out with
+ *  edges of about the ideal length
+ * \param result    Output for the positions, used by the refinement test
+ * \return Integer, non-zero on failure
+ */
+int testFullLayout(QVector<QPointF> *result)
+{
+    QVector<QPointF> positions;
+    QVector< QPair<int, int> > edges;
+    makeGrid(&positions, &edges);
+
+    ForceLayout layout;
+    layout.setIdealLength(IDEAL_LENGTH);
+    layout.setIterations(100);
+    layout.setGraph(positions, edges);
+    int steps = run(&layout);
+    if(steps != layout.totalIterations())
+    {
+        std::cerr << "Full layout ran " << steps << " iterations, expected "
+                  << layout.totalIterations() << std::endl;
+        return 1;
+    }
+
+    *result = layout.positions();
+    double minimum = -1.0;
+    for(int i = 0; i < result->size(); ++i)
+    {
+        if(result->at(i).x() != result->at(i).x()
+                || result->at(i).y() != result->at(i).y())
+        {
+            std::cerr << "Full layout placed node " << i << " at NaN"
+                      << std::endl;
+            return 1;
+        }
+
+        for(int j = i + 1; j < result->size(); ++j)
+        {
+            double d = distance(result->at(i), result->at(j));
+            if(minimum < 0.0 || d < minimum)
+                minimum = d;
+        }
+    }
+
+    double total = 0.0;
+    for(int i = 0; i < edges.size(); ++i)
+        total += distance(result->at(edges.at(i).first),
+                          result->at(edges.at(i).second));
+    double mean = total / edges.size();
+
+    if(std::fabs(mean - IDEAL_LENGTH) > 0.1 * IDEAL_LENGTH)
+    {
+        std::cerr << "Full layout has a mean edge length of " << mean
+                  << ", expected about " << IDEAL_LENGTH << std::endl;
+        return 1;
+    }
+
+    if(minimum < 0.1 * IDEAL_LENGTH)
+    {
+        std::cerr << "Full layout placed two nodes " << minimum << " apart"
+                  << std::endl;
+        return 1;
+    }
+
+    // The corners of an unfolded grid are the furthest apart
+    double diagonal = distance(result->at(0), result->last());
+    if(diagonal < (GRID_SIZE - 1) * IDEAL_LENGTH * 0.5)
+    {
+        std::cerr << "Full layout folded the grid, opposite corners are "
+                  << diagonal << " apart" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+ * \brief Move one node and add another, then check a refinement settles them
+ *  without moving anything else
+ * \param laidOut   The result of the full layout
+ * \return Integer, non-zero on failure
+ */
+int testRefinement(const QVector<QPointF> &laidOut)
+{
+    QVector<QPointF> positions = laidOut;
+    QVector< QPair<int, int> > edges;
+    QVector<QPointF> unused;
+    makeGrid(&unused, &edges);
+
+    // Drag a corner away from its neighbours, and add a node on top of an
+    // existing one
+    int moved = 0;
+    positions[moved] += QPointF(3 * IDEAL_LENGTH, 3 * IDEAL_LENGTH);
+    int added = positions.size();
+    int anchor = GRID_SIZE + 5;
+    positions.push_back(positions.at(anchor));
+    edges.push_back(qMakePair(anchor, added));
+
+    QVector<int> free;
+    free.push_back(moved);
+    free.push_back(added);
+
+    ForceLayout layout;
+    layout.setIdealLength(IDEAL_LENGTH);
+    layout.setIterations(50);
+    layout.setGraph(positions, edges);
+    layout.setFree(free);
+    run(&layout);
+    QVector<QPointF> result = layout.positions();
+
+    for(int i = 0; i < laidOut.size(); ++i)
+    {
+        if(i != moved && result.at(i) != laidOut.at(i))
+        {
+            std::cerr << "Refinement moved node " << i
+                      << " which was not free" << std::endl;
+            return 1;
+        }
+    }
+
+    double pulled = distance(result.at(moved), result.at(1));
+    if(pulled > 2 * IDEAL_LENGTH)
+    {
+        std::cerr << "Refinement left the moved node " << pulled
+                  << " from its neighbour" << std::endl;
+        return 1;
+    }
+
+    double pushed = distance(result.at(added), result.at(anchor));
+    if(pushed < 0.2 * IDEAL_LENGTH)
+    {
+        std::cerr << "Refinement left the added node " << pushed
+                  << " from the node it was added on" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+ * \brief Check that an empty graph finishes immediately
+ * \return Integer, non-zero on failure
+ */
+int testEmptyGraph()
+{
+    ForceLayout layout;
+    layout.setGraph(QVector<QPointF>(), QVector< QPair<int, int> >());
+    layout.start();
+    if(layout.step() || !layout.finished() || !layout.positions().isEmpty())
+    {
+        std::cerr << "Empty graph did not finish immediately" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+ * \brief Entry point for this test program, run the tests
+ * \return Integer, non-zero on any failure
+ */
+int main(void)
+{
+    QVector<QPointF> laidOut;
+    int failures = testEmptyGraph();
+
+    int fullFailures = testFullLayout(&laidOut);
+    failures += fullFailures;
+    if(fullFailures == 0)
+        failures += testRefinement(laidOut);
+
+    if(failures > 0)
+    {
+        std::cerr << failures << " force layout test(s) failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*!
+ * \file
+ *
+ * This file contains unit tests for the table-driven Lexer shared by the
+ * program and condition editors
+ */
+#include <iostream>
+
+#include "lexer.hpp"
+#include "programtokens.hpp"
+#include "conditiontokens.hpp"
+
+using namespace Developer;
+
+/*!
+ * \brief Check that the lexer matches the expected lexeme and length
+ * \param lexer     The lexer to use
+ * \param text      The text to match against
+ * \param lexeme    The expected lexeme
+ * \param length    The expected length of the match
+ * \param hint      The hint to pass to the lexer
+ * \return Integer, non-zero on failure
+ */
+int expectMatch(const Lexer &lexer, const char *text, int lexeme, int length,
+                int hint = -1)
+{
+    int matched = -1;
+    int matchLength = lexer.match(QString(text), 0, &matched, hint);
+    if(matched != lexeme || matchLength != length)
+    {
+        std::cerr << "Lexing \"" << text << "\": expected " << lexeme << "/"
+                  << length << ", got " << matched << "/" << matchLength
+                  << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+ * \brief testProgramLexemes tests the program language tables
+ * \return Integer, non-zero on failure
+ */
+int testProgramLexemes()
+{
+    Lexer lexer(ProgramLanguage);
+    int failures = 0;
+
+    failures += expectMatch(lexer, "main = x", ProgramLexeme_Keyword, 4);
+    failures += expectMatch(lexer, "mainly", ProgramLexeme_Identifier, 6);
+    failures += expectMatch(lexer, "rule_1!", ProgramLexeme_Identifier, 6);
+    failures += expectMatch(lexer, "/* c */", ProgramLexeme_CommentOpen, 2);
+    failures += expectMatch(lexer, "};", ProgramLexeme_CloseBrace, 1);
+    failures += expectMatch(lexer, "9", -1, 0);
+
+    // Identifiers are limited to 63 characters
+    QString longIdentifier(70, QChar('a'));
+    int lexeme = -1;
+    if(lexer.match(longIdentifier, 0, &lexeme) != Lexer::MaxIdentifierLength)
+        ++failures;
+
+    return failures;
+}
+
+/*!
+ * \brief testConditionLexemes tests the condition language tables, including
+ *  maximal munch and tie-breaking
+ * \return Integer, non-zero on failure
+ */
+int testConditionLexemes()
+{
+    Lexer lexer(ConditionLanguage);
+    int failures = 0;
+
+    failures += expectMatch(lexer, "empty", Empty, 5);
+    failures += expectMatch(lexer, "emptyx", Variable, 6);
+    failures += expectMatch(lexer, "outdeg(n)", DegreeTest, 6);
+    failures += expectMatch(lexer, "<= 2", LessThanEqualTo, 2);
+    failures += expectMatch(lexer, "!=", NotEquals, 2);
+    failures += expectMatch(lexer, "/*", ConditionLexeme_CommentOpen, 2);
+    failures += expectMatch(lexer, "-", Negation, 1);
+    failures += expectMatch(lexer, "123", Integer, 3);
+    failures += expectMatch(lexer, "123abc", GraphLexeme, 6);
+    failures += expectMatch(lexer, "\"a b\"", QuotedString, 5);
+    failures += expectMatch(lexer, "\"open", -1, 0);
+
+    // Hints win ties
+    failures += expectMatch(lexer, "edge", GraphLexeme, 4, GraphLexeme);
+    failures += expectMatch(lexer, "123", GraphLexeme, 3, GraphLexeme);
+
+    return failures;
+}
+
+/*!
+ * \brief testHelpers tests whitespace, identifier and comment scanning
+ * \return Integer, non-zero on failure
+ */
+int testHelpers()
+{
+    Lexer lexer(ConditionLanguage);
+    int failures = 0;
+
+    if(lexer.skipWhitespace(QString(" \t\n x"), 0) != 4)
+        ++failures;
+    if(lexer.matchIdentifier(QString("_a1-b"), 0) != 3)
+        ++failures;
+    if(lexer.matchIdentifier(QString("1a"), 0) != 0)
+        ++failures;
+    if(lexer.findCommentClose(QString("/* a */ b"), 2) != 7)
+        ++failures;
+    if(lexer.findCommentClose(QString("/* a"), 2) != -1)
+        ++failures;
+
+    return failures;
+}
+
+/*!
+ * \brief Entry point for this test program, run the tests
+ * \return Integer, non-zero on any failure
+ */
+int main(void)
+{
+    int failures = testProgramLexemes() + testConditionLexemes()
+            + testHelpers();
+
+    if(failures > 0)
+    {
+        std::cerr << failures << " lexer test(s) failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
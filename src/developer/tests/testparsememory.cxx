@@ -0,0 +1,141 @@
+/*!
+ * \file
+ *
+ * This file contains a memory growth test for the token storage shared by the
+ * program and condition parsers. Each test runs many successive parses into
+ * the same TokenBuffer, as an editor does while the user types, and checks
+ * that the buffer stops growing once it has fitted the largest parse.
+ */
+#include <iostream>
+
+#include <QStringList>
+
+#include "programparser.hpp"
+#include "conditionparser.hpp"
+
+using namespace Developer;
+
+//! The number of successive parses run by each test
+const int PARSE_COUNT = 10000;
+//! The number of parses allowed before the buffer is expected to have settled
+const int WARMUP_PARSES = 10;
+
+/*!
+ * \brief Build a parse job for the provided text in the way the editors do
+ * \param text      The document text
+ * \param tokens    The buffer to parse into
+ * \return The job, split into one block per line
+ */
+ParseJob makeJob(const QString &text, TokenBuffer *tokens)
+{
+    ParseJob job;
+    job.latestRevision = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    job.text = text;
+    job.tokens = tokens;
+
+    int position = 0;
+    QStringList lines = text.split('\n');
+    for(int i = 0; i < lines.size(); ++i)
+    {
+        ParseBlock block;
+        block.text = lines.at(i);
+        block.position = position;
+        job.blocks.push_back(block);
+        position += lines.at(i).length() + 1;
+    }
+
+    return job;
+}
+
+/*!
+ * \brief Parse alternating documents into one buffer and check its capacity
+ *  settles
+ * \param name      The name of the parser, for reporting
+ * \param run       The parser entry point
+ * \param first     The first document
+ * \param second    The second document, which should produce a different
+ *  number of tokens
+ * \return Integer, non-zero on failure
+ */
+int testRepeatedParses(const char *name, ParseJob (*run)(ParseJob),
+                       const QString &first, const QString &second)
+{
+    TokenBuffer tokens;
+    int capacity = 0;
+    int firstCount = -1;
+    int secondCount = -1;
+
+    for(int i = 0; i < PARSE_COUNT; ++i)
+    {
+        bool useFirst = (i % 2) == 0;
+        ParseJob job = run(makeJob(useFirst ? first : second, &tokens));
+        if(job.cancelled)
+        {
+            std::cerr << name << ": parse " << i << " was cancelled"
+                      << std::endl;
+            return 1;
+        }
+
+        // Every parse of the same text should produce the same tokens
+        int &count = useFirst ? firstCount : secondCount;
+        if(count < 0)
+            count = tokens.size();
+        else if(count != tokens.size())
+        {
+            std::cerr << name << ": parse " << i << " produced "
+                      << tokens.size() << " tokens, expected " << count
+                      << std::endl;
+            return 1;
+        }
+
+        if(i == WARMUP_PARSES)
+            capacity = tokens.capacity();
+        else if(i > WARMUP_PARSES && tokens.capacity() != capacity)
+        {
+            std::cerr << name << ": token storage grew from " << capacity
+                      << " to " << tokens.capacity() << " after " << i
+                      << " parses" << std::endl;
+            return 1;
+        }
+    }
+
+    if(firstCount == secondCount)
+    {
+        std::cerr << name << ": test documents should differ in length"
+                  << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+ * \brief Entry point for this test program, run the tests
+ * \return Integer, non-zero on any failure
+ */
+int main(void)
+{
+    // The second program contains errors so descriptions are produced too
+    QString program = "main = (rule1; rule2)!; {a, b}\n"
+                      "/* A comment\n"
+                      "   over two lines */\n"
+                      "macro = if a then b else skip";
+    QString brokenProgram = "main = (rule1; rule2; {a, }\n"
+                            "macro = if then else";
+
+    QString condition = "indeg(n1) > 2 and edge(n1, n2) or not x = \"s\"";
+    QString brokenCondition = "(indeg(n1) > 2 and ) ) /* open";
+
+    int failures = testRepeatedParses("ProgramParser", &ProgramParser::run,
+                                      program, brokenProgram)
+            + testRepeatedParses("ConditionParser", &ConditionParser::run,
+                                 condition, brokenCondition);
+
+    if(failures > 0)
+    {
+        std::cerr << failures << " parse memory test(s) failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*!
+ * \file
+ *
+ * This file contains unit tests for the inference of rule variable types from
+ * rule conditions and parameter declarations
+ */
+#include <iostream>
+
+#include <QStringList>
+
+#include "typeinference.hpp"
+
+using namespace Developer;
+
+/*!
+ * \brief Check that a variable is inferred to have the expected type
+ * \param condition The condition to analyse
+ * \param variable  The variable to check
+ * \param type      The expected type
+ * \return Integer, non-zero on failure
+ */
+int expectType(const char *condition, const char *variable, int type)
+{
+    TypeInference inference;
+    inference.addVariables(QStringList() << "x" << "y");
+    inference.addCondition(QString(condition));
+
+    int inferred = inference.type(QString(variable));
+    if(inferred != type)
+    {
+        std::cerr << "In \"" << condition << "\": expected " << variable
+                  << " to have type " << type << ", got " << inferred
+                  << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+ * \brief testConditions tests the constraints taken from rule conditions
+ * \return Integer, non-zero on failure
+ */
+int testConditions()
+{
+    int failures = 0;
+
+    failures += expectType("", "x", VariableType_List);
+    failures += expectType("x > 2", "x", VariableType_Integer);
+    failures += expectType("indeg(n1) = x", "x", VariableType_Integer);
+    failures += expectType("x = indeg(n1)", "x", VariableType_Integer);
+    failures += expectType("x + 1 = y", "x", VariableType_Integer);
+    failures += expectType("x = \"s\"", "x", VariableType_String);
+    failures += expectType("atom(x)", "x", VariableType_Atom);
+    failures += expectType("not int(x)", "x", VariableType_List);
+    failures += expectType("x = 1:2", "x", VariableType_List);
+    failures += expectType("x:y = \"s\"", "y", VariableType_List);
+    failures += expectType("/* x > 2 */ x = y", "x", VariableType_List);
+
+    // Only uses which must hold narrow a type
+    failures += expectType("x != 5", "x", VariableType_List);
+    failures += expectType("x != y and y < 3", "x", VariableType_List);
+    failures += expectType("not x = 5", "x", VariableType_List);
+    failures += expectType("not (x > 1 and y = 2)", "x", VariableType_List);
+    failures += expectType("x = 5 or y > 1", "x", VariableType_List);
+    failures += expectType("y > 1 and (x = 5 or y = 2)", "x",
+                           VariableType_List);
+    failures += expectType("int(x) or y > 1", "x", VariableType_List);
+    failures += expectType("not y = 1 and x = 5", "x", VariableType_Integer);
+    failures += expectType("(x = 5 or y = 1) or x > 2", "y",
+                           VariableType_List);
+    failures += expectType("y = 1 and (x = 5 and y < 2)", "x",
+                           VariableType_Integer);
+
+    // Equal variables share their types
+    failures += expectType("x = y and y < 3", "x", VariableType_Integer);
+
+    // An integer cannot also be a string
+    failures += expectType("x > 2 and x = \"s\"", "x", VariableType_Conflict);
+
+    return failures;
+}
+
+/*!
+ * \brief testDeclarations tests that declared types combine with uses
+ * \return Integer, non-zero on failure
+ */
+int testDeclarations()
+{
+    int failures = 0;
+
+    TypeInference inference;
+    inference.declare("x", "atom");
+    inference.declare("y", "string");
+    inference.addCondition(QString("x > 1 and y >= 2"));
+
+    if(inference.type("x") != VariableType_Integer)
+    {
+        std::cerr << "An atom compared with > should be an integer"
+                  << std::endl;
+        ++failures;
+    }
+
+    if(inference.type("y") != VariableType_Conflict
+            || inference.errors().size() != 1)
+    {
+        std::cerr << "A string compared with >= should be reported"
+                  << std::endl;
+        ++failures;
+    }
+
+    return failures;
+}
+
+/*!
+ * \brief Entry point for this test program, run the tests
+ * \return Integer, non-zero on any failure
+ */
+int main(void)
+{
+    int failures = testConditions() + testDeclarations();
+
+    if(failures > 0)
+    {
+        std::cerr << failures << " type inference test(s) failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
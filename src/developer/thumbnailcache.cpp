@@ -0,0 +1,198 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "thumbnailcache.hpp"
+#include "graphview/graphrenderer.hpp"
+#include "graphview/graphviewstyle.hpp"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QtConcurrentMap>
+
+namespace Developer {
+
+ThumbnailGenerator::ThumbnailGenerator(const QString &directory, int size)
+    : _directory(directory)
+    , _size(size)
+{
+}
+
+Thumbnail ThumbnailGenerator::operator()(const QString &graphPath) const
+{
+    Thumbnail thumbnail;
+    thumbnail.graphPath = graphPath;
+    thumbnail.modified = QFileInfo(graphPath).lastModified();
+
+    QFile file(graphPath);
+    if(!file.open(QIODevice::ReadOnly))
+        return thumbnail;
+    QByteArray contents = file.readAll();
+    file.close();
+
+    QDir dir(_directory);
+    if(!dir.exists() && !dir.mkpath(dir.absolutePath()))
+    {
+        qDebug() << "ThumbnailGenerator: could not create directory"
+                 << _directory;
+        return thumbnail;
+    }
+
+    // The path hash groups every image of a graph, the contents hash picks
+    // out the one matching what is on disk now
+    QString prefix = QCryptographicHash::hash(graphPath.toUtf8(),
+                                              QCryptographicHash::Sha1
+                                              ).toHex();
+    QString name = prefix + "-" + QCryptographicHash::hash(
+                contents, QCryptographicHash::Sha1).toHex() + ".png";
+    if(dir.exists(name))
+    {
+        thumbnail.imagePath = dir.filePath(name);
+        return thumbnail;
+    }
+
+    QImage image = renderThumbnail(graphPath, _size);
+    if(image.isNull())
+    {
+        qDebug() << "ThumbnailGenerator: could not draw graph" << graphPath;
+        return thumbnail;
+    }
+
+    // Write to a temporary file first so that a half written image is never
+    // shown
+    QString temporary = dir.filePath(name + ".tmp");
+    if(!image.save(temporary, "PNG")
+            || !QFile::rename(temporary, dir.filePath(name)))
+    {
+        qDebug() << "ThumbnailGenerator: could not save thumbnail for"
+                 << graphPath;
+        QFile::remove(temporary);
+        return thumbnail;
+    }
+    thumbnail.imagePath = dir.filePath(name);
+
+    // Remove the images of earlier versions of the graph
+    QStringList stale = dir.entryList(QStringList() << prefix + "-*.png",
+                                      QDir::Files);
+    for(int i = 0; i < stale.count(); ++i)
+    {
+        if(stale.at(i) != name)
+            dir.remove(stale.at(i));
+    }
+
+    return thumbnail;
+}
+
+ThumbnailCache::ThumbnailCache(QObject *parent)
+    : QObject(parent)
+    , _watcher(new QFutureWatcher<Thumbnail>(this))
+{
+    // The style is created on first use and must belong to this thread
+    // rather than to a worker
+    GraphViewStyle::instance();
+
+    connect(_watcher, SIGNAL(resultReadyAt(int)), this, SLOT(resultReady(int)));
+    connect(_watcher, SIGNAL(finished()), this, SLOT(finished()));
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    _watcher->cancel();
+    _watcher->waitForFinished();
+}
+
+QString ThumbnailCache::directory() const
+{
+    return _directory;
+}
+
+void ThumbnailCache::setDirectory(const QString &directory)
+{
+    if(directory == _directory)
+        return;
+
+    _directory = directory;
+    _thumbnails.clear();
+    _queued.clear();
+    _pending.clear();
+    if(_watcher->isRunning())
+        _watcher->cancel();
+}
+
+QString ThumbnailCache::thumbnail(const QString &graphPath)
+{
+    if(_directory.isEmpty())
+        return QString();
+
+    QDateTime modified = QFileInfo(graphPath).lastModified();
+    if(_thumbnails.contains(graphPath))
+    {
+        const Thumbnail &thumbnail = _thumbnails[graphPath];
+        // A graph which could not be drawn is not tried again until it
+        // changes
+        if(thumbnail.modified == modified
+                && (thumbnail.imagePath.isEmpty()
+                    || QFile::exists(thumbnail.imagePath)))
+            return thumbnail.imagePath;
+    }
+
+    if(!_pending.contains(graphPath))
+    {
+        _pending.insert(graphPath);
+        _queued << graphPath;
+        start();
+    }
+
+    return QString();
+}
+
+void ThumbnailCache::resultReady(int index)
+{
+    if(_batchDirectory != _directory)
+        return;
+
+    Thumbnail thumbnail = _watcher->resultAt(index);
+    _pending.remove(thumbnail.graphPath);
+    _thumbnails.insert(thumbnail.graphPath, thumbnail);
+    if(!thumbnail.imagePath.isEmpty())
+        emit thumbnailReady(thumbnail.graphPath);
+}
+
+void ThumbnailCache::finished()
+{
+    start();
+}
+
+void ThumbnailCache::start()
+{
+    if(_watcher->isRunning() || _queued.isEmpty())
+        return;
+
+    _batchDirectory = _directory;
+    _watcher->setFuture(QtConcurrent::mapped(
+                            _queued, ThumbnailGenerator(_directory,
+                                                        THUMBNAIL_SIZE)));
+    _queued.clear();
+}
+
+}
@@ -0,0 +1,130 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef THUMBNAILCACHE_HPP
+#define THUMBNAILCACHE_HPP
+
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+#include "global.hpp"
+
+namespace Developer {
+
+/*!
+ * \brief The Thumbnail struct records where the thumbnail of one graph file
+ *  was stored
+ */
+struct Thumbnail
+{
+    //! The absolute path of the graph file
+    QString graphPath;
+    //! The path of the PNG image, empty if none could be made
+    QString imagePath;
+    //! When the graph file was last modified as the image was made
+    QDateTime modified;
+};
+
+/*!
+ * \brief The ThumbnailGenerator class makes or finds the thumbnail of a single
+ *  graph file, it is the functor mapped across graph files by ThumbnailCache
+ */
+class ThumbnailGenerator
+{
+public:
+    typedef Thumbnail result_type;
+
+    ThumbnailGenerator(const QString &directory, int size);
+
+    Thumbnail operator()(const QString &graphPath) const;
+
+private:
+    QString _directory;
+    int _size;
+};
+
+/*!
+ * \brief The ThumbnailCache class provides small preview images of a
+ *  project's graphs without opening them in a GraphScene
+ *
+ * Thumbnails are stored as PNG files in a directory next to the project, each
+ * named after a hash of the graph's path and a hash of its contents, so an
+ * image is only remade once the graph itself changes and survives between
+ * sessions. The images are made on the global thread pool with
+ * renderThumbnail(), which draws plain lines and circles rather than items.
+ *
+ * thumbnail() never waits: a graph whose image is not known yet is queued and
+ * thumbnailReady() is emitted once its image is on disk.
+ */
+class ThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ThumbnailCache(QObject *parent = 0);
+    ~ThumbnailCache();
+
+    QString directory() const;
+    /*!
+     * \brief Set the directory the thumbnails are stored in, forgetting those
+     *  of the previous directory
+     */
+    void setDirectory(const QString &directory);
+
+    /*!
+     * \brief Get the path of the thumbnail of a graph file
+     *
+     * If the thumbnail is missing or older than the graph then one is made in
+     * the background, and thumbnailReady() is emitted once it has been.
+     *
+     * \param graphPath The absolute path of the graph file
+     * \return The path of the PNG image, or an empty string if it is not ready
+     */
+    QString thumbnail(const QString &graphPath);
+
+signals:
+    void thumbnailReady(QString graphPath);
+
+protected slots:
+    void resultReady(int index);
+    void finished();
+
+private:
+    void start();
+
+    QString _directory;
+    QHash<QString, Thumbnail> _thumbnails;
+    //! Graphs waiting for the running batch to finish
+    QStringList _queued;
+    //! Graphs queued or in the running batch
+    QSet<QString> _pending;
+    //! The directory of the running batch, results for any other directory
+    //! are discarded
+    QString _batchDirectory;
+    QFutureWatcher<Thumbnail> *_watcher;
+};
+
+}
+
+#endif // THUMBNAILCACHE_HPP
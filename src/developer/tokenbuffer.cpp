@@ -0,0 +1,80 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "tokenbuffer.hpp"
+
+namespace Developer {
+
+TokenBuffer::TokenBuffer()
+    : _size(0)
+{
+}
+
+void TokenBuffer::clear()
+{
+    // QVector::clear() would release the storage, so the slots are kept and
+    // simply overwritten by later appends
+    _size = 0;
+}
+
+Token *TokenBuffer::append(const Token &token)
+{
+    if(_size < _tokens.size())
+        _tokens[_size] = token;
+    else
+        _tokens.push_back(token);
+
+    return &_tokens[_size++];
+}
+
+int TokenBuffer::size() const
+{
+    return _size;
+}
+
+bool TokenBuffer::isEmpty() const
+{
+    return _size == 0;
+}
+
+int TokenBuffer::capacity() const
+{
+    return _tokens.capacity();
+}
+
+const Token &TokenBuffer::at(int i) const
+{
+    Q_ASSERT(i >= 0 && i < _size);
+    return _tokens.at(i);
+}
+
+Token &TokenBuffer::operator[](int i)
+{
+    Q_ASSERT(i >= 0 && i < _size);
+    return _tokens[i];
+}
+
+Token &TokenBuffer::last()
+{
+    Q_ASSERT(_size > 0);
+    return _tokens[_size - 1];
+}
+
+}
@@ -0,0 +1,81 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TOKENBUFFER_HPP
+#define TOKENBUFFER_HPP
+
+#include <QVector>
+
+#include "token.hpp"
+
+namespace Developer {
+
+/*!
+ * \brief The TokenBuffer class holds the tokens produced by a parse by value in
+ *  contiguous storage which is reused from one parse to the next
+ *
+ * Clearing the buffer only resets its size, the storage (and the slots within
+ * it) is kept and overwritten by the next parse. Once an editor has parsed its
+ * document a few times the buffer has grown to fit and re-parsing allocates
+ * nothing further for the tokens themselves.
+ *
+ * Pointers and references to tokens in the buffer remain valid until the next
+ * token is appended.
+ */
+class TokenBuffer
+{
+public:
+    TokenBuffer();
+
+    /*!
+     * \brief Remove all of the tokens, keeping the storage for reuse
+     */
+    void clear();
+
+    /*!
+     * \brief Append a copy of a token to the buffer
+     * \param token The token to append
+     * \return A pointer to the stored token, which can be used to adjust it
+     *  until the next token is appended
+     */
+    Token *append(const Token &token);
+
+    //! The number of tokens in the buffer
+    int size() const;
+    //! Whether the buffer holds no tokens
+    bool isEmpty() const;
+    //! The number of tokens the buffer can hold without allocating
+    int capacity() const;
+
+    const Token &at(int i) const;
+    Token &operator[](int i);
+    //! The most recently appended token, the buffer must not be empty
+    Token &last();
+
+private:
+    Q_DISABLE_COPY(TokenBuffer)
+
+    QVector<Token> _tokens;
+    int _size;
+};
+
+}
+
+#endif // TOKENBUFFER_HPP
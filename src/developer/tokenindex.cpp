@@ -0,0 +1,100 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "tokenindex.hpp"
+
+#include <QtAlgorithms>
+
+namespace Developer {
+
+/*!
+ * \brief Orders indices into a TokenBuffer by the start position of the tokens
+ */
+class TokenStartLessThan
+{
+public:
+    TokenStartLessThan(const TokenBuffer *tokens)
+        : _tokens(tokens)
+    {
+    }
+
+    bool operator()(int a, int b) const
+    {
+        return _tokens->at(a).startPos < _tokens->at(b).startPos;
+    }
+
+private:
+    const TokenBuffer *_tokens;
+};
+
+TokenIndex::TokenIndex()
+    : _tokens(0)
+{
+}
+
+void TokenIndex::setTokens(const TokenBuffer *tokens)
+{
+    _tokens = tokens;
+    _order.clear();
+
+    int size = count();
+    for(int i = 1; i < size; ++i)
+    {
+        if(_tokens->at(i).startPos < _tokens->at(i-1).startPos)
+        {
+            _order.resize(size);
+            for(int j = 0; j < size; ++j)
+                _order[j] = j;
+            qStableSort(_order.begin(), _order.end(),
+                        TokenStartLessThan(_tokens));
+            break;
+        }
+    }
+
+    // Tokens may in principle overlap, so a running maximum is kept rather
+    // than relying on the end positions being sorted as well
+    _maxEnd.resize(size);
+    int maxEnd = -1;
+    for(int i = 0; i < size; ++i)
+    {
+        maxEnd = qMax(maxEnd, at(i).endPos);
+        _maxEnd[i] = maxEnd;
+    }
+}
+
+int TokenIndex::count() const
+{
+    return (_tokens == 0) ? 0 : _tokens->size();
+}
+
+const Token &TokenIndex::at(int i) const
+{
+    return _tokens->at(_order.isEmpty() ? i : _order.at(i));
+}
+
+int TokenIndex::firstOverlapping(int position) const
+{
+    QVector<int>::const_iterator iter = qUpperBound(_maxEnd.constBegin(),
+                                                    _maxEnd.constEnd(),
+                                                    position);
+    return static_cast<int>(iter - _maxEnd.constBegin());
+}
+
+}
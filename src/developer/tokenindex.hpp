@@ -0,0 +1,83 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TOKENINDEX_HPP
+#define TOKENINDEX_HPP
+
+#include <QVector>
+
+#include "tokenbuffer.hpp"
+
+namespace Developer {
+
+/*!
+ * \brief The TokenIndex class provides fast lookup of the tokens overlapping a
+ *  range of the document
+ *
+ * The highlighters are asked to highlight one block at a time, and checking
+ * every token in the document for each block makes a full re-highlight cost
+ * O(blocks * tokens). This class keeps the tokens sorted by their start
+ * position along with a running maximum of their end positions, which allows a
+ * binary search for the first token which can overlap a given position.
+ * Highlighting a block then only visits the tokens which overlap it.
+ */
+class TokenIndex
+{
+public:
+    TokenIndex();
+
+    /*!
+     * \brief Replace the indexed tokens
+     *
+     * The parsers emit tokens in document order so normally the buffer is used
+     * as it is, otherwise a sorted ordering of the tokens is kept alongside it.
+     *
+     * \param tokens    The tokens to index, these are not owned by the index and
+     *  must not change until the next call to setTokens()
+     */
+    void setTokens(const TokenBuffer *tokens);
+
+    //! The number of indexed tokens
+    int count() const;
+    //! The token at the provided index in sorted order
+    const Token &at(int i) const;
+
+    /*!
+     * \brief Find the first token which could overlap the provided position
+     *
+     * Every token before the returned index ends at or before \p position.
+     * Tokens from the returned index onwards should be visited until one is
+     * found which starts after the range of interest.
+     *
+     * \param position  The document position to search from
+     * \return The index of the first candidate token, or count() if none
+     */
+    int firstOverlapping(int position) const;
+
+private:
+    const TokenBuffer *_tokens;
+    //! Indices into the buffer in sorted order, empty if already sorted
+    QVector<int> _order;
+    QVector<int> _maxEnd;
+};
+
+}
+
+#endif // TOKENINDEX_HPP
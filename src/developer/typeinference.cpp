@@ -0,0 +1,398 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "typeinference.hpp"
+#include "conditionparser.hpp"
+#include "conditiontokens.hpp"
+#include "tokenbuffer.hpp"
+
+namespace Developer {
+
+namespace {
+
+bool isArithmetic(int lexeme)
+{
+    return lexeme == Plus || lexeme == Minus || lexeme == Times
+            || lexeme == Divide || lexeme == Negation;
+}
+
+bool isOrdering(int lexeme)
+{
+    return lexeme == LessThan || lexeme == LessThanEqualTo
+            || lexeme == GreaterThan || lexeme == GreaterThanEqualTo;
+}
+
+/*!
+ * \brief A group of brackets open while reading a condition
+ */
+struct Frame
+{
+    //! Set if the group, or one enclosing it, is negated or joined by "or"
+    bool uncertain;
+    //! Set if the term being read within the group is negated
+    bool negated;
+};
+
+/*!
+ * \brief Find the tokens whose comparison must hold for the whole condition to
+ *  hold
+ *
+ * A token qualifies unless it is negated by a "not" or sits in a group, at any
+ * level of brackets, which is joined by "or". Only uses in such a place say
+ * anything certain about the type of a variable: "x != 5", "not x = 5" and
+ * "x = 5 or y > 1" can all hold for a string x.
+ *
+ * \param t The tokens of the condition, without comments
+ * \return A flag for each token, true where the token qualifies
+ */
+QVector<bool> certainTokens(const QVector<const Token *> &t)
+{
+    int count = t.size();
+
+    // Find the groups joined by "or", index 0 is the condition as a whole and
+    // every other group is numbered after its opening bracket
+    QVector<bool> disjunctive(count + 1, false);
+    QVector<int> open;
+    open.push_back(0);
+    for(int i = 0; i < count; ++i)
+    {
+        int lexeme = t.at(i)->lexeme;
+        if(lexeme == OpeningParen)
+            open.push_back(i + 1);
+        else if(lexeme == ClosingParen && open.size() > 1)
+            open.pop_back();
+        else if(lexeme == Or)
+            disjunctive[open.last()] = true;
+    }
+
+    // Each frame is a group of brackets, the innermost last
+    QVector<bool> certain(count, false);
+    QVector<Frame> frames;
+    Frame top = { disjunctive.at(0), false };
+    frames.push_back(top);
+    for(int i = 0; i < count; ++i)
+    {
+        int lexeme = t.at(i)->lexeme;
+        Frame &frame = frames.last();
+        certain[i] = !frame.uncertain && !frame.negated;
+
+        if(lexeme == Not)
+            frame.negated = true;
+        else if(lexeme == And || lexeme == Or)
+            frame.negated = false;
+        else if(lexeme == OpeningParen)
+        {
+            Frame inner = { frame.uncertain || frame.negated
+                            || disjunctive.at(i + 1), false };
+            frames.push_back(inner);
+        }
+        else if(lexeme == ClosingParen && frames.size() > 1)
+            frames.pop_back();
+    }
+
+    return certain;
+}
+
+}
+
+TypeInference::TypeInference()
+    : _solved(false)
+{
+}
+
+void TypeInference::addVariables(const QStringList &variables)
+{
+    for(int i = 0; i < variables.size(); ++i)
+        addVariable(variables.at(i));
+}
+
+void TypeInference::addCondition(const QString &condition)
+{
+    TokenBuffer tokens;
+    ConditionParser parser;
+    parser.parseCondition(condition, &tokens);
+    addCondition(&tokens);
+}
+
+void TypeInference::addCondition(const TokenBuffer *tokens)
+{
+    // Comments can sit anywhere, work only with the meaningful tokens
+    QVector<const Token *> t;
+    for(int i = 0; i < tokens->size(); ++i)
+    {
+        const Token &token = tokens->at(i);
+        if(token.lexeme != ConditionLexeme_Comment)
+            t.push_back(&token);
+    }
+
+    int count = t.size();
+    QVector<bool> certain = certainTokens(t);
+    for(int i = 0; i < count; ++i)
+    {
+        if(t.at(i)->lexeme != Variable)
+            continue;
+
+        const QString &text = t.at(i)->text;
+        int prev = (i > 0) ? t.at(i-1)->lexeme : ConditionLexeme_Default;
+        int next = (i + 1 < count) ? t.at(i+1)->lexeme
+                                   : ConditionLexeme_Default;
+
+        // Type tests: int(x), string(x) and atom(x)
+        if(next == OpeningParen && i + 3 < count
+                && t.at(i+2)->lexeme == Variable
+                && t.at(i+3)->lexeme == ClosingParen)
+        {
+            int tested = typeFromName(text);
+            if(tested >= 0)
+            {
+                if(certain.at(i))
+                    constrain(t.at(i+2)->text, tested,
+                              tr("tested with %1()").arg(text));
+                else
+                    addVariable(t.at(i+2)->text);
+                i += 3;
+                continue;
+            }
+        }
+
+        // The node in a degree test is not a variable
+        if(prev == OpeningParen && i > 1 && t.at(i-2)->lexeme == DegreeTest)
+            continue;
+
+        addVariable(text);
+
+        // A variable which is part of a larger list says nothing about its
+        // own type
+        if(prev == ListSeparator || next == ListSeparator)
+            continue;
+
+        // Nor does one which is negated or one side of an "or"
+        if(!certain.at(i))
+            continue;
+
+        if(isArithmetic(prev) || isArithmetic(next))
+        {
+            constrain(text, VariableType_Integer, tr("used in arithmetic"));
+            continue;
+        }
+
+        if(isOrdering(prev) || isOrdering(next))
+        {
+            constrain(text, VariableType_Integer,
+                      tr("compared with an ordering operator"));
+            continue;
+        }
+
+        // Look at the other side of an equality, provided it is a single
+        // value rather than a list
+        int other = -1;
+        int beyond = ConditionLexeme_Default;
+        if(next == Equals && i + 2 < count)
+        {
+            other = i + 2;
+            if(i + 3 < count)
+                beyond = t.at(i+3)->lexeme;
+        }
+        else if(prev == Equals && i > 1)
+        {
+            other = i - 2;
+            if(i > 2)
+                beyond = t.at(i-3)->lexeme;
+        }
+
+        if(other < 0 || beyond == ListSeparator)
+            continue;
+
+        int lexeme = t.at(other)->lexeme;
+        if(lexeme == Integer || lexeme == DegreeTest
+                || (lexeme == ClosingParen && other > 2
+                    && t.at(other-3)->lexeme == DegreeTest))
+        {
+            constrain(text, VariableType_Integer,
+                      tr("compared with an integer"));
+        }
+        else if(lexeme == QuotedString)
+            constrain(text, VariableType_String, tr("compared with a string"));
+        else if(lexeme == Variable && other > i)
+            unify(text, t.at(other)->text);
+    }
+}
+
+void TypeInference::declare(const QString &variable, const QString &typeName)
+{
+    int declared = typeFromName(typeName);
+    if(declared < 0)
+    {
+        addVariable(variable);
+        return;
+    }
+
+    constrain(variable, declared, tr("declared as %1").arg(typeName));
+}
+
+void TypeInference::constrain(const QString &variable, int type,
+                              const QString &reason)
+{
+    addVariable(variable);
+    _constraints[variable] = meet(_constraints.value(variable,
+                                                     VariableType_List), type);
+    _reasons[variable] << reason;
+    _solved = false;
+}
+
+void TypeInference::unify(const QString &first, const QString &second)
+{
+    addVariable(first);
+    addVariable(second);
+    if(first == second)
+        return;
+
+    _equalities.push_back(qMakePair(first, second));
+    _reasons[first] << tr("compared with %1").arg(second);
+    _reasons[second] << tr("compared with %1").arg(first);
+    _solved = false;
+}
+
+QStringList TypeInference::variables() const
+{
+    return _variables;
+}
+
+int TypeInference::type(const QString &variable) const
+{
+    solve();
+    return _types.value(variable, VariableType_List);
+}
+
+QStringList TypeInference::reasons(const QString &variable) const
+{
+    return _reasons.value(variable);
+}
+
+QStringList TypeInference::errors() const
+{
+    solve();
+
+    QStringList ret;
+    for(int i = 0; i < _variables.size(); ++i)
+    {
+        const QString &variable = _variables.at(i);
+        if(type(variable) != VariableType_Conflict)
+            continue;
+
+        ret << tr("The variable '%1' is used as incompatible types (%2).").arg(
+                   variable, reasons(variable).join(", "));
+    }
+
+    return ret;
+}
+
+int TypeInference::meet(int first, int second)
+{
+    if(first == second)
+        return first;
+    if(first == VariableType_Conflict || second == VariableType_Conflict)
+        return VariableType_Conflict;
+    if(first == VariableType_List)
+        return second;
+    if(second == VariableType_List)
+        return first;
+    if(first == VariableType_Atom)
+        return second;
+    if(second == VariableType_Atom)
+        return first;
+
+    // An integer and a string
+    return VariableType_Conflict;
+}
+
+QString TypeInference::typeName(int type)
+{
+    switch(type)
+    {
+    case VariableType_List:
+        return "list";
+    case VariableType_Atom:
+        return "atom";
+    case VariableType_String:
+        return "string";
+    case VariableType_Integer:
+        return "int";
+    case VariableType_Conflict:
+    default:
+        return QString();
+    }
+}
+
+int TypeInference::typeFromName(const QString &name)
+{
+    QString lower = name.toLower();
+    if(lower == "list")
+        return VariableType_List;
+    if(lower == "atom")
+        return VariableType_Atom;
+    if(lower == "string")
+        return VariableType_String;
+    if(lower == "int" || lower == "integer")
+        return VariableType_Integer;
+    return -1;
+}
+
+void TypeInference::addVariable(const QString &variable)
+{
+    if(variable.isEmpty() || _constraints.contains(variable))
+        return;
+
+    _variables << variable;
+    _constraints.insert(variable, VariableType_List);
+    _solved = false;
+}
+
+void TypeInference::solve() const
+{
+    if(_solved)
+        return;
+
+    // Equal variables share the meet of their types, repeat until nothing
+    // changes. Each pass can only narrow types so this is bounded by the
+    // height of the type hierarchy.
+    _types = _constraints;
+    bool changed = true;
+    while(changed)
+    {
+        changed = false;
+        for(int i = 0; i < _equalities.size(); ++i)
+        {
+            const QString &first = _equalities.at(i).first;
+            const QString &second = _equalities.at(i).second;
+            int type = meet(_types.value(first), _types.value(second));
+            if(_types.value(first) != type || _types.value(second) != type)
+            {
+                _types[first] = type;
+                _types[second] = type;
+                changed = true;
+            }
+        }
+    }
+
+    _solved = true;
+}
+
+}
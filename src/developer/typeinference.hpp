@@ -0,0 +1,186 @@
+/*!
+ * \file
+ * \author Alex Elliott
+ *
+ * \section LICENSE
+ * This file is part of GP Developer.
+ *
+ * GP Developer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * GP Developer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * GP Developer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TYPEINFERENCE_HPP
+#define TYPEINFERENCE_HPP
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QPair>
+#include <QStringList>
+#include <QVector>
+
+namespace Developer {
+
+class TokenBuffer;
+
+/*!
+ * \brief The VariableTypes enum defines the types a rule variable can take
+ *
+ * The types form a hierarchy: every integer and string is an atom and every
+ * atom is a list. The first four values are in the order they are offered by
+ * the variables table of the rule editor.
+ */
+enum VariableTypes
+{
+    //! Any list of values, the least specific type
+    VariableType_List,
+    //! A single integer or string
+    VariableType_Atom,
+    //! A single string
+    VariableType_String,
+    //! A single integer
+    VariableType_Integer,
+    //! The variable is used in ways which no single type allows
+    VariableType_Conflict
+};
+
+/*!
+ * \brief The TypeInference class works out the most specific type of each
+ *  variable in a rule from the way the variable is used
+ *
+ * Every variable starts as a list and is narrowed by each use:
+ *  - arithmetic and the ordering comparisons (<, <=, >, >=) require integers
+ *  - equality with an integer or a degree test requires an integer, equality
+ *    with a quoted string requires a string
+ *  - equality between two variables gives them the same type
+ *  - the type tests int(x), string(x) and atom(x) narrow x
+ *  - a declared parameter type narrows the variable to that type
+ *
+ * Only uses which must hold for the condition to hold narrow a type, so uses
+ * which are negated with "not" or joined to others with "or" are ignored, as
+ * is inequality (!=).
+ *
+ * If two uses require incompatible types the variable is marked as a conflict
+ * and errors() describes why. Uses which sit inside a list (next to ":") are
+ * ignored, the list as a whole is what is being compared.
+ *
+ * The result is intended both for display in the rule editor and for anything
+ * matching or compiling rules, which can pick integer or string comparisons
+ * for variables known to hold them rather than general list unification.
+ */
+class TypeInference
+{
+    Q_DECLARE_TR_FUNCTIONS(TypeInference)
+
+public:
+    TypeInference();
+
+    /*!
+     * \brief Add variables which appear in the rule, such as those in the LHS
+     *  and RHS labels, these start with no constraints
+     * \param variables The variables to add
+     */
+    void addVariables(const QStringList &variables);
+
+    /*!
+     * \brief Add the constraints implied by a rule condition
+     * \param condition The text of the condition
+     */
+    void addCondition(const QString &condition);
+
+    /*!
+     * \brief Add the constraints implied by an already parsed rule condition
+     * \param tokens    The tokens produced by ConditionParser
+     */
+    void addCondition(const TokenBuffer *tokens);
+
+    /*!
+     * \brief Add a declared parameter type
+     * \param variable  The variable declared
+     * \param typeName  The declared type, as written in the rule ("list",
+     *  "atom", "int" or "string")
+     */
+    void declare(const QString &variable, const QString &typeName);
+
+    /*!
+     * \brief Narrow a variable to the provided type
+     * \param variable  The variable to narrow
+     * \param type      A value from the VariableTypes enum
+     * \param reason    A description of the use which requires the type
+     */
+    void constrain(const QString &variable, int type, const QString &reason);
+
+    /*!
+     * \brief Require that two variables have the same type
+     */
+    void unify(const QString &first, const QString &second);
+
+    /*!
+     * \brief Get every variable seen so far
+     * \return The variables in the order they were first seen
+     */
+    QStringList variables() const;
+
+    /*!
+     * \brief Get the inferred type of a variable
+     * \param variable  The variable to look up
+     * \return A value from the VariableTypes enum, VariableType_List for
+     *  variables which have not been seen
+     */
+    int type(const QString &variable) const;
+
+    /*!
+     * \brief Get the reasons for a variable's type
+     * \param variable  The variable to look up
+     * \return A description of each use which narrowed the variable's type
+     */
+    QStringList reasons(const QString &variable) const;
+
+    /*!
+     * \brief Get a description of each conflict found
+     * \return The error messages, empty if every variable has a valid type
+     */
+    QStringList errors() const;
+
+    /*!
+     * \brief Get the most general type satisfying both of the provided types
+     * \return A value from the VariableTypes enum
+     */
+    static int meet(int first, int second);
+    /*!
+     * \brief Get the name of a type as it is written in a rule
+     */
+    static QString typeName(int type);
+    /*!
+     * \brief Get the type named in a rule declaration
+     * \return A value from the VariableTypes enum, or -1 if the name is not
+     *  recognised
+     */
+    static int typeFromName(const QString &name);
+
+private:
+    void addVariable(const QString &variable);
+    void solve() const;
+
+    QStringList _variables;
+    //! The type each variable is narrowed to by its own uses
+    QHash<QString, int> _constraints;
+    QHash<QString, QStringList> _reasons;
+    QVector< QPair<QString, QString> > _equalities;
+
+    //! The solved types, taking equalities into account
+    mutable QHash<QString, int> _types;
+    mutable bool _solved;
+};
+
+}
+
+#endif // TYPEINFERENCE_HPP